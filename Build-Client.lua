@@ -20,4 +20,8 @@ include "Walnut/Build-Walnut-External.lua"
 group "App"
     include "Cubed-Common/Build-Cubed-Common.lua"
     include "Cubed-Client/Build-Cubed-Client.lua"
+group ""
+
+group "Tools"
+    include "Cubed-Client/Build-Cubed-Client-Benchmarks.lua"
 group ""
\ No newline at end of file
@@ -1,6 +1,22 @@
 @echo off
 
-call glslangValidator -V -o bin/basic.vert.spirv basic.vert.glsl
-call glslangValidator -V -o bin/basic.frag.spirv basic.frag.glsl
+rem Builds bin/*.spirv from the GLSL here and validates the result; the client's pre-build step
+rem runs it with --no-pause. glslangValidator and spirv-val come with the Vulkan SDK.
 
-pause
\ No newline at end of file
+pushd "%~dp0"
+if not exist bin mkdir bin
+
+for %%s in (quad.vert quad.frag) do (
+	glslangValidator -V --target-env vulkan1.0 -o bin/%%s.spirv %%s.glsl || goto :error
+	spirv-val --target-env vulkan1.0 bin/%%s.spirv || goto :error
+)
+
+popd
+if not "%1"=="--no-pause" pause
+exit /b 0
+
+:error
+echo Shader compilation failed
+popd
+if not "%1"=="--no-pause" pause
+exit /b 1
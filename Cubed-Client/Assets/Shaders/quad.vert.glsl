@@ -0,0 +1,24 @@
+#version 460 core
+
+// Per vertex: corner of the unit quad, 0 to 1
+layout(location = 0) in vec2 a_Position;
+
+// Per instance: top-left corner in pixels and RGBA8 color
+layout(location = 1) in vec2 a_InstancePosition;
+layout(location = 2) in vec4 a_InstanceColor;
+
+layout(push_constant) uniform PushConstants
+{
+    vec2 PixelToClip; // 2 / framebuffer size
+    vec2 Size; // quad size in pixels
+} u_Push;
+
+layout(location = 0) out vec4 v_Color;
+
+void main()
+{
+    vec2 pixel = a_InstancePosition + a_Position * u_Push.Size;
+    gl_Position = vec4(pixel * u_Push.PixelToClip - 1.0, 0.0, 1.0);
+
+    v_Color = a_InstanceColor;
+}
@@ -0,0 +1,504 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "GPUAllocator.h"
+#include "QuadPipeline.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+
+	static constexpr uint32_t s_Width = 1280;
+	static constexpr uint32_t s_Height = 720;
+	static constexpr uint32_t s_MaxQuads = 50000;
+
+	// Relative to the working directory, like the client: run from Cubed-Client
+	static constexpr const char* s_ShaderDirectory = "Assets/Shaders/bin";
+
+	static constexpr const char* s_ValidationLayer = "VK_LAYER_KHRONOS_validation";
+
+	static uint32_t s_ValidationErrors = 0;
+
+	static VKAPI_ATTR VkBool32 VKAPI_CALL OnValidationMessage(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT,
+		const VkDebugUtilsMessengerCallbackDataEXT* data, void*)
+	{
+		if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+			s_ValidationErrors++;
+
+		std::cout << fmt::format("{:<24} {}\n", "QuadRender", data->pMessage);
+		return VK_FALSE;
+	}
+
+	//
+	// The client's quad pass without a window: CreateQuadPipeline and RecordQuadDraw, exactly as
+	// Renderer uses them, drawing into an offscreen RGBA8 target that can be read back. Runs under
+	// the Khronos validation layer when it is installed (it comes with the Vulkan SDK).
+	//
+	class OffscreenQuadRenderer
+	{
+	public:
+		~OffscreenQuadRenderer() { Shutdown(); }
+
+		// Returns false, having reported why, if there is no usable device or the pipeline fails
+		bool Init()
+		{
+			if (!InitDevice() || !InitTarget())
+				return false;
+
+			m_Allocator.Init(m_PhysicalDevice, m_Device);
+			m_VertexBuffer = m_Allocator.CreateBuffer(sizeof(QuadVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_IndexBuffer = m_Allocator.CreateBuffer(sizeof(QuadIndices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_InstanceBuffer = m_Allocator.CreateBuffer(s_MaxQuads * sizeof(QuadInstance), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_ReadbackBuffer = m_Allocator.CreateBuffer((VkDeviceSize)s_Width * s_Height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			if (!m_VertexBuffer.Handle || !m_IndexBuffer.Handle || !m_InstanceBuffer.Handle || !m_ReadbackBuffer.Handle)
+			{
+				Benchmark::ReportFailure("QuadRender", "failed to allocate host-visible buffers");
+				return false;
+			}
+			memcpy(m_VertexBuffer.Allocation.Mapped, QuadVertices, sizeof(QuadVertices));
+			memcpy(m_IndexBuffer.Allocation.Mapped, QuadIndices, sizeof(QuadIndices));
+
+			m_PipelineLayout = CreateQuadPipelineLayout(m_Device);
+			m_Pipeline = CreateQuadPipeline(m_Device, m_RenderPass, m_PipelineLayout, VK_NULL_HANDLE, s_ShaderDirectory);
+			if (!m_Pipeline)
+			{
+				Benchmark::ReportFailure("QuadRender", fmt::format("failed to create the quad pipeline from {}", s_ShaderDirectory));
+				return false;
+			}
+			return true;
+		}
+
+		void Shutdown()
+		{
+			if (!m_Instance)
+				return;
+
+			if (m_Device)
+			{
+				vkDeviceWaitIdle(m_Device);
+
+				vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+				vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+				m_Allocator.DestroyBuffer(m_VertexBuffer);
+				m_Allocator.DestroyBuffer(m_IndexBuffer);
+				m_Allocator.DestroyBuffer(m_InstanceBuffer);
+				m_Allocator.DestroyBuffer(m_ReadbackBuffer);
+				m_Allocator.Shutdown();
+
+				vkDestroyFramebuffer(m_Device, m_Framebuffer, nullptr);
+				vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+				vkDestroyImageView(m_Device, m_TargetView, nullptr);
+				vkDestroyImage(m_Device, m_Target, nullptr);
+				vkFreeMemory(m_Device, m_TargetMemory, nullptr);
+
+				vkDestroyFence(m_Device, m_Fence, nullptr);
+				vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+				vkDestroyDevice(m_Device, nullptr);
+			}
+
+			if (m_Messenger)
+			{
+				auto destroyMessenger = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_Instance, "vkDestroyDebugUtilsMessengerEXT");
+				destroyMessenger(m_Instance, m_Messenger, nullptr);
+			}
+			vkDestroyInstance(m_Instance, nullptr);
+			m_Instance = VK_NULL_HANDLE;
+		}
+
+		bool IsValidating() const { return m_Messenger != VK_NULL_HANDLE; }
+
+		// Writes the instances and records the frame, without submitting it. With `perQuadDraws`
+		// every quad gets its own RecordQuadDraw, as a baseline for the single instanced draw.
+		void RecordFrame(const std::vector<QuadInstance>& quads, glm::vec2 quadSize, bool perQuadDraws, bool readBack)
+		{
+			memcpy(m_InstanceBuffer.Allocation.Mapped, quads.data(), quads.size() * sizeof(QuadInstance));
+
+			VK_CHECK(vkResetCommandBuffer(m_CommandBuffer, 0));
+			VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VK_CHECK(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo));
+
+			VkClearValue clear{};
+			VkRenderPassBeginInfo passInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			passInfo.renderPass = m_RenderPass;
+			passInfo.framebuffer = m_Framebuffer;
+			passInfo.renderArea.extent = { s_Width, s_Height };
+			passInfo.clearValueCount = 1;
+			passInfo.pClearValues = &clear;
+			vkCmdBeginRenderPass(m_CommandBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			QuadDraw draw;
+			draw.VertexBuffer = m_VertexBuffer.Handle;
+			draw.IndexBuffer = m_IndexBuffer.Handle;
+			draw.InstanceBuffer = m_InstanceBuffer.Handle;
+			draw.InstanceCount = (uint32_t)quads.size();
+			draw.TargetSize = { (float)s_Width, (float)s_Height };
+			draw.QuadSize = quadSize;
+			if (perQuadDraws)
+			{
+				draw.InstanceCount = 1;
+				for (size_t i = 0; i < quads.size(); i++)
+				{
+					draw.InstanceOffset = i * sizeof(QuadInstance);
+					RecordQuadDraw(m_CommandBuffer, m_Pipeline, m_PipelineLayout, draw);
+				}
+			}
+			else
+			{
+				RecordQuadDraw(m_CommandBuffer, m_Pipeline, m_PipelineLayout, draw);
+			}
+
+			vkCmdEndRenderPass(m_CommandBuffer);
+
+			if (readBack)
+			{
+				// The render pass leaves the target in TRANSFER_SRC_OPTIMAL, after its writes
+				VkBufferImageCopy region{};
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.layerCount = 1;
+				region.imageExtent = { s_Width, s_Height, 1 };
+				vkCmdCopyImageToBuffer(m_CommandBuffer, m_Target, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ReadbackBuffer.Handle, 1, &region);
+
+				VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+				vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+
+			VK_CHECK(vkEndCommandBuffer(m_CommandBuffer));
+		}
+
+		// Submits what RecordFrame recorded and waits for the GPU to finish it
+		void SubmitFrame()
+		{
+			VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &m_CommandBuffer;
+			VK_CHECK(vkQueueSubmit(m_Queue, 1, &submitInfo, m_Fence));
+			VK_CHECK(vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX));
+			VK_CHECK(vkResetFences(m_Device, 1, &m_Fence));
+		}
+
+		// Row-major RGBA8 pixels of the last frame recorded with readBack
+		const uint32_t* GetPixels() const { return (const uint32_t*)m_ReadbackBuffer.Allocation.Mapped; }
+		const char* GetDeviceName() const { return m_DeviceName; }
+	private:
+		bool InitDevice()
+		{
+			std::vector<const char*> layers, extensions;
+
+			uint32_t layerCount = 0;
+			vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+			std::vector<VkLayerProperties> availableLayers(layerCount);
+			vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+			for (const VkLayerProperties& layer : availableLayers)
+			{
+				if (std::string_view(layer.layerName) == s_ValidationLayer)
+				{
+					layers.push_back(s_ValidationLayer);
+					extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+				}
+			}
+
+			VkApplicationInfo appInfo{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
+			appInfo.pApplicationName = "Cubed-Client-Benchmarks";
+			appInfo.apiVersion = VK_API_VERSION_1_0;
+
+			VkInstanceCreateInfo instanceInfo{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+			instanceInfo.pApplicationInfo = &appInfo;
+			instanceInfo.enabledLayerCount = (uint32_t)layers.size();
+			instanceInfo.ppEnabledLayerNames = layers.data();
+			instanceInfo.enabledExtensionCount = (uint32_t)extensions.size();
+			instanceInfo.ppEnabledExtensionNames = extensions.data();
+			if (vkCreateInstance(&instanceInfo, nullptr, &m_Instance) != VK_SUCCESS)
+			{
+				m_Instance = VK_NULL_HANDLE;
+				Benchmark::ReportFailure("QuadRender", "no Vulkan driver");
+				return false;
+			}
+
+			if (layers.empty())
+			{
+				std::cout << fmt::format("{:<24} {} not installed, API usage isn't validated\n", "QuadRender", s_ValidationLayer);
+			}
+			else
+			{
+				VkDebugUtilsMessengerCreateInfoEXT messengerInfo{ VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT };
+				messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+				messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+				messengerInfo.pfnUserCallback = OnValidationMessage;
+				auto createMessenger = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_Instance, "vkCreateDebugUtilsMessengerEXT");
+				VK_CHECK(createMessenger(m_Instance, &messengerInfo, nullptr, &m_Messenger));
+			}
+
+			// The first device with a graphics queue will do
+			uint32_t deviceCount = 0;
+			vkEnumeratePhysicalDevices(m_Instance, &deviceCount, nullptr);
+			std::vector<VkPhysicalDevice> devices(deviceCount);
+			vkEnumeratePhysicalDevices(m_Instance, &deviceCount, devices.data());
+			for (VkPhysicalDevice device : devices)
+			{
+				uint32_t familyCount = 0;
+				vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+				std::vector<VkQueueFamilyProperties> families(familyCount);
+				vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+				for (uint32_t i = 0; i < familyCount && !m_PhysicalDevice; i++)
+				{
+					if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+					{
+						m_PhysicalDevice = device;
+						m_QueueFamily = i;
+					}
+				}
+			}
+			if (!m_PhysicalDevice)
+			{
+				Benchmark::ReportFailure("QuadRender", "no Vulkan device with a graphics queue");
+				return false;
+			}
+
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+			memcpy(m_DeviceName, properties.deviceName, sizeof(m_DeviceName));
+
+			float priority = 1.0f;
+			VkDeviceQueueCreateInfo queueInfo{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+			queueInfo.queueFamilyIndex = m_QueueFamily;
+			queueInfo.queueCount = 1;
+			queueInfo.pQueuePriorities = &priority;
+
+			VkDeviceCreateInfo deviceInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+			deviceInfo.queueCreateInfoCount = 1;
+			deviceInfo.pQueueCreateInfos = &queueInfo;
+			VK_CHECK(vkCreateDevice(m_PhysicalDevice, &deviceInfo, nullptr, &m_Device));
+			vkGetDeviceQueue(m_Device, m_QueueFamily, 0, &m_Queue);
+
+			VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			poolInfo.queueFamilyIndex = m_QueueFamily;
+			VK_CHECK(vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool));
+
+			VkCommandBufferAllocateInfo commandBufferInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+			commandBufferInfo.commandPool = m_CommandPool;
+			commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			commandBufferInfo.commandBufferCount = 1;
+			VK_CHECK(vkAllocateCommandBuffers(m_Device, &commandBufferInfo, &m_CommandBuffer));
+
+			VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+			VK_CHECK(vkCreateFence(m_Device, &fenceInfo, nullptr, &m_Fence));
+			return true;
+		}
+
+		bool InitTarget()
+		{
+			VkImageCreateInfo imageInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+			imageInfo.extent = { s_Width, s_Height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			VK_CHECK(vkCreateImage(m_Device, &imageInfo, nullptr, &m_Target));
+
+			// Its own allocation: GPUAllocator only places buffers
+			VkMemoryRequirements requirements;
+			vkGetImageMemoryRequirements(m_Device, m_Target, &requirements);
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &memoryProperties);
+
+			VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+			allocateInfo.allocationSize = requirements.size;
+			allocateInfo.memoryTypeIndex = ~0u;
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount && allocateInfo.memoryTypeIndex == ~0u; i++)
+			{
+				if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+					allocateInfo.memoryTypeIndex = i;
+			}
+			if (allocateInfo.memoryTypeIndex == ~0u || vkAllocateMemory(m_Device, &allocateInfo, nullptr, &m_TargetMemory) != VK_SUCCESS)
+			{
+				Benchmark::ReportFailure("QuadRender", "failed to allocate the render target");
+				return false;
+			}
+			VK_CHECK(vkBindImageMemory(m_Device, m_Target, m_TargetMemory, 0));
+
+			VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+			viewInfo.image = m_Target;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = imageInfo.format;
+			viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			viewInfo.subresourceRange.levelCount = 1;
+			viewInfo.subresourceRange.layerCount = 1;
+			VK_CHECK(vkCreateImageView(m_Device, &viewInfo, nullptr, &m_TargetView));
+
+			// Like the swapchain pass the client draws in: one color attachment, cleared first
+			VkAttachmentDescription attachment{};
+			attachment.format = imageInfo.format;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+			VkAttachmentReference colorReference{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+			VkSubpassDescription subpass{};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = 1;
+			subpass.pColorAttachments = &colorReference;
+
+			// Color writes, and the move to TRANSFER_SRC_OPTIMAL, finish before the read back copy
+			VkSubpassDependency dependency{};
+			dependency.srcSubpass = 0;
+			dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+			dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			VkRenderPassCreateInfo renderPassInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+			renderPassInfo.attachmentCount = 1;
+			renderPassInfo.pAttachments = &attachment;
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+			renderPassInfo.dependencyCount = 1;
+			renderPassInfo.pDependencies = &dependency;
+			VK_CHECK(vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass));
+
+			VkFramebufferCreateInfo framebufferInfo{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+			framebufferInfo.renderPass = m_RenderPass;
+			framebufferInfo.attachmentCount = 1;
+			framebufferInfo.pAttachments = &m_TargetView;
+			framebufferInfo.width = s_Width;
+			framebufferInfo.height = s_Height;
+			framebufferInfo.layers = 1;
+			VK_CHECK(vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &m_Framebuffer));
+			return true;
+		}
+	private:
+		VkInstance m_Instance = VK_NULL_HANDLE;
+		VkDebugUtilsMessengerEXT m_Messenger = VK_NULL_HANDLE;
+		VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+		char m_DeviceName[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE] = {};
+		uint32_t m_QueueFamily = 0;
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VkQueue m_Queue = VK_NULL_HANDLE;
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+		VkFence m_Fence = VK_NULL_HANDLE;
+
+		VkImage m_Target = VK_NULL_HANDLE;
+		VkDeviceMemory m_TargetMemory = VK_NULL_HANDLE;
+		VkImageView m_TargetView = VK_NULL_HANDLE;
+		VkRenderPass m_RenderPass = VK_NULL_HANDLE;
+		VkFramebuffer m_Framebuffer = VK_NULL_HANDLE;
+
+		GPUAllocator m_Allocator;
+		Buffer m_VertexBuffer, m_IndexBuffer, m_InstanceBuffer, m_ReadbackBuffer;
+
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+		VkPipeline m_Pipeline = VK_NULL_HANDLE;
+	};
+
+	// 10k quads on a grid with gaps, each a different color; every pixel of the frame is checked
+	static void VerifyQuads(OffscreenQuadRenderer& renderer)
+	{
+		const uint32_t columns = 100, rows = 100;
+		const uint32_t cellWidth = s_Width / columns, cellHeight = s_Height / rows;
+		const uint32_t quadSize = 4;
+
+		std::vector<QuadInstance> quads;
+		std::vector<uint32_t> expected((size_t)s_Width * s_Height, 0);
+		for (uint32_t row = 0; row < rows; row++)
+		{
+			for (uint32_t column = 0; column < columns; column++)
+			{
+				uint32_t x = column * cellWidth, y = row * cellHeight;
+				uint32_t color = 0xff000000 | (uint32_t)(quads.size() + 1);
+				quads.push_back({ { (float)x, (float)y }, color });
+
+				for (uint32_t py = y; py < y + quadSize; py++)
+				{
+					for (uint32_t px = x; px < x + quadSize; px++)
+						expected[(size_t)py * s_Width + px] = color;
+				}
+			}
+		}
+
+		renderer.RecordFrame(quads, { (float)quadSize, (float)quadSize }, false, true);
+		renderer.SubmitFrame();
+
+		const uint32_t* pixels = renderer.GetPixels();
+		uint32_t mismatches = 0;
+		size_t firstMismatch = 0;
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			if (pixels[i] != expected[i] && mismatches++ == 0)
+				firstMismatch = i;
+		}
+
+		if (mismatches)
+		{
+			Benchmark::ReportFailure("QuadRender", fmt::format("{} of {} pixels wrong, first at ({}, {}): {:08x} instead of {:08x}", mismatches, expected.size(),
+				firstMismatch % s_Width, firstMismatch / s_Width, pixels[firstMismatch], expected[firstMismatch]));
+		}
+	}
+
+	static void BenchmarkQuads(OffscreenQuadRenderer& renderer, uint32_t quadCount, bool perQuadDraws)
+	{
+		const glm::vec2 quadSize = { 8.0f, 8.0f };
+
+		std::mt19937 random(quadCount);
+		std::uniform_real_distribution<float> x(0.0f, s_Width - quadSize.x), y(0.0f, s_Height - quadSize.y);
+		std::uniform_int_distribution<uint32_t> color;
+		std::vector<QuadInstance> quads(quadCount);
+		for (QuadInstance& quad : quads)
+			quad = { { x(random), y(random) }, color(random) | 0xff000000 };
+
+		// CPU side only: instance upload and command recording, which is what the client pays per frame
+		double recordTime = Benchmark::Measure(s_Runs, [&]() { renderer.RecordFrame(quads, quadSize, perQuadDraws, false); });
+		double frameTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			renderer.RecordFrame(quads, quadSize, perQuadDraws, false);
+			renderer.SubmitFrame();
+		});
+
+		std::string suffix = perQuadDraws ? fmt::format(" ({} quads, {} draws)", quadCount, quadCount) : fmt::format(" ({} quads, 1 draw)", quadCount);
+		Benchmark::Report({ "QuadRender", "Record" + suffix, quadCount, recordTime });
+		Benchmark::Report({ "QuadRender", "Record + GPU" + suffix, quadCount, frameTime });
+	}
+
+	CUBED_BENCHMARK_SUITE(QuadRenderSuite)
+	{
+		s_ValidationErrors = 0;
+		{
+			OffscreenQuadRenderer renderer;
+			if (!renderer.Init())
+				return;
+
+			std::cout << fmt::format("{:<24} {}, {}x{}{}\n", "QuadRender", renderer.GetDeviceName(), s_Width, s_Height, renderer.IsValidating() ? ", validated" : "");
+
+			VerifyQuads(renderer);
+
+			for (uint32_t quadCount : { 1000u, 10000u, s_MaxQuads })
+				BenchmarkQuads(renderer, quadCount, false);
+
+			// What one draw per player would cost; the draw count is what grows, so fewer quads do
+			for (uint32_t quadCount : { 1000u, 10000u })
+				BenchmarkQuads(renderer, quadCount, true);
+		}
+
+		// After Shutdown, so leaked objects are counted too
+		if (s_ValidationErrors)
+			Benchmark::ReportFailure("QuadRender", fmt::format("{} validation errors", s_ValidationErrors));
+	}
+}
@@ -0,0 +1,74 @@
+project "Cubed-Client-Benchmarks"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++20"
+   targetdir "bin/%{cfg.buildcfg}"
+   staticruntime "off"
+
+   -- The renderer's quad pass on its own, offscreen, with the common benchmark harness
+   files
+   {
+      "Benchmarks/**.h",
+      "Benchmarks/**.cpp",
+
+      "../Cubed-Common/Benchmarks/Benchmark.h",
+      "../Cubed-Common/Benchmarks/Benchmark.cpp",
+
+      "Source/Renderer/QuadPipeline.h",
+      "Source/Renderer/QuadPipeline.cpp",
+      "Source/Renderer/GPUAllocator.h",
+      "Source/Renderer/GPUAllocator.cpp",
+      "Source/Renderer/MappedFile.h",
+      "Source/Renderer/MappedFile.cpp",
+      "Source/Renderer/Vulkan.h",
+      "Source/Renderer/Vulkan.cpp",
+   }
+
+   includedirs
+   {
+      "Source/Renderer",
+      "../Cubed-Common/Benchmarks",
+
+      "../Walnut/vendor/imgui",
+      "../Walnut/vendor/glm",
+      "../Walnut/vendor/spdlog/include",
+
+      "../Walnut/Walnut/Source",
+
+      "%{IncludeDir.VulkanSDK}",
+   }
+
+    links
+    {
+        "Walnut"
+    }
+
+   -- Loads Assets/Shaders/bin like the client, so it runs from here too
+   debugdir "."
+
+   targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+   objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+   filter "system:windows"
+      systemversion "latest"
+      defines { "WL_PLATFORM_WINDOWS" }
+      buildoptions { "/utf-8" }
+
+      prebuildcommands { 'call "%{prj.location}/Assets/Shaders/Compile.bat" --no-pause' }
+
+   filter "configurations:Debug"
+      defines { "WL_DEBUG" }
+      runtime "Debug"
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "WL_RELEASE" }
+      runtime "Release"
+      optimize "On"
+      symbols "On"
+
+   filter "configurations:Dist"
+      defines { "WL_DIST" }
+      runtime "Release"
+      optimize "On"
+      symbols "Off"
@@ -40,6 +40,9 @@ project "Cubed-Client"
       defines { "WL_PLATFORM_WINDOWS" }
       buildoptions { "/utf-8" }
 
+      -- SPIR-V isn't checked in; it's compiled from the GLSL (and validated) on every build
+      prebuildcommands { 'call "%{prj.location}/Assets/Shaders/Compile.bat" --no-pause' }
+
       postbuildcommands 
       {
         '{COPY} "../%{WalnutNetworkingBinDir}/GameNetworkingSockets.dll" "%{cfg.targetdir}"',
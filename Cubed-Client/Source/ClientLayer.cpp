@@ -1,5 +1,7 @@
 #include "ClientLayer.h"
 
+#include <cstring>
+
 #include "Walnut/Input/Input.h"
 #include "Walnut/ImGui/ImGuiTheme.h"
 
@@ -10,32 +12,25 @@
 
 #include "Walnut/Serialization/BufferStream.h"
 #include "ServerPacket.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "PacketFrame.h"
 
 
 namespace Cubed
 {
-	static Walnut::Buffer s_ScratchBuffer;
-
-
-	static void DrawRect(glm::vec2 position, glm::vec2 size, uint32_t color)
-	{
-		ImDrawList* drawList = ImGui::GetBackgroundDrawList();
-		ImVec2 min = ImGui::GetWindowPos() + ImVec2(position.x, position.y);
-		ImVec2 max = min + ImVec2(size.x,size.y);
+	// Prediction steps (and inputs sent) per frame at most; the rest is dropped after a hitch
+	static constexpr uint32_t s_MaxPredictionStepsPerFrame = 4;
 
-		drawList->AddRectFilled(min, max, color);
-	}
 	void ClientLayer::OnAttach()
 	{
-		s_ScratchBuffer.Allocate(10 * 1024 * 1024);
-		
 		m_Client.SetDataReceivedCallback([this](const Walnut::Buffer buffer) {OnDataReceived(buffer); });
 
 		m_Renderer.Init();
 	}
 	void ClientLayer::OnDetach()
 	{
-
+		m_Renderer.Shutdown();
 	}
 	void ClientLayer::OnUpdate(float ts)
 	{
@@ -43,46 +38,57 @@ namespace Cubed
 		if (connectionStatus != Walnut::Client::ConnectionStatus::Connected)
 			return;
 
-		glm::vec2 dir{ 0.0f, 0.0f };
+		// The server is authoritative, but we don't wait for it: input is sampled once per server
+		// tick (regardless of framerate) and applied locally right away, and snapshots correct us afterwards
+		PlayerInput input;
 		if (Walnut::Input::IsKeyDown(Walnut::KeyCode::W))
-			dir.y = -1;
+			input.MoveY = -1;
 		else if (Walnut::Input::IsKeyDown(Walnut::KeyCode::S))
-			dir.y = 1;
+			input.MoveY = 1;
 
 		if (Walnut::Input::IsKeyDown(Walnut::KeyCode::A))
-			dir.x = -1;
+			input.MoveX = -1;
 		if (Walnut::Input::IsKeyDown(Walnut::KeyCode::D))
-			dir.x = 1;
+			input.MoveX = 1;
 
-		if (glm::length(dir) > 0.0f)
-		{
-			dir = glm::normalize(dir);
-			const float speed = 50.0f;
-			m_PlayerVelocity = dir * speed;
-		}
-		
-		m_PlayerVelocity = glm::mix(m_PlayerVelocity, glm::vec2(0.0f), 2 * ts);
+		float timestep = 1.0f / (float)m_ServerTickRate.load();
+		m_PredictionAccumulator += ts;
 
-		m_PlayerPosition += m_PlayerVelocity * ts;
+		std::scoped_lock<std::mutex> lock(m_PlayerDataMutex);
 
-		Walnut::BufferStreamWriter stream(s_ScratchBuffer);
+		// Nothing to predict from until the first snapshot with our player in it
+		if (!m_Predictor.IsInitialized())
+		{
+			m_PredictionAccumulator = 0.0f;
+			return;
+		}
 
-		stream.WriteRaw(PacketType::ClientUpdate);
-		stream.WriteRaw<glm::vec2>(m_PlayerPosition);
-		stream.WriteRaw<glm::vec2>(m_PlayerVelocity);
-		m_Client.SendBuffer(stream.GetBuffer());
+		uint32_t steps = 0;
+		for (; m_PredictionAccumulator >= timestep && steps < s_MaxPredictionStepsPerFrame; steps++)
+		{
+			m_PredictionAccumulator -= timestep;
 
-		m_PlayerDataMutex.lock();
-		std::map<uint32_t, PlayerData> playerData = m_PlayerData;
-		m_PlayerDataMutex.unlock();
+			input.Sequence = ++m_InputSequence;
+			m_Predictor.Predict(input, timestep);
 
-		for (const auto& [id, data] : playerData)
-		{
-			if (id == m_PlayerID)
+			// Inputs go out a few at a time, each packet repeating the previous few
+			if (!m_InputWindow.Add(input))
 				continue;
 
+			PacketStreamWriter& stream = GetThreadPacketWriter();
 
+			WritePacket<ClientUpdatePacket>(stream);
+			BitWriter writer(stream);
+			WritePlayerInputs(writer, m_InputWindow.GetInputs(), m_InputWindow.GetCount());
+			writer.WriteBits(m_LastReceivedSnapshotTick, 32);
+			writer.WriteBits(m_LastReceivedChunkSequence, 32);
+			writer.Flush();
+			m_Client.SendBuffer(stream.GetBuffer());
 		}
+
+		// After a long hitch, skip the backlog instead of sending a burst of inputs
+		if (steps == s_MaxPredictionStepsPerFrame)
+			m_PredictionAccumulator = 0.0f;
 	}
 
 	void ClientLayer::OnRender()
@@ -95,20 +101,100 @@ namespace Cubed
 		Walnut::Client::ConnectionStatus connectionStatus = m_Client.GetConnectionStatus();
 		if (connectionStatus == Walnut::Client::ConnectionStatus::Connected)
 		{
-			DrawRect(m_PlayerPosition, { 200, 200 }, 0xffff00ff);
-
 			m_PlayerDataMutex.lock();
-			std::map<uint32_t, PlayerData> playerData = m_PlayerData;
-			m_PlayerDataMutex.unlock();
 
-			for (const auto& [id, data] : playerData)
+			m_SnapshotInterpolator.Sample(SnapshotInterpolator::Clock::now(), m_Players);
+
+			// Drawn by the renderer in OnRender, all players in one instanced draw
+			const std::vector<PlayerID>& playerIDs = m_Players.GetIDs();
+			const std::vector<glm::vec2>& positions = m_Players.GetPositions();
+			m_Renderer.BeginQuads({ 200, 200 });
+			for (uint32_t i = 0; i < m_Players.GetCount(); i++)
+			{
+				// Everyone else is drawn in the past; our own player is drawn at its predicted position
+				if (playerIDs[i] == m_PlayerID && m_Predictor.IsInitialized())
+					m_Renderer.SubmitQuad(m_Predictor.GetRenderPosition(), 0xffff00ff);
+				else
+					m_Renderer.SubmitQuad(positions[i], 0xff00ff00);
+			}
+
+			ImGui::Begin("Network");
+
+			float interpolationDelay = m_SnapshotInterpolator.GetInterpolationDelay() * 1000.0f;
+			if (ImGui::SliderFloat("Interpolation delay (ms)", &interpolationDelay, 0.0f, 500.0f, "%.0f"))
+				m_SnapshotInterpolator.SetInterpolationDelay(interpolationDelay / 1000.0f);
+
+			const SnapshotInterpolatorStats& interpolatorStats = m_SnapshotInterpolator.GetStats();
+			ImGui::Text("Buffered: %u snapshots, %.0fms ahead", m_SnapshotInterpolator.GetBufferedCount(), m_SnapshotInterpolator.GetBufferedTime() * 1000.0f);
+			ImGui::Text("Extrapolated frames: %llu (starved %llu)", (unsigned long long)interpolatorStats.ExtrapolatedSamples, (unsigned long long)interpolatorStats.StarvedSamples);
+			ImGui::Text("Late snapshots: %llu", (unsigned long long)interpolatorStats.LateSnapshots);
+			ImGui::Text("Chunks: %u loaded, %.1fKB received", m_LoadedChunkCount.load(), m_ReceivedChunkBytes.load() / 1024.0f);
+
+			const PredictionStats& predictionStats = m_Predictor.GetStats();
+			float averageCorrection = predictionStats.Corrections ? (float)(predictionStats.TotalCorrection / (double)predictionStats.Corrections) : 0.0f;
+			ImGui::Separator();
+			ImGui::Text("Unacknowledged inputs: %u", m_Predictor.GetPendingInputCount());
+			ImGui::Text("Corrections: %llu of %llu snapshots", (unsigned long long)predictionStats.Corrections, (unsigned long long)predictionStats.Reconciliations);
+			ImGui::Text("Correction size: last %.2f, avg %.2f, max %.2f", predictionStats.LastCorrection, averageCorrection, predictionStats.MaxCorrection);
+
+			ImGui::End();
+
+			ImGui::Begin("Chat");
+			if (m_JoinRejected)
+			{
+				ImGui::TextColored(ImColor(Walnut::UI::Colors::Theme::invalidPrefab), "That username is taken or invalid.");
+				ImGui::InputText("Username", &m_Username);
+				if (ImGui::Button("Join"))
+				{
+					{
+						std::scoped_lock<std::mutex> lock(m_RosterMutex);
+						m_JoinUsername = m_Username;
+					}
+					m_JoinRejected = false;
+					SendJoinRequest();
+				}
+			}
+
 			{
-				if (id == m_PlayerID)
-					continue;
+				std::scoped_lock<std::mutex> lock(m_RosterMutex);
+				std::string label = "Online (" + std::to_string(m_Roster.GetEntries().size()) + ")###Online";
+				if (ImGui::CollapsingHeader(label.c_str()))
+				{
+					for (const auto& [clientID, entry] : m_Roster.GetEntries())
+						ImGui::TextColored(ImColor((entry.Color >> 16) & 0xff, (entry.Color >> 8) & 0xff, entry.Color & 0xff), "%s%s", entry.Username.c_str(), clientID == m_RosterClientID ? " (you)" : "");
+				}
+			}
 
-				DrawRect(data.Position, { 200, 200 }, 0xff00ff00);
+			ImGui::BeginChild("Messages", ImVec2(0, -ImGui::GetFrameHeightWithSpacing()));
+			{
+				std::scoped_lock<std::mutex> lock(m_ChatMutex);
+				for (const auto& [id, message] : m_ChatMessages)
+					ImGui::TextWrapped("%s: %s", message.Username.c_str(), message.Text.c_str());
+			}
+			if (m_ScrollChatToBottom.exchange(false))
+				ImGui::SetScrollHereY(1.0f);
+			ImGui::EndChild();
 
+			if (ImGui::InputText("##ChatInput", &m_ChatInput, ImGuiInputTextFlags_EnterReturnsTrue) && m_Joined)
+			{
+				SendChatMessage(m_ChatInput);
+				m_ChatInput.clear();
+				ImGui::SetKeyboardFocusHere(-1);
 			}
+			ImGui::End();
+
+			// From the previous frame's Render()
+			const RendererStats& rendererStats = m_Renderer.GetStats();
+			const GPUMemoryStats& memoryStats = rendererStats.Memory;
+			ImGui::Begin("Renderer");
+			ImGui::Text("Drawn: %u players in %u draw calls, %.1fKB instance data", rendererStats.QuadCount, rendererStats.DrawCalls, rendererStats.InstanceBytes / 1024.0f);
+			ImGui::Text("Upload ring: %.1f of %.1fKB per frame", rendererStats.UploadBytes / 1024.0f, rendererStats.UploadCapacity / 1024.0f);
+			ImGui::Text("GPU memory: %.2f of %.2fMB in %u blocks, %.0f%% fragmented", memoryStats.UsedBytes / (1024.0f * 1024.0f), memoryStats.ReservedBytes / (1024.0f * 1024.0f), memoryStats.BlockCount, memoryStats.Fragmentation * 100.0f);
+			ImGui::Text("Allocations: %u live, %u this frame, %llu device allocations", memoryStats.AllocationCount, rendererStats.FrameAllocations, (unsigned long long)memoryStats.DeviceAllocations);
+			ImGui::Text("Pipelines created in %.1fms at startup (%s pipeline cache)", rendererStats.PipelineCreationTime, rendererStats.PipelineCacheWarm ? "warm" : "cold");
+			ImGui::End();
+
+			m_PlayerDataMutex.unlock();
 		}
 		else
 		{
@@ -116,6 +202,8 @@ namespace Cubed
 				
 
 			ImGui::InputText("Server address", &m_ServerAddress);
+			ImGui::InputText("Username", &m_Username);
+			ImGui::ColorEdit3("Color", &m_Color.x);
 			if(connectionStatus == Walnut::Client::ConnectionStatus::FailedToConnect)
 				ImGui::TextColored(ImColor(Walnut::UI::Colors::Theme::invalidPrefab),"Failed to connect.");
 			else if (connectionStatus == Walnut::Client::ConnectionStatus::Connecting)
@@ -123,6 +211,14 @@ namespace Cubed
 
 			if (ImGui::Button("Connect"))
 			{
+				// Sent once the server has set up our player (see ClientConnect)
+				{
+					std::scoped_lock<std::mutex> lock(m_RosterMutex);
+					m_JoinUsername = m_Username;
+					m_JoinColor = ((uint32_t)(m_Color.x * 255.0f) << 16) | ((uint32_t)(m_Color.y * 255.0f) << 8) | (uint32_t)(m_Color.z * 255.0f);
+				}
+				m_Joined = false;
+				m_JoinRejected = false;
 				m_Client.ConnectToServer(m_ServerAddress);
 			}
 
@@ -132,44 +228,308 @@ namespace Cubed
 		}
 
 	}
+
+	void ClientLayer::SendJoinRequest()
+	{
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		{
+			std::scoped_lock<std::mutex> lock(m_RosterMutex);
+			WritePacket<ConnectionRequest>(stream, m_JoinColor, m_JoinUsername, m_Roster.GetEpoch(), m_Roster.GetVersion());
+		}
+		m_Client.SendBuffer(stream.GetBuffer());
+	}
+
+	void ClientLayer::RequestRoster()
+	{
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		{
+			std::scoped_lock<std::mutex> lock(m_RosterMutex);
+			WritePacket<ClientListRequest>(stream, m_Roster.GetEpoch(), m_Roster.GetVersion());
+		}
+		m_Client.SendBuffer(stream.GetBuffer());
+	}
+
+	void ClientLayer::SendChatMessage(std::string_view text)
+	{
+		text = TruncateUTF8(text, MaxChatMessageLength);
+		if (text.empty())
+			return;
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ChatMessageRequest>(stream, text);
+		m_Client.SendBuffer(stream.GetBuffer());
+	}
+
+	void ClientLayer::RequestChatHistory()
+	{
+		uint64_t afterID;
+		{
+			std::scoped_lock<std::mutex> lock(m_ChatMutex);
+			afterID = m_ChatHistoryCursor;
+		}
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<MessageHistoryRequest>(stream, afterID);
+		m_Client.SendBuffer(stream.GetBuffer());
+	}
+
+	void ClientLayer::AdvanceChatHistoryCursor()
+	{
+		while (m_ChatHistoryCursor && m_ChatMessages.contains(m_ChatHistoryCursor + 1))
+			m_ChatHistoryCursor++;
+
+		while (m_ChatMessages.size() > ChatHistory::DefaultCapacity)
+			m_ChatMessages.erase(m_ChatMessages.begin());
+	}
+
 	void ClientLayer::OnDataReceived(const Walnut::Buffer buffer)
 	{
-		Walnut::BufferStreamReader stream(buffer);
-		PacketType type;
-		stream.ReadRaw(type);
+		// Messages are read in place, straight out of the frame; a malformed frame is dropped whole
+		ForEachFrameMessage(buffer, [this](Walnut::Buffer message) {OnMessageReceived(message); });
+	}
+
+	void ClientLayer::OnMessageReceived(const Walnut::Buffer buffer)
+	{
+		// Each case reads through a PacketView, which drops the packet unless it matches its layout exactly
+		PacketType type = PacketType::None;
+		if (buffer.Size >= sizeof(PacketType))
+			std::memcpy(&type, buffer.Data, sizeof(type));
+
 		switch (type)
 		{
 		case PacketType::None:
 			break;
 		case PacketType::Message:
+		{
+			PacketView<ChatMessagePacket> packet(buffer);
+			if (!packet)
+				break;
+
+			ChatMessage message = ReadChatMessage(packet);
+			std::scoped_lock<std::mutex> lock(m_ChatMutex);
+			m_ChatMessages[message.ID] = std::move(message);
+			AdvanceChatHistoryCursor();
+			m_ScrollChatToBottom = true;
 			break;
+		}
 		case PacketType::ClientConnectionRequest:
+		{
+			PacketView<ConnectionResponse> response(buffer);
+			if (!response)
+				break;
+
+			bool accepted = response.Get<ConnectionResponse::Accepted>();
+			if (accepted)
+			{
+				std::scoped_lock<std::mutex> lock(m_RosterMutex);
+				m_RosterClientID = response.Get<ConnectionResponse::ClientID>();
+			}
+
+			m_Joined = accepted;
+			m_JoinRejected = !accepted;
 			break;
+		}
 		case PacketType::ConnectionStatus:
 			break;
 		case PacketType::ClientList:
+		{
+			// A malformed list leaves the roster as it was
+			PacketView<ClientListPacket> list(buffer);
+			if (!list)
+				break;
+
+			std::scoped_lock<std::mutex> lock(m_RosterMutex);
+			m_Roster.ApplyList(list);
 			break;
+		}
 		case PacketType::ClientConnect:
-			uint32_t idFromServer;
-			stream.ReadRaw<uint32_t>(idFromServer);
-			m_PlayerID = idFromServer;
+		{
+			PacketView<ClientConnectPacket> packet(buffer);
+			if (!packet)
+				break;
+
+			if (packet.Get<ClientConnectPacket::RosterVersion>() != 0)
+			{
+				// Someone else joined
+				bool applied;
+				{
+					std::scoped_lock<std::mutex> lock(m_RosterMutex);
+					applied = m_Roster.ApplyConnect(packet);
+				}
+				if (!applied)
+					RequestRoster();
+				break;
+			}
+
+			PacketView<OwnPlayerRecord> ownPlayer(packet.Get<ClientConnectPacket::Body>());
+			if (!ownPlayer)
+				break;
+
+			m_PlayerDataMutex.lock();
+			m_PlayerID = ownPlayer.Get<OwnPlayerRecord::Player>();
+			m_SnapshotInterpolator.Clear();
+			m_Predictor = MovementPredictor();
+			// Inputs still waiting for an ack belonged to the old session's player
+			m_InputWindow.Clear();
+			m_PlayerDataMutex.unlock();
+
+			// The new session's first snapshot is a full one; nothing it sends can be a delta against ours
+			m_SnapshotHistory.Clear();
+			m_LastReceivedSnapshotTick = InvalidSnapshotTick;
+
+			// A new session streams chunks from scratch
+			m_Chunks.clear();
+			m_LastReceivedChunkSequence = 0;
+			m_LoadedChunkCount = 0;
+
+			// Chat and the roster pick up from whatever we had before
+			RequestChatHistory();
+			m_Joined = false;
+			SendJoinRequest();
 			break;
+		}
 
 		case PacketType::ClientUpdate:
+		{
+			SnapshotInterpolator::Clock::time_point receiveTime = SnapshotInterpolator::Clock::now();
+
+			PacketView<ClientUpdatePacket> update(buffer);
+			if (!update)
+				break;
+
+			BitReader reader(update.Get<ClientUpdatePacket::Body>());
+			SnapshotDeltaHeader header = ReadSnapshotDeltaHeader(reader);
+
+			auto snapshot = std::make_shared<WorldSnapshot>();
+			snapshot->Tick = header.Tick;
+			snapshot->TickRate = header.TickRate;
+			snapshot->SnapshotInterval = header.SnapshotInterval;
+			snapshot->HasLastInputSequence = header.HasLastInputSequence;
+			snapshot->LastInputSequence = header.LastInputSequence;
+			if (header.BaselineTick != InvalidSnapshotTick)
+			{
+				const WorldSnapshot* baseline = m_SnapshotHistory.Find(header.BaselineTick);
+				if (!baseline)
+				{
+					// Baseline already fell out of history, ask the server for a full snapshot
+					m_LastReceivedSnapshotTick = InvalidSnapshotTick;
+					break;
+				}
+
+				snapshot->Players = baseline->Players;
+			}
+
+			ApplySnapshotDelta(reader, *snapshot);
+			if (!reader.IsValid())
+				break;
+
+			m_SnapshotHistory.Push(snapshot);
+			m_LastReceivedSnapshotTick = header.Tick;
+
+			if (header.TickRate)
+				m_ServerTickRate = header.TickRate;
+
+			// Not drawn directly; rendering samples between buffered snapshots
 			m_PlayerDataMutex.lock();
-			stream.ReadMap(m_PlayerData);
+			m_SnapshotInterpolator.Push(snapshot, receiveTime);
+
+			auto localPlayer = snapshot->Players.find(m_PlayerID);
+			if (localPlayer != snapshot->Players.end())
+				m_Predictor.Reconcile(localPlayer->second, header.HasLastInputSequence, header.LastInputSequence);
 			m_PlayerDataMutex.unlock();
 			break;
+		}
 		case PacketType::ClientDisconnect:
+		{
+			PacketView<ClientDisconnectPacket> packet(buffer);
+			bool applied = false;
+			if (packet)
+			{
+				std::scoped_lock<std::mutex> lock(m_RosterMutex);
+				applied = m_Roster.ApplyDisconnect(packet);
+			}
+			if (!applied)
+				RequestRoster();
 			break;
+		}
 		case PacketType::ClientUpdateResponse:
 			break;
 		case PacketType::MessageHistory:
+		{
+			PacketView<MessageHistoryPacket> page(buffer);
+			if (!page)
+				break;
+
+			uint64_t newestID = page.Get<MessageHistoryPacket::NewestID>();
+			uint32_t count = std::min(page.Get<MessageHistoryPacket::Count>(), ChatHistory::MaxPageSize);
+
+			bool requestMore;
+			{
+				std::scoped_lock<std::mutex> lock(m_ChatMutex);
+				const uint64_t previousCursor = m_ChatHistoryCursor;
+				RecordReader<ChatMessageRecord> reader(page.Get<MessageHistoryPacket::Messages>());
+				for (uint32_t i = 0; i < count; i++)
+				{
+					PacketView<ChatMessageRecord> record = reader.Next();
+					if (!record)
+						break;
+
+					ChatMessage message = ReadChatMessage(record);
+					m_ChatHistoryCursor = std::max(m_ChatHistoryCursor, message.ID);
+					m_ChatMessages[message.ID] = std::move(message);
+				}
+
+				// An empty page means there is nothing after our cursor (or nothing at all)
+				if (count == 0)
+					m_ChatHistoryCursor = std::max(m_ChatHistoryCursor, newestID);
+
+				AdvanceChatHistoryCursor();
+				// Stop on a page that didn't move us forward, rather than asking for it again
+				requestMore = m_ChatHistoryCursor < newestID && m_ChatHistoryCursor > previousCursor;
+			}
+
+			m_ScrollChatToBottom = true;
+			if (requestMore)
+				RequestChatHistory();
 			break;
+		}
 		case PacketType::ServerShutdown:
 			break;
 		case PacketType::ClientKick:
 			break;
+		case PacketType::ChunkData:
+		{
+			PacketView<ChunkDataPacket> packet(buffer);
+			if (!packet)
+				break;
+
+			// Acknowledged even if the chunk doesn't decode, so the server doesn't stall waiting for it
+			m_LastReceivedChunkSequence = packet.Get<ChunkDataPacket::Sequence>();
+			m_ReceivedChunkBytes += buffer.Size;
+
+			BitReader reader(packet.Get<ChunkDataPacket::Body>());
+			Chunk chunk(ReadChunkCoordinate(reader));
+			if (!ReadChunkBlocks(reader, chunk.GetBlocks()))
+				break;
+
+			m_Chunks.insert_or_assign(GetChunkKey(chunk.GetCoordinate()), std::move(chunk));
+			m_LoadedChunkCount = (uint32_t)m_Chunks.size();
+			break;
+		}
+		case PacketType::ChunkUnload:
+		{
+			PacketView<ChunkUnloadPacket> packet(buffer);
+			if (!packet)
+				break;
+
+			BitReader reader(packet.Get<ChunkUnloadPacket::Body>());
+			uint32_t count = reader.ReadVarUInt();
+			for (uint32_t i = 0; i < count && reader.IsValid(); i++)
+				m_Chunks.erase(GetChunkKey(ReadChunkCoordinate(reader)));
+
+			m_LoadedChunkCount = (uint32_t)m_Chunks.size();
+			break;
+		}
 		default:
 			break;
 		}
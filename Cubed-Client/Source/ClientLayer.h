@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #include "Walnut/Application.h"
 #include "Walnut/Layer.h"
 
@@ -9,6 +11,16 @@
 
 #include "Renderer/Renderer.h"
 
+#include "Snapshot.h"
+#include "SnapshotInterpolator.h"
+#include "PlayerStore.h"
+#include "Movement.h"
+#include "MovementPredictor.h"
+#include "InputQueue.h"
+#include "Chunk.h"
+#include "ChatHistory.h"
+#include "ClientRoster.h"
+
 #include "vulkan/vulkan.h"
 namespace Cubed
 {
@@ -23,26 +35,71 @@ namespace Cubed
 		virtual void OnUIRender() override;
 	private:
 		void OnDataReceived(const Walnut::Buffer buffer);
+		// One message of what OnDataReceived got; the server sends several per tick as a Frame
+		void OnMessageReceived(const Walnut::Buffer buffer);
+
+		// Joins the roster with m_JoinUsername, sending the roster version we still have
+		void SendJoinRequest();
+		// Asks for the roster again after a delta we couldn't apply
+		void RequestRoster();
+
+		void SendChatMessage(std::string_view text);
+		// Asks for the next page of chat after m_ChatHistoryCursor
+		void RequestChatHistory();
+		// Moves m_ChatHistoryCursor over messages we already have; call with m_ChatMutex held
+		void AdvanceChatHistoryCursor();
 	private:
 		Renderer m_Renderer;
 		
-		glm::vec2 m_PlayerPosition{ 50,50 };
-		glm::vec2 m_PlayerVelocity{ 0, 0 };
+		uint32_t m_InputSequence = 0;
+		float m_PredictionAccumulator = 0.0f;
+		// Input is sampled once per server tick, taken from the snapshots
+		std::atomic<uint32_t> m_ServerTickRate = 30;
+		InputSendWindow m_InputWindow;
 
 		std::string m_ServerAddress;
 
 		Walnut::Client m_Client;
 
-		uint32_t m_PlayerID = 0;
+		std::mutex m_PlayerDataMutex;
+		PlayerID m_PlayerID = InvalidPlayerID; // set by the network thread on ClientConnect
+		// What we draw: the interpolated world, resampled every frame
+		PlayerStore m_Players;
+		SnapshotInterpolator m_SnapshotInterpolator;
+		MovementPredictor m_Predictor; // our own player
 
-		struct PlayerData
-		{
-			glm::vec2 Position;
-			glm::vec2 Velocity;
-		};
+		// Received snapshots, kept as baselines for incoming deltas
+		SnapshotHistory m_SnapshotHistory;
+		std::atomic<uint32_t> m_LastReceivedSnapshotTick = InvalidSnapshotTick;
 
-		std::mutex m_PlayerDataMutex;
-		std::map<uint32_t, PlayerData> m_PlayerData;
+		// Chunks the server streamed to us, only touched by the network thread
+		std::unordered_map<uint64_t, Chunk> m_Chunks;
+		std::atomic<uint32_t> m_LastReceivedChunkSequence = 0; // acknowledged in ClientUpdate
+		std::atomic<uint32_t> m_LoadedChunkCount = 0;
+		std::atomic<uint64_t> m_ReceivedChunkBytes = 0;
+
+		// Live messages and history pages both land here, keyed by ID so overlaps and reordering don't matter
+		std::mutex m_ChatMutex;
+		std::map<uint64_t, ChatMessage> m_ChatMessages; // newest ChatHistory::DefaultCapacity
+		// Newest message ID we have with nothing missing before it (as far back as the server still had);
+		// kept across reconnects, so only what we missed is synced again
+		uint64_t m_ChatHistoryCursor = 0;
+		std::string m_ChatInput;
+		std::atomic<bool> m_ScrollChatToBottom = false;
+
+		// Everyone who joined with a username. The server only sends changes, so the replica is
+		// kept across reconnects and only what we missed is sent again. Guarded by m_RosterMutex.
+		std::mutex m_RosterMutex;
+		RosterReplica m_Roster;
+		std::string m_JoinUsername;
+		uint32_t m_JoinColor = 0;
+		uint32_t m_RosterClientID = 0; // our own entry, once joined
+
+		// Edited by the UI, copied into m_JoinUsername/m_JoinColor when (re)joining
+		std::string m_Username = "Player";
+		glm::vec3 m_Color{ 1.0f, 0.0f, 1.0f };
+		std::atomic<bool> m_Joined = false;
+		std::atomic<bool> m_JoinRejected = false;
 	};
 
 }
\ No newline at end of file
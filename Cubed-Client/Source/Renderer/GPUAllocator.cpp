@@ -0,0 +1,243 @@
+#include "GPUAllocator.h"
+
+#include <algorithm>
+
+namespace Cubed
+{
+    static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    OffsetAllocator::OffsetAllocator(uint64_t size)
+        : m_Size(size), m_FreeSize(size)
+    {
+        m_FreeRanges.push_back({ 0, size });
+    }
+
+    uint64_t OffsetAllocator::Allocate(uint64_t size, uint64_t alignment)
+    {
+        alignment = std::max<uint64_t>(alignment, 1);
+        for (size_t i = 0; i < m_FreeRanges.size(); i++)
+        {
+            Range& range = m_FreeRanges[i];
+            uint64_t offset = AlignUp(range.Offset, alignment);
+            uint64_t padding = offset - range.Offset;
+            if (padding + size > range.Size)
+                continue;
+
+            uint64_t tailOffset = offset + size;
+            uint64_t tailSize = range.Offset + range.Size - tailOffset;
+
+            // The alignment padding stays free in front, the rest after
+            if (padding > 0)
+            {
+                range.Size = padding;
+                if (tailSize > 0)
+                    m_FreeRanges.insert(m_FreeRanges.begin() + i + 1, { tailOffset, tailSize });
+            }
+            else if (tailSize > 0)
+            {
+                range = { tailOffset, tailSize };
+            }
+            else
+            {
+                m_FreeRanges.erase(m_FreeRanges.begin() + i);
+            }
+
+            m_FreeSize -= size;
+            return offset;
+        }
+
+        return InvalidOffset;
+    }
+
+    void OffsetAllocator::Free(uint64_t offset, uint64_t size)
+    {
+        auto next = std::lower_bound(m_FreeRanges.begin(), m_FreeRanges.end(), offset, [](const Range& range, uint64_t offset) { return range.Offset < offset; });
+        bool mergePrevious = next != m_FreeRanges.begin() && std::prev(next)->Offset + std::prev(next)->Size == offset;
+        bool mergeNext = next != m_FreeRanges.end() && offset + size == next->Offset;
+
+        if (mergePrevious && mergeNext)
+        {
+            std::prev(next)->Size += size + next->Size;
+            m_FreeRanges.erase(next);
+        }
+        else if (mergePrevious)
+        {
+            std::prev(next)->Size += size;
+        }
+        else if (mergeNext)
+        {
+            next->Offset = offset;
+            next->Size += size;
+        }
+        else
+        {
+            m_FreeRanges.insert(next, { offset, size });
+        }
+
+        m_FreeSize += size;
+    }
+
+    uint64_t OffsetAllocator::GetLargestFreeRange() const
+    {
+        uint64_t largest = 0;
+        for (const Range& range : m_FreeRanges)
+            largest = std::max(largest, range.Size);
+        return largest;
+    }
+
+    void GPUAllocator::Init(VkPhysicalDevice physicalDevice, VkDevice device)
+    {
+        m_Device = device;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+    }
+
+    void GPUAllocator::Shutdown()
+    {
+        for (std::vector<Block>& blocks : m_Blocks)
+        {
+            for (Block& block : blocks)
+            {
+                if (block.Mapped)
+                    vkUnmapMemory(m_Device, block.Memory);
+                vkFreeMemory(m_Device, block.Memory, nullptr);
+            }
+            blocks.clear();
+        }
+    }
+
+    uint32_t GPUAllocator::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const
+    {
+        for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+            if ((m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties && typeBits & (1 << i))
+                return i;
+        return 0xFFFFFFFF; // Unable to find memoryType
+    }
+
+    GPUAllocation GPUAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+    {
+        uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, required | preferred);
+        if (memoryType == 0xFFFFFFFF)
+            memoryType = FindMemoryType(requirements.memoryTypeBits, required);
+        if (memoryType == 0xFFFFFFFF)
+        {
+            std::cout << "No memory type for GPU allocation of " << requirements.size << " bytes" << std::endl;
+            return {};
+        }
+
+        m_SubAllocations++;
+
+        std::vector<Block>& blocks = m_Blocks[memoryType];
+        for (uint32_t i = 0; i < (uint32_t)blocks.size(); i++)
+        {
+            Block& block = blocks[i];
+            uint64_t offset = block.Allocator->Allocate(requirements.size, requirements.alignment);
+            if (offset == OffsetAllocator::InvalidOffset)
+                continue;
+
+            block.AllocationCount++;
+            return { block.Memory, offset, requirements.size, block.Mapped ? (uint8_t*)block.Mapped + offset : nullptr, memoryType, i };
+        }
+
+        // Nothing fits, start a new block (oversized resources get a block of their own size)
+        Block block;
+        VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        allocInfo.allocationSize = std::max(BlockSize, AlignUp(requirements.size, requirements.alignment));
+        allocInfo.memoryTypeIndex = memoryType;
+        VkResult result = vkAllocateMemory(m_Device, &allocInfo, nullptr, &block.Memory);
+        if (result != VK_SUCCESS)
+        {
+            std::cout << "Vulkan error: " << vkb::to_string(result) << " allocating " << allocInfo.allocationSize << " bytes" << std::endl;
+            return {};
+        }
+        m_DeviceAllocations++;
+
+        // Only coherent memory is mapped, so writes through Mapped never need flushing
+        constexpr VkMemoryPropertyFlags mappable = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        if ((m_MemoryProperties.memoryTypes[memoryType].propertyFlags & mappable) == mappable)
+            VK_CHECK(vkMapMemory(m_Device, block.Memory, 0, VK_WHOLE_SIZE, 0, &block.Mapped));
+
+        block.Allocator = std::make_unique<OffsetAllocator>(allocInfo.allocationSize);
+        uint64_t offset = block.Allocator->Allocate(requirements.size, requirements.alignment);
+        block.AllocationCount++;
+
+        blocks.push_back(std::move(block));
+        const Block& newBlock = blocks.back();
+        return { newBlock.Memory, offset, requirements.size, newBlock.Mapped ? (uint8_t*)newBlock.Mapped + offset : nullptr, memoryType, (uint32_t)blocks.size() - 1 };
+    }
+
+    void GPUAllocator::Free(const GPUAllocation& allocation)
+    {
+        if (!allocation)
+            return;
+
+        // Blocks stay around empty; the next allocation of this type reuses them
+        Block& block = m_Blocks[allocation.MemoryType][allocation.BlockIndex];
+        block.Allocator->Free(allocation.Offset, allocation.Size);
+        block.AllocationCount--;
+    }
+
+    Buffer GPUAllocator::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+    {
+        Buffer buffer;
+
+        VkBufferCreateInfo bufferCI = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bufferCI.size = size;
+        bufferCI.usage = usage;
+        bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VK_CHECK(vkCreateBuffer(m_Device, &bufferCI, nullptr, &buffer.Handle));
+        if (buffer.Handle == VK_NULL_HANDLE)
+            return buffer;
+
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(m_Device, buffer.Handle, &req);
+        buffer.Allocation = Allocate(req, required, preferred);
+        if (!buffer.Allocation)
+        {
+            vkDestroyBuffer(m_Device, buffer.Handle, nullptr);
+            buffer.Handle = VK_NULL_HANDLE;
+            return buffer;
+        }
+
+        VK_CHECK(vkBindBufferMemory(m_Device, buffer.Handle, buffer.Allocation.Memory, buffer.Allocation.Offset));
+        buffer.Size = size;
+        return buffer;
+    }
+
+    void GPUAllocator::DestroyBuffer(Buffer& buffer)
+    {
+        if (buffer.Handle != VK_NULL_HANDLE)
+            vkDestroyBuffer(m_Device, buffer.Handle, nullptr);
+        Free(buffer.Allocation);
+        buffer = {};
+    }
+
+    GPUMemoryStats GPUAllocator::GetStats() const
+    {
+        GPUMemoryStats stats;
+        stats.DeviceAllocations = m_DeviceAllocations;
+        stats.SubAllocations = m_SubAllocations;
+
+        uint64_t freeBytes = 0, largestFreeRanges = 0;
+        for (const std::vector<Block>& blocks : m_Blocks)
+        {
+            for (const Block& block : blocks)
+            {
+                stats.BlockCount++;
+                stats.ReservedBytes += block.Allocator->GetSize();
+                stats.UsedBytes += block.Allocator->GetSize() - block.Allocator->GetFreeSize();
+                stats.AllocationCount += block.AllocationCount;
+
+                freeBytes += block.Allocator->GetFreeSize();
+                largestFreeRanges += block.Allocator->GetLargestFreeRange();
+            }
+        }
+
+        if (freeBytes > 0)
+            stats.Fragmentation = 1.0f - (float)((double)largestFreeRanges / (double)freeBytes);
+        return stats;
+    }
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "Vulkan.h"
+
+namespace Cubed
+{
+    //
+    // OffsetAllocator - first-fit free list over one block's offset range. Free ranges are
+    // kept sorted by offset and merged with their neighbours on free, so a block that is
+    // completely freed is one range again. Knows nothing about Vulkan.
+    //
+    class OffsetAllocator
+    {
+    public:
+        static constexpr uint64_t InvalidOffset = ~0ull;
+    public:
+        explicit OffsetAllocator(uint64_t size);
+
+        // Returns InvalidOffset if no free range fits
+        uint64_t Allocate(uint64_t size, uint64_t alignment);
+        void Free(uint64_t offset, uint64_t size);
+
+        uint64_t GetSize() const { return m_Size; }
+        uint64_t GetFreeSize() const { return m_FreeSize; }
+        uint64_t GetLargestFreeRange() const;
+        uint32_t GetFreeRangeCount() const { return (uint32_t)m_FreeRanges.size(); }
+    private:
+        struct Range
+        {
+            uint64_t Offset;
+            uint64_t Size;
+        };
+
+        uint64_t m_Size;
+        uint64_t m_FreeSize;
+        std::vector<Range> m_FreeRanges;
+    };
+
+    struct GPUAllocation
+    {
+        VkDeviceMemory Memory = VK_NULL_HANDLE;
+        VkDeviceSize Offset = 0;
+        VkDeviceSize Size = 0;
+        void* Mapped = nullptr; // set for host-visible, host-coherent memory, which is always mapped
+
+        uint32_t MemoryType = 0;
+        uint32_t BlockIndex = 0;
+
+        explicit operator bool() const { return Memory != VK_NULL_HANDLE; }
+    };
+
+    struct Buffer
+    {
+        VkBuffer Handle = VK_NULL_HANDLE;
+        GPUAllocation Allocation;
+        VkDeviceSize Size = 0;
+    };
+
+    struct GPUMemoryStats
+    {
+        uint32_t BlockCount = 0;
+        uint64_t ReservedBytes = 0; // in device memory blocks
+        uint64_t UsedBytes = 0; // handed out
+        uint32_t AllocationCount = 0; // live sub-allocations
+        uint64_t DeviceAllocations = 0; // vkAllocateMemory calls, ever
+        uint64_t SubAllocations = 0; // Allocate() calls, ever
+
+        // 1 - largest free range / total free: 0 when all free space is contiguous within each block
+        float Fragmentation = 0.0f;
+    };
+
+    //
+    // GPUAllocator - hands out ranges of large VkDeviceMemory blocks instead of making one
+    // device allocation per resource (drivers cap the number of those, and they are slow).
+    // Blocks are per memory type and never freed before Shutdown, so once the working set is
+    // reached allocating and freeing never touches the driver.
+    //
+    // Only buffers are allocated from it, so bufferImageGranularity doesn't apply.
+    //
+    class GPUAllocator
+    {
+    public:
+        static constexpr VkDeviceSize BlockSize = 16 * 1024 * 1024;
+    public:
+        void Init(VkPhysicalDevice physicalDevice, VkDevice device);
+        void Shutdown();
+
+        // `required` properties must be present; `preferred` ones are used if some memory type has them
+        GPUAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0);
+        void Free(const GPUAllocation& allocation);
+
+        // Creates a buffer bound to a sub-allocation; Handle is VK_NULL_HANDLE on failure
+        Buffer CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0);
+        // The caller makes sure the GPU is done with it
+        void DestroyBuffer(Buffer& buffer);
+
+        GPUMemoryStats GetStats() const;
+    private:
+        struct Block
+        {
+            VkDeviceMemory Memory = VK_NULL_HANDLE;
+            void* Mapped = nullptr;
+            std::unique_ptr<OffsetAllocator> Allocator;
+            uint32_t AllocationCount = 0;
+        };
+
+        uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+    private:
+        VkDevice m_Device = VK_NULL_HANDLE;
+        VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+
+        std::vector<Block> m_Blocks[VK_MAX_MEMORY_TYPES];
+
+        uint64_t m_DeviceAllocations = 0;
+        uint64_t m_SubAllocations = 0;
+    };
+
+}
@@ -0,0 +1,114 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef WL_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Cubed
+{
+#ifdef WL_PLATFORM_WINDOWS
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+        m_FileHandle = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            Close();
+            return;
+        }
+
+        m_MappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_MappingHandle)
+        {
+            Close();
+            return;
+        }
+
+        m_Data = (const uint8_t*)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+        m_Size = m_Data ? (uint64_t)size.QuadPart : 0;
+        if (!m_Data)
+            Close();
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_MappingHandle)
+            CloseHandle(m_MappingHandle);
+        if (m_FileHandle)
+            CloseHandle(m_FileHandle);
+
+        m_Data = nullptr;
+        m_Size = 0;
+        m_MappingHandle = nullptr;
+        m_FileHandle = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return;
+
+        // The mapping stays valid after the descriptor is closed
+        struct stat status;
+        if (fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED)
+            {
+                m_Data = (const uint8_t*)data;
+                m_Size = (uint64_t)status.st_size;
+            }
+        }
+        close(file);
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            munmap((void*)m_Data, (size_t)m_Size);
+
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+#endif
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        Close();
+        std::swap(m_Data, other.m_Data);
+        std::swap(m_Size, other.m_Size);
+#ifdef WL_PLATFORM_WINDOWS
+        std::swap(m_FileHandle, other.m_FileHandle);
+        std::swap(m_MappingHandle, other.m_MappingHandle);
+#endif
+        return *this;
+    }
+}
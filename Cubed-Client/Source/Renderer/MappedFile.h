@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+
+namespace Cubed
+{
+    //
+    // MappedFile - read-only memory mapping of a whole file, so shaders and caches are read
+    // straight from the page cache instead of being copied into a temporary buffer.
+    //
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path& path);
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // False if the file couldn't be opened or is empty
+        bool IsValid() const { return m_Data != nullptr; }
+        const uint8_t* GetData() const { return m_Data; }
+        uint64_t GetSize() const { return m_Size; }
+    private:
+        void Close();
+    private:
+        const uint8_t* m_Data = nullptr;
+        uint64_t m_Size = 0;
+#ifdef WL_PLATFORM_WINDOWS
+        void* m_FileHandle = nullptr;
+        void* m_MappingHandle = nullptr;
+#endif
+    };
+}
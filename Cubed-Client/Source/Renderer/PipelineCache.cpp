@@ -0,0 +1,114 @@
+#include "PipelineCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace Cubed
+{
+    // VkPipelineCacheHeaderVersionOne, as laid out at the start of the cache data
+    struct PipelineCacheHeader
+    {
+        uint32_t HeaderSize;
+        uint32_t HeaderVersion;
+        uint32_t VendorID;
+        uint32_t DeviceID;
+        uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+    };
+
+    static bool IsCompatible(const uint8_t* data, uint64_t size, const VkPhysicalDeviceProperties& properties)
+    {
+        if (size < sizeof(PipelineCacheHeader))
+            return false;
+
+        PipelineCacheHeader header;
+        memcpy(&header, data, sizeof(header));
+        return header.HeaderSize >= sizeof(PipelineCacheHeader)
+            && header.HeaderVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.VendorID == properties.vendorID
+            && header.DeviceID == properties.deviceID
+            && memcmp(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void PipelineCache::Init(const std::filesystem::path& path, VkPhysicalDevice physicalDevice, VkDevice device)
+    {
+        m_Path = path;
+        m_Device = device;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        MappedFile file(path);
+        m_Warm = file.IsValid() && IsCompatible(file.GetData(), file.GetSize(), properties);
+        if (file.IsValid() && !m_Warm)
+            std::cout << "Pipeline cache " << path << " is from another device or driver, starting a new one" << std::endl;
+
+        VkPipelineCacheCreateInfo cacheCI{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+        if (m_Warm)
+        {
+            cacheCI.initialDataSize = (size_t)file.GetSize();
+            cacheCI.pInitialData = file.GetData();
+        }
+
+        VkResult result = vkCreatePipelineCache(device, &cacheCI, nullptr, &m_Cache);
+        if (result != VK_SUCCESS && m_Warm)
+        {
+            // The driver can still reject data that passed the header check
+            std::cout << "Pipeline cache " << path << " rejected (" << vkb::to_string(result) << "), starting a new one" << std::endl;
+            m_Warm = false;
+            cacheCI.initialDataSize = 0;
+            cacheCI.pInitialData = nullptr;
+            result = vkCreatePipelineCache(device, &cacheCI, nullptr, &m_Cache);
+        }
+        VK_CHECK(result);
+
+        m_LoadedSize = m_Warm ? (size_t)file.GetSize() : 0;
+        m_SavedSize = m_LoadedSize;
+    }
+
+    void PipelineCache::Save()
+    {
+        if (m_Cache == VK_NULL_HANDLE)
+            return;
+
+        size_t size = 0;
+        VK_CHECK(vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr));
+        // Caches only grow, so the same size means nothing new was compiled
+        if (size == 0 || size == m_SavedSize)
+            return;
+
+        std::vector<uint8_t> data(size);
+        VK_CHECK(vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data()));
+
+        // Write next to it and rename, so a crash mid-write can't leave a truncated cache behind
+        std::filesystem::path temporaryPath = m_Path;
+        temporaryPath += ".tmp";
+        {
+            std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!stream.write((const char*)data.data(), (std::streamsize)size))
+            {
+                std::cout << "Failed to write pipeline cache " << temporaryPath << std::endl;
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, m_Path, error);
+        if (error)
+        {
+            std::cout << "Failed to write pipeline cache " << m_Path << ": " << error.message() << std::endl;
+            return;
+        }
+
+        m_SavedSize = size;
+    }
+
+    void PipelineCache::Shutdown()
+    {
+        Save();
+        vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+        m_Cache = VK_NULL_HANDLE;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <filesystem>
+
+#include "Vulkan.h"
+
+namespace Cubed
+{
+    //
+    // PipelineCache - VkPipelineCache persisted to disk between runs, so pipelines compiled
+    // once are only looked up on later startups. The file is only used if its header matches
+    // this device (vendor, device and pipelineCacheUUID, which changes with the driver);
+    // anything else starts an empty cache. Vulkan caches are internally synchronized, so
+    // pipelines can be created against it from several threads at once.
+    //
+    class PipelineCache
+    {
+    public:
+        void Init(const std::filesystem::path& path, VkPhysicalDevice physicalDevice, VkDevice device);
+        // Writes the cache back if it changed since it was loaded or last saved
+        void Save();
+        void Shutdown();
+
+        VkPipelineCache GetHandle() const { return m_Cache; }
+        // True if a valid cache for this device was loaded from disk
+        bool IsWarm() const { return m_Warm; }
+        size_t GetLoadedSize() const { return m_LoadedSize; }
+    private:
+        std::filesystem::path m_Path;
+        VkDevice m_Device = VK_NULL_HANDLE;
+        VkPipelineCache m_Cache = VK_NULL_HANDLE;
+
+        bool m_Warm = false;
+        size_t m_LoadedSize = 0;
+        size_t m_SavedSize = 0;
+    };
+}
@@ -0,0 +1,182 @@
+#include "QuadPipeline.h"
+
+#include <array>
+#include <cstddef>
+
+#include "MappedFile.h"
+
+namespace Cubed
+{
+    VkPipeline CreateQuadPipeline(VkDevice device, VkRenderPass renderPass, VkPipelineLayout layout, VkPipelineCache cache, const std::filesystem::path& shaderDirectory)
+    {
+        // Load our SPIR-V shaders.
+        VkShaderModule vertexShader = LoadShaderModule(device, shaderDirectory / "quad.vert.spirv");
+        VkShaderModule fragmentShader = LoadShaderModule(device, shaderDirectory / "quad.frag.spirv");
+        if (!vertexShader || !fragmentShader)
+        {
+            vkDestroyShaderModule(device, vertexShader, nullptr);
+            vkDestroyShaderModule(device, fragmentShader, nullptr);
+            return VK_NULL_HANDLE;
+        }
+
+        // Binding 0 is the unit quad, binding 1 advances once per instance.
+        std::array<VkVertexInputBindingDescription, 2> bindings{};
+        bindings[0].binding   = 0;
+        bindings[0].stride    = sizeof(glm::vec2);
+        bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindings[1].binding   = 1;
+        bindings[1].stride    = sizeof(QuadInstance);
+        bindings[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+        std::array<VkVertexInputAttributeDescription, 3> attributes{};
+        attributes[0] = { 0, 0, VK_FORMAT_R32G32_SFLOAT, 0 };
+        attributes[1] = { 1, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(QuadInstance, Position) };
+        attributes[2] = { 2, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(QuadInstance, Color) };
+
+        VkPipelineVertexInputStateCreateInfo vertex_input{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+        vertex_input.vertexBindingDescriptionCount   = (uint32_t)bindings.size();
+        vertex_input.pVertexBindingDescriptions      = bindings.data();
+        vertex_input.vertexAttributeDescriptionCount = (uint32_t)attributes.size();
+        vertex_input.pVertexAttributeDescriptions    = attributes.data();
+
+        // Specify we will use triangle lists to draw geometry.
+        VkPipelineInputAssemblyStateCreateInfo input_assembly{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+        input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        // Specify rasterization state.
+        VkPipelineRasterizationStateCreateInfo raster{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+        // Flat 2D quads, nothing to cull.
+        raster.cullMode  = VK_CULL_MODE_NONE;
+        raster.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        raster.lineWidth = 1.0f;
+
+        // Our attachment will write to all color channels, but no blending is enabled.
+        VkPipelineColorBlendAttachmentState blend_attachment{};
+        blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+        VkPipelineColorBlendStateCreateInfo blend{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+        blend.attachmentCount = 1;
+        blend.pAttachments    = &blend_attachment;
+
+        // We will have one viewport and scissor box.
+        VkPipelineViewportStateCreateInfo viewport{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+        viewport.viewportCount = 1;
+        viewport.scissorCount  = 1;
+
+        // Disable all depth testing.
+        VkPipelineDepthStencilStateCreateInfo depth_stencil{VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+
+        // No multisampling.
+        VkPipelineMultisampleStateCreateInfo multisample{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        // Specify that these states will be dynamic, i.e. not part of pipeline state object.
+        std::array<VkDynamicState, 2> dynamics{VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+        VkPipelineDynamicStateCreateInfo dynamic{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+        dynamic.pDynamicStates    = dynamics.data();
+        dynamic.dynamicStateCount = (uint32_t)dynamics.size();
+
+        std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages{};
+
+        // Vertex stage of the pipeline
+        shader_stages[0].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shader_stages[0].stage  = VK_SHADER_STAGE_VERTEX_BIT;
+        shader_stages[0].module = vertexShader;
+        shader_stages[0].pName  = "main";
+
+        // Fragment stage of the pipeline
+        shader_stages[1].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shader_stages[1].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shader_stages[1].module = fragmentShader;
+        shader_stages[1].pName  = "main";
+
+        VkGraphicsPipelineCreateInfo pipe{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+        pipe.stageCount          = (uint32_t)shader_stages.size();
+        pipe.pStages             = shader_stages.data();
+        pipe.pVertexInputState   = &vertex_input;
+        pipe.pInputAssemblyState = &input_assembly;
+        pipe.pRasterizationState = &raster;
+        pipe.pColorBlendState    = &blend;
+        pipe.pMultisampleState   = &multisample;
+        pipe.pViewportState      = &viewport;
+        pipe.pDepthStencilState  = &depth_stencil;
+        pipe.pDynamicState       = &dynamic;
+
+        // We need to specify the pipeline layout and the render pass description up front as well.
+        pipe.renderPass = renderPass;
+        pipe.layout     = layout;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VK_CHECK(vkCreateGraphicsPipelines(device, cache, 1, &pipe, nullptr, &pipeline));
+
+        // Pipeline is baked, we can delete the shader modules now.
+        vkDestroyShaderModule(device, vertexShader, nullptr);
+        vkDestroyShaderModule(device, fragmentShader, nullptr);
+        return pipeline;
+    }
+
+    VkPipelineLayout CreateQuadPipelineLayout(VkDevice device)
+    {
+        VkPushConstantRange push_constants{};
+        push_constants.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        push_constants.size       = 2 * sizeof(glm::vec2);
+
+        VkPipelineLayoutCreateInfo layout_info{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        layout_info.pushConstantRangeCount = 1;
+        layout_info.pPushConstantRanges    = &push_constants;
+
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VK_CHECK(vkCreatePipelineLayout(device, &layout_info, nullptr, &layout));
+        return layout;
+    }
+
+    VkShaderModule LoadShaderModule(VkDevice device, const std::filesystem::path& path)
+    {
+        // Mapped, so the SPIR-V goes from the page cache straight to the driver (and mappings
+        // are page aligned, as pCode needs)
+        MappedFile file(path);
+        if (!file.IsValid())
+        {
+            std::cout << "Failed to load shader " << path << std::endl;
+            return VK_NULL_HANDLE;
+        }
+
+        VkShaderModuleCreateInfo shaderModuleCI{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+        shaderModuleCI.pCode = (const uint32_t*)file.GetData();
+        shaderModuleCI.codeSize = (size_t)file.GetSize();
+
+        VkShaderModule result = VK_NULL_HANDLE;
+        VK_CHECK(vkCreateShaderModule(device, &shaderModuleCI, nullptr, &result));
+        return result;
+    }
+
+    void RecordQuadDraw(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkPipelineLayout layout, const QuadDraw& draw)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+        // Not flipped, so clip space y points down like window pixels do
+        VkViewport vp{};
+        vp.width    = draw.TargetSize.x;
+        vp.height   = draw.TargetSize.y;
+        vp.minDepth = 0.0f;
+        vp.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &vp);
+
+        VkRect2D scissor{};
+        scissor.extent.width  = (uint32_t)draw.TargetSize.x;
+        scissor.extent.height = (uint32_t)draw.TargetSize.y;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        VkBuffer vertexBuffers[2] = { draw.VertexBuffer, draw.InstanceBuffer };
+        VkDeviceSize offsets[2] = { 0, draw.InstanceOffset };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, draw.IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+        glm::vec2 pushConstants[2] = { 2.0f / draw.TargetSize, draw.QuadSize };
+        vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), pushConstants);
+
+        // Every quad in one draw
+        vkCmdDrawIndexed(commandBuffer, 6, draw.InstanceCount, 0, 0, 0);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+
+#include "glm/glm.hpp"
+
+#include "Vulkan.h"
+
+namespace Cubed
+{
+    // Per-instance vertex data, matches the attributes in quad.vert.glsl
+    struct QuadInstance
+    {
+        glm::vec2 Position; // top-left corner in pixels, from the top-left of the target
+        uint32_t Color; // 0xAABBGGRR like ImGui colors, read as RGBA8 unorm
+    };
+
+    // Unit quad, scaled and positioned per instance in the vertex shader
+    static constexpr float QuadVertices[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+    static constexpr uint32_t QuadIndices[] = { 0, 1, 2, 2, 3, 0 };
+
+    //
+    // Quad pipeline - the state and draw recording behind Renderer's instanced quads, kept apart
+    // from Walnut's window so the quad render benchmark builds and draws with exactly this code.
+    //
+    // Shaders are loaded from `shaderDirectory` (quad.vert.spirv, quad.frag.spirv). Returns
+    // VK_NULL_HANDLE if either fails to load.
+    VkPipeline CreateQuadPipeline(VkDevice device, VkRenderPass renderPass, VkPipelineLayout layout, VkPipelineCache cache, const std::filesystem::path& shaderDirectory);
+    // No descriptors, just the pixel-to-clip scale and quad size as vertex stage push constants
+    VkPipelineLayout CreateQuadPipelineLayout(VkDevice device);
+    VkShaderModule LoadShaderModule(VkDevice device, const std::filesystem::path& path);
+
+    struct QuadDraw
+    {
+        VkBuffer VertexBuffer = VK_NULL_HANDLE; // QuadVertices
+        VkBuffer IndexBuffer = VK_NULL_HANDLE; // QuadIndices
+        VkBuffer InstanceBuffer = VK_NULL_HANDLE;
+        VkDeviceSize InstanceOffset = 0;
+        uint32_t InstanceCount = 0;
+
+        glm::vec2 TargetSize{ 0.0f, 0.0f }; // pixels
+        glm::vec2 QuadSize{ 0.0f, 0.0f }; // pixels
+    };
+
+    // Every instance in one vkCmdDrawIndexed, inside a render pass compatible with the pipeline's.
+    // Sets its own viewport and scissor to the whole target.
+    void RecordQuadDraw(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkPipelineLayout layout, const QuadDraw& draw);
+}
@@ -1,244 +1,165 @@
 ﻿#include "Renderer.h"
 
-#include <array>
-#include <fstream>
-#include <glm/vec3.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
 
 #include "Walnut/Application.h"
 
 namespace Cubed
 {
 
-	static uint32_t ImGui_ImplVulkan_MemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
-	{
-		VkPhysicalDevice physicalDevice = Cubed::GetVulkanInfo()->PhysicalDevice;
-		VkPhysicalDeviceMemoryProperties prop;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &prop);
-		for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
-			if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
-				return i;
-		return 0xFFFFFFFF; // Unable to find memoryType
-	}
-	
     void Renderer::Init()
     {
-    	InitPipeline();
+    	m_Allocator.Init(GetVulkanInfo()->PhysicalDevice, GetVulkanInfo()->Device);
+    	m_UploadRing.Init(m_Allocator, s_InitialUploadFrameSize, Walnut::Application::GetMainWindowData()->ImageCount);
+
+    	m_PipelineCache.Init(s_PipelineCachePath, GetVulkanInfo()->PhysicalDevice, GetVulkanInfo()->Device);
+    	InitPipelines();
 		InitBuffers();
     }
 
     void Renderer::Shutdown()
     {
-    	
+    	VkDevice device = GetVulkanInfo()->Device;
+    	VK_CHECK(vkDeviceWaitIdle(device));
+
+    	m_UploadRing.Shutdown();
+    	m_Allocator.DestroyBuffer(m_VertexBuffer);
+    	m_Allocator.DestroyBuffer(m_IndexBuffer);
+    	m_Allocator.Shutdown();
+
+    	vkDestroyPipeline(device, m_GraphicsPipeline, nullptr);
+    	vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+    	m_GraphicsPipeline = nullptr;
+    	m_PipelineLayout = nullptr;
+    	m_PipelineCache.Shutdown();
+    }
+
+    void Renderer::BeginQuads(glm::vec2 size)
+    {
+    	m_QuadInstances.clear();
+    	m_QuadSize = size;
     }
 
 	void Renderer::Render()
     {
+    	uint64_t subAllocations = m_Allocator.GetStats().SubAllocations;
+    	m_Stats = {};
+
     	VkCommandBuffer commandBuffer = Walnut::Application::GetActiveCommandBuffer();
     	auto wd =  Walnut::Application::GetMainWindowData();
-    	// Bind the graphics pipeline.
-    	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
-
-    	VkViewport vp{};
-    	vp.y = static_cast<float>(wd->Height);
-    	vp.width    = static_cast<float>(wd->Width);
-    	vp.height   = -static_cast<float>(wd->Height);
-    	vp.minDepth = 0.0f;
-    	vp.maxDepth = 1.0f;
-    	// Set viewport dynamically
-    	vkCmdSetViewport(commandBuffer, 0, 1, &vp);
-
-    	VkRect2D scissor{};
-    	scissor.extent.width  = static_cast<uint32_t>(wd->Width);
-    	scissor.extent.height = static_cast<uint32_t>(wd->Height);
-    	// Set scissor dynamically
-    	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-    	// Draw three vertices with one instance.
-    	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 
+    	// This swapchain image's previous frame has completed (its fence was waited on), so its
+    	// region of the upload ring is free again
+    	uint32_t instanceCount = (uint32_t)m_QuadInstances.size();
+    	uint64_t instanceBytes = (uint64_t)instanceCount * sizeof(QuadInstance);
+    	m_UploadRing.BeginFrame(wd->FrameIndex, wd->ImageCount, instanceBytes);
+
+    	// No quad pipeline (its shaders failed to load): nothing to draw with, so skip the pass
+    	bool canDraw = instanceCount && m_GraphicsPipeline != VK_NULL_HANDLE;
+    	UploadAllocation instances = canDraw ? m_UploadRing.Allocate(instanceBytes, alignof(QuadInstance)) : UploadAllocation{};
+    	if (!instances)
+    	{
+    		UpdateStats(subAllocations);
+    		m_QuadInstances.clear();
+    		return;
+    	}
+
+    	// Coherent memory, no flush needed
+    	memcpy(instances.Data, m_QuadInstances.data(), instanceBytes);
+
+    	QuadDraw draw;
+    	draw.VertexBuffer = m_VertexBuffer.Handle;
+    	draw.IndexBuffer = m_IndexBuffer.Handle;
+    	draw.InstanceBuffer = instances.Buffer;
+    	draw.InstanceOffset = instances.Offset;
+    	draw.InstanceCount = instanceCount;
+    	draw.TargetSize = { (float)wd->Width, (float)wd->Height };
+    	draw.QuadSize = m_QuadSize;
+    	RecordQuadDraw(commandBuffer, m_GraphicsPipeline, m_PipelineLayout, draw);
+
+    	m_Stats.QuadCount = instanceCount;
+    	m_Stats.DrawCalls = 1;
+    	m_Stats.InstanceBytes = instanceBytes;
+    	UpdateStats(subAllocations);
+    	m_QuadInstances.clear();
+    }
+
+    void Renderer::UpdateStats(uint64_t subAllocationsBeforeFrame)
+    {
+    	m_Stats.Memory = m_Allocator.GetStats();
+    	m_Stats.PipelineCreationTime = m_PipelineCreationTime;
+    	m_Stats.PipelineCacheWarm = m_PipelineCache.IsWarm();
+    	m_Stats.FrameAllocations = (uint32_t)(m_Stats.Memory.SubAllocations - subAllocationsBeforeFrame);
+    	m_Stats.UploadBytes = m_UploadRing.GetFrameUsed();
+    	m_Stats.UploadCapacity = m_UploadRing.GetFrameSize();
     }
-1:31:00
 	
-    void Renderer::InitPipeline()
+    void Renderer::InitPipelines()
     {
     	VkDevice device = GetVulkanInfo()->Device;
-		VkRenderPass renderPass = Walnut::Application::GetMainWindowData()->RenderPass;
-    	
-        	// Create a blank pipeline layout.
-	// We are not binding any resources to the pipeline in this first sample.
-	VkPipelineLayoutCreateInfo layout_info{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-	VK_CHECK(vkCreatePipelineLayout(device, &layout_info, nullptr, &m_PipelineLayout));
-
-	VkPipelineVertexInputStateCreateInfo vertex_input{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-
-	// Specify we will use triangle lists to draw geometry.
-	VkPipelineInputAssemblyStateCreateInfo input_assembly{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
-	input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-	// Specify rasterization state.
-	VkPipelineRasterizationStateCreateInfo raster{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
-	raster.cullMode  = VK_CULL_MODE_BACK_BIT;
-	raster.frontFace = VK_FRONT_FACE_CLOCKWISE;
-	raster.lineWidth = 1.0f;
-
-	// Our attachment will write to all color channels, but no blending is enabled.
-	VkPipelineColorBlendAttachmentState blend_attachment{};
-	blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-	VkPipelineColorBlendStateCreateInfo blend{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
-	blend.attachmentCount = 1;
-	blend.pAttachments    = &blend_attachment;
-
-	// We will have one viewport and scissor box.
-	VkPipelineViewportStateCreateInfo viewport{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
-	viewport.viewportCount = 1;
-	viewport.scissorCount  = 1;
-
-	// Disable all depth testing.
-	VkPipelineDepthStencilStateCreateInfo depth_stencil{VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
-
-	// No multisampling.
-	VkPipelineMultisampleStateCreateInfo multisample{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
-	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-	// Specify that these states will be dynamic, i.e. not part of pipeline state object.
-	std::array<VkDynamicState, 2> dynamics{VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
-
-	VkPipelineDynamicStateCreateInfo dynamic{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
-	dynamic.pDynamicStates    = dynamics.data();
-	dynamic.dynamicStateCount =(uint32_t)dynamics.size();
-
-	// Load our SPIR-V shaders.
-	std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages{};
-	//
-	// Vertex stage of the pipeline
-	shader_stages[0].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	shader_stages[0].stage  = VK_SHADER_STAGE_VERTEX_BIT;
-	shader_stages[0].module = LoadShader("Assets/Shaders/bin/basic.vert.spirv");
-	shader_stages[0].pName  = "main";
-	
-	// Fragment stage of the pipeline
-	shader_stages[1].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	shader_stages[1].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
-	shader_stages[1].module = LoadShader("Assets/Shaders/bin/basic.frag.spirv");
-	shader_stages[1].pName  = "main";
-
-	VkGraphicsPipelineCreateInfo pipe{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
-	pipe.stageCount          = (uint32_t)shader_stages.size();
-	pipe.pStages             = shader_stages.data();
-	pipe.pVertexInputState   = &vertex_input;
-	pipe.pInputAssemblyState = &input_assembly;
-	pipe.pRasterizationState = &raster;
-	pipe.pColorBlendState    = &blend;
-	pipe.pMultisampleState   = &multisample;
-	pipe.pViewportState      = &viewport;
-	pipe.pDepthStencilState  = &depth_stencil;
-	pipe.pDynamicState       = &dynamic;
-
-	// We need to specify the pipeline layout and the render pass description up front as well.
-	pipe.renderPass = renderPass;
-	pipe.layout     = m_PipelineLayout;
-    	
-	VK_CHECK(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipe, nullptr, &m_GraphicsPipeline));
-
-	// Pipeline is baked, we can delete the shader modules now.
-	vkDestroyShaderModule(device, shader_stages[0].module, nullptr);
-	vkDestroyShaderModule(device, shader_stages[1].module, nullptr);
-    }
+    	auto start = std::chrono::steady_clock::now();
 
-	void Renderer::InitBuffers()
+	// Layouts are cheap, so they're made up front
+	m_PipelineLayout = CreateQuadPipelineLayout(device);
+
+	// Each pipeline loads its shaders and compiles on its own worker thread, all against the
+	// shared (internally synchronized) cache. New pipelines go in this list.
+	std::vector<std::pair<VkPipeline*, std::future<VkPipeline>>> pipelines;
+	VkRenderPass renderPass = Walnut::Application::GetMainWindowData()->RenderPass;
+	pipelines.emplace_back(&m_GraphicsPipeline, std::async(std::launch::async, [=, this]() { return CreateQuadPipeline(device, renderPass, m_PipelineLayout, m_PipelineCache.GetHandle(), s_ShaderDirectory); }));
+
+	uint32_t failedCount = 0;
+	for (auto& [pipeline, future] : pipelines)
 	{
-		VkDevice device = GetVulkanInfo()->Device;
-		
-		glm::vec3 vertexData[3] ={
-		glm::vec3(-0.5f, -0.5f, 0.0f),
-		glm::vec3( 0.0f,  0.5f, 0.0f),
-		glm::vec3( 0.5f, -0.5f, 0.0f)
-		};
-		
-		uint32_t indices[3] = {0,1,2};
-		
-		m_VertexBuffer.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-		CreateOrResizeBuffer(m_VertexBuffer,sizeof(vertexData));
-		
-		m_IndexBuffer.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-		CreateOrResizeBuffer(m_IndexBuffer,sizeof(indices));
-
-		glm::vec3* vbMemory;
-		VK_CHECK(vkMapMemory(device,m_VertexBuffer.Memory, 0,sizeof(vertexData),0,(void**)&vbMemory));
-		memcpy(vbMemory,vertexData,sizeof(vertexData));
-		
-		uint32_t* ibMemory;
-		VK_CHECK(vkMapMemory(device,m_IndexBuffer.Memory, 0,sizeof(indices),0,(void**)&ibMemory));
-		memcpy(ibMemory,indices,sizeof(indices));
-		
-		VkMappedMemoryRange range[2] = {};
-		range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		range[0].memory = m_VertexBuffer.Memory;
-		range[0].size = VK_WHOLE_SIZE;
-		range[1].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		range[1].memory = m_IndexBuffer.Memory;
-		range[1].size = VK_WHOLE_SIZE;
-
-		VK_CHECK(vkFlushMappedMemoryRanges(device,2,range));
-		vkUnmapMemory(device,m_VertexBuffer.Memory);
-		vkUnmapMemory(device,m_IndexBuffer.Memory);
-		
+		*pipeline = future.get();
+		if (*pipeline == VK_NULL_HANDLE)
+			failedCount++;
 	}
 
-    VkShaderModule Renderer::LoadShader(const std::filesystem::path& path)
-    {
-    	std::ifstream stream(path, std::ios::binary);
+	// Render() skips passes whose pipeline is missing, so this is survivable, just visible
+	if (m_GraphicsPipeline == VK_NULL_HANDLE)
+		std::cout << "Failed to create the quad pipeline; players won't be drawn" << std::endl;
 
-    	if(!stream)
-    		return nullptr;
+	m_PipelineCreationTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Created " << pipelines.size() - failedCount << " of " << pipelines.size() << " pipelines in " << m_PipelineCreationTime << "ms ("
+		<< (m_PipelineCache.IsWarm() ? "warm" : "cold") << " pipeline cache, " << m_PipelineCache.GetLoadedSize() << " bytes loaded)" << std::endl;
 
-    	stream.seekg(0,std::ios_base::end);
-    	std::streampos size = stream.tellg();
-    	stream.seekg(0,std::ios_base::beg);
+	// Right away rather than at shutdown, so the next start is warm even if this one crashes
+	m_PipelineCache.Save();
+    }
 
-    	std::vector<char>  buffer(size);
-    	if(!stream.read(buffer.data(),size))
-    		return nullptr;
+	void Renderer::InitBuffers()
+	{
+		// Static, so device-local where possible (UploadToBuffer stages the copy if it isn't mappable)
+		m_VertexBuffer = m_Allocator.CreateBuffer(sizeof(QuadVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		m_IndexBuffer = m_Allocator.CreateBuffer(sizeof(QuadIndices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    	stream.close();
-    	
-    	VkShaderModuleCreateInfo shaderModuleCI{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-    	shaderModuleCI.pCode = (uint32_t*)buffer.data();
-    	shaderModuleCI.codeSize = buffer.size();
-    	VkDevice device = GetVulkanInfo()->Device;
-    	VkShaderModule result = nullptr;
-    	
-    	VK_CHECK(vkCreateShaderModule(device, &shaderModuleCI,nullptr, &result));
-    	return result;
-    }
+		UploadToBuffer(m_VertexBuffer, QuadVertices, sizeof(QuadVertices));
+		UploadToBuffer(m_IndexBuffer, QuadIndices, sizeof(QuadIndices));
+	}
 
-	void Renderer::CreateOrResizeBuffer(Buffer& buffer, size_t newSize)
+	void Renderer::UploadToBuffer(Buffer& buffer, const void* data, VkDeviceSize size)
     {
-    	VkDevice device = GetVulkanInfo()->Device;
-    	
-    	if (buffer.Handle != VK_NULL_HANDLE)
-    		vkDestroyBuffer(device, buffer.Handle, nullptr);
-    	if (buffer.Handle != VK_NULL_HANDLE)
-    		vkFreeMemory(device, buffer.Memory, nullptr);
-
-    	VkBufferCreateInfo bufferCI = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-    	bufferCI.size = newSize;
-    	bufferCI.usage = buffer.usage;
-    	bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    	VK_CHECK(vkCreateBuffer(device, &bufferCI, nullptr, &buffer.Handle));
-
-    	VkMemoryRequirements req;
-    	vkGetBufferMemoryRequirements(device, buffer.Handle, &req);
-    	//bd->BufferMemoryAlignment = (bd->BufferMemoryAlignment > req.alignment) ? bd->BufferMemoryAlignment : req.alignment;
-    	VkMemoryAllocateInfo alloc_info = {};
-    	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    	alloc_info.allocationSize = req.size;
-    	alloc_info.memoryTypeIndex = ImGui_ImplVulkan_MemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
-    	VK_CHECK(vkAllocateMemory(device, &alloc_info,nullptr, &buffer.Memory));
-
-    	VK_CHECK(vkBindBufferMemory(device, buffer.Handle, buffer.Memory, 0));
-    	buffer.Size = req.size;
+    	if (buffer.Allocation.Mapped)
+    	{
+    		memcpy(buffer.Allocation.Mapped, data, size);
+    		return;
+    	}
+
+    	// Device-local: copy through a staging buffer, which goes back to the allocator afterwards
+    	Buffer staging = m_Allocator.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    	memcpy(staging.Allocation.Mapped, data, size);
+
+    	VkCommandBuffer commandBuffer = Walnut::Application::GetCommandBuffer(true);
+    	VkBufferCopy region{};
+    	region.size = size;
+    	vkCmdCopyBuffer(commandBuffer, staging.Handle, buffer.Handle, 1, &region);
+    	Walnut::Application::FlushCommandBuffer(commandBuffer);
+
+    	m_Allocator.DestroyBuffer(staging);
     }
 
 }
@@ -1,36 +1,74 @@
 ﻿#pragma once
 
-#include <filesystem>
+#include <vector>
+
+#include "glm/glm.hpp"
 
 #include "Vulkan.h"
+#include "GPUAllocator.h"
+#include "UploadRing.h"
+#include "PipelineCache.h"
+#include "QuadPipeline.h"
 namespace  Cubed
 {
-    struct Buffer
+    struct RendererStats
     {
-        VkBuffer Handle;
-        VkDeviceMemory Memory;
-        VkDeviceSize Size = 0;
-        VkBufferUsageFlagBits usage = VK_BUFFER_USAGE_FLAG_BITS_MAX_ENUM;
+        uint32_t QuadCount = 0;
+        uint32_t DrawCalls = 0;
+        uint64_t InstanceBytes = 0; // uploaded last frame
+
+        GPUMemoryStats Memory;
+        uint32_t FrameAllocations = 0; // GPU sub-allocations made during the frame
+        uint64_t UploadBytes = 0; // upload ring bytes used by the frame
+        uint64_t UploadCapacity = 0; // per frame
+
+        float PipelineCreationTime = 0.0f; // at startup, milliseconds
+        bool PipelineCacheWarm = false;
     };
     
+    //
+    // All quads submitted in a frame are drawn with a single instanced draw: one unit quad
+    // mesh plus instance data written once per frame into the upload ring. Buffers are
+    // sub-allocated from GPUAllocator blocks, so a steady frame allocates nothing.
+    //
     class Renderer
     {
     public:
         void Init();
         void Shutdown();
+
+        // Quads for the next Render(), which draws and then clears them
+        void BeginQuads(glm::vec2 size);
+        void SubmitQuad(glm::vec2 position, uint32_t color) { m_QuadInstances.push_back({ position, color }); }
         
         void Render();
 
-
+        const RendererStats& GetStats() const { return m_Stats; }
     private:
-        void InitPipeline();
+        void InitPipelines();
         void InitBuffers();
-        void CreateOrResizeBuffer(Buffer& buffer, uint64_t newSize);
-        VkShaderModule LoadShader(const std::filesystem::path& path);
+        void UploadToBuffer(Buffer& buffer, const void* data, VkDeviceSize size);
+        void UpdateStats(uint64_t subAllocationsBeforeFrame);
     private:
         VkPipeline m_GraphicsPipeline = nullptr;
         VkPipelineLayout m_PipelineLayout = nullptr;
 
+        static constexpr const char* s_ShaderDirectory = "Assets/Shaders/bin";
+        static constexpr const char* s_PipelineCachePath = "PipelineCache.bin";
+        PipelineCache m_PipelineCache;
+        float m_PipelineCreationTime = 0.0f;
+
+        // Room for ~20k quads per frame before the ring has to grow
+        static constexpr VkDeviceSize s_InitialUploadFrameSize = 256 * 1024;
+
+        GPUAllocator m_Allocator;
+        UploadRing m_UploadRing;
+
         Buffer m_VertexBuffer, m_IndexBuffer;
+
+        std::vector<QuadInstance> m_QuadInstances;
+        glm::vec2 m_QuadSize{ 0.0f, 0.0f };
+
+        RendererStats m_Stats;
     };
 }
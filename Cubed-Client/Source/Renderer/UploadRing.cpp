@@ -0,0 +1,71 @@
+#include "UploadRing.h"
+
+#include <algorithm>
+
+namespace Cubed
+{
+    void UploadRing::Init(GPUAllocator& allocator, VkDeviceSize frameSize, uint32_t frameCount)
+    {
+        m_Allocator = &allocator;
+        Create(frameSize, frameCount);
+    }
+
+    void UploadRing::Shutdown()
+    {
+        m_Allocator->DestroyBuffer(m_Buffer);
+        m_FrameSize = 0;
+        m_FrameCount = 0;
+    }
+
+    void UploadRing::Create(VkDeviceSize frameSize, uint32_t frameCount)
+    {
+        m_Allocator->DestroyBuffer(m_Buffer);
+
+        m_Buffer = m_Allocator->CreateBuffer(frameSize * frameCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        m_FrameSize = m_Buffer.Handle != VK_NULL_HANDLE ? frameSize : 0;
+        m_FrameCount = frameCount;
+        m_FrameBegin = 0;
+        m_FrameUsed = 0;
+        m_RequiredFrameSize = 0;
+    }
+
+    void UploadRing::BeginFrame(uint32_t frameIndex, uint32_t frameCount, VkDeviceSize minFrameSize)
+    {
+        VkDeviceSize requiredFrameSize = std::max(minFrameSize, m_RequiredFrameSize);
+        if (requiredFrameSize > m_FrameSize || frameCount != m_FrameCount)
+        {
+            // Rare (the working set grew or the swapchain changed), so just wait for every
+            // frame still using the old buffer instead of retiring it per frame
+            VK_CHECK(vkDeviceWaitIdle(GetVulkanInfo()->Device));
+
+            VkDeviceSize frameSize = std::max<VkDeviceSize>(m_FrameSize, 1);
+            while (frameSize < requiredFrameSize)
+                frameSize *= 2;
+            Create(frameSize, frameCount);
+        }
+
+        m_FrameBegin = (VkDeviceSize)frameIndex * m_FrameSize;
+        m_FrameUsed = 0;
+    }
+
+    UploadAllocation UploadRing::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        alignment = std::max<VkDeviceSize>(alignment, 1);
+        VkDeviceSize offset = (m_FrameUsed + alignment - 1) / alignment * alignment;
+        if (offset + size > m_FrameSize)
+        {
+            m_RequiredFrameSize = std::max(m_RequiredFrameSize, offset + size);
+            return {};
+        }
+
+        m_FrameUsed = offset + size;
+
+        UploadAllocation allocation;
+        allocation.Buffer = m_Buffer.Handle;
+        allocation.Offset = m_FrameBegin + offset;
+        allocation.Data = (uint8_t*)m_Buffer.Allocation.Mapped + allocation.Offset;
+        return allocation;
+    }
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "GPUAllocator.h"
+
+namespace Cubed
+{
+    struct UploadAllocation
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceSize Offset = 0;
+        void* Data = nullptr;
+
+        explicit operator bool() const { return Data != nullptr; }
+    };
+
+    //
+    // UploadRing - one persistently mapped, host-coherent buffer split into a region per frame
+    // in flight, for data that is rewritten every frame (instance data and the like). Allocating
+    // is a bump of the current region's offset; BeginFrame() rewinds the region of the frame
+    // being recorded, whose previous contents the GPU has finished with by then.
+    //
+    // The buffer only grows in BeginFrame(), before anything from it is bound for that frame,
+    // and only when a frame asks for more than fits.
+    //
+    class UploadRing
+    {
+    public:
+        void Init(GPUAllocator& allocator, VkDeviceSize frameSize, uint32_t frameCount);
+        void Shutdown();
+
+        // `frameIndex`'s previous frame must have completed (its fence waited on). Grows the
+        // ring, waiting for the device to go idle, if a frame needs more than `minFrameSize`
+        // or the last frame ran out.
+        void BeginFrame(uint32_t frameIndex, uint32_t frameCount, VkDeviceSize minFrameSize = 0);
+        // Empty if the frame's region is full
+        UploadAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+        VkDeviceSize GetFrameSize() const { return m_FrameSize; }
+        VkDeviceSize GetFrameUsed() const { return m_FrameUsed; }
+    private:
+        void Create(VkDeviceSize frameSize, uint32_t frameCount);
+    private:
+        GPUAllocator* m_Allocator = nullptr;
+        Buffer m_Buffer;
+
+        VkDeviceSize m_FrameSize = 0;
+        uint32_t m_FrameCount = 0;
+
+        VkDeviceSize m_FrameBegin = 0;
+        VkDeviceSize m_FrameUsed = 0;
+        VkDeviceSize m_RequiredFrameSize = 0; // largest request that didn't fit
+    };
+
+}
@@ -0,0 +1,176 @@
+#include "Benchmark.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed::Benchmark
+{
+	struct Suite
+	{
+		const char* Name;
+		SuiteFunc Func;
+	};
+
+	// Function-local so registration order across translation units doesn't matter
+	static std::vector<Suite>& GetSuites()
+	{
+		static std::vector<Suite> s_Suites;
+		return s_Suites;
+	}
+
+	static const volatile void* s_Sink = nullptr;
+	static uint32_t s_FailureCount = 0;
+	static std::vector<Result> s_Results;
+
+	static constexpr const char* s_TSVHeader = "suite\tname\titems\tmilliseconds\tns_per_item\tbytes_per_item";
+
+	static double GetNanosecondsPerItem(const Result& result)
+	{
+		return result.Items ? result.Milliseconds * 1e6 / (double)result.Items : 0.0;
+	}
+
+	SuiteRegistrar::SuiteRegistrar(const char* name, SuiteFunc func)
+	{
+		GetSuites().push_back({ name, func });
+	}
+
+	void Report(const Result& result)
+	{
+		std::string line = fmt::format("{:<24} {:<40} {:>10} items {:>10.3f}ms {:>10.2f}ns/item",
+			result.Suite, result.Name, result.Items, result.Milliseconds, GetNanosecondsPerItem(result));
+		if (result.BytesPerItem > 0.0)
+			line += fmt::format(" {:>8.2f}B/item", result.BytesPerItem);
+
+		std::cout << line << '\n';
+		s_Results.push_back(result);
+	}
+
+	void ReportFailure(std::string_view suite, std::string_view message)
+	{
+		std::cout << fmt::format("{:<24} FAILED: {}\n", suite, message);
+		s_FailureCount++;
+	}
+
+	void DoNotOptimizeImpl(const volatile void* value)
+	{
+		s_Sink = value;
+	}
+
+	static bool WriteTSV(const std::string& path)
+	{
+		std::ofstream stream(path);
+		if (!stream)
+			return false;
+
+		stream << s_TSVHeader << '\n';
+		for (const Result& result : s_Results)
+		{
+			stream << fmt::format("{}\t{}\t{}\t{:.6f}\t{:.4f}\t{:.4f}\n",
+				result.Suite, result.Name, result.Items, result.Milliseconds, GetNanosecondsPerItem(result), result.BytesPerItem);
+		}
+
+		return (bool)stream;
+	}
+
+	// Keyed by suite + tab + name, value is ns per item
+	static bool ReadBaseline(const std::string& path, std::map<std::string, double>& baseline)
+	{
+		std::ifstream stream(path);
+		if (!stream)
+			return false;
+
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			if (line == s_TSVHeader)
+				continue;
+
+			std::vector<std::string> fields;
+			std::stringstream lineStream(line);
+			std::string field;
+			while (std::getline(lineStream, field, '\t'))
+				fields.push_back(field);
+
+			if (fields.size() < 5)
+				continue;
+
+			double nanosecondsPerItem = 0.0;
+			std::from_chars(fields[4].data(), fields[4].data() + fields[4].size(), nanosecondsPerItem);
+			baseline[fields[0] + '\t' + fields[1]] = nanosecondsPerItem;
+		}
+
+		return true;
+	}
+
+	static void CompareWithBaseline(const std::map<std::string, double>& baseline, double maxRegression)
+	{
+		for (const Result& result : s_Results)
+		{
+			auto it = baseline.find(result.Suite + '\t' + result.Name);
+			if (it == baseline.end() || it->second <= 0.0)
+				continue;
+
+			double nanosecondsPerItem = GetNanosecondsPerItem(result);
+			double change = nanosecondsPerItem / it->second - 1.0;
+			if (change > maxRegression)
+			{
+				ReportFailure(result.Suite, fmt::format("{} regressed {:.1f}% ({:.2f} -> {:.2f}ns/item)",
+					result.Name, change * 100.0, it->second, nanosecondsPerItem));
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string_view filter;
+	std::string tsvPath, baselinePath;
+	double maxRegressionPercent = 10.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string_view argument = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (argument == "--tsv" && hasValue)
+			tsvPath = argv[++i];
+		else if (argument == "--baseline" && hasValue)
+			baselinePath = argv[++i];
+		else if (argument == "--max-regression" && hasValue)
+			maxRegressionPercent = std::atof(argv[++i]);
+		else
+			filter = argument;
+	}
+
+	std::map<std::string, double> baseline;
+	if (!baselinePath.empty() && !Cubed::Benchmark::ReadBaseline(baselinePath, baseline))
+	{
+		std::cout << fmt::format("Failed to read baseline '{}'\n", baselinePath);
+		return 1;
+	}
+
+	for (const auto& suite : Cubed::Benchmark::GetSuites())
+	{
+		if (!filter.empty() && std::string_view(suite.Name).find(filter) == std::string_view::npos)
+			continue;
+
+		suite.Func();
+	}
+
+	if (!baselinePath.empty())
+		Cubed::Benchmark::CompareWithBaseline(baseline, maxRegressionPercent / 100.0);
+
+	if (!tsvPath.empty() && !Cubed::Benchmark::WriteTSV(tsvPath))
+	{
+		std::cout << fmt::format("Failed to write results to '{}'\n", tsvPath);
+		return 1;
+	}
+
+	return Cubed::Benchmark::s_FailureCount ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+//
+// Minimal benchmark harness - suites register themselves with CUBED_BENCHMARK_SUITE
+// and report one Result per measured case.
+//
+// Usage: Cubed-Benchmarks [suite filter] [--tsv <file>] [--baseline <file>] [--max-regression <percent>]
+//   --tsv writes every result as tab-separated values (same format --baseline reads)
+//   --baseline fails the run if any case is slower per item than in the baseline by more
+//   than --max-regression percent (default 10), so CI can catch hot path regressions
+//
+namespace Cubed::Benchmark
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Result
+	{
+		std::string Suite;
+		std::string Name;
+		uint64_t Items = 0; // operations performed per run
+		double Milliseconds = 0.0; // best run
+		double BytesPerItem = 0.0; // encoded size, for serialization cases
+	};
+
+	using SuiteFunc = void(*)();
+
+	struct SuiteRegistrar
+	{
+		SuiteRegistrar(const char* name, SuiteFunc func);
+	};
+
+	void Report(const Result& result);
+	// For suites that also verify results; makes the run exit with a non-zero code
+	void ReportFailure(std::string_view suite, std::string_view message);
+
+	// Best of `runs` runs, in milliseconds
+	template<typename Func>
+	double Measure(uint32_t runs, Func&& func)
+	{
+		double best = 1e30;
+		for (uint32_t i = 0; i < runs; i++)
+		{
+			Clock::time_point start = Clock::now();
+			func();
+			double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			if (elapsed < best)
+				best = elapsed;
+		}
+		return best;
+	}
+
+	void DoNotOptimizeImpl(const volatile void* value);
+
+	// Keeps the optimizer from discarding work whose result is otherwise unused
+	template<typename T>
+	void DoNotOptimize(const T& value)
+	{
+		DoNotOptimizeImpl(&value);
+	}
+}
+
+#define CUBED_BENCHMARK_SUITE(name) \
+	static void name(); \
+	static ::Cubed::Benchmark::SuiteRegistrar s_##name##Registrar(#name, name); \
+	static void name()
@@ -0,0 +1,271 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <vector>
+
+#include "ChatHistory.h"
+#include "PacketBuffer.h"
+#include "PacketFrame.h"
+#include "PacketLayouts.h"
+#include "ServerPacket.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	static constexpr uint32_t s_Messages = 10000;
+
+	static std::string MakeMessageText(uint32_t i)
+	{
+		return fmt::format("message {} from the benchmark, about as long as a typical chat line", i);
+	}
+
+	// Reads a MessageHistory reply the way the client does
+	struct HistoryPage
+	{
+		uint64_t OldestID = 0, NewestID = 0;
+		std::vector<ChatMessage> Messages;
+		bool Valid = true;
+	};
+
+	static HistoryPage ReadPage(Walnut::Buffer buffer)
+	{
+		HistoryPage page;
+		PacketView<MessageHistoryPacket> view(buffer);
+		page.Valid = view.IsValid();
+		if (!page.Valid)
+			return page;
+
+		page.OldestID = view.Get<MessageHistoryPacket::OldestID>();
+		page.NewestID = view.Get<MessageHistoryPacket::NewestID>();
+
+		RecordReader<ChatMessageRecord> reader(view.Get<MessageHistoryPacket::Messages>());
+		uint32_t count = view.Get<MessageHistoryPacket::Count>();
+		for (uint32_t i = 0; i < count && page.Valid; i++)
+		{
+			PacketView<ChatMessageRecord> record = reader.Next();
+			page.Valid = record.IsValid();
+			if (page.Valid)
+				page.Messages.push_back(ReadChatMessage(record));
+		}
+
+		page.Valid &= reader.IsAtEnd();
+		return page;
+	}
+
+	static bool IsContiguous(const HistoryPage& page, uint64_t firstID)
+	{
+		for (size_t i = 0; i < page.Messages.size(); i++)
+		{
+			if (page.Messages[i].ID != firstID + i || page.Messages[i].Text != MakeMessageText((uint32_t)(firstID + i)))
+				return false;
+		}
+		return true;
+	}
+
+	static void BenchmarkAdd()
+	{
+		std::vector<std::string> texts(s_Messages);
+		for (uint32_t i = 0; i < s_Messages; i++)
+			texts[i] = MakeMessageText(i + 1);
+
+		ChatHistory history;
+		auto addAll = [&]()
+		{
+			for (const std::string& text : texts)
+				Benchmark::DoNotOptimize(history.Add("Player", text));
+		};
+
+		// Once the ring is full every new message reuses the storage of the one it overwrites
+		addAll();
+		uint64_t allocatedBlocks = PacketPool::Get().GetAllocatedBlockCount();
+		double time = Benchmark::Measure(s_Runs, addAll);
+
+		Benchmark::Report({ "Chat", fmt::format("Add (ring of {})", history.GetCapacity()), s_Messages, time });
+
+		if (PacketPool::Get().GetAllocatedBlockCount() != allocatedBlocks)
+			Benchmark::ReportFailure("Chat", "adding to a full history allocated");
+		if (history.GetCount() != history.GetCapacity() || history.GetNewestID() != (uint64_t)s_Messages * (s_Runs + 1))
+			Benchmark::ReportFailure("Chat", fmt::format("history holds {} messages up to ID {}", history.GetCount(), history.GetNewestID()));
+	}
+
+	static void BenchmarkPaging()
+	{
+		ChatHistory history;
+		for (uint32_t i = 1; i <= s_Messages; i++)
+			history.Add("Player", MakeMessageText(i));
+
+		const uint64_t oldestID = s_Messages - history.GetCapacity() + 1;
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+
+		// A new client gets the latest page only
+		stream.Reset();
+		history.WritePage(stream, 0);
+		HistoryPage latest = ReadPage(stream.GetBuffer());
+		if (!latest.Valid || latest.OldestID != oldestID || latest.NewestID != s_Messages || latest.Messages.size() != ChatHistory::MaxPageSize
+			|| !IsContiguous(latest, s_Messages - ChatHistory::MaxPageSize + 1))
+			Benchmark::ReportFailure("Chat", "first history page isn't the latest messages");
+
+		// A client that missed more than the history holds resumes from the oldest message still there
+		stream.Reset();
+		history.WritePage(stream, 10);
+		HistoryPage gap = ReadPage(stream.GetBuffer());
+		if (!gap.Valid || gap.Messages.size() != ChatHistory::MaxPageSize || !IsContiguous(gap, oldestID))
+			Benchmark::ReportFailure("Chat", "history page after a gap doesn't start at the oldest message");
+
+		// A caught-up client gets an empty page
+		stream.Reset();
+		history.WritePage(stream, s_Messages);
+		HistoryPage empty = ReadPage(stream.GetBuffer());
+		if (!empty.Valid || !empty.Messages.empty() || empty.NewestID != s_Messages)
+			Benchmark::ReportFailure("Chat", "caught-up client got messages");
+
+		// Catching up on the whole history a page at a time, as a client that was away does
+		uint64_t bytes = 0;
+		uint32_t pages = 0;
+		bool contiguous = true;
+		double time = Benchmark::Measure(s_Runs, [&]()
+		{
+			bytes = 0;
+			pages = 0;
+			uint64_t cursor = 1;
+			while (cursor < s_Messages)
+			{
+				stream.Reset();
+				history.WritePage(stream, cursor);
+				HistoryPage page = ReadPage(stream.GetBuffer());
+				if (page.Messages.empty())
+					break;
+
+				contiguous &= page.Valid && IsContiguous(page, std::max(cursor + 1, oldestID));
+				cursor = page.Messages.back().ID;
+				bytes += stream.GetBuffer().Size;
+				pages++;
+			}
+		});
+
+		Benchmark::Report({ "Chat", fmt::format("Sync full history ({} pages)", pages), history.GetCount(), time, (double)bytes / history.GetCount() });
+		if (!contiguous || pages != history.GetCapacity() / ChatHistory::MaxPageSize)
+			Benchmark::ReportFailure("Chat", "paging through the history skipped or repeated messages");
+	}
+
+	static void BenchmarkFanOut(uint32_t recipientCount)
+	{
+		const uint32_t messageCount = 1000;
+		std::string suffix = fmt::format(" ({} recipients)", recipientCount);
+		std::vector<std::vector<SharedPacket>> queues(recipientCount);
+		for (auto& queue : queues)
+			queue.reserve(messageCount);
+
+		// Building the packet again for every recipient, as the server would without a shared buffer
+		double perRecipientTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (auto& queue : queues)
+				queue.clear();
+
+			for (uint32_t i = 1; i <= messageCount; i++)
+			{
+				ChatMessage message{ i, "Player", MakeMessageText(i) };
+				for (auto& queue : queues)
+				{
+					PacketStreamWriter& stream = GetThreadPacketWriter();
+					WritePacket<ChatMessagePacket>(stream, message.ID, message.Username, message.Text);
+					queue.push_back(PacketPool::Get().Create(stream));
+				}
+			}
+		});
+
+		ChatHistory history;
+		double sharedTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (auto& queue : queues)
+				queue.clear();
+
+			for (uint32_t i = 1; i <= messageCount; i++)
+			{
+				SharedPacket packet = history.Add("Player", MakeMessageText(i));
+				for (auto& queue : queues)
+					queue.push_back(packet);
+			}
+		});
+
+		queues.clear();
+
+		// Serialized once, but copied into each recipient's frame for the tick
+		std::vector<FrameBuilder> frames(recipientCount);
+		uint64_t frameBytes = 0;
+		double framedTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 1; i <= messageCount; i++)
+			{
+				SharedPacket packet = history.Add("Player", MakeMessageText(i));
+				for (FrameBuilder& frame : frames)
+					frame.Add(packet.GetBuffer());
+			}
+
+			frameBytes = 0;
+			for (FrameBuilder& frame : frames)
+				frame.Flush([&](Walnut::Buffer packet, uint32_t) { frameBytes += packet.Size; });
+		});
+		Benchmark::DoNotOptimize(frameBytes);
+
+		// What the server does: each recipient's frame holds a reference, sent as is
+		double sharedFramedTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 1; i <= messageCount; i++)
+			{
+				SharedPacket packet = history.Add("Player", MakeMessageText(i));
+				for (FrameBuilder& frame : frames)
+					frame.Add(packet);
+			}
+
+			frameBytes = 0;
+			for (FrameBuilder& frame : frames)
+				frame.Flush([&](Walnut::Buffer packet, uint32_t) { frameBytes += packet.Size; });
+		});
+		Benchmark::DoNotOptimize(frameBytes);
+
+		uint64_t sends = (uint64_t)messageCount * recipientCount;
+		Benchmark::Report({ "Chat", "Serialize per recipient" + suffix, sends, perRecipientTime });
+		Benchmark::Report({ "Chat", "Serialize once" + suffix, sends, sharedTime });
+		Benchmark::Report({ "Chat", "Serialize once, copy into frames" + suffix, sends, framedTime });
+		Benchmark::Report({ "Chat", "Serialize once, reference from frames" + suffix, sends, sharedFramedTime });
+	}
+
+	static void VerifyLimits()
+	{
+		// "é" is two bytes; cutting between them would leave invalid UTF-8
+		std::string text = std::string(MaxChatMessageLength - 1, 'a') + "\xc3\xa9";
+		if (TruncateUTF8(text, MaxChatMessageLength).size() != MaxChatMessageLength - 1)
+			Benchmark::ReportFailure("Chat", "truncation split a UTF-8 character");
+		if (TruncateUTF8("short", MaxChatMessageLength) != "short")
+			Benchmark::ReportFailure("Chat", "truncation changed a short message");
+
+		// A peer claiming a huge length must be refused before anything is read
+		PacketStreamWriter stream;
+		WritePacket<ChatMessagePacket>(stream, 1ull, "Player", std::string(MaxChatMessageLength, 'a'));
+		Walnut::Buffer buffer = stream.GetBuffer();
+		size_t hugeLength = (size_t)1 << 40;
+		std::memcpy(buffer.As<uint8_t>() + buffer.Size - MaxChatMessageLength - sizeof(size_t), &hugeLength, sizeof(hugeLength));
+		if (PacketView<ChatMessagePacket>(buffer))
+			Benchmark::ReportFailure("Chat", "oversized string length was accepted");
+
+		stream.Reset();
+		WritePacket<ChatMessagePacket>(stream, 1ull, std::string(MaxUsernameLength, 'a'), std::string(MaxChatMessageLength, 'a'));
+		PacketView<ChatMessagePacket> exact(stream.GetBuffer());
+		if (!exact || ReadChatMessage(exact).Text.size() != MaxChatMessageLength)
+			Benchmark::ReportFailure("Chat", "strings at the length limit were refused");
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(ChatSuite)
+{
+	Cubed::VerifyLimits();
+	Cubed::BenchmarkAdd();
+	Cubed::BenchmarkPaging();
+
+	for (uint32_t recipientCount : { 16u, 100u })
+		Cubed::BenchmarkFanOut(recipientCount);
+}
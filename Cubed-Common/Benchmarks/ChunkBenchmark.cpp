@@ -0,0 +1,256 @@
+#include "Benchmark.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Chunk.h"
+#include "ChunkMesher.h"
+#include "JobPool.h"
+#include "WorldGenerator.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 3;
+
+	// 8 x 3 x 8 chunks, enough for the noisy terrain's full height range
+	static constexpr int32_t s_WorldWidth = 8;
+	static constexpr int32_t s_WorldHeight = 3;
+
+	static const glm::ivec3 s_FaceOffsets[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+	struct TestWorld
+	{
+		std::vector<Chunk> Chunks;
+		std::vector<ChunkNeighbours> Neighbours;
+	};
+
+	static uint32_t GetChunkIndex(const glm::ivec3& coordinate)
+	{
+		return (uint32_t)((coordinate.y * s_WorldWidth + coordinate.z) * s_WorldWidth + coordinate.x);
+	}
+
+	static bool IsInWorld(const glm::ivec3& coordinate)
+	{
+		return coordinate.x >= 0 && coordinate.x < s_WorldWidth && coordinate.z >= 0 && coordinate.z < s_WorldWidth
+			&& coordinate.y >= 0 && coordinate.y < s_WorldHeight;
+	}
+
+	template<typename Func>
+	static TestWorld CreateWorld(Func&& generate)
+	{
+		TestWorld world;
+		world.Chunks.reserve(s_WorldWidth * s_WorldWidth * s_WorldHeight);
+		for (int32_t y = 0; y < s_WorldHeight; y++)
+		{
+			for (int32_t z = 0; z < s_WorldWidth; z++)
+			{
+				for (int32_t x = 0; x < s_WorldWidth; x++)
+				{
+					Chunk& chunk = world.Chunks.emplace_back(glm::ivec3(x, y, z));
+					generate(chunk);
+				}
+			}
+		}
+
+		world.Neighbours.resize(world.Chunks.size());
+		for (size_t i = 0; i < world.Chunks.size(); i++)
+		{
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				glm::ivec3 neighbour = world.Chunks[i].GetCoordinate() + s_FaceOffsets[face];
+				if (IsInWorld(neighbour))
+					world.Neighbours[i].Chunks[face] = &world.Chunks[GetChunkIndex(neighbour)];
+			}
+		}
+
+		return world;
+	}
+
+	// Block at chunk-local coordinates that may be one outside the chunk
+	static BlockID GetBlock(const Chunk& chunk, const ChunkNeighbours& neighbours, const glm::ivec3& position)
+	{
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			uint32_t axis = GetFaceAxis((BlockFace)face);
+			int32_t outside = IsPositiveFace((BlockFace)face) ? (int32_t)Chunk::Size : -1;
+			if (position[axis] != outside)
+				continue;
+
+			const Chunk* neighbour = neighbours.Chunks[face];
+			if (!neighbour)
+				return AirBlock;
+
+			glm::ivec3 local = position;
+			local[axis] = IsPositiveFace((BlockFace)face) ? 0 : (int32_t)Chunk::Size - 1;
+			return neighbour->Get(local.x, local.y, local.z);
+		}
+		return chunk.Get(position.x, position.y, position.z);
+	}
+
+	// Every visible (block, face) of a chunk the slow way, encoded as index * 6 + face
+	static std::vector<uint8_t> GetVisibleFaces(const Chunk& chunk, const ChunkNeighbours& neighbours)
+	{
+		std::vector<uint8_t> visible(Chunk::Volume * 6, 0);
+		for (uint32_t y = 0; y < Chunk::Size; y++)
+		{
+			for (uint32_t z = 0; z < Chunk::Size; z++)
+			{
+				for (uint32_t x = 0; x < Chunk::Size; x++)
+				{
+					if (chunk.Get(x, y, z) == AirBlock)
+						continue;
+
+					glm::ivec3 position((int32_t)x, (int32_t)y, (int32_t)z);
+					for (uint32_t face = 0; face < 6; face++)
+						visible[Chunk::GetIndex(x, y, z) * 6 + face] = GetBlock(chunk, neighbours, position + s_FaceOffsets[face]) == AirBlock;
+				}
+			}
+		}
+		return visible;
+	}
+
+	// The greedy mesh must cover exactly the visible faces, each once, with the right block
+	static bool VerifyMesh(const Chunk& chunk, const ChunkNeighbours& neighbours, const std::vector<ChunkQuad>& quads)
+	{
+		std::vector<uint8_t> expected = GetVisibleFaces(chunk, neighbours);
+		std::vector<uint8_t> covered(expected.size(), 0);
+
+		for (const ChunkQuad& quad : quads)
+		{
+			uint32_t axis = GetFaceAxis(quad.Face);
+			uint32_t uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+			for (uint32_t v = 0; v < quad.Height; v++)
+			{
+				for (uint32_t u = 0; u < quad.Width; u++)
+				{
+					glm::ivec3 position(quad.X, quad.Y, quad.Z);
+					position[uAxis] += (int32_t)u;
+					position[vAxis] += (int32_t)v;
+					if (position[uAxis] >= (int32_t)Chunk::Size || position[vAxis] >= (int32_t)Chunk::Size)
+						return false;
+					if (chunk.Get(position.x, position.y, position.z) != quad.Block)
+						return false;
+
+					uint8_t& face = covered[Chunk::GetIndex(position.x, position.y, position.z) * 6 + (uint32_t)quad.Face];
+					if (face)
+						return false; // overlap
+					face = 1;
+				}
+			}
+		}
+
+		return covered == expected;
+	}
+
+	static void VerifyPalette()
+	{
+		std::mt19937 random(7);
+		PalettedBlockStorage storage(Chunk::Volume);
+		std::vector<BlockID> reference(Chunk::Volume, AirBlock);
+
+		// Walk the palette up through every width, then back down with Compact()
+		for (uint32_t distinct : { 2u, 3u, 5u, 17u, 300u, 4u, 1u })
+		{
+			std::uniform_int_distribution<uint32_t> blockDistribution(0, distinct - 1);
+			std::uniform_int_distribution<uint32_t> indexDistribution(0, Chunk::Volume - 1);
+			for (uint32_t i = 0; i < Chunk::Volume * 2; i++)
+			{
+				uint32_t index = indexDistribution(random);
+				BlockID block = (BlockID)blockDistribution(random);
+				storage.Set(index, block);
+				reference[index] = block;
+			}
+
+			storage.Compact();
+
+			std::vector<BlockID> decoded(Chunk::Volume);
+			storage.Decode(decoded.data());
+			bool matches = decoded == reference;
+			for (uint32_t i = 0; i < Chunk::Volume && matches; i++)
+				matches = storage.Get(i) == reference[i];
+
+			if (!matches)
+			{
+				Benchmark::ReportFailure("Chunk", fmt::format("palette storage with {} block types doesn't match the dense reference", distinct));
+				return;
+			}
+		}
+
+		PalettedBlockStorage encoded(Chunk::Volume);
+		encoded.Encode(reference.data());
+		for (uint32_t i = 0; i < Chunk::Volume; i++)
+		{
+			if (encoded.Get(i) != reference[i])
+			{
+				Benchmark::ReportFailure("Chunk", "encoded palette storage doesn't match the dense reference");
+				return;
+			}
+		}
+	}
+
+	static void BenchmarkWorld(const std::string& name, const TestWorld& world, JobPool& jobPool)
+	{
+		const uint32_t chunkCount = (uint32_t)world.Chunks.size();
+
+		size_t memory = 0;
+		for (const Chunk& chunk : world.Chunks)
+			memory += chunk.GetBlocks().GetMemoryUsage();
+		Benchmark::Report({ "Chunk", fmt::format("{} storage (dense: {} B)", name, Chunk::Volume * sizeof(BlockID)), chunkCount, 0.0, (double)memory / chunkCount });
+
+		std::vector<std::vector<ChunkQuad>> meshes(chunkCount);
+		ChunkMesher mesher;
+		double singleTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < chunkCount; i++)
+				mesher.Mesh(world.Chunks[i], world.Neighbours[i], meshes[i]);
+		});
+
+		size_t quadCount = 0;
+		for (uint32_t i = 0; i < chunkCount; i++)
+		{
+			quadCount += meshes[i].size();
+			if (!VerifyMesh(world.Chunks[i], world.Neighbours[i], meshes[i]))
+			{
+				Benchmark::ReportFailure("Chunk", fmt::format("{} chunk {} greedy mesh doesn't match its visible faces", name, i));
+				break;
+			}
+		}
+
+		Benchmark::Report({ "Chunk", name + " mesh", chunkCount, singleTime, (double)(quadCount * sizeof(ChunkQuad)) / chunkCount });
+
+		std::vector<std::vector<ChunkQuad>> parallelMeshes(chunkCount);
+		double parallelTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			jobPool.ParallelFor(chunkCount, 4, [&](uint32_t i)
+			{
+				thread_local ChunkMesher threadMesher;
+				threadMesher.Mesh(world.Chunks[i], world.Neighbours[i], parallelMeshes[i]);
+			});
+		});
+
+		Benchmark::Report({ "Chunk", fmt::format("{} mesh ({} threads)", name, jobPool.GetThreadCount() + 1), chunkCount, parallelTime, 0.0 });
+	}
+
+	CUBED_BENCHMARK_SUITE(ChunkSuite)
+	{
+		VerifyPalette();
+
+		JobPool jobPool;
+
+		TestWorld flatWorld = CreateWorld([](Chunk& chunk) { GenerateFlatChunk(chunk, 40); });
+		BenchmarkWorld("Flat", flatWorld, jobPool);
+
+		TestWorld terrainWorld = CreateWorld([](Chunk& chunk) { GenerateTerrainChunk(chunk); });
+		BenchmarkWorld("Terrain", terrainWorld, jobPool);
+
+		double generateTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			jobPool.ParallelFor((uint32_t)terrainWorld.Chunks.size(), 4, [&](uint32_t i) { GenerateTerrainChunk(terrainWorld.Chunks[i]); });
+		});
+		Benchmark::Report({ "Chunk", "Terrain generate (parallel)", (uint64_t)terrainWorld.Chunks.size(), generateTime, 0.0 });
+	}
+
+}
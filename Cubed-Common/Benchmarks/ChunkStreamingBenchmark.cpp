@@ -0,0 +1,212 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "ChunkStreamer.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "ServerPacket.h"
+#include "WorldGenerator.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 3;
+	static constexpr uint32_t s_TickRate = 30;
+	static constexpr float s_PlayerSpeed = 50.0f; // blocks per second, like PlayerMovement
+	// Ticks between the server sending a chunk and its acknowledgement arriving (about 100ms)
+	static constexpr uint32_t s_AckDelayTicks = 3;
+
+	static void BenchmarkSerialization()
+	{
+		std::vector<Chunk> chunks;
+		for (int32_t y = 0; y < 2; y++)
+			for (int32_t z = 0; z < 4; z++)
+				for (int32_t x = 0; x < 4; x++)
+					GenerateTerrainChunk(chunks.emplace_back(glm::ivec3(x, y, z)));
+
+		PacketStreamWriter stream;
+		double encodeTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			stream.Reset();
+			BitWriter writer(stream);
+			for (const Chunk& chunk : chunks)
+			{
+				WriteChunkCoordinate(writer, chunk.GetCoordinate());
+				WriteChunkBlocks(writer, chunk.GetBlocks());
+			}
+			writer.Flush();
+		});
+
+		size_t memory = 0;
+		for (const Chunk& chunk : chunks)
+			memory += chunk.GetBlocks().GetMemoryUsage();
+
+		Walnut::Buffer buffer = stream.GetBuffer();
+		Benchmark::Report({ "ChunkStreaming", fmt::format("Encode terrain (in memory: {:.0f} B)", (double)memory / chunks.size()), (uint64_t)chunks.size(), encodeTime, (double)buffer.Size / chunks.size() });
+
+		std::vector<Chunk> decoded(chunks.size());
+		bool valid = true;
+		double decodeTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			BitReader bitReader(buffer);
+			for (Chunk& chunk : decoded)
+			{
+				chunk = Chunk(ReadChunkCoordinate(bitReader));
+				valid &= ReadChunkBlocks(bitReader, chunk.GetBlocks());
+			}
+		});
+		Benchmark::Report({ "ChunkStreaming", "Decode terrain", (uint64_t)chunks.size(), decodeTime });
+
+		for (size_t i = 0; i < chunks.size() && valid; i++)
+		{
+			valid = decoded[i].GetCoordinate() == chunks[i].GetCoordinate();
+			for (uint32_t block = 0; block < Chunk::Volume && valid; block++)
+				valid = decoded[i].GetBlocks().Get(block) == chunks[i].GetBlocks().Get(block);
+		}
+		if (!valid)
+			Benchmark::ReportFailure("ChunkStreaming", "decoded chunks don't match the encoded ones");
+
+		// Truncated data must be rejected, not read past
+		BitReader truncated(Walnut::Buffer(buffer.Data, buffer.Size / 8));
+		Chunk chunk(ReadChunkCoordinate(truncated));
+		bool truncatedAccepted = ReadChunkBlocks(truncated, chunk.GetBlocks()) && ReadChunkBlocks(truncated, chunk.GetBlocks());
+		if (truncatedAccepted)
+			Benchmark::ReportFailure("ChunkStreaming", "truncated chunk data was accepted");
+	}
+
+	// What a client would hold, built only from the packets the streamer sends
+	struct SimulatedClient
+	{
+		glm::vec2 Position;
+		glm::vec2 Velocity;
+		std::unordered_map<uint64_t, glm::ivec3> Chunks;
+		std::deque<std::pair<uint32_t, uint32_t>> PendingAcks; // tick to deliver at, sequence
+		uint64_t BytesThisTick = 0;
+		uint64_t MaxBytesPerTick = 0;
+		uint32_t ChunksAhead = 0, ChunksBehind = 0; // of the first chunks received
+		bool Resent = false;
+	};
+
+	struct StreamingResult
+	{
+		uint64_t ChunksSent = 0;
+		uint64_t BytesSent = 0;
+		uint64_t MaxBytesPerTick = 0;
+		uint32_t ChunksAhead = 0, ChunksBehind = 0;
+		bool Resent = false;
+	};
+
+	// Clients spread far apart, each walking along +x, for `ticks` ticks
+	static StreamingResult SimulateStreaming(uint32_t clientCount, uint32_t ticks)
+	{
+		ChunkStreamer streamer;
+		std::vector<SimulatedClient> clients(clientCount);
+		uint32_t tick = 0;
+
+		streamer.SetSendCallback([&](uint32_t clientID, Walnut::Buffer buffer)
+		{
+			SimulatedClient& client = clients[clientID];
+			client.BytesThisTick += buffer.Size;
+
+			if (PacketView<ChunkDataPacket> packet(buffer); packet)
+			{
+				uint32_t sequence = packet.Get<ChunkDataPacket::Sequence>();
+				BitReader reader(packet.Get<ChunkDataPacket::Body>());
+				glm::ivec3 coordinate = ReadChunkCoordinate(reader);
+
+				client.Resent |= !client.Chunks.emplace(GetChunkKey(coordinate), coordinate).second;
+				client.PendingAcks.emplace_back(tick + s_AckDelayTicks, sequence);
+
+				// Early chunks should favour the direction of travel
+				if (client.Chunks.size() <= 64)
+				{
+					float dx = (coordinate.x + 0.5f) * Chunk::Size - client.Position.x;
+					if (dx > Chunk::Size)
+						client.ChunksAhead++;
+					else if (dx < -(float)Chunk::Size)
+						client.ChunksBehind++;
+				}
+			}
+			else if (PacketView<ChunkUnloadPacket> packet(buffer); packet)
+			{
+				BitReader reader(packet.Get<ChunkUnloadPacket::Body>());
+				uint32_t count = reader.ReadVarUInt();
+				for (uint32_t i = 0; i < count; i++)
+					client.Chunks.erase(GetChunkKey(ReadChunkCoordinate(reader)));
+			}
+		});
+
+		for (uint32_t i = 0; i < clientCount; i++)
+		{
+			clients[i].Position = { (float)(i % 8) * 4096.0f, (float)(i / 8) * 4096.0f };
+			clients[i].Velocity = { s_PlayerSpeed, 0.0f };
+			streamer.AddClient(i);
+		}
+
+		for (; tick < ticks; tick++)
+		{
+			for (uint32_t i = 0; i < clientCount; i++)
+			{
+				SimulatedClient& client = clients[i];
+				while (!client.PendingAcks.empty() && client.PendingAcks.front().first <= tick)
+				{
+					streamer.Acknowledge(i, client.PendingAcks.front().second);
+					client.PendingAcks.pop_front();
+				}
+
+				client.Position += client.Velocity * (1.0f / s_TickRate);
+				streamer.UpdateClient(i, client.Position, client.Velocity);
+				client.BytesThisTick = 0;
+			}
+
+			streamer.Update();
+
+			for (SimulatedClient& client : clients)
+				client.MaxBytesPerTick = std::max(client.MaxBytesPerTick, client.BytesThisTick);
+		}
+
+		StreamingResult result;
+		for (uint32_t i = 0; i < clientCount; i++)
+		{
+			ChunkStreamStats stats = streamer.GetClientStats(i);
+			result.ChunksSent += stats.ChunksSent;
+			result.BytesSent += stats.BytesSent;
+			result.MaxBytesPerTick = std::max(result.MaxBytesPerTick, clients[i].MaxBytesPerTick);
+			result.ChunksAhead += clients[i].ChunksAhead;
+			result.ChunksBehind += clients[i].ChunksBehind;
+			result.Resent |= clients[i].Resent;
+		}
+		return result;
+	}
+
+	CUBED_BENCHMARK_SUITE(ChunkStreamingSuite)
+	{
+		BenchmarkSerialization();
+
+		const ChunkStreamingSettings settings;
+		for (uint32_t clientCount : { 1u, 16u })
+		{
+			const uint32_t ticks = 10 * s_TickRate;
+
+			StreamingResult result;
+			double time = Benchmark::Measure(s_Runs, [&]() { result = SimulateStreaming(clientCount, ticks); });
+			Benchmark::Report({ "ChunkStreaming", fmt::format("Stream tick ({} clients, {} chunks sent)", clientCount, result.ChunksSent), ticks, time,
+				(double)result.BytesSent / ticks / clientCount });
+
+			// The budget may be overdrawn by the last chunk of a tick, never by more
+			if (result.MaxBytesPerTick > 2 * settings.BytesPerTick + 16 * 1024)
+				Benchmark::ReportFailure("ChunkStreaming", fmt::format("{} bytes sent to one client in one tick, budget is {}", result.MaxBytesPerTick, settings.BytesPerTick));
+			if (result.Resent)
+				Benchmark::ReportFailure("ChunkStreaming", "a chunk was sent to a client that already held it");
+			if (result.ChunksAhead <= result.ChunksBehind)
+				Benchmark::ReportFailure("ChunkStreaming", fmt::format("first chunks don't favour the direction of travel ({} ahead, {} behind)", result.ChunksAhead, result.ChunksBehind));
+		}
+	}
+
+}
@@ -0,0 +1,216 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "PacketBuffer.h"
+#include "PacketFrame.h"
+#include "PacketLayouts.h"
+#include "ServerPacket.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	static constexpr uint32_t s_ClientCount = 200;
+
+	using Message = std::vector<uint8_t>;
+
+	// PacketType first, like every real message, then filler
+	static Message MakeMessage(PacketType type, uint32_t size, std::mt19937& random)
+	{
+		Message message(std::max<uint32_t>(size, sizeof(PacketType)));
+		std::memcpy(message.data(), &type, sizeof(type));
+		for (size_t i = sizeof(PacketType); i < message.size(); i++)
+			message[i] = (uint8_t)random();
+		return message;
+	}
+
+	// What one client gets in a busy tick: a snapshot, a couple of chunks, a chat message and a roster change
+	static std::vector<Message> MakeTickMessages(std::mt19937& random)
+	{
+		std::vector<Message> messages;
+		messages.push_back(MakeMessage(PacketType::ClientUpdate, 400, random));
+		messages.push_back(MakeMessage(PacketType::ChunkData, 2500, random));
+		messages.push_back(MakeMessage(PacketType::ChunkData, 1800, random));
+		messages.push_back(MakeMessage(PacketType::Message, 80, random));
+		messages.push_back(MakeMessage(PacketType::ClientConnect, 40, random));
+		return messages;
+	}
+
+	static Walnut::Buffer AsBuffer(const Message& message)
+	{
+		return Walnut::Buffer(message.data(), message.size());
+	}
+
+	static bool SameBytes(Walnut::Buffer buffer, const Message& message)
+	{
+		return buffer.Size == message.size() && std::memcmp(buffer.Data, message.data(), message.size()) == 0;
+	}
+
+	// Sends what the builder flushes into `packets` and reads them back; true if the messages come out as they went in
+	static bool RoundTrip(FrameBuilder& builder, const std::vector<Message>& messages, std::vector<Message>& packets)
+	{
+		packets.clear();
+		for (const Message& message : messages)
+			builder.Add(AsBuffer(message));
+		builder.Flush([&](Walnut::Buffer packet, uint32_t) { packets.emplace_back(packet.As<uint8_t>(), packet.As<uint8_t>() + packet.Size); });
+
+		size_t index = 0;
+		bool matches = true;
+		for (const Message& packet : packets)
+		{
+			matches &= ForEachFrameMessage(AsBuffer(packet), [&](Walnut::Buffer message)
+			{
+				matches &= index < messages.size() && SameBytes(message, messages[index]);
+				index++;
+			});
+		}
+		return matches && index == messages.size();
+	}
+
+	static void BenchmarkTick()
+	{
+		std::mt19937 random(1);
+		std::vector<std::vector<Message>> clientMessages(s_ClientCount);
+		uint64_t messageCount = 0;
+		for (std::vector<Message>& messages : clientMessages)
+		{
+			messages = MakeTickMessages(random);
+			messageCount += messages.size();
+		}
+
+		std::vector<FrameBuilder> builders(s_ClientCount);
+		std::vector<Message> packets;
+		uint64_t sendCount = 0, frameBytes = 0;
+
+		// Queue every client's messages, then flush, copying each packet out like a transport would
+		double buildTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			packets.clear();
+			sendCount = 0;
+			frameBytes = 0;
+			for (uint32_t client = 0; client < s_ClientCount; client++)
+			{
+				for (const Message& message : clientMessages[client])
+					builders[client].Add(AsBuffer(message));
+			}
+
+			for (FrameBuilder& builder : builders)
+			{
+				builder.Flush([&](Walnut::Buffer packet, uint32_t)
+				{
+					packets.emplace_back(packet.As<uint8_t>(), packet.As<uint8_t>() + packet.Size);
+					sendCount++;
+					frameBytes += packet.Size;
+				});
+			}
+		});
+
+		uint64_t messageBytes = 0;
+		double readTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			messageBytes = 0;
+			for (const Message& packet : packets)
+				ForEachFrameMessage(AsBuffer(packet), [&](Walnut::Buffer message) { messageBytes += message.Size; });
+		});
+
+		Benchmark::Report({ "Frame", fmt::format("Build + flush ({} clients, {} messages in {} sends)", s_ClientCount, messageCount, sendCount),
+			messageCount, buildTime, (double)frameBytes / messageCount });
+		Benchmark::Report({ "Frame", "Read in place", messageCount, readTime, (double)messageBytes / messageCount });
+
+		if (sendCount != s_ClientCount)
+			Benchmark::ReportFailure("Frame", fmt::format("{} clients' ticks took {} sends, expected one each", s_ClientCount, sendCount));
+
+		FrameBuilder builder;
+		for (const std::vector<Message>& messages : clientMessages)
+		{
+			if (!RoundTrip(builder, messages, packets))
+			{
+				Benchmark::ReportFailure("Frame", "messages didn't come out of a frame as they went in");
+				break;
+			}
+		}
+	}
+
+	static void VerifyLimits()
+	{
+		std::mt19937 random(2);
+		FrameBuilder builder;
+		std::vector<Message> packets;
+
+		// A lone message goes out untouched
+		std::vector<Message> lone = { MakeMessage(PacketType::ClientUpdate, 300, random) };
+		if (!RoundTrip(builder, lone, packets) || packets.size() != 1 || packets[0] != lone[0])
+			Benchmark::ReportFailure("Frame", "a lone message wasn't sent as is");
+
+		// A shared packet goes out on its own, from its own bytes, in order with the copied messages around it
+		std::vector<Message> mixed = { MakeMessage(PacketType::ClientUpdate, 200, random), MakeMessage(PacketType::Message, 80, random), MakeMessage(PacketType::ChunkData, 500, random) };
+		SharedPacket shared = PacketPool::Get().Create(AsBuffer(mixed[1]));
+		builder.Add(AsBuffer(mixed[0]));
+		builder.Add(shared);
+		builder.Add(AsBuffer(mixed[2]));
+
+		std::vector<Walnut::Buffer> sent;
+		builder.Flush([&](Walnut::Buffer packet, uint32_t) { sent.push_back(packet); });
+		bool inOrder = sent.size() == mixed.size();
+		for (size_t i = 0; inOrder && i < sent.size(); i++)
+			inOrder = SameBytes(sent[i], mixed[i]);
+		if (!inOrder || sent[1].Data != shared.GetBuffer().Data)
+			Benchmark::ReportFailure("Frame", "a shared packet was copied or sent out of order");
+
+		// More than fits in one frame splits, in order, and nothing but the lone big one leaves unframed
+		std::vector<Message> many;
+		for (uint32_t i = 0; i < 100; i++)
+			many.push_back(MakeMessage(PacketType::ChunkData, 2000, random));
+		many.push_back(MakeMessage(PacketType::ChunkData, MaxFrameSize + 1000, random));
+		many.push_back(MakeMessage(PacketType::Message, 50, random));
+		if (!RoundTrip(builder, many, packets))
+			Benchmark::ReportFailure("Frame", "a split tick didn't read back in order");
+
+		for (const Message& packet : packets)
+		{
+			if (packet.size() > MaxFrameSize && PacketView<FramePacket>(AsBuffer(packet)))
+				Benchmark::ReportFailure("Frame", fmt::format("a {} byte frame is over MaxFrameSize", packet.size()));
+		}
+
+		// Malformed frames are dropped whole: nothing is handed on
+		std::vector<Message> pair = { MakeMessage(PacketType::ClientUpdate, 100, random), MakeMessage(PacketType::Message, 60, random) };
+		RoundTrip(builder, pair, packets);
+		const Message frame = packets[0];
+
+		auto expectDropped = [&](const Message& packet, const char* what)
+		{
+			uint32_t delivered = 0;
+			bool valid = ForEachFrameMessage(AsBuffer(packet), [&](Walnut::Buffer) { delivered++; });
+			if (valid || delivered != 0)
+				Benchmark::ReportFailure("Frame", fmt::format("{}: accepted, {} messages delivered", what, delivered));
+		};
+
+		Message truncated(frame.begin(), frame.end() - 1);
+		expectDropped(truncated, "truncated frame");
+
+		Message padded = frame;
+		padded.push_back(0);
+		expectDropped(padded, "frame with trailing bytes");
+
+		Message wrongCount = frame;
+		uint32_t count = 3;
+		std::memcpy(wrongCount.data() + sizeof(PacketType), &count, sizeof(count));
+		expectDropped(wrongCount, "frame counting more messages than it has");
+
+		Message hugeSize = frame;
+		uint32_t size = 0xffffffff;
+		std::memcpy(hugeSize.data() + sizeof(PacketType) + sizeof(uint32_t), &size, sizeof(size));
+		expectDropped(hugeSize, "message size past the end");
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(FrameSuite)
+{
+	Cubed::VerifyLimits();
+	Cubed::BenchmarkTick();
+}
@@ -0,0 +1,172 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "SnapshotInterpolator.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+
+	static constexpr uint32_t s_TickRate = 30;
+	static constexpr uint32_t s_SnapshotInterval = 2; // 15Hz, the server default
+	static constexpr float s_FrameTime = 1.0f / 144.0f;
+	static constexpr float s_Speed = 50.0f;
+
+	using Clock = SnapshotInterpolator::Clock;
+
+	static Clock::duration ToDuration(double seconds)
+	{
+		return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	}
+
+	struct PlaybackResult
+	{
+		uint64_t Frames = 0;
+		uint64_t ExtrapolatedFrames = 0;
+		float MaxFrameStep = 0.0f; // largest on-screen movement between two interpolated frames
+	};
+
+	// One player walking a square (turning every second) over `seconds` of server time; snapshots
+	// arrive with 20ms base latency plus up to `jitter` seconds and a 1% loss rate, and are rendered at 144Hz
+	static PlaybackResult Playback(float seconds, float jitter, float interpolationDelay)
+	{
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> latency(0.02f, 0.02f + jitter);
+		std::uniform_real_distribution<float> loss(0.0f, 1.0f);
+
+		struct Arrival
+		{
+			double Time;
+			std::shared_ptr<WorldSnapshot> Snapshot;
+		};
+		std::vector<Arrival> arrivals;
+
+		const glm::vec2 directions[] = { { 1.0f, 0.0f }, { 0.0f, 1.0f }, { -1.0f, 0.0f }, { 0.0f, -1.0f } };
+		glm::vec2 position = { 0.0f, 0.0f };
+		uint32_t tickCount = (uint32_t)(seconds * s_TickRate);
+		for (uint32_t tick = 1; tick <= tickCount; tick++)
+		{
+			glm::vec2 velocity = directions[(tick / s_TickRate) % 4] * s_Speed;
+			position += velocity * (1.0f / s_TickRate);
+
+			if (tick % s_SnapshotInterval != 0 || loss(random) < 0.01f)
+				continue;
+
+			auto snapshot = std::make_shared<WorldSnapshot>();
+			snapshot->Tick = tick;
+			snapshot->TickRate = s_TickRate;
+			snapshot->SnapshotInterval = s_SnapshotInterval;
+			snapshot->Players[MakePlayerID(0, 1)] = { position, velocity };
+			arrivals.push_back({ (double)tick / s_TickRate + latency(random), snapshot });
+		}
+
+		std::sort(arrivals.begin(), arrivals.end(), [](const Arrival& a, const Arrival& b) { return a.Time < b.Time; });
+
+		SnapshotInterpolator interpolator({ interpolationDelay, 0.25f });
+		PlayerStore players;
+		Clock::time_point start = Clock::now();
+
+		PlaybackResult result;
+		bool hasPrevious = false, previousExtrapolated = false;
+		glm::vec2 previous = { 0.0f, 0.0f };
+		size_t nextArrival = 0;
+		for (double time = 0.0; time < seconds; time += s_FrameTime)
+		{
+			while (nextArrival < arrivals.size() && arrivals[nextArrival].Time <= time)
+			{
+				interpolator.Push(arrivals[nextArrival].Snapshot, start + ToDuration(arrivals[nextArrival].Time));
+				nextArrival++;
+			}
+
+			uint64_t extrapolatedSamples = interpolator.GetStats().ExtrapolatedSamples;
+			interpolator.Sample(start + ToDuration(time), players);
+			if (players.GetCount() == 0)
+				continue;
+
+			// Extrapolation past a corner has to be corrected once the real snapshot shows up,
+			// so frames next to an extrapolated one are allowed to jump
+			bool extrapolated = interpolator.GetStats().ExtrapolatedSamples != extrapolatedSamples;
+
+			glm::vec2 current = players.GetPositions()[0];
+			if (hasPrevious && !extrapolated && !previousExtrapolated)
+			{
+				glm::vec2 step = current - previous;
+				result.MaxFrameStep = std::max(result.MaxFrameStep, std::sqrt(step.x * step.x + step.y * step.y));
+			}
+			previous = current;
+			previousExtrapolated = extrapolated;
+			hasPrevious = true;
+		}
+
+		result.Frames = interpolator.GetStats().SampleCount;
+		result.ExtrapolatedFrames = interpolator.GetStats().ExtrapolatedSamples;
+		return result;
+	}
+
+	// With the delay covering an interval plus jitter, playback should almost never run dry,
+	// and the player should never move faster on screen than it does on the server
+	static void VerifyPlayback()
+	{
+		PlaybackResult result = Playback(60.0f, 0.04f, 0.1f);
+
+		float extrapolatedPercent = 100.0f * (float)result.ExtrapolatedFrames / (float)std::max(result.Frames, (uint64_t)1);
+		if (extrapolatedPercent > 1.0f)
+			Benchmark::ReportFailure("Interpolation", fmt::format("{:.2f}% of frames extrapolated at 15Hz with 40ms jitter", extrapolatedPercent));
+
+		// Playback may run up to 5% fast while it eases onto a new clock offset
+		float maxExpectedStep = s_Speed * s_FrameTime * 1.06f;
+		if (result.MaxFrameStep > maxExpectedStep)
+			Benchmark::ReportFailure("Interpolation", fmt::format("Player jumped {:.3f} units in one frame (expected at most {:.3f})", result.MaxFrameStep, maxExpectedStep));
+	}
+
+	static void BenchmarkSample(uint32_t playerCount)
+	{
+		std::mt19937 random(playerCount);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+
+		SnapshotInterpolator interpolator;
+		Clock::time_point start = Clock::now();
+		for (uint32_t tick = s_SnapshotInterval; tick <= s_SnapshotInterval * 4; tick += s_SnapshotInterval)
+		{
+			auto snapshot = std::make_shared<WorldSnapshot>();
+			snapshot->Tick = tick;
+			snapshot->TickRate = s_TickRate;
+			snapshot->SnapshotInterval = s_SnapshotInterval;
+			for (uint32_t i = 0; i < playerCount; i++)
+				snapshot->Players[MakePlayerID(i, 1)] = { { position(random), position(random) }, { s_Speed, 0.0f } };
+
+			interpolator.Push(snapshot, start + ToDuration((double)tick / s_TickRate));
+		}
+
+		// Between the last two snapshots once the delay is applied
+		Clock::time_point sampleTime = start + ToDuration((double)(s_SnapshotInterval * 3.5f) / s_TickRate + interpolator.GetInterpolationDelay());
+
+		PlayerStore players;
+		constexpr uint32_t samples = 1000;
+		double time = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < samples; i++)
+			{
+				interpolator.Sample(sampleTime, players);
+				Benchmark::DoNotOptimize(players);
+			}
+		});
+
+		Benchmark::Report({ "Interpolation", fmt::format("Sample ({} players)", playerCount), (uint64_t)samples * playerCount, time });
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(InterpolationSuite)
+{
+	Cubed::VerifyPlayback();
+
+	for (uint32_t count : { 10u, 100u, 1000u })
+		Cubed::BenchmarkSample(count);
+}
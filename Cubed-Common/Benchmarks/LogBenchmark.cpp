@@ -0,0 +1,166 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "AsyncLog.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	// A burst that fits in the default queue, so nothing should be dropped
+	static constexpr uint32_t s_Messages = 4000;
+
+	// A real file stands in for the terminal: every flush is a system call, like std::endl on stdout
+	struct FileSink
+	{
+		std::FILE* File = std::tmpfile();
+		uint64_t Bytes = 0;
+
+		~FileSink() { if (File) std::fclose(File); }
+
+		void Write(std::string_view text)
+		{
+			std::fwrite(text.data(), 1, text.size(), File);
+			std::fflush(File);
+			Bytes += text.size();
+		}
+	};
+
+	static void BenchmarkThroughput()
+	{
+		FileSink syncSink;
+		if (!syncSink.File)
+		{
+			Benchmark::ReportFailure("Log", "couldn't open a temporary file");
+			return;
+		}
+
+		// What HeadlessConsole did: format, write and flush on the logging thread
+		double syncTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < s_Messages; i++)
+			{
+				std::string message = fmt::format("[Server] Client connected! ID={} PlayerID={}", i, i * 3);
+				message += '\n';
+				syncSink.Write(message);
+			}
+		});
+
+		FileSink asyncSink;
+		AsyncLog log(AsyncLog::DefaultQueueCapacity, AsyncLog::DefaultHistoryRetention, [&](std::string_view text) { asyncSink.Write(text); });
+
+		// Only the logging thread's side is timed: formatting and queueing. The writer catches up between runs.
+		uint64_t dropped = 0;
+		double asyncTime = 1e30;
+		for (uint32_t run = 0; run < s_Runs; run++)
+		{
+			double time = Benchmark::Measure(1, [&]()
+			{
+				for (uint32_t i = 0; i < s_Messages; i++)
+					dropped += !log.Push({ "Server", fmt::format("Client connected! ID={} PlayerID={}", i, i * 3) });
+			});
+			asyncTime = std::min(asyncTime, time);
+			log.Flush();
+		}
+
+		Benchmark::Report({ "Log", "Synchronous write + flush", s_Messages, syncTime });
+		Benchmark::Report({ "Log", fmt::format("Async push ({} writes for {} messages)", log.GetBatchCount(), log.GetWrittenCount()), s_Messages, asyncTime });
+
+		if (dropped != 0 || log.GetWrittenCount() != (uint64_t)s_Messages * s_Runs)
+			Benchmark::ReportFailure("Log", fmt::format("{} messages written and {} dropped of {}", log.GetWrittenCount(), dropped, s_Messages * s_Runs));
+		if (asyncSink.Bytes != syncSink.Bytes)
+			Benchmark::ReportFailure("Log", "async output differs in size from the synchronous output");
+		if (log.GetHistory().size() != AsyncLog::DefaultHistoryRetention)
+			Benchmark::ReportFailure("Log", fmt::format("history holds {} messages, retention is {}", log.GetHistory().size(), AsyncLog::DefaultHistoryRetention));
+	}
+
+	static void BenchmarkProducers(uint32_t threadCount)
+	{
+		const uint32_t messagesPerThread = s_Messages / threadCount;
+
+		FileSink sink;
+		AsyncLog log(AsyncLog::DefaultQueueCapacity, AsyncLog::DefaultHistoryRetention, [&](std::string_view text) { sink.Write(text); });
+
+		std::atomic<uint64_t> dropped = 0;
+		double time = Benchmark::Measure(s_Runs, [&]()
+		{
+			std::vector<std::thread> threads;
+			for (uint32_t t = 0; t < threadCount; t++)
+			{
+				threads.emplace_back([&, t]()
+				{
+					for (uint32_t i = 0; i < messagesPerThread; i++)
+						dropped += !log.Push({ "Net", fmt::format("thread {} message {}", t, i) });
+				});
+			}
+
+			for (std::thread& thread : threads)
+				thread.join();
+			log.Flush();
+		});
+
+		Benchmark::Report({ "Log", fmt::format("Async push + flush ({} threads)", threadCount), (uint64_t)messagesPerThread * threadCount, time });
+
+		uint64_t pushed = (uint64_t)messagesPerThread * threadCount * s_Runs;
+		if (log.GetWrittenCount() + dropped != pushed || log.GetDroppedCount() != dropped)
+			Benchmark::ReportFailure("Log", fmt::format("{} threads: {} written and {} dropped of {} pushed", threadCount, log.GetWrittenCount(), dropped.load(), pushed));
+	}
+
+	static void VerifyOverload()
+	{
+		// A tiny queue and a terminal that takes a millisecond per write
+		std::string output;
+		uint64_t dropped = 0;
+		{
+			AsyncLog log(64, 100, [&](std::string_view text)
+			{
+				output += text;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			});
+
+			for (uint32_t i = 0; i < 10000; i++)
+				dropped += !log.Push({ {}, fmt::format("message {}", i) });
+
+			log.Flush();
+			uint64_t expectedHistory = std::min<uint64_t>(100, 10000 - dropped);
+			if (log.GetHistory().size() != expectedHistory)
+				Benchmark::ReportFailure("Log", fmt::format("history holds {} messages after an overload, expected {}", log.GetHistory().size(), expectedHistory));
+		}
+
+		if (dropped == 0)
+			Benchmark::ReportFailure("Log", "an overloaded log dropped nothing (the queue should be full)");
+		else if (output.find("messages dropped") == std::string::npos)
+			Benchmark::ReportFailure("Log", "dropped messages weren't reported in the output");
+
+		// Whatever was accepted comes out in order
+		size_t position = 0;
+		int32_t previous = -1;
+		bool ordered = true;
+		while ((position = output.find("message ", position)) != std::string::npos)
+		{
+			position += 8;
+			int32_t index = std::atoi(output.c_str() + position);
+			ordered &= index > previous;
+			previous = index;
+		}
+		if (!ordered)
+			Benchmark::ReportFailure("Log", "messages came out of order");
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(LogSuite)
+{
+	Cubed::VerifyOverload();
+	Cubed::BenchmarkThroughput();
+
+	for (uint32_t threadCount : { 2u, 8u })
+		Cubed::BenchmarkProducers(threadCount);
+}
@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Movement.h"
+#include "Snapshot.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	static constexpr float s_Timestep = 1.0f / 30.0f;
+
+	struct MovementState
+	{
+		std::vector<glm::vec2> Positions;
+		std::vector<glm::vec2> Velocities;
+		std::vector<glm::vec2> Directions;
+	};
+
+	// Spread across the whole world (so clamping gets exercised) with every input combination
+	static MovementState RandomMovementState(uint32_t count, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(PlayerPositionQuantization.Min - 16.0f, PlayerPositionQuantization.Max + 16.0f);
+		std::uniform_real_distribution<float> velocity(-PlayerMovement.Speed, PlayerMovement.Speed);
+		std::uniform_int_distribution<int> axis(-1, 1);
+
+		MovementState state;
+		state.Positions.resize(count);
+		state.Velocities.resize(count);
+		state.Directions.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			state.Positions[i] = { position(random), position(random) };
+			state.Velocities[i] = { velocity(random), velocity(random) };
+
+			PlayerInput input;
+			input.MoveX = (int8_t)axis(random);
+			input.MoveY = (int8_t)axis(random);
+			state.Directions[i] = GetInputDirection(input);
+		}
+		return state;
+	}
+
+	static bool IsBitIdentical(const std::vector<glm::vec2>& a, const std::vector<glm::vec2>& b)
+	{
+		return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(glm::vec2)) == 0;
+	}
+
+	// Odd counts cover the scalar tail after the last full SIMD register
+	static void VerifyKernels()
+	{
+		for (uint32_t count : { 1u, 2u, 3u, 5u, 7u, 1001u, 4096u })
+		{
+			MovementState scalar = RandomMovementState(count, count);
+			MovementState simd = scalar;
+
+			// Several steps so damping and clamping compound
+			for (uint32_t step = 0; step < 64; step++)
+			{
+				IntegrateMovementScalar(scalar.Positions.data(), scalar.Velocities.data(), scalar.Directions.data(), count, s_Timestep);
+				IntegrateMovementSIMD(simd.Positions.data(), simd.Velocities.data(), simd.Directions.data(), count, s_Timestep);
+			}
+
+			if (!IsBitIdentical(scalar.Positions, simd.Positions) || !IsBitIdentical(scalar.Velocities, simd.Velocities))
+				Benchmark::ReportFailure("Movement", fmt::format("{} kernel differs from scalar for {} players", GetMovementKernelName(), count));
+		}
+	}
+
+	static void BenchmarkKernels(uint32_t count)
+	{
+		MovementState state = RandomMovementState(count, 1);
+		std::string suffix = fmt::format(" ({})", count);
+
+		double scalarTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			IntegrateMovementScalar(state.Positions.data(), state.Velocities.data(), state.Directions.data(), count, s_Timestep);
+			Benchmark::DoNotOptimize(state.Positions);
+		});
+
+		double simdTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			IntegrateMovementSIMD(state.Positions.data(), state.Velocities.data(), state.Directions.data(), count, s_Timestep);
+			Benchmark::DoNotOptimize(state.Positions);
+		});
+
+		Benchmark::Report({ "Movement", "Scalar integrate" + suffix, count, scalarTime });
+		Benchmark::Report({ "Movement", fmt::format("{} integrate{}", GetMovementKernelName(), suffix), count, simdTime });
+		std::cout << fmt::format("{:<24} {:.0f} vs {:.0f} players/ms\n", "Movement", count / scalarTime, count / simdTime);
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(MovementSuite)
+{
+	Cubed::VerifyKernels();
+
+	for (uint32_t count : { 1000u, 10000u, 100000u, 1000000u })
+		Cubed::BenchmarkKernels(count);
+}
@@ -0,0 +1,131 @@
+#include "Benchmark.h"
+
+#include <vector>
+
+#include "PacketBuffer.h"
+#include "ServerPacket.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	static constexpr uint32_t s_Ticks = 100;
+
+	// Stand-in for a serialized payload that's identical for every recipient
+	static void WritePayload(PacketStreamWriter& stream, uint32_t payloadSize, uint32_t tick)
+	{
+		stream.WriteRaw(PacketType::Message);
+		for (uint32_t i = 0; i < payloadSize / sizeof(uint32_t); i++)
+			stream.WriteRaw<uint32_t>(tick + i);
+	}
+
+	// Each client's outgoing queue, as a transport that retains packets until they're acknowledged would keep them
+	struct ClientQueues
+	{
+		std::vector<std::vector<SharedPacket>> Shared;
+		std::vector<std::vector<Walnut::Buffer>> Copies;
+
+		ClientQueues(uint32_t clientCount)
+			: Shared(clientCount), Copies(clientCount)
+		{
+			for (uint32_t i = 0; i < clientCount; i++)
+			{
+				Shared[i].reserve(s_Ticks);
+				Copies[i].reserve(s_Ticks);
+			}
+		}
+
+		void Clear()
+		{
+			for (auto& queue : Shared)
+				queue.clear();
+
+			for (auto& queue : Copies)
+			{
+				for (Walnut::Buffer& buffer : queue)
+					buffer.Release();
+				queue.clear();
+			}
+		}
+	};
+
+	static void BenchmarkBroadcast(uint32_t clientCount, uint32_t payloadSize)
+	{
+		std::string suffix = fmt::format(" ({} clients, {}B)", clientCount, payloadSize);
+		uint64_t sends = (uint64_t)clientCount * s_Ticks;
+		ClientQueues queues(clientCount);
+
+		// What a plain buffer API forces: every recipient gets its own copy of the bytes
+		double copyTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			queues.Clear();
+			for (uint32_t tick = 0; tick < s_Ticks; tick++)
+			{
+				PacketStreamWriter& stream = GetThreadPacketWriter();
+				WritePayload(stream, payloadSize, tick);
+				for (uint32_t client = 0; client < clientCount; client++)
+					queues.Copies[client].push_back(Walnut::Buffer::Copy(stream.GetBuffer()));
+			}
+		});
+
+		// Serialize once into pooled storage, recipients share it by reference
+		auto broadcastShared = [&]()
+		{
+			queues.Clear();
+			for (uint32_t tick = 0; tick < s_Ticks; tick++)
+			{
+				PacketStreamWriter& stream = GetThreadPacketWriter();
+				WritePayload(stream, payloadSize, tick);
+				SharedPacket packet = PacketPool::Get().Create(stream);
+				for (uint32_t client = 0; client < clientCount; client++)
+					queues.Shared[client].push_back(packet);
+			}
+		};
+
+		// Warm up the arena and pool, after which broadcasting must not allocate
+		broadcastShared();
+		uint64_t allocatedBlocks = PacketPool::Get().GetAllocatedBlockCount();
+		uint64_t arenaCapacity = GetThreadPacketWriter().GetCapacity();
+
+		double sharedTime = Benchmark::Measure(s_Runs, broadcastShared);
+
+		if (PacketPool::Get().GetAllocatedBlockCount() != allocatedBlocks || GetThreadPacketWriter().GetCapacity() != arenaCapacity)
+			Benchmark::ReportFailure("PacketBuffer", "steady-state broadcast allocated" + suffix);
+
+		queues.Clear();
+
+		Benchmark::Report({ "PacketBuffer", "Copy per client" + suffix, sends, copyTime });
+		Benchmark::Report({ "PacketBuffer", "SharedPacket" + suffix, sends, sharedTime });
+	}
+
+	static void VerifyOverflow()
+	{
+		PacketStreamWriter stream(16, 64);
+		for (uint32_t i = 0; i < 16; i++)
+			stream.WriteRaw<uint32_t>(i);
+
+		if (!stream || stream.GetBuffer().Size != 64)
+			Benchmark::ReportFailure("PacketBuffer", "writer failed to grow to its maximum capacity");
+
+		stream.WriteRaw<uint8_t>(0);
+		if (stream || stream.GetBuffer().Size != 64)
+			Benchmark::ReportFailure("PacketBuffer", "writer accepted data past its maximum capacity");
+
+		stream.Reset();
+		if (!stream || stream.GetBuffer().Size != 0)
+			Benchmark::ReportFailure("PacketBuffer", "writer did not recover after Reset()");
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(PacketBufferSuite)
+{
+	Cubed::VerifyOverflow();
+
+	for (uint32_t clientCount : { 16u, 256u })
+	{
+		for (uint32_t payloadSize : { 256u, 4096u })
+			Cubed::BenchmarkBroadcast(clientCount, payloadSize);
+	}
+}
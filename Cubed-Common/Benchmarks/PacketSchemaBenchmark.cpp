@@ -0,0 +1,310 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ChatHistory.h"
+#include "ClientRoster.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "ServerPacket.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	static constexpr uint32_t s_PacketsPerRun = 200000;
+
+	// Fixed-size layouts are checked by size alone, with offsets known at compile time
+	static_assert(ClientDisconnectPacket::IsFixedSize && ClientDisconnectPacket::MinSize == sizeof(PacketType) + 8);
+	static_assert(FixedFieldOffsets<ClientDisconnectPacket>[ClientDisconnectPacket::ClientID] == sizeof(PacketType) + 4);
+	static_assert(ConnectionResponse::MinSize == sizeof(PacketType) + 5);
+	static_assert(!ConnectionRequest::IsFixedSize && ClientListPacket::HasPayload && !ClientListRequest::HasPayload);
+
+	static Walnut::Buffer GetBuffer(const std::vector<uint8_t>& bytes, size_t size)
+	{
+		return Walnut::Buffer(bytes.data(), size);
+	}
+
+	// Reads a packet the way its receive handler does; returns how many values it got out (0 = dropped)
+	using DecodeFunc = std::function<uint32_t(Walnut::Buffer buffer)>;
+
+	struct EncodedPacket
+	{
+		std::string Name;
+		std::vector<uint8_t> Bytes;
+		bool HasPayload = false;
+		DecodeFunc Decode;
+	};
+
+	static uint32_t DecodeConnectionRequest(Walnut::Buffer buffer)
+	{
+		PacketView<ConnectionRequest> request(buffer);
+		return request ? (uint32_t)request.Get<ConnectionRequest::Username>().size() + 3 : 0;
+	}
+
+	static uint32_t DecodeChatMessage(Walnut::Buffer buffer)
+	{
+		PacketView<ChatMessagePacket> message(buffer);
+		return message ? (uint32_t)ReadChatMessage(message).Text.size() + 2 : 0;
+	}
+
+	static uint32_t DecodeClientDisconnect(Walnut::Buffer buffer)
+	{
+		PacketView<ClientDisconnectPacket> disconnect(buffer);
+		return disconnect ? 1 + (disconnect.Get<ClientDisconnectPacket::ClientID>() != 0) : 0;
+	}
+
+	static uint32_t DecodeConnectionResponse(Walnut::Buffer buffer)
+	{
+		PacketView<ConnectionResponse> response(buffer);
+		return response ? 1 + response.Get<ConnectionResponse::Accepted>() : 0;
+	}
+
+	static uint32_t DecodeClientList(Walnut::Buffer buffer)
+	{
+		PacketView<ClientListPacket> list(buffer);
+		if (!list)
+			return 0;
+
+		uint32_t values = 1;
+		RecordReader<RosterEntryRecord> reader(list.Get<ClientListPacket::Entries>());
+		for (uint32_t i = 0; i < list.Get<ClientListPacket::Count>(); i++)
+		{
+			PacketView<RosterEntryRecord> entry = reader.Next();
+			if (!entry)
+				break;
+			values += (uint32_t)entry.Get<RosterEntryRecord::Username>().size() + 1;
+		}
+		return values;
+	}
+
+	static uint32_t DecodeMessageHistory(Walnut::Buffer buffer)
+	{
+		PacketView<MessageHistoryPacket> page(buffer);
+		if (!page)
+			return 0;
+
+		uint32_t values = 1;
+		RecordReader<ChatMessageRecord> reader(page.Get<MessageHistoryPacket::Messages>());
+		while (PacketView<ChatMessageRecord> record = reader.Next())
+			values += (uint32_t)record.Get<ChatMessageRecord::Text>().size() + 1;
+		return values;
+	}
+
+	static EncodedPacket Encode(std::string name, bool hasPayload, DecodeFunc decode, PacketStreamWriter& stream)
+	{
+		Walnut::Buffer buffer = stream.GetBuffer();
+		return { std::move(name), std::vector<uint8_t>(buffer.As<uint8_t>(), buffer.As<uint8_t>() + buffer.Size), hasPayload, std::move(decode) };
+	}
+
+	static std::vector<EncodedPacket> EncodeSamples()
+	{
+		std::vector<EncodedPacket> packets;
+		PacketStreamWriter stream;
+
+		WritePacket<ConnectionRequest>(stream, 0xff8000u, "Alice", 7u, 42u);
+		packets.push_back(Encode("ConnectionRequest", false, DecodeConnectionRequest, stream));
+
+		stream.Reset();
+		WritePacket<ChatMessagePacket>(stream, 12ull, "Alice", "hello there");
+		packets.push_back(Encode("ChatMessage", false, DecodeChatMessage, stream));
+
+		stream.Reset();
+		WritePacket<ClientDisconnectPacket>(stream, 43u, 9u);
+		packets.push_back(Encode("ClientDisconnect", false, DecodeClientDisconnect, stream));
+
+		stream.Reset();
+		WritePacket<ConnectionResponse>(stream, true, 9u);
+		packets.push_back(Encode("ConnectionResponse", false, DecodeConnectionResponse, stream));
+
+		ClientRoster roster;
+		for (uint32_t i = 0; i < 4; i++)
+			roster.Add(i, i, fmt::format("Player{}", i));
+		stream.Reset();
+		roster.WriteList(stream);
+		packets.push_back(Encode("ClientList", true, DecodeClientList, stream));
+
+		ChatHistory history;
+		for (uint32_t i = 0; i < 4; i++)
+			history.Add("Player", fmt::format("message {}", i));
+		stream.Reset();
+		history.WritePage(stream, 0);
+		packets.push_back(Encode("MessageHistory", true, DecodeMessageHistory, stream));
+
+		return packets;
+	}
+
+	static void VerifyRoundTrip()
+	{
+		PacketStreamWriter stream;
+		WritePacket<ConnectionRequest>(stream, 0xff8000u, "Alice", 7u, 42u);
+		PacketView<ConnectionRequest> request(stream.GetBuffer());
+		if (!request || request.Get<ConnectionRequest::Color>() != 0xff8000 || request.Get<ConnectionRequest::Username>() != "Alice"
+			|| request.Get<ConnectionRequest::RosterEpoch>() != 7 || request.Get<ConnectionRequest::RosterVersion>() != 42)
+			Benchmark::ReportFailure("PacketSchema", "ConnectionRequest didn't read back what was written");
+		if (stream.GetBuffer().Size != GetPacketSize<ConnectionRequest>(0xff8000u, std::string_view("Alice"), 7u, 42u))
+			Benchmark::ReportFailure("PacketSchema", "GetPacketSize disagrees with WritePacket");
+
+		// Same bytes as the hand-written serialization it replaced
+		PacketStreamWriter legacy;
+		legacy.WriteRaw(PacketType::ClientConnectionRequest);
+		legacy.WriteRaw<uint32_t>(0xff8000);
+		legacy.WriteString("Alice");
+		legacy.WriteRaw<uint32_t>(7);
+		legacy.WriteRaw<uint32_t>(42);
+		if (legacy.GetBuffer().Size != stream.GetBuffer().Size || std::memcmp(legacy.GetBuffer().Data, stream.GetBuffer().Data, legacy.GetBuffer().Size) != 0)
+			Benchmark::ReportFailure("PacketSchema", "WritePacket changed the wire format");
+
+		// The right size but the wrong packet type
+		stream.Reset();
+		WritePacket<ClientListRequest>(stream, 1u, 2u);
+		if (PacketView<ClientDisconnectPacket>(stream.GetBuffer()) || !PacketView<ClientListRequest>(stream.GetBuffer()))
+			Benchmark::ReportFailure("PacketSchema", "a view accepted another packet type");
+	}
+
+	static void VerifyTruncation()
+	{
+		uint32_t accepted = 0;
+		for (const EncodedPacket& packet : EncodeSamples())
+		{
+			uint32_t fullValues = packet.Decode(GetBuffer(packet.Bytes, packet.Bytes.size()));
+			if (fullValues == 0)
+				Benchmark::ReportFailure("PacketSchema", packet.Name + " didn't decode");
+
+			// Every cut either fails its view or, inside a payload, stops at the last whole record.
+			// Each cut is a fresh allocation of exactly that size, so a sanitizer catches any read past it.
+			for (size_t size = 0; size < packet.Bytes.size(); size++)
+			{
+				std::vector<uint8_t> truncated(packet.Bytes.begin(), packet.Bytes.begin() + size);
+				uint32_t values = packet.Decode(GetBuffer(truncated, size));
+				if ((!packet.HasPayload && values != 0) || values >= fullValues)
+					accepted++;
+			}
+
+			// A trailing byte isn't part of any layout
+			std::vector<uint8_t> padded = packet.Bytes;
+			padded.push_back(0);
+			if (!packet.HasPayload && packet.Decode(GetBuffer(padded, padded.size())) != 0)
+				accepted++;
+		}
+
+		if (accepted)
+			Benchmark::ReportFailure("PacketSchema", fmt::format("{} truncated or padded packets were accepted", accepted));
+	}
+
+	static void VerifyRandomBytes()
+	{
+		// Garbage behind a valid packet type, including string lengths of any size, through every reader
+		const DecodeFunc decoders[] = { DecodeConnectionRequest, DecodeChatMessage, DecodeClientDisconnect, DecodeConnectionResponse, DecodeClientList, DecodeMessageHistory };
+		std::mt19937 random(1234);
+		uint64_t values = 0;
+		for (uint32_t i = 0; i < 100000; i++)
+		{
+			std::vector<uint8_t> bytes(random() % 64);
+			for (uint8_t& byte : bytes)
+				byte = (uint8_t)random();
+
+			PacketType types[] = { PacketType::ClientConnectionRequest, PacketType::Message, PacketType::ClientList, PacketType::MessageHistory, PacketType::ClientDisconnect };
+			PacketType type = types[random() % std::size(types)];
+			if (bytes.size() >= sizeof(type))
+				std::memcpy(bytes.data(), &type, sizeof(type));
+
+			for (const DecodeFunc& decode : decoders)
+				values += decode(GetBuffer(bytes, bytes.size()));
+		}
+		Benchmark::DoNotOptimize(values);
+	}
+
+	static void BenchmarkDecode()
+	{
+		PacketStreamWriter stream;
+		WritePacket<ConnectionRequest>(stream, 0xff8000u, "Player1234", 7u, 42u);
+		std::vector<uint8_t> request(stream.GetBuffer().As<uint8_t>(), stream.GetBuffer().As<uint8_t>() + stream.GetBuffer().Size);
+
+		// What ServerLayer did: a stream read per field, each checked, the username copied out
+		double streamTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < s_PacketsPerRun; i++)
+			{
+				Walnut::BufferStreamReader reader(GetBuffer(request, request.size()));
+				PacketType type;
+				uint32_t color = 0, epoch = 0, version = 0;
+				size_t length = 0;
+				std::string username;
+				bool valid = reader.ReadData((char*)&type, sizeof(type)) && reader.ReadData((char*)&color, sizeof(color))
+					&& reader.ReadData((char*)&length, sizeof(length)) && length <= MaxUsernameLength;
+				if (valid)
+				{
+					username.resize(length);
+					valid = reader.ReadData(username.data(), length) && reader.ReadData((char*)&epoch, sizeof(epoch)) && reader.ReadData((char*)&version, sizeof(version));
+				}
+				Benchmark::DoNotOptimize(valid);
+				Benchmark::DoNotOptimize(username);
+				Benchmark::DoNotOptimize(version);
+			}
+		});
+
+		double viewTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < s_PacketsPerRun; i++)
+			{
+				PacketView<ConnectionRequest> view(GetBuffer(request, request.size()));
+				bool valid = view.IsValid();
+				std::string_view username = valid ? view.Get<ConnectionRequest::Username>() : std::string_view();
+				uint32_t version = valid ? view.Get<ConnectionRequest::RosterVersion>() : 0;
+				Benchmark::DoNotOptimize(valid);
+				Benchmark::DoNotOptimize(username);
+				Benchmark::DoNotOptimize(version);
+			}
+		});
+
+		Benchmark::Report({ "PacketSchema", "ConnectionRequest, checked stream reads", s_PacketsPerRun, streamTime, (double)request.size() });
+		Benchmark::Report({ "PacketSchema", "ConnectionRequest, PacketView", s_PacketsPerRun, viewTime, (double)request.size() });
+
+		stream.Reset();
+		WritePacket<ClientDisconnectPacket>(stream, 43u, 9u);
+		std::vector<uint8_t> disconnect(stream.GetBuffer().As<uint8_t>(), stream.GetBuffer().As<uint8_t>() + stream.GetBuffer().Size);
+
+		double fixedStreamTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < s_PacketsPerRun; i++)
+			{
+				Walnut::BufferStreamReader reader(GetBuffer(disconnect, disconnect.size()));
+				PacketType type;
+				uint32_t version = 0, clientID = 0;
+				bool valid = reader.ReadData((char*)&type, sizeof(type)) && reader.ReadData((char*)&version, sizeof(version)) && reader.ReadData((char*)&clientID, sizeof(clientID));
+				Benchmark::DoNotOptimize(valid);
+				Benchmark::DoNotOptimize(clientID);
+			}
+		});
+
+		double fixedViewTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < s_PacketsPerRun; i++)
+			{
+				PacketView<ClientDisconnectPacket> view(GetBuffer(disconnect, disconnect.size()));
+				bool valid = view.IsValid();
+				uint32_t clientID = valid ? view.Get<ClientDisconnectPacket::ClientID>() : 0;
+				Benchmark::DoNotOptimize(valid);
+				Benchmark::DoNotOptimize(clientID);
+			}
+		});
+
+		Benchmark::Report({ "PacketSchema", "ClientDisconnect, checked stream reads", s_PacketsPerRun, fixedStreamTime, (double)disconnect.size() });
+		Benchmark::Report({ "PacketSchema", "ClientDisconnect, PacketView", s_PacketsPerRun, fixedViewTime, (double)disconnect.size() });
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(PacketSchemaSuite)
+{
+	Cubed::VerifyRoundTrip();
+	Cubed::VerifyTruncation();
+	Cubed::VerifyRandomBytes();
+	Cubed::BenchmarkDecode();
+}
@@ -0,0 +1,133 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "PlayerStore.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	static constexpr float s_Timestep = 1.0f / 30.0f;
+
+	static std::vector<uint32_t> ShuffledIndices(uint32_t count, uint32_t seed)
+	{
+		std::vector<uint32_t> indices(count);
+		for (uint32_t i = 0; i < count; i++)
+			indices[i] = i;
+		std::shuffle(indices.begin(), indices.end(), std::mt19937(seed));
+		return indices;
+	}
+
+	static void BenchmarkMap(uint32_t count)
+	{
+		std::string suffix = fmt::format(" ({})", count);
+		std::vector<uint32_t> lookupOrder = ShuffledIndices(count, 1);
+		std::vector<uint32_t> removeOrder = ShuffledIndices(count, 2);
+
+		// Same ID distribution the store produces, so tree shape is comparable
+		std::vector<uint32_t> ids(count);
+		for (uint32_t i = 0; i < count; i++)
+			ids[i] = MakePlayerID(i, 1);
+
+		std::map<uint32_t, PlayerData> players;
+		double insertTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			players.clear();
+			for (uint32_t id : ids)
+				players[id] = { { 1.0f, 2.0f }, { 3.0f, 4.0f } };
+		});
+
+		double lookupTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			glm::vec2 sum(0.0f);
+			for (uint32_t index : lookupOrder)
+				sum += players.find(ids[index])->second.Position;
+			Benchmark::DoNotOptimize(sum);
+		});
+
+		double iterateTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (auto& [id, playerData] : players)
+				playerData.Position += playerData.Velocity * s_Timestep;
+			Benchmark::DoNotOptimize(players);
+		});
+
+		double removeTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			std::map<uint32_t, PlayerData> copy = players;
+			for (uint32_t index : removeOrder)
+				copy.erase(ids[index]);
+			Benchmark::DoNotOptimize(copy);
+		});
+
+		Benchmark::Report({ "PlayerStore", "std::map insert" + suffix, count, insertTime });
+		Benchmark::Report({ "PlayerStore", "std::map lookup" + suffix, count, lookupTime });
+		Benchmark::Report({ "PlayerStore", "std::map iterate" + suffix, count, iterateTime });
+		Benchmark::Report({ "PlayerStore", "std::map copy+remove" + suffix, count, removeTime });
+	}
+
+	static void BenchmarkStore(uint32_t count)
+	{
+		std::string suffix = fmt::format(" ({})", count);
+		std::vector<uint32_t> lookupOrder = ShuffledIndices(count, 1);
+		std::vector<uint32_t> removeOrder = ShuffledIndices(count, 2);
+
+		PlayerStore players;
+		std::vector<PlayerID> ids(count);
+		double insertTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			players.Clear();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				ids[i] = players.Create();
+				players.Set(ids[i], { { 1.0f, 2.0f }, { 3.0f, 4.0f } });
+			}
+		});
+
+		double lookupTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			glm::vec2 sum(0.0f);
+			const std::vector<glm::vec2>& positions = players.GetPositions();
+			for (uint32_t index : lookupOrder)
+				sum += positions[players.GetDenseIndex(ids[index])];
+			Benchmark::DoNotOptimize(sum);
+		});
+
+		double iterateTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			glm::vec2* positions = players.GetPositions().data();
+			const glm::vec2* velocities = players.GetVelocities().data();
+			for (uint32_t i = 0; i < players.GetCount(); i++)
+				positions[i] += velocities[i] * s_Timestep;
+			Benchmark::DoNotOptimize(positions);
+		});
+
+		double removeTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			PlayerStore copy = players;
+			for (uint32_t index : removeOrder)
+				copy.Remove(ids[index]);
+			Benchmark::DoNotOptimize(copy);
+		});
+
+		Benchmark::Report({ "PlayerStore", "PlayerStore insert" + suffix, count, insertTime });
+		Benchmark::Report({ "PlayerStore", "PlayerStore lookup" + suffix, count, lookupTime });
+		Benchmark::Report({ "PlayerStore", "PlayerStore iterate" + suffix, count, iterateTime });
+		Benchmark::Report({ "PlayerStore", "PlayerStore copy+remove" + suffix, count, removeTime });
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(PlayerStoreSuite)
+{
+	for (uint32_t count : { 1000u, 10000u, 100000u })
+	{
+		Cubed::BenchmarkMap(count);
+		Cubed::BenchmarkStore(count);
+	}
+}
@@ -0,0 +1,246 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <iostream>
+#include <random>
+
+#include "MovementPredictor.h"
+#include "InputQueue.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+
+	static constexpr uint32_t s_TickRate = 30;
+	static constexpr uint32_t s_SnapshotInterval = 2;
+	static constexpr double s_TickTime = 1.0 / s_TickRate;
+	static constexpr float s_Timestep = 1.0f / s_TickRate;
+
+	struct LinkSpecification
+	{
+		double Latency = 0.05; // one way, seconds
+		double Jitter = 0.0; // up to this much extra, uniformly distributed
+		double Loss = 0.0; // fraction of messages dropped, as if sent unreliably
+	};
+
+	// In order like the real connection, so jitter delays but never reorders
+	template<typename T>
+	class SimulatedLink
+	{
+	public:
+		SimulatedLink(const LinkSpecification& specification, uint32_t seed)
+			: m_Specification(specification), m_Random(seed) {}
+
+		void Send(double time, const T& message)
+		{
+			if (std::uniform_real_distribution<double>(0.0, 1.0)(m_Random) < m_Specification.Loss)
+				return;
+
+			double arrival = time + m_Specification.Latency + std::uniform_real_distribution<double>(0.0, m_Specification.Jitter)(m_Random);
+			if (!m_InFlight.empty())
+				arrival = std::max(arrival, m_InFlight.back().first);
+			m_InFlight.emplace_back(arrival, message);
+		}
+
+		template<typename Func>
+		void Deliver(double time, Func&& func)
+		{
+			while (!m_InFlight.empty() && m_InFlight.front().first <= time)
+			{
+				func(m_InFlight.front().second);
+				m_InFlight.pop_front();
+			}
+		}
+	private:
+		LinkSpecification m_Specification;
+		std::mt19937 m_Random;
+		std::deque<std::pair<double, T>> m_InFlight;
+	};
+
+	struct SimulatedSnapshot
+	{
+		PlayerData State;
+		bool HasLastInputSequence = false;
+		uint32_t LastInputSequence = 0;
+	};
+
+	// Walks the eight compass directions, standing still every fourth step
+	static PlayerInput GetScriptedInput(uint32_t clientTick)
+	{
+		static constexpr int8_t directions[8][2] = { { 0, -1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 } };
+
+		uint32_t step = clientTick / 20;
+		PlayerInput input;
+		if (step % 4 != 3)
+		{
+			input.MoveX = directions[step % 8][0];
+			input.MoveY = directions[step % 8][1];
+		}
+		return input;
+	}
+
+	struct InputPacket
+	{
+		std::array<PlayerInput, InputSendWindow::Capacity> Inputs;
+		uint32_t Count = 0;
+	};
+
+	//
+	// Deterministic client/server loop with simulated latency. Both sides mirror the real ones:
+	// the client samples one input per tick and sends them in batches through InputSendWindow;
+	// the server queues them in an InputQueue and applies one per tick, then integrates and
+	// every SnapshotInterval ticks sends a quantized snapshot.
+	//
+	struct SimulationResult
+	{
+		PredictionStats Stats;
+		uint64_t LostInputs = 0; // never reached the server, or were skipped by it
+	};
+
+	static SimulationResult SimulatePrediction(uint32_t ticks, const LinkSpecification& uplink, const LinkSpecification& downlink)
+	{
+		SimulationResult result;
+
+		SimulatedLink<InputPacket> inputLink(uplink, 1);
+		SimulatedLink<SimulatedSnapshot> snapshotLink(downlink, 2);
+
+		PlayerData serverState = { { 50.0f, 50.0f }, { 0.0f, 0.0f } };
+		glm::vec2 serverDirection = { 0.0f, 0.0f };
+		InputQueue serverInputs;
+		bool hasInput = false;
+		uint32_t lastInputSequence = 0;
+
+		MovementPredictor predictor;
+		predictor.Reset(QuantizePlayerData(serverState));
+		InputSendWindow inputWindow;
+		uint32_t inputSequence = 0;
+
+		// Client frames fall a fraction of a tick after server ticks, as they would in practice
+		constexpr double clientPhase = 0.3 * s_TickTime;
+
+		for (uint32_t tick = 1; tick <= ticks; tick++)
+		{
+			double serverTime = tick * s_TickTime;
+			inputLink.Deliver(serverTime, [&](const InputPacket& packet)
+			{
+				serverInputs.Push(packet.Inputs.data(), packet.Count);
+			});
+
+			PlayerInput serverInput;
+			if (serverInputs.Pop(serverInput))
+			{
+				if (hasInput && serverInput.Sequence != lastInputSequence + 1)
+					result.LostInputs += serverInput.Sequence - lastInputSequence - 1;
+
+				serverDirection = GetInputDirection(serverInput);
+				lastInputSequence = serverInput.Sequence;
+				hasInput = true;
+			}
+
+			IntegrateMovement(&serverState.Position, &serverState.Velocity, &serverDirection, 1, s_Timestep);
+			if (tick % s_SnapshotInterval == 0)
+				snapshotLink.Send(serverTime, { QuantizePlayerData(serverState), hasInput, lastInputSequence });
+
+			double clientTime = serverTime + clientPhase;
+			snapshotLink.Deliver(clientTime, [&](const SimulatedSnapshot& snapshot)
+			{
+				predictor.Reconcile(snapshot.State, snapshot.HasLastInputSequence, snapshot.LastInputSequence);
+			});
+
+			PlayerInput input = GetScriptedInput(tick);
+			input.Sequence = ++inputSequence;
+			predictor.Predict(input, s_Timestep);
+
+			if (inputWindow.Add(input))
+			{
+				InputPacket packet;
+				std::copy(inputWindow.GetInputs(), inputWindow.GetInputs() + inputWindow.GetCount(), packet.Inputs.begin());
+				packet.Count = inputWindow.GetCount();
+				inputLink.Send(clientTime, packet);
+			}
+		}
+
+		result.Stats = predictor.GetStats();
+		return result;
+	}
+
+	static void ReportPrediction(std::string_view name, const SimulationResult& result)
+	{
+		const PredictionStats& stats = result.Stats;
+		double averageCorrection = stats.Corrections ? stats.TotalCorrection / (double)stats.Corrections : 0.0;
+		std::cout << fmt::format("{:<24} {:<40} {:>6} corrections / {} snapshots, avg {:.2f} max {:.2f} units, {} replayed steps, {} lost inputs\n",
+			"Prediction", name, stats.Corrections, stats.Reconciliations, averageCorrection, stats.MaxCorrection, stats.ReplayedSteps, result.LostInputs);
+	}
+
+	static void VerifyPrediction()
+	{
+		// With steady latency every input lands on its own server tick, so prediction has to match
+		// the server exactly (up to quantization) no matter how long the round trip is
+		for (double latency : { 0.0, 0.05, 0.15 })
+		{
+			SimulationResult result = SimulatePrediction(3000, { latency, 0.0 }, { latency, 0.0 });
+			ReportPrediction(fmt::format("{:.0f}ms each way", latency * 1000.0), result);
+
+			if (result.Stats.Corrections > 0)
+				Benchmark::ReportFailure("Prediction", fmt::format("{} corrections at a steady {:.0f}ms latency", result.Stats.Corrections, latency * 1000.0));
+			if (result.Stats.Reconciliations == 0)
+				Benchmark::ReportFailure("Prediction", "No snapshots reached the client");
+		}
+
+		// The server's input queue absorbs jitter, so inputs are still applied one per tick in order.
+		// When the queue runs dry (heavy jitter, or waiting on the packet after a lost one) the server
+		// holds the previous input for an extra tick and the client gets corrected; reported for comparison.
+		ReportPrediction("50ms + 20ms jitter", SimulatePrediction(3000, { 0.05, 0.02 }, { 0.05, 0.02 }));
+		ReportPrediction("50ms + 60ms jitter", SimulatePrediction(3000, { 0.05, 0.06 }, { 0.05, 0.06 }));
+
+		// Each input is sent in two consecutive packets, so it's only lost when both are (0.25% at 5%
+		// packet loss, against 5% without redundancy); allow some slack for the random draw
+		constexpr uint32_t lossyTicks = 3000;
+		SimulationResult lossy = SimulatePrediction(lossyTicks, { 0.05, 0.0, 0.05 }, { 0.05, 0.0 });
+		ReportPrediction("50ms, 5% uplink loss", lossy);
+		if (lossy.LostInputs > lossyTicks / 100)
+			Benchmark::ReportFailure("Prediction", fmt::format("{} of {} inputs lost at 5% packet loss; redundant inputs should cover most of it", lossy.LostInputs, lossyTicks));
+	}
+
+	// Cost of rebasing onto a snapshot and replaying a round trip's worth of inputs
+	static void BenchmarkReconcile(uint32_t pendingInputs)
+	{
+		MovementPredictor predictor;
+		predictor.Reset({ { 50.0f, 50.0f }, { 0.0f, 0.0f } });
+
+		uint32_t sequence = 0;
+		for (uint32_t i = 0; i < pendingInputs; i++)
+		{
+			PlayerInput input = GetScriptedInput(i);
+			input.Sequence = ++sequence;
+			predictor.Predict(input, s_Timestep);
+		}
+
+		constexpr uint32_t iterations = 10000;
+		PlayerData authoritative = predictor.GetState();
+		double time = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				// Acknowledges nothing, so the same inputs are replayed every time
+				predictor.Reconcile(authoritative, false, 0);
+				Benchmark::DoNotOptimize(predictor.GetState());
+			}
+		});
+
+		Benchmark::Report({ "Prediction", fmt::format("Reconcile ({} pending inputs)", pendingInputs), (uint64_t)iterations * pendingInputs, time });
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(PredictionSuite)
+{
+	Cubed::VerifyPrediction();
+
+	for (uint32_t pendingInputs : { 3u, 10u, 30u })
+		Cubed::BenchmarkReconcile(pendingInputs);
+}
@@ -0,0 +1,276 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+#include "ClientRoster.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "ServerPacket.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+
+	// The interval the old protocol re-sent the whole ClientList at
+	static constexpr uint32_t s_ClientListInterval = 10;
+
+	static std::string MakeUsername(uint32_t i)
+	{
+		return fmt::format("Player{}", i);
+	}
+
+	// Applies a roster packet the way the client does; false means the client would ask for the list again
+	static bool ApplyRosterPacket(RosterReplica& replica, Walnut::Buffer buffer)
+	{
+		if (PacketView<ClientListPacket> list(buffer); list)
+			return replica.ApplyList(list);
+		if (PacketView<ClientConnectPacket> connect(buffer); connect)
+			return connect.Get<ClientConnectPacket::RosterVersion>() != 0 && replica.ApplyConnect(connect);
+		if (PacketView<ClientDisconnectPacket> disconnect(buffer); disconnect)
+			return replica.ApplyDisconnect(disconnect);
+		return false;
+	}
+
+	static bool Matches(const RosterReplica& replica, const ClientRoster& roster)
+	{
+		if (replica.GetVersion() != roster.GetVersion() || replica.GetEntries().size() != roster.GetEntries().size())
+			return false;
+
+		for (const auto& [clientID, entry] : roster.GetEntries())
+		{
+			const RosterEntry* copy = replica.Find(clientID);
+			if (!copy || copy->Username != entry.Username || copy->Color != entry.Color)
+				return false;
+		}
+		return true;
+	}
+
+	static void VerifyUsernames()
+	{
+		ClientRoster roster;
+		roster.ReserveUsername("Server");
+
+		if (!roster.Add(1, 0xff0000, "Alice"))
+			Benchmark::ReportFailure("Roster", "a free username was refused");
+		if (roster.Add(2, 0, "alice") || roster.Add(2, 0, "SERVER"))
+			Benchmark::ReportFailure("Roster", "a taken username was accepted with different case");
+		if (roster.Add(2, 0, "") || roster.Add(2, 0, std::string(MaxUsernameLength + 1, 'a')) || roster.Add(2, 0, "new\nline"))
+			Benchmark::ReportFailure("Roster", "an invalid username was accepted");
+		if (roster.Add(1, 0, "Bob"))
+			Benchmark::ReportFailure("Roster", "a client joined twice");
+
+		roster.Remove(1);
+		if (!roster.Add(2, 0, "ALICE"))
+			Benchmark::ReportFailure("Roster", "a username wasn't freed when its client left");
+	}
+
+	static void BenchmarkUsernameLookup(uint32_t clientCount)
+	{
+		std::string suffix = fmt::format(" ({} clients)", clientCount);
+
+		ClientRoster roster;
+		std::vector<RosterEntry> entries;
+		for (uint32_t i = 0; i < clientCount; i++)
+		{
+			roster.Add(i, 0, MakeUsername(i));
+			entries.push_back({ i, 0, MakeUsername(i) });
+		}
+
+		// Half taken, half free, like a mix of collisions and new names
+		std::vector<std::string> requested;
+		for (uint32_t i = 0; i < 1000; i++)
+			requested.push_back(MakeUsername(i * 2 * clientCount / 1000));
+
+		// What checking uniqueness against a list of clients costs
+		uint32_t scanTaken = 0;
+		double scanTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			scanTaken = 0;
+			for (const std::string& username : requested)
+			{
+				for (const RosterEntry& entry : entries)
+				{
+					if (entry.Username.size() == username.size() && std::equal(username.begin(), username.end(), entry.Username.begin(),
+						[](char a, char b) { return std::tolower((uint8_t)a) == std::tolower((uint8_t)b); }))
+					{
+						scanTaken++;
+						break;
+					}
+				}
+			}
+		});
+
+		uint32_t indexTaken = 0;
+		double indexTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			indexTaken = 0;
+			for (const std::string& username : requested)
+				indexTaken += roster.IsUsernameTaken(username);
+		});
+
+		Benchmark::Report({ "Roster", "Username check, linear scan" + suffix, (uint64_t)requested.size(), scanTime });
+		Benchmark::Report({ "Roster", "Username check, hashed" + suffix, (uint64_t)requested.size(), indexTime });
+
+		if (scanTaken != indexTaken)
+			Benchmark::ReportFailure("Roster", "hashed and scanned username checks disagree" + suffix);
+	}
+
+	// Clients joining and leaving at a steady rate, everyone else watching the roster
+	static void BenchmarkBandwidth(uint32_t clientCount, uint32_t joinsPerSecond)
+	{
+		const uint32_t seconds = 60;
+		std::string suffix = fmt::format(" ({} clients, {} joins/s)", clientCount, joinsPerSecond);
+
+		// The old protocol: the full list to each client as it connects and to everyone every 10 seconds
+		uint64_t listBytes = 0;
+		double listTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			ClientRoster roster;
+			for (uint32_t i = 0; i < clientCount; i++)
+				roster.Add(i, 0, MakeUsername(i));
+
+			listBytes = 0;
+			uint32_t nextClientID = clientCount;
+			for (uint32_t second = 0; second < seconds; second++)
+			{
+				for (uint32_t i = 0; i < joinsPerSecond; i++)
+				{
+					roster.Remove(nextClientID - clientCount);
+					roster.Add(nextClientID, 0, MakeUsername(nextClientID));
+					nextClientID++;
+
+					PacketStreamWriter& stream = GetThreadPacketWriter();
+					roster.WriteList(stream);
+					listBytes += stream.GetBuffer().Size;
+				}
+
+				if (second % s_ClientListInterval == 0)
+				{
+					PacketStreamWriter& stream = GetThreadPacketWriter();
+					roster.WriteList(stream);
+					listBytes += stream.GetBuffer().Size * roster.GetCount();
+				}
+			}
+		});
+
+		// Deltas to everyone else, the full list only to the client that joins
+		uint64_t deltaBytes = 0;
+		bool replicasMatch = true;
+		double deltaTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			ClientRoster roster;
+			for (uint32_t i = 0; i < clientCount; i++)
+				roster.Add(i, 0, MakeUsername(i));
+
+			// One client's view, to check the deltas are enough to stay in sync
+			RosterReplica observer;
+			roster.CatchUp(0, 0, [&](Walnut::Buffer buffer) { replicasMatch &= ApplyRosterPacket(observer, buffer); });
+
+			deltaBytes = 0;
+			uint32_t nextClientID = clientCount;
+			for (uint32_t second = 0; second < seconds; second++)
+			{
+				for (uint32_t i = 0; i < joinsPerSecond; i++)
+				{
+					// The observer (client 0) stays for the whole run
+					uint32_t leaving = nextClientID - clientCount + 1;
+					SharedPacket leave = roster.Remove(leaving);
+					deltaBytes += leave.GetBuffer().Size * roster.GetCount();
+					replicasMatch &= ApplyRosterPacket(observer, leave.GetBuffer());
+
+					SharedPacket join = roster.Add(nextClientID, 0, MakeUsername(nextClientID));
+					deltaBytes += join.GetBuffer().Size * (roster.GetCount() - 1);
+					replicasMatch &= ApplyRosterPacket(observer, join.GetBuffer());
+					roster.CatchUp(0, 0, [&](Walnut::Buffer buffer) { deltaBytes += buffer.Size; });
+					nextClientID++;
+				}
+			}
+
+			replicasMatch &= Matches(observer, roster);
+		});
+
+		uint64_t clientSeconds = (uint64_t)clientCount * seconds;
+		Benchmark::Report({ "Roster", "Periodic ClientList" + suffix, clientSeconds, listTime, (double)listBytes / clientSeconds });
+		Benchmark::Report({ "Roster", "Versioned deltas" + suffix, clientSeconds, deltaTime, (double)deltaBytes / clientSeconds });
+
+		if (!replicasMatch)
+			Benchmark::ReportFailure("Roster", "a client applying deltas ended up with a different roster" + suffix);
+	}
+
+	static void VerifyCatchUp()
+	{
+		ClientRoster roster;
+		for (uint32_t i = 0; i < 100; i++)
+			roster.Add(i, i, MakeUsername(i));
+
+		RosterReplica replica;
+		bool valid = true;
+		uint32_t lists = 0;
+		auto catchUp = [&]()
+		{
+			lists += roster.CatchUp(replica.GetEpoch(), replica.GetVersion(), [&](Walnut::Buffer buffer) { valid &= ApplyRosterPacket(replica, buffer); });
+		};
+
+		// New client: full list
+		catchUp();
+		if (!valid || lists != 1 || !Matches(replica, roster))
+			Benchmark::ReportFailure("Roster", "a new client didn't get the full list");
+
+		// Up to date: nothing
+		catchUp();
+		if (lists != 1)
+			Benchmark::ReportFailure("Roster", "an up-to-date client was sent the list again");
+
+		// A few changes behind: only the deltas
+		for (uint32_t i = 0; i < 10; i++)
+		{
+			roster.Remove(i);
+			roster.Add(100 + i, 0, MakeUsername(100 + i));
+		}
+		catchUp();
+		if (!valid || lists != 1 || !Matches(replica, roster))
+			Benchmark::ReportFailure("Roster", "a client a few changes behind wasn't caught up with deltas");
+
+		// Further behind than the change log reaches: the list
+		for (uint32_t i = 0; i < ClientRoster::ChangeLogCapacity; i++)
+		{
+			roster.Remove(10 + i % 90);
+			roster.Add(10 + i % 90, 0, MakeUsername(10 + i % 90));
+		}
+		catchUp();
+		if (!valid || lists != 2 || !Matches(replica, roster))
+			Benchmark::ReportFailure("Roster", "a client behind the change log wasn't sent the list");
+
+		// A delta that skips a version is refused rather than applied out of order
+		roster.Add(1000, 0, "Skipped");
+		SharedPacket next = roster.Add(1001, 0, "Next");
+		if (ApplyRosterPacket(replica, next.GetBuffer()))
+			Benchmark::ReportFailure("Roster", "a delta that skipped a version was applied");
+
+		// Same version from another server run: the list
+		ClientRoster restarted(roster.GetEpoch() + 1);
+		for (uint32_t i = 0; i < roster.GetVersion(); i++)
+			restarted.Add(i, 0, MakeUsername(i));
+		lists = 0;
+		restarted.CatchUp(replica.GetEpoch(), replica.GetVersion(), [&](Walnut::Buffer buffer) { lists++; valid &= ApplyRosterPacket(replica, buffer); });
+		if (!valid || lists != 1 || !Matches(replica, restarted))
+			Benchmark::ReportFailure("Roster", "a client from an earlier server run wasn't sent the list");
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(RosterSuite)
+{
+	Cubed::VerifyUsernames();
+	Cubed::VerifyCatchUp();
+
+	for (uint32_t clientCount : { 1000u, 10000u })
+		Cubed::BenchmarkUsernameLookup(clientCount);
+
+	for (uint32_t clientCount : { 1000u, 5000u })
+		Cubed::BenchmarkBandwidth(clientCount, 2);
+}
@@ -0,0 +1,255 @@
+#include "Benchmark.h"
+
+#include <array>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Movement.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "PlayerStore.h"
+#include "ServerPacket.h"
+#include "Snapshot.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	// Entities encoded per run, spread over however many packets that takes at a given population
+	static constexpr uint32_t s_EntitiesPerRun = 200000;
+	static constexpr uint32_t s_PacketsPerRun = 20000;
+
+	// Player state as it went over the wire before quantization: raw floats, written with WriteMap
+	struct RawPlayerData
+	{
+		glm::vec2 Position;
+		glm::vec2 Velocity;
+	};
+
+	struct Population
+	{
+		std::map<uint32_t, RawPlayerData> RawPlayers;
+		PlayerStore Store;
+		WorldSnapshot Snapshot; // quantized
+		WorldSnapshot MovedSnapshot; // 10% of players moved since Snapshot
+	};
+
+	static Population CreatePopulation(uint32_t count)
+	{
+		std::mt19937 random(count);
+		std::uniform_real_distribution<float> position(PlayerPositionQuantization.Min, PlayerPositionQuantization.Max);
+		std::uniform_real_distribution<float> velocity(-PlayerMovement.Speed, PlayerMovement.Speed);
+
+		Population population;
+		population.Snapshot.Tick = 1;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			PlayerData playerData = QuantizePlayerData({ { position(random), position(random) }, { velocity(random), velocity(random) } });
+
+			PlayerID id = population.Store.Create();
+			population.Store.Set(id, playerData);
+			population.RawPlayers[id] = { playerData.Position, playerData.Velocity };
+			population.Snapshot.Players[id] = playerData;
+		}
+
+		population.MovedSnapshot = population.Snapshot;
+		population.MovedSnapshot.Tick = 2;
+		uint32_t index = 0;
+		for (auto& [id, playerData] : population.MovedSnapshot.Players)
+		{
+			if (index++ % 10 == 0)
+				playerData = QuantizePlayerData({ playerData.Position + playerData.Velocity * (1.0f / 30.0f), playerData.Velocity });
+		}
+
+		return population;
+	}
+
+	// Measures encode and decode separately; `encode` writes one packet into the stream,
+	// `decode` reads one packet back from the encoded bytes (a Walnut::Buffer)
+	template<typename EncodeFunc, typename DecodeFunc>
+	static void BenchmarkCodec(std::string_view name, uint32_t entitiesPerPacket, uint32_t packets, EncodeFunc&& encode, DecodeFunc&& decode)
+	{
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		encode(stream);
+		std::vector<uint8_t> encoded(stream.GetBuffer().As<uint8_t>(), stream.GetBuffer().As<uint8_t>() + stream.GetBuffer().Size);
+
+		double encodeTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < packets; i++)
+			{
+				PacketStreamWriter& packetStream = GetThreadPacketWriter();
+				encode(packetStream);
+				Benchmark::DoNotOptimize(packetStream);
+			}
+		});
+
+		double decodeTime = Benchmark::Measure(s_Runs, [&]()
+		{
+			for (uint32_t i = 0; i < packets; i++)
+			{
+				decode(Walnut::Buffer(encoded.data(), encoded.size()));
+			}
+		});
+
+		uint64_t items = (uint64_t)entitiesPerPacket * packets;
+		double bytesPerItem = (double)encoded.size() / (double)entitiesPerPacket;
+		Benchmark::Report({ "Serialization", fmt::format("{} encode", name), items, encodeTime, bytesPerItem });
+		Benchmark::Report({ "Serialization", fmt::format("{} decode", name), items, decodeTime, bytesPerItem });
+	}
+
+	// PacketType::ClientUpdate, server->client
+	static void BenchmarkSnapshots(uint32_t count)
+	{
+		Population population = CreatePopulation(count);
+		uint32_t packets = std::max(1u, s_EntitiesPerRun / count);
+
+		std::map<uint32_t, RawPlayerData> decodedMap;
+		BenchmarkCodec(fmt::format("Snapshot WriteMap ({})", count), count, packets,
+			[&](Walnut::StreamWriter& stream)
+			{
+				stream.WriteRaw(PacketType::ClientUpdate);
+				stream.WriteMap(population.RawPlayers);
+			},
+			[&](Walnut::Buffer buffer)
+			{
+				Walnut::BufferStreamReader stream(buffer);
+				PacketType type;
+				stream.ReadRaw(type);
+				decodedMap.clear();
+				stream.ReadMap(decodedMap);
+				Benchmark::DoNotOptimize(decodedMap);
+			});
+
+		std::vector<PlayerID> decodedIDs;
+		std::vector<glm::vec2> decodedPositions, decodedVelocities;
+		BenchmarkCodec(fmt::format("Snapshot flat arrays ({})", count), count, packets,
+			[&](Walnut::StreamWriter& stream)
+			{
+				stream.WriteRaw(PacketType::ClientUpdate);
+				stream.WriteRaw<uint32_t>(population.Store.GetCount());
+				stream.WriteData((const char*)population.Store.GetIDs().data(), count * sizeof(PlayerID));
+				stream.WriteData((const char*)population.Store.GetPositions().data(), count * sizeof(glm::vec2));
+				stream.WriteData((const char*)population.Store.GetVelocities().data(), count * sizeof(glm::vec2));
+			},
+			[&](Walnut::Buffer buffer)
+			{
+				Walnut::BufferStreamReader stream(buffer);
+				PacketType type;
+				uint32_t size = 0;
+				stream.ReadRaw(type);
+				stream.ReadRaw(size);
+				decodedIDs.resize(size);
+				decodedPositions.resize(size);
+				decodedVelocities.resize(size);
+				stream.ReadData((char*)decodedIDs.data(), size * sizeof(PlayerID));
+				stream.ReadData((char*)decodedPositions.data(), size * sizeof(glm::vec2));
+				stream.ReadData((char*)decodedVelocities.data(), size * sizeof(glm::vec2));
+				Benchmark::DoNotOptimize(decodedPositions);
+			});
+
+		WorldSnapshot decoded;
+		BenchmarkCodec(fmt::format("Snapshot quantized full ({})", count), count, packets,
+			[&](Walnut::StreamWriter& stream)
+			{
+				stream.WriteRaw(PacketType::ClientUpdate);
+				BitWriter writer(stream);
+				WriteSnapshotDelta(writer, nullptr, population.Snapshot);
+			},
+			[&](Walnut::Buffer buffer)
+			{
+				BitReader reader(PacketView<ClientUpdatePacket>(buffer).Get<ClientUpdatePacket::Body>());
+				ReadSnapshotDeltaHeader(reader);
+				decoded.Players.clear();
+				ApplySnapshotDelta(reader, decoded);
+				Benchmark::DoNotOptimize(decoded);
+			});
+
+		BenchmarkCodec(fmt::format("Snapshot quantized delta ({})", count), count, packets,
+			[&](Walnut::StreamWriter& stream)
+			{
+				stream.WriteRaw(PacketType::ClientUpdate);
+				BitWriter writer(stream);
+				WriteSnapshotDelta(writer, &population.Snapshot, population.MovedSnapshot);
+			},
+			[&](Walnut::Buffer buffer)
+			{
+				BitReader reader(PacketView<ClientUpdatePacket>(buffer).Get<ClientUpdatePacket::Body>());
+				ReadSnapshotDeltaHeader(reader);
+				decoded.Players = population.Snapshot.Players;
+				ApplySnapshotDelta(reader, decoded);
+				Benchmark::DoNotOptimize(decoded);
+			});
+	}
+
+	// PacketType::ClientUpdate, client->server, and PacketType::ClientConnect
+	static void BenchmarkSmallPackets()
+	{
+		RawPlayerData rawPlayerData = { { 100.0f, 200.0f }, { 35.0f, -35.0f } };
+		BenchmarkCodec("Input raw state", 1, s_PacketsPerRun,
+			[&](Walnut::StreamWriter& stream)
+			{
+				stream.WriteRaw(PacketType::ClientUpdate);
+				stream.WriteRaw(rawPlayerData);
+			},
+			[&](Walnut::Buffer buffer)
+			{
+				Walnut::BufferStreamReader stream(buffer);
+				PacketType type;
+				RawPlayerData playerData;
+				stream.ReadRaw(type);
+				stream.ReadRaw(playerData);
+				Benchmark::DoNotOptimize(playerData);
+			});
+
+		// What the client sends now: one packet per InputsPerPacket ticks, with redundant inputs
+		std::array<PlayerInput, InputsPerPacket + RedundantInputs> inputs;
+		for (uint32_t i = 0; i < inputs.size(); i++)
+			inputs[i] = { 1, (int8_t)(i % 2), 12345 + i };
+
+		std::array<PlayerInput, MaxInputsPerPacket> decodedInputs;
+		BenchmarkCodec(fmt::format("Input batch ({} new + {} redundant)", InputsPerPacket, RedundantInputs), 1, s_PacketsPerRun,
+			[&](Walnut::StreamWriter& stream)
+			{
+				stream.WriteRaw(PacketType::ClientUpdate);
+				BitWriter writer(stream);
+				WritePlayerInputs(writer, inputs.data(), (uint32_t)inputs.size());
+				writer.WriteBits(1000, 32);
+			},
+			[&](Walnut::Buffer buffer)
+			{
+				BitReader reader(PacketView<ClientUpdatePacket>(buffer).Get<ClientUpdatePacket::Body>());
+				uint32_t count = ReadPlayerInputs(reader, decodedInputs.data());
+				uint32_t ack = reader.ReadBits(32);
+				Benchmark::DoNotOptimize(decodedInputs);
+				Benchmark::DoNotOptimize(count);
+				Benchmark::DoNotOptimize(ack);
+			});
+
+		BenchmarkCodec("ClientConnect", 1, s_PacketsPerRun,
+			[&](Walnut::StreamWriter& stream)
+			{
+				stream.WriteRaw(PacketType::ClientConnect);
+				stream.WriteRaw<PlayerID>(MakePlayerID(42, 1));
+			},
+			[&](Walnut::Buffer buffer)
+			{
+				Walnut::BufferStreamReader stream(buffer);
+				PacketType type;
+				PlayerID id;
+				stream.ReadRaw(type);
+				stream.ReadRaw(id);
+				Benchmark::DoNotOptimize(id);
+			});
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(SerializationSuite)
+{
+	Cubed::BenchmarkSmallPackets();
+
+	for (uint32_t count : { 10u, 100u, 1000u, 10000u })
+		Cubed::BenchmarkSnapshots(count);
+}
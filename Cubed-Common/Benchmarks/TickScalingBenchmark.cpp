@@ -0,0 +1,268 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "JobGraph.h"
+#include "JobPool.h"
+#include "Movement.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "PlayerStore.h"
+#include "Snapshot.h"
+#include "SpatialHashGrid.h"
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_Runs = 5;
+	static constexpr uint32_t s_TicksPerRun = 10;
+	static constexpr float s_Timestep = 1.0f / 30.0f;
+
+	// Same split as the server's tick
+	static constexpr uint32_t s_PlayersPerJob = 4096;
+	static constexpr uint32_t s_ClientsPerJob = 4;
+
+	// Players are spread so each sees about this many others
+	static constexpr float s_InterestRadius = 64.0f;
+	static constexpr float s_AreaPerPlayer = 200.0f;
+
+	//
+	// The server's tick without the networking: every player is a client, and each tick integrates
+	// movement, quantizes, updates the interest grid and builds one snapshot delta per client against
+	// the one before. Runs as the same job graph as ServerLayer, or inline with no pool.
+	//
+	class TickSimulation
+	{
+	public:
+		TickSimulation(uint32_t playerCount, JobPool* jobPool)
+			: m_JobPool(jobPool), m_Grid(s_InterestRadius * 2.0f)
+		{
+			std::mt19937 random(playerCount);
+			float worldSize = std::sqrt(playerCount * s_AreaPerPlayer);
+			std::uniform_real_distribution<float> position(0.0f, worldSize);
+			std::uniform_int_distribution<int32_t> axis(-1, 1);
+
+			m_Clients.resize(playerCount);
+			for (Client& client : m_Clients)
+			{
+				client.Player = m_Players.Create();
+				m_Players.Set(client.Player, { { position(random), position(random) }, { 0.0f, 0.0f } });
+
+				PlayerInput input;
+				input.MoveX = (int8_t)axis(random);
+				input.MoveY = (int8_t)axis(random);
+				m_Players.GetInputDirections()[m_Players.GetDenseIndex(client.Player)] = GetInputDirection(input);
+			}
+
+			if (m_JobPool)
+			{
+				JobGraph::JobID integrate = m_Graph.Add([this]() { Integrate(); });
+				JobGraph::JobID quantize = m_Graph.Add([this]() { Quantize(); }, { integrate });
+				JobGraph::JobID grid = m_Graph.Add([this]() { UpdateGrid(); }, { quantize });
+				m_Graph.Add([this]() { BuildSnapshots(); }, { grid });
+			}
+		}
+
+		void Tick()
+		{
+			m_Tick++;
+			if (m_JobPool)
+			{
+				m_Graph.Run(*m_JobPool);
+			}
+			else
+			{
+				Integrate();
+				Quantize();
+				UpdateGrid();
+				BuildSnapshots();
+			}
+
+			// Every client's bytes, in client order
+			for (const Client& client : m_Clients)
+			{
+				for (uint8_t byte : client.Packet)
+					m_Hash = (m_Hash ^ byte) * 1099511628211ull;
+				m_Bytes += client.Packet.size();
+			}
+		}
+
+		uint64_t GetHash() const { return m_Hash; }
+		uint64_t GetBytes() const { return m_Bytes; }
+	private:
+		template<typename Func>
+		void ParallelFor(uint32_t count, uint32_t batchSize, Func&& func)
+		{
+			if (m_JobPool)
+			{
+				m_JobPool->ParallelFor(count, batchSize, func);
+				return;
+			}
+
+			for (uint32_t i = 0; i < count; i++)
+				func(i);
+		}
+
+		void Integrate()
+		{
+			uint32_t count = m_Players.GetCount();
+			ParallelFor((count + s_PlayersPerJob - 1) / s_PlayersPerJob, 1, [&](uint32_t job)
+			{
+				uint32_t begin = job * s_PlayersPerJob;
+				uint32_t end = std::min(begin + s_PlayersPerJob, count);
+				IntegrateMovement(m_Players.GetPositions().data() + begin, m_Players.GetVelocities().data() + begin, m_Players.GetInputDirections().data() + begin,
+					end - begin, s_Timestep);
+			});
+		}
+
+		void Quantize()
+		{
+			m_TickPlayers = m_Players;
+
+			std::vector<glm::vec2>& positions = m_TickPlayers.GetPositions();
+			std::vector<glm::vec2>& velocities = m_TickPlayers.GetVelocities();
+			ParallelFor(m_TickPlayers.GetCount(), s_PlayersPerJob, [&](uint32_t i)
+			{
+				PlayerData quantized = QuantizePlayerData({ positions[i], velocities[i] });
+				positions[i] = quantized.Position;
+				velocities[i] = quantized.Velocity;
+			});
+		}
+
+		void UpdateGrid()
+		{
+			const std::vector<PlayerID>& playerIDs = m_TickPlayers.GetIDs();
+			const std::vector<glm::vec2>& positions = m_TickPlayers.GetPositions();
+			for (uint32_t i = 0; i < m_TickPlayers.GetCount(); i++)
+				m_Grid.Update(playerIDs[i], positions[i]);
+		}
+
+		void BuildSnapshots()
+		{
+			ParallelFor((uint32_t)m_Clients.size(), s_ClientsPerJob, [&](uint32_t i)
+			{
+				Client& client = m_Clients[i];
+
+				auto snapshot = std::make_shared<WorldSnapshot>();
+				snapshot->Tick = m_Tick;
+				snapshot->TickRate = 30;
+				m_Grid.QueryRadius(m_TickPlayers.Get(client.Player).Position, s_InterestRadius, [&](uint32_t entityID, const glm::vec2&)
+				{
+					snapshot->Players.emplace(entityID, m_TickPlayers.Get(entityID));
+				});
+
+				PacketStreamWriter& stream = GetThreadPacketWriter();
+				WritePacket<ClientUpdatePacket>(stream);
+				BitWriter writer(stream);
+				WriteSnapshotDelta(writer, client.Baseline.get(), *snapshot);
+				writer.Flush();
+
+				Walnut::Buffer buffer = stream.GetBuffer();
+				client.Packet.assign(buffer.As<uint8_t>(), buffer.As<uint8_t>() + buffer.Size);
+				client.Baseline = std::move(snapshot);
+			});
+		}
+	private:
+		struct Client
+		{
+			PlayerID Player = InvalidPlayerID;
+			std::shared_ptr<const WorldSnapshot> Baseline; // every snapshot is acknowledged right away
+			std::vector<uint8_t> Packet; // this tick's snapshot, as it would be sent
+		};
+
+		JobPool* m_JobPool;
+		JobGraph m_Graph;
+
+		PlayerStore m_Players;
+		PlayerStore m_TickPlayers;
+		SpatialHashGrid m_Grid;
+		std::vector<Client> m_Clients;
+		uint32_t m_Tick = 0;
+
+		uint64_t m_Hash = 14695981039346656037ull;
+		uint64_t m_Bytes = 0;
+	};
+
+	static void BenchmarkScaling(uint32_t playerCount)
+	{
+		uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+		uint64_t serialHash = 0;
+		for (uint32_t threadCount : { 1u, 2u, 4u, 8u })
+		{
+			// The thread that runs the tick helps, so the pool only needs the rest
+			std::unique_ptr<JobPool> jobPool = threadCount > 1 ? std::make_unique<JobPool>(threadCount - 1) : nullptr;
+			TickSimulation simulation(playerCount, jobPool.get());
+
+			double time = Benchmark::Measure(s_Runs, [&]()
+			{
+				for (uint32_t tick = 0; tick < s_TicksPerRun; tick++)
+					simulation.Tick();
+			});
+
+			std::string name = fmt::format("Tick ({} players, {} threads{})", playerCount, threadCount, threadCount > hardwareThreads ? ", oversubscribed" : "");
+			Benchmark::Report({ "TickScaling", name, s_TicksPerRun, time, (double)simulation.GetBytes() / (s_Runs * s_TicksPerRun) });
+
+			// Same ticks from the same start, so every thread count has to produce the same bytes
+			if (threadCount == 1)
+				serialHash = simulation.GetHash();
+			else if (simulation.GetHash() != serialHash)
+				Benchmark::ReportFailure("TickScaling", fmt::format("{} players: snapshots on {} threads differ from the single-threaded tick", playerCount, threadCount));
+		}
+	}
+
+	static void VerifyJobGraph()
+	{
+		JobPool jobPool(3);
+
+		// A diamond, each job also running a ParallelFor; every job must see all of its dependencies done
+		for (uint32_t run = 0; run < 100; run++)
+		{
+			std::atomic<uint32_t> done[4] = {};
+			std::atomic<bool> ordered = true;
+			std::atomic<uint64_t> sum = 0;
+
+			auto job = [&](uint32_t index, std::initializer_list<uint32_t> dependencies)
+			{
+				return [&, index, dependencies = std::vector<uint32_t>(dependencies)]()
+				{
+					for (uint32_t dependency : dependencies)
+						ordered = ordered && done[dependency].load() == 1;
+
+					jobPool.ParallelFor(1000, 10, [&](uint32_t i) { sum += i; });
+					done[index]++;
+				};
+			};
+
+			JobGraph graph;
+			JobGraph::JobID a = graph.Add(job(0, {}));
+			JobGraph::JobID b = graph.Add(job(1, { 0 }), { a });
+			JobGraph::JobID c = graph.Add(job(2, { 0 }), { a });
+			graph.Add(job(3, { 1, 2 }), { b, c });
+			graph.Run(jobPool);
+
+			bool allDone = done[0] == 1 && done[1] == 1 && done[2] == 1 && done[3] == 1;
+			if (!ordered || !allDone || sum != 4 * 499500ull)
+			{
+				Benchmark::ReportFailure("TickScaling", fmt::format("job graph run {}: ordered={} all done once={} sum={}", run, ordered.load(), allDone, sum.load()));
+				return;
+			}
+		}
+	}
+
+}
+
+CUBED_BENCHMARK_SUITE(TickScalingSuite)
+{
+	Cubed::VerifyJobGraph();
+
+	for (uint32_t playerCount : { 500u, 2000u })
+		Cubed::BenchmarkScaling(playerCount);
+}
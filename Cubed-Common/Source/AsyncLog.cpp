@@ -0,0 +1,151 @@
+#include "AsyncLog.h"
+
+#include <iostream>
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	// Records per write at most, so a flood still reaches the output (and history) in steady steps
+	static constexpr uint32_t s_MaxBatchSize = 256;
+
+	AsyncLog::AsyncLog(uint32_t queueCapacity, uint32_t historyRetention, const WriteCallback& write)
+		: m_Queue(queueCapacity), m_Write(write), m_HistoryRetention(historyRetention)
+	{
+		if (!m_Write)
+		{
+			m_Write = [](std::string_view text)
+			{
+				std::cout.write(text.data(), (std::streamsize)text.size());
+				std::cout.flush();
+			};
+		}
+
+		m_WriterThread = std::thread([this]() { WriterThreadFunc(); });
+	}
+
+	AsyncLog::~AsyncLog()
+	{
+		// One extra pending count wakes the writer; it drains the queue and then sees we're stopping
+		m_Running = false;
+		m_PendingCount.fetch_add(1, std::memory_order_release);
+		m_PendingCount.notify_one();
+
+		if (m_WriterThread.joinable())
+			m_WriterThread.join();
+	}
+
+	bool AsyncLog::Push(LogRecord&& record)
+	{
+		if (!m_Queue.Push(std::move(record)))
+		{
+			m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		m_PushedCount.fetch_add(1, std::memory_order_relaxed);
+		// Only costs a wake-up when the writer is actually asleep
+		m_PendingCount.fetch_add(1, std::memory_order_release);
+		m_PendingCount.notify_one();
+		return true;
+	}
+
+	void AsyncLog::Flush()
+	{
+		uint64_t target = m_PushedCount.load(std::memory_order_relaxed);
+		uint64_t written = m_WrittenCount.load(std::memory_order_acquire);
+		while (written < target)
+		{
+			m_WrittenCount.wait(written, std::memory_order_acquire);
+			written = m_WrittenCount.load(std::memory_order_acquire);
+		}
+	}
+
+	std::vector<LogRecord> AsyncLog::GetHistory() const
+	{
+		std::scoped_lock<std::mutex> lock(m_HistoryMutex);
+		return std::vector<LogRecord>(m_History.begin(), m_History.end());
+	}
+
+	void AsyncLog::ClearHistory()
+	{
+		std::scoped_lock<std::mutex> lock(m_HistoryMutex);
+		m_History.clear();
+	}
+
+	void AsyncLog::WriterThreadFunc()
+	{
+		std::string batch;
+		std::vector<LogRecord> records;
+		records.reserve(s_MaxBatchSize);
+		uint64_t reportedDroppedCount = 0;
+
+		for (;;)
+		{
+			uint64_t pending = m_PendingCount.load(std::memory_order_acquire);
+			if (pending == 0)
+			{
+				m_PendingCount.wait(0, std::memory_order_acquire);
+				continue;
+			}
+
+			// Records are announced after they're in the queue, so at least `pending` of them can be
+			// popped, unless an earlier producer is still mid-push; then we come straight back
+			LogRecord record;
+			uint32_t batchSize = (uint32_t)std::min<uint64_t>(pending, s_MaxBatchSize);
+			while (records.size() < batchSize && m_Queue.Pop(record))
+				records.push_back(std::move(record));
+
+			batch.clear();
+			for (const LogRecord& entry : records)
+			{
+				if (!entry.Tag.empty())
+				{
+					batch += '[';
+					batch += entry.Tag;
+					batch += "] ";
+				}
+				batch += entry.Message;
+				batch += '\n';
+			}
+
+			uint64_t droppedCount = m_DroppedCount.load(std::memory_order_relaxed);
+			if (droppedCount != reportedDroppedCount)
+			{
+				batch += fmt::format("[Log] {} messages dropped, the log queue was full\n", droppedCount - reportedDroppedCount);
+				reportedDroppedCount = droppedCount;
+			}
+
+			if (!batch.empty())
+			{
+				m_Write(batch);
+				m_BatchCount.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			if (!records.empty())
+			{
+				std::scoped_lock<std::mutex> lock(m_HistoryMutex);
+				uint32_t retention = m_HistoryRetention.load(std::memory_order_relaxed);
+				for (LogRecord& entry : records)
+					m_History.push_back(std::move(entry));
+				while (m_History.size() > retention)
+					m_History.pop_front();
+			}
+
+			uint32_t popped = (uint32_t)records.size();
+			records.clear();
+
+			m_PendingCount.fetch_sub(popped, std::memory_order_relaxed);
+			m_WrittenCount.fetch_add(popped, std::memory_order_release);
+			m_WrittenCount.notify_all();
+
+			if (popped == 0)
+			{
+				if (!m_Running)
+					break;
+				std::this_thread::yield();
+			}
+		}
+	}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "MPSCQueue.h"
+
+namespace Cubed
+{
+	struct LogRecord
+	{
+		std::string Tag; // written as "[Tag] " before the message when set
+		std::string Message;
+		bool Italic = false;
+		uint32_t Color = 0xffffffff;
+	};
+
+	//
+	// AsyncLog - records are pushed into a bounded lock-free queue and written out by a
+	// background thread, many per write, so logging from the tick or the network thread
+	// never waits on the terminal. When the queue is full a record is dropped and counted
+	// instead of blocking; the writer reports drops in the output itself.
+	//
+	// The last HistoryRetention records written are kept for GetHistory().
+	//
+	class AsyncLog
+	{
+	public:
+		// Receives one batch of newline-terminated lines; defaults to stdout
+		using WriteCallback = std::function<void(std::string_view text)>;
+
+		static constexpr uint32_t DefaultQueueCapacity = 4096;
+		static constexpr uint32_t DefaultHistoryRetention = 1000;
+	public:
+		AsyncLog(uint32_t queueCapacity = DefaultQueueCapacity, uint32_t historyRetention = DefaultHistoryRetention, const WriteCallback& write = {});
+		// Writes out whatever is still queued
+		~AsyncLog();
+
+		AsyncLog(const AsyncLog&) = delete;
+		AsyncLog& operator=(const AsyncLog&) = delete;
+
+		// Safe to call from any thread; returns false if the record was dropped
+		bool Push(LogRecord&& record);
+
+		// Waits until the writer has caught up with everything pushed before the call
+		void Flush();
+
+		void SetHistoryRetention(uint32_t retention) { m_HistoryRetention = retention; }
+		uint32_t GetHistoryRetention() const { return m_HistoryRetention; }
+		std::vector<LogRecord> GetHistory() const;
+		void ClearHistory();
+
+		uint64_t GetWrittenCount() const { return m_WrittenCount.load(std::memory_order_relaxed); }
+		uint64_t GetDroppedCount() const { return m_DroppedCount.load(std::memory_order_relaxed); }
+		uint64_t GetBatchCount() const { return m_BatchCount.load(std::memory_order_relaxed); }
+	private:
+		void WriterThreadFunc();
+	private:
+		MPSCQueue<LogRecord> m_Queue;
+		WriteCallback m_Write;
+
+		// Records pushed and not yet popped, as far as producers have announced them; the writer sleeps on it
+		std::atomic<uint64_t> m_PendingCount = 0;
+		std::atomic<uint64_t> m_PushedCount = 0;
+		std::atomic<uint64_t> m_WrittenCount = 0;
+		std::atomic<uint64_t> m_DroppedCount = 0;
+		std::atomic<uint64_t> m_BatchCount = 0;
+		std::atomic<bool> m_Running = true;
+
+		mutable std::mutex m_HistoryMutex;
+		std::deque<LogRecord> m_History;
+		std::atomic<uint32_t> m_HistoryRetention;
+
+		std::thread m_WriterThread;
+	};
+
+}
@@ -0,0 +1,123 @@
+#include "BitStream.h"
+
+namespace Cubed
+{
+	static constexpr uint32_t s_VarUIntClassBits[4] = { 4, 8, 16, 32 };
+
+	static uint64_t BitMask(uint32_t bitCount)
+	{
+		return bitCount >= 64 ? ~0ull : (1ull << bitCount) - 1;
+	}
+
+	BitWriter::BitWriter(Walnut::StreamWriter& stream)
+		: m_Stream(stream)
+	{
+	}
+
+	BitWriter::~BitWriter()
+	{
+		Flush();
+	}
+
+	void BitWriter::WriteBits(uint32_t value, uint32_t bitCount)
+	{
+		m_Scratch |= ((uint64_t)value & BitMask(bitCount)) << m_ScratchBits;
+		m_ScratchBits += bitCount;
+		m_BitsWritten += bitCount;
+
+		if (m_ScratchBits >= 32)
+		{
+			uint32_t word = (uint32_t)m_Scratch;
+			uint8_t bytes[4] = { (uint8_t)word, (uint8_t)(word >> 8), (uint8_t)(word >> 16), (uint8_t)(word >> 24) };
+			m_Stream.WriteData((const char*)bytes, sizeof(bytes));
+
+			m_Scratch >>= 32;
+			m_ScratchBits -= 32;
+		}
+	}
+
+	void BitWriter::WriteVarUInt(uint32_t value)
+	{
+		uint32_t sizeClass = 0;
+		while (sizeClass < 3 && value > BitMask(s_VarUIntClassBits[sizeClass]))
+			sizeClass++;
+
+		WriteBits(sizeClass, 2);
+		WriteBits(value, s_VarUIntClassBits[sizeClass]);
+	}
+
+	void BitWriter::WriteQuantized(float value, const QuantizationRange& range)
+	{
+		WriteBits(range.Quantize(value), range.Bits);
+	}
+
+	void BitWriter::WriteQuantized(const glm::vec2& value, const QuantizationRange& range)
+	{
+		WriteQuantized(value.x, range);
+		WriteQuantized(value.y, range);
+	}
+
+	void BitWriter::Flush()
+	{
+		while (m_ScratchBits > 0)
+		{
+			uint8_t byte = (uint8_t)m_Scratch;
+			m_Stream.WriteData((const char*)&byte, 1);
+
+			m_Scratch >>= 8;
+			m_ScratchBits = m_ScratchBits > 8 ? m_ScratchBits - 8 : 0;
+		}
+
+		m_Scratch = 0;
+	}
+
+	BitReader::BitReader(Walnut::Buffer buffer)
+		: m_Data((const uint8_t*)buffer.Data), m_Remaining(buffer.Size)
+	{
+	}
+
+	uint32_t BitReader::ReadBits(uint32_t bitCount)
+	{
+		// Refill a byte at a time so we never read past the end of the packet
+		while (m_ScratchBits < bitCount)
+		{
+			uint8_t byte = 0;
+			if (m_Remaining > 0)
+			{
+				byte = *m_Data++;
+				m_Remaining--;
+			}
+			else
+			{
+				m_Valid = false;
+			}
+
+			m_Scratch |= (uint64_t)byte << m_ScratchBits;
+			m_ScratchBits += 8;
+		}
+
+		uint32_t value = (uint32_t)(m_Scratch & BitMask(bitCount));
+		m_Scratch >>= bitCount;
+		m_ScratchBits -= bitCount;
+		return value;
+	}
+
+	uint32_t BitReader::ReadVarUInt()
+	{
+		uint32_t sizeClass = ReadBits(2);
+		return ReadBits(s_VarUIntClassBits[sizeClass]);
+	}
+
+	float BitReader::ReadQuantized(const QuantizationRange& range)
+	{
+		return range.Dequantize(ReadBits(range.Bits));
+	}
+
+	glm::vec2 BitReader::ReadQuantizedVec2(const QuantizationRange& range)
+	{
+		float x = ReadQuantized(range);
+		float y = ReadQuantized(range);
+		return { x, y };
+	}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "glm/glm.hpp"
+
+#include "Walnut/Core/Buffer.h"
+#include "Walnut/Serialization/BufferStream.h"
+
+namespace Cubed
+{
+	//
+	// Fixed-point quantization of a float range into Bits bits.
+	// The step is (Max - Min) / 2^Bits, so with power-of-two ranges every
+	// quantized value (including 0 for symmetric ranges) is exact in float.
+	// Values in [Min, Max - step] round-trip within step / 2; anything outside is clamped.
+	//
+	struct QuantizationRange
+	{
+		float Min = 0.0f;
+		float Max = 1.0f;
+		uint32_t Bits = 16; // 1-24, beyond that float can't represent every step
+
+		constexpr float GetStep() const { return (Max - Min) / (float)(1u << Bits); }
+		constexpr uint32_t GetMaxValue() const { return (1u << Bits) - 1; }
+		constexpr float GetMaxError() const { return GetStep() * 0.5f; }
+
+		constexpr uint32_t Quantize(float value) const
+		{
+			float scaled = (value - Min) / GetStep() + 0.5f;
+			if (!(scaled > 0.0f)) // also catches NaN
+				return 0;
+			if (scaled >= (float)GetMaxValue())
+				return GetMaxValue();
+			return (uint32_t)scaled;
+		}
+
+		constexpr float Dequantize(uint32_t value) const
+		{
+			return Min + (float)value * GetStep();
+		}
+
+		constexpr float RoundTrip(float value) const { return Dequantize(Quantize(value)); }
+	};
+
+	//
+	// BitWriter - packs values at bit granularity (LSB first) into a Walnut stream.
+	// Bytes are only written to the underlying stream in whole 32-bit words;
+	// call Flush() before reading the stream position or sending the buffer.
+	//
+	class BitWriter
+	{
+	public:
+		BitWriter(Walnut::StreamWriter& stream);
+		~BitWriter();
+
+		void WriteBits(uint32_t value, uint32_t bitCount);
+		void WriteBool(bool value) { WriteBits(value ? 1 : 0, 1); }
+
+		// 2-bit size class followed by 4, 8, 16 or 32 bits of payload
+		void WriteVarUInt(uint32_t value);
+
+		void WriteQuantized(float value, const QuantizationRange& range);
+		void WriteQuantized(const glm::vec2& value, const QuantizationRange& range);
+
+		// Pads the final partial byte with zeroes and writes it out
+		void Flush();
+
+		uint64_t GetBitsWritten() const { return m_BitsWritten; }
+	private:
+		Walnut::StreamWriter& m_Stream;
+		uint64_t m_Scratch = 0;
+		uint32_t m_ScratchBits = 0;
+		uint64_t m_BitsWritten = 0;
+	};
+
+	//
+	// BitReader - counterpart of BitWriter, reading in place from a packet's bytes
+	// (usually a PacketView payload). Reading past the end yields zeroes and marks
+	// the reader as invalid instead of asserting.
+	//
+	class BitReader
+	{
+	public:
+		BitReader(Walnut::Buffer buffer);
+
+		uint32_t ReadBits(uint32_t bitCount);
+		bool ReadBool() { return ReadBits(1) != 0; }
+		uint32_t ReadVarUInt();
+
+		float ReadQuantized(const QuantizationRange& range);
+		glm::vec2 ReadQuantizedVec2(const QuantizationRange& range);
+
+		bool IsValid() const { return m_Valid; }
+	private:
+		const uint8_t* m_Data = nullptr;
+		uint64_t m_Remaining = 0;
+		uint64_t m_Scratch = 0;
+		uint32_t m_ScratchBits = 0;
+		bool m_Valid = true;
+	};
+
+}
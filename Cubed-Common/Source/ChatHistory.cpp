@@ -0,0 +1,69 @@
+#include "ChatHistory.h"
+
+#include "ServerPacket.h"
+
+namespace Cubed
+{
+	std::string_view TruncateUTF8(std::string_view text, uint32_t maxLength)
+	{
+		if (text.size() <= maxLength)
+			return text;
+
+		// Back up over continuation bytes (10xxxxxx) so the cut lands before a character's first byte
+		size_t length = maxLength;
+		while (length > 0 && ((uint8_t)text[length] & 0xc0) == 0x80)
+			length--;
+		return text.substr(0, length);
+	}
+
+	ChatHistory::ChatHistory(uint32_t capacity)
+		: m_Messages(capacity ? capacity : 1)
+	{
+	}
+
+	SharedPacket ChatHistory::Add(std::string_view username, std::string_view text)
+	{
+		uint64_t id = m_NextID++;
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ChatMessagePacket>(stream, id, TruncateUTF8(username, MaxUsernameLength), TruncateUTF8(text, MaxChatMessageLength));
+
+		// Overwrites (and releases) the oldest message once full
+		SharedPacket& packet = m_Messages[(id - 1) % m_Messages.size()];
+		packet = PacketPool::Get().Create(stream);
+		return packet;
+	}
+
+	uint32_t ChatHistory::WritePage(Walnut::StreamWriter& stream, uint64_t afterID, uint32_t maxCount) const
+	{
+		uint64_t oldestID = GetOldestID();
+		uint64_t newestID = GetNewestID();
+
+		uint32_t count = 0;
+		uint64_t firstID = 0;
+		if (GetCount() > 0)
+		{
+			if (afterID == 0)
+				firstID = newestID >= maxCount ? newestID - maxCount + 1 : 1;
+			else
+				firstID = afterID + 1;
+
+			// Whatever was overwritten is gone; the client sees that from the oldest ID
+			firstID = std::max(firstID, oldestID);
+			if (firstID <= newestID)
+				count = (uint32_t)std::min<uint64_t>(newestID - firstID + 1, maxCount);
+		}
+
+		WritePacket<MessageHistoryPacket>(stream, oldestID, newestID, count);
+
+		// The stored Message packets minus their PacketType are exactly the page's ChatMessageRecords
+		for (uint64_t id = firstID; id < firstID + count; id++)
+		{
+			Walnut::Buffer buffer = GetPacket(id).GetBuffer();
+			stream.WriteData((const char*)buffer.Data + sizeof(PacketType), buffer.Size - sizeof(PacketType));
+		}
+
+		return count;
+	}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Walnut/Serialization/BufferStream.h"
+
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+
+namespace Cubed
+{
+	struct ChatMessage
+	{
+		uint64_t ID = 0;
+		std::string Username;
+		std::string Text;
+	};
+
+	// Cuts `text` to at most maxLength bytes without splitting a UTF-8 character
+	std::string_view TruncateUTF8(std::string_view text, uint32_t maxLength);
+
+	// Copies a message out of a valid Message packet or MessageHistory record view
+	template<typename Layout>
+	ChatMessage ReadChatMessage(const PacketView<Layout>& view)
+	{
+		return { view.template Get<ChatMessageRecord::ID>(), std::string(view.template Get<ChatMessageRecord::Username>()),
+			std::string(view.template Get<ChatMessageRecord::Text>()) };
+	}
+
+	//
+	// ChatHistory - the last Capacity chat messages, oldest overwritten first.
+	// IDs start at 1 and increase by one per message, so a client that knows the newest ID it
+	// has can ask for exactly what it missed, a page at a time.
+	//
+	// Each message is serialized once, as the Message packet that goes to every client; history
+	// pages copy those bytes instead of serializing again. Recipients' frames keep a reference to
+	// the packet rather than a copy (see FrameBuilder). Not thread-safe.
+	//
+	class ChatHistory
+	{
+	public:
+		static constexpr uint32_t DefaultCapacity = 1024;
+		static constexpr uint32_t MaxPageSize = 64;
+	public:
+		explicit ChatHistory(uint32_t capacity = DefaultCapacity);
+
+		// Stores the message under the next ID and returns its Message packet, ready to send to everyone
+		SharedPacket Add(std::string_view username, std::string_view text);
+
+		// Writes a MessageHistory reply (see ServerPacket.h) with up to maxCount messages after `afterID`,
+		// oldest first. afterID = 0 means the client has nothing yet and gets the latest maxCount.
+		// Returns how many messages it wrote.
+		uint32_t WritePage(Walnut::StreamWriter& stream, uint64_t afterID, uint32_t maxCount = MaxPageSize) const;
+
+		// 0 while empty
+		uint64_t GetOldestID() const { return GetCount() ? m_NextID - GetCount() : 0; }
+		uint64_t GetNewestID() const { return m_NextID - 1; }
+		uint32_t GetCount() const { return (uint32_t)std::min<uint64_t>(m_NextID - 1, m_Messages.size()); }
+		uint32_t GetCapacity() const { return (uint32_t)m_Messages.size(); }
+	private:
+		const SharedPacket& GetPacket(uint64_t id) const { return m_Messages[(id - 1) % m_Messages.size()]; }
+	private:
+		std::vector<SharedPacket> m_Messages; // message ID - 1 modulo capacity
+		uint64_t m_NextID = 1;
+	};
+
+}
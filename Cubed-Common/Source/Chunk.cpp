@@ -0,0 +1,264 @@
+#include "Chunk.h"
+
+#include <algorithm>
+
+namespace Cubed
+{
+	PalettedBlockStorage::PalettedBlockStorage(uint32_t blockCount, BlockID fill)
+		: m_BlockCount(blockCount)
+	{
+		m_Palette.push_back(fill);
+	}
+
+	uint32_t PalettedBlockStorage::GetBitsForPaletteSize(size_t paletteSize)
+	{
+		uint32_t bits = 0;
+		while ((size_t(1) << bits) < paletteSize)
+			bits++;
+
+		// Round up to a power of two so indices never straddle words
+		if (bits == 0)
+			return 0;
+		uint32_t rounded = 1;
+		while (rounded < bits)
+			rounded *= 2;
+		return rounded;
+	}
+
+	void PalettedBlockStorage::SetBitsPerBlock(uint32_t bitsPerBlock)
+	{
+		m_BitsPerBlock = bitsPerBlock;
+		if (bitsPerBlock == 0)
+		{
+			m_Words.clear();
+			m_Words.shrink_to_fit();
+			m_IndicesPerWordShift = 0;
+			m_IndexMask = 0;
+			return;
+		}
+
+		uint32_t indicesPerWord = 64 / bitsPerBlock;
+		m_IndicesPerWordShift = 0;
+		while ((1u << m_IndicesPerWordShift) < indicesPerWord)
+			m_IndicesPerWordShift++;
+		m_IndexMask = bitsPerBlock == 64 ? ~0ull : (1ull << bitsPerBlock) - 1;
+
+		m_Words.assign((m_BlockCount + indicesPerWord - 1) / indicesPerWord, 0);
+		m_Words.shrink_to_fit();
+	}
+
+	uint32_t PalettedBlockStorage::GetIndex(uint32_t index) const
+	{
+		if (m_BitsPerBlock == 0)
+			return 0;
+
+		uint32_t word = index >> m_IndicesPerWordShift;
+		uint32_t shift = (index & ((1u << m_IndicesPerWordShift) - 1)) * m_BitsPerBlock;
+		return (uint32_t)((m_Words[word] >> shift) & m_IndexMask);
+	}
+
+	void PalettedBlockStorage::SetIndex(uint32_t index, uint32_t paletteIndex)
+	{
+		uint32_t word = index >> m_IndicesPerWordShift;
+		uint32_t shift = (index & ((1u << m_IndicesPerWordShift) - 1)) * m_BitsPerBlock;
+		m_Words[word] = (m_Words[word] & ~(m_IndexMask << shift)) | ((uint64_t)paletteIndex << shift);
+	}
+
+	void PalettedBlockStorage::Repack(uint32_t bitsPerBlock)
+	{
+		std::vector<uint16_t> indices(m_BlockCount);
+		for (uint32_t i = 0; i < m_BlockCount; i++)
+			indices[i] = (uint16_t)GetIndex(i);
+
+		SetBitsPerBlock(bitsPerBlock);
+		if (bitsPerBlock == 0)
+			return;
+
+		for (uint32_t i = 0; i < m_BlockCount; i++)
+			SetIndex(i, indices[i]);
+	}
+
+	void PalettedBlockStorage::Set(uint32_t index, BlockID block)
+	{
+		// Palettes are small (a handful of entries for terrain), a linear search beats hashing
+		auto it = std::find(m_Palette.begin(), m_Palette.end(), block);
+		uint32_t paletteIndex = (uint32_t)(it - m_Palette.begin());
+		if (it == m_Palette.end())
+		{
+			m_Palette.push_back(block);
+			uint32_t bits = GetBitsForPaletteSize(m_Palette.size());
+			if (bits != m_BitsPerBlock)
+				Repack(bits);
+		}
+		else if (m_BitsPerBlock == 0)
+		{
+			return; // the only block there is
+		}
+
+		SetIndex(index, paletteIndex);
+	}
+
+	void PalettedBlockStorage::Fill(BlockID block)
+	{
+		m_Palette.assign(1, block);
+		SetBitsPerBlock(0);
+	}
+
+	void PalettedBlockStorage::Decode(BlockID* blocks) const
+	{
+		if (m_BitsPerBlock == 0)
+		{
+			std::fill(blocks, blocks + m_BlockCount, m_Palette[0]);
+			return;
+		}
+
+		uint32_t indicesPerWord = 1u << m_IndicesPerWordShift;
+		uint32_t index = 0;
+		for (uint64_t word : m_Words)
+		{
+			uint32_t count = std::min(indicesPerWord, m_BlockCount - index);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				blocks[index++] = m_Palette[word & m_IndexMask];
+				word >>= m_BitsPerBlock;
+			}
+		}
+	}
+
+	void PalettedBlockStorage::Encode(const BlockID* blocks)
+	{
+		m_Palette.clear();
+
+		// Palette indices first, then the smallest packing that fits them
+		std::vector<uint16_t> indices(m_BlockCount);
+		BlockID lastBlock = blocks[0];
+		uint16_t lastIndex = 0;
+		m_Palette.push_back(lastBlock);
+		for (uint32_t i = 0; i < m_BlockCount; i++)
+		{
+			// Runs of the same block are the common case
+			if (blocks[i] != lastBlock)
+			{
+				auto it = std::find(m_Palette.begin(), m_Palette.end(), blocks[i]);
+				if (it == m_Palette.end())
+					it = m_Palette.insert(m_Palette.end(), blocks[i]);
+				lastBlock = blocks[i];
+				lastIndex = (uint16_t)(it - m_Palette.begin());
+			}
+			indices[i] = lastIndex;
+		}
+		m_Palette.shrink_to_fit();
+
+		SetBitsPerBlock(GetBitsForPaletteSize(m_Palette.size()));
+		if (m_BitsPerBlock == 0)
+			return;
+
+		uint32_t indicesPerWord = 1u << m_IndicesPerWordShift;
+		for (uint32_t w = 0; w < (uint32_t)m_Words.size(); w++)
+		{
+			uint64_t word = 0;
+			uint32_t begin = w * indicesPerWord;
+			uint32_t count = std::min(indicesPerWord, m_BlockCount - begin);
+			for (uint32_t i = 0; i < count; i++)
+				word |= (uint64_t)indices[begin + i] << (i * m_BitsPerBlock);
+			m_Words[w] = word;
+		}
+	}
+
+	void PalettedBlockStorage::Compact()
+	{
+		if (m_BitsPerBlock == 0)
+			return;
+
+		std::vector<BlockID> blocks(m_BlockCount);
+		Decode(blocks.data());
+		Encode(blocks.data());
+	}
+
+	static uint32_t ZigZagEncode(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+	static int32_t ZigZagDecode(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+	static uint32_t GetPaletteIndexBits(size_t paletteSize)
+	{
+		uint32_t bits = 0;
+		while ((size_t(1) << bits) < paletteSize)
+			bits++;
+		return bits;
+	}
+
+	void WriteChunkCoordinate(BitWriter& writer, const glm::ivec3& coordinate)
+	{
+		writer.WriteVarUInt(ZigZagEncode(coordinate.x));
+		writer.WriteVarUInt(ZigZagEncode(coordinate.y));
+		writer.WriteVarUInt(ZigZagEncode(coordinate.z));
+	}
+
+	glm::ivec3 ReadChunkCoordinate(BitReader& reader)
+	{
+		glm::ivec3 coordinate;
+		coordinate.x = ZigZagDecode(reader.ReadVarUInt());
+		coordinate.y = ZigZagDecode(reader.ReadVarUInt());
+		coordinate.z = ZigZagDecode(reader.ReadVarUInt());
+		return coordinate;
+	}
+
+	void WriteChunkBlocks(BitWriter& writer, const PalettedBlockStorage& blocks)
+	{
+		thread_local std::vector<BlockID> decoded;
+		decoded.resize(blocks.GetBlockCount());
+		blocks.Decode(decoded.data());
+
+		const std::vector<BlockID>& palette = blocks.GetPalette();
+		writer.WriteVarUInt((uint32_t)palette.size());
+		for (BlockID block : palette)
+			writer.WriteBits(block, 16);
+
+		uint32_t indexBits = GetPaletteIndexBits(palette.size());
+		for (uint32_t begin = 0; begin < (uint32_t)decoded.size();)
+		{
+			BlockID block = decoded[begin];
+			uint32_t end = begin + 1;
+			while (end < (uint32_t)decoded.size() && decoded[end] == block)
+				end++;
+
+			writer.WriteVarUInt(end - begin - 1);
+			if (indexBits)
+				writer.WriteBits((uint32_t)(std::find(palette.begin(), palette.end(), block) - palette.begin()), indexBits);
+
+			begin = end;
+		}
+	}
+
+	bool ReadChunkBlocks(BitReader& reader, PalettedBlockStorage& blocks)
+	{
+		const uint32_t blockCount = blocks.GetBlockCount();
+
+		uint32_t paletteSize = reader.ReadVarUInt();
+		if (!reader.IsValid() || paletteSize == 0 || paletteSize > blockCount || paletteSize > 65536)
+			return false;
+
+		thread_local std::vector<BlockID> palette;
+		palette.resize(paletteSize);
+		for (BlockID& block : palette)
+			block = (BlockID)reader.ReadBits(16);
+
+		thread_local std::vector<BlockID> decoded;
+		decoded.resize(blockCount);
+
+		uint32_t indexBits = GetPaletteIndexBits(paletteSize);
+		for (uint32_t begin = 0; begin < blockCount;)
+		{
+			uint32_t length = reader.ReadVarUInt() + 1;
+			uint32_t index = indexBits ? reader.ReadBits(indexBits) : 0;
+			if (!reader.IsValid() || length == 0 || length > blockCount - begin || index >= paletteSize)
+				return false;
+
+			std::fill_n(&decoded[begin], length, palette[index]);
+			begin += length;
+		}
+
+		blocks.Encode(decoded.data());
+		return true;
+	}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "BitStream.h"
+
+namespace Cubed
+{
+	using BlockID = uint16_t;
+
+	static constexpr BlockID AirBlock = 0;
+	static constexpr BlockID StoneBlock = 1;
+	static constexpr BlockID DirtBlock = 2;
+	static constexpr BlockID GrassBlock = 3;
+	static constexpr BlockID SandBlock = 4;
+
+	//
+	// PalettedBlockStorage - a chunk's blocks as indices into a per-chunk palette of distinct
+	// block IDs, bit-packed at the fewest bits the palette needs (0, 1, 2, 4, 8 or 16; powers of
+	// two so no index straddles a 64-bit word). A chunk of a single block type stores no
+	// indices at all, and typical terrain chunks need 2-4 bits per block instead of 16.
+	//
+	// The palette only grows while blocks are set; Compact() drops entries that are no longer
+	// used and shrinks the indices again.
+	//
+	class PalettedBlockStorage
+	{
+	public:
+		explicit PalettedBlockStorage(uint32_t blockCount, BlockID fill = AirBlock);
+
+		BlockID Get(uint32_t index) const
+		{
+			if (m_BitsPerBlock == 0)
+				return m_Palette[0];
+
+			uint32_t word = index >> m_IndicesPerWordShift;
+			uint32_t shift = (index & ((1u << m_IndicesPerWordShift) - 1)) * m_BitsPerBlock;
+			return m_Palette[(m_Words[word] >> shift) & m_IndexMask];
+		}
+
+		void Set(uint32_t index, BlockID block);
+		void Fill(BlockID block);
+
+		// Writes every block to `blocks` (GetBlockCount() of them), much faster than Get() per block
+		void Decode(BlockID* blocks) const;
+		// Replaces every block from `blocks`, building a minimal palette
+		void Encode(const BlockID* blocks);
+
+		void Compact();
+
+		uint32_t GetBlockCount() const { return m_BlockCount; }
+		uint32_t GetBitsPerBlock() const { return m_BitsPerBlock; }
+		const std::vector<BlockID>& GetPalette() const { return m_Palette; }
+		const std::vector<uint64_t>& GetWords() const { return m_Words; }
+		// Heap memory held by the palette and packed indices
+		size_t GetMemoryUsage() const { return m_Palette.capacity() * sizeof(BlockID) + m_Words.capacity() * sizeof(uint64_t); }
+	private:
+		uint32_t GetIndex(uint32_t index) const;
+		void SetIndex(uint32_t index, uint32_t paletteIndex);
+		void Repack(uint32_t bitsPerBlock);
+		void SetBitsPerBlock(uint32_t bitsPerBlock);
+
+		static uint32_t GetBitsForPaletteSize(size_t paletteSize);
+	private:
+		uint32_t m_BlockCount;
+		std::vector<BlockID> m_Palette;
+		std::vector<uint64_t> m_Words;
+
+		uint32_t m_BitsPerBlock = 0;
+		uint32_t m_IndicesPerWordShift = 0; // log2(64 / bits per block)
+		uint64_t m_IndexMask = 0;
+	};
+
+	//
+	// Chunk - Size^3 blocks of the world, at chunk coordinate Coordinate (in chunks; the block
+	// at local (x, y, z) is at world block Coordinate * Size + (x, y, z)). Y is up.
+	// Blocks are stored x fastest, then z, then y, so a horizontal layer is contiguous.
+	//
+	class Chunk
+	{
+	public:
+		static constexpr uint32_t Size = 32;
+		static constexpr uint32_t Volume = Size * Size * Size;
+	public:
+		explicit Chunk(const glm::ivec3& coordinate = { 0, 0, 0 }, BlockID fill = AirBlock)
+			: m_Coordinate(coordinate), m_Blocks(Volume, fill) {}
+
+		static constexpr uint32_t GetIndex(uint32_t x, uint32_t y, uint32_t z) { return (y * Size + z) * Size + x; }
+
+		BlockID Get(uint32_t x, uint32_t y, uint32_t z) const { return m_Blocks.Get(GetIndex(x, y, z)); }
+		void Set(uint32_t x, uint32_t y, uint32_t z, BlockID block) { m_Blocks.Set(GetIndex(x, y, z), block); }
+
+		const glm::ivec3& GetCoordinate() const { return m_Coordinate; }
+		PalettedBlockStorage& GetBlocks() { return m_Blocks; }
+		const PalettedBlockStorage& GetBlocks() const { return m_Blocks; }
+	private:
+		glm::ivec3 m_Coordinate;
+		PalettedBlockStorage m_Blocks;
+	};
+
+	// Chunk coordinate packed into one integer for hashing, 21 bits per axis
+	inline uint64_t GetChunkKey(const glm::ivec3& coordinate)
+	{
+		return ((uint64_t)((uint32_t)coordinate.x & 0x1fffff) << 42) | ((uint64_t)((uint32_t)coordinate.y & 0x1fffff) << 21) | (uint64_t)((uint32_t)coordinate.z & 0x1fffff);
+	}
+
+	//
+	// Chunk serialization, bit-packed (see BitStream.h):
+	// Coordinate - three zigzag-encoded VarUInts
+	// Blocks - VarUInt palette size, 16 bits per palette entry, then runs of the same palette
+	// index in block order until all blocks are covered: VarUInt run length - 1, followed by the
+	// index in ceil(log2(palette size)) bits (nothing for a single entry palette). Terrain is
+	// mostly long horizontal runs, so this is a fraction of even the packed in-memory size.
+	//
+	void WriteChunkCoordinate(BitWriter& writer, const glm::ivec3& coordinate);
+	glm::ivec3 ReadChunkCoordinate(BitReader& reader);
+
+	void WriteChunkBlocks(BitWriter& writer, const PalettedBlockStorage& blocks);
+	// Returns false, leaving `blocks` unchanged, if the data is malformed or doesn't cover exactly its block count
+	bool ReadChunkBlocks(BitReader& reader, PalettedBlockStorage& blocks);
+
+}
@@ -0,0 +1,134 @@
+#include "ChunkMesher.h"
+
+#include <algorithm>
+
+namespace Cubed
+{
+	static constexpr uint32_t s_N = Chunk::Size;
+	static constexpr uint32_t s_Padded = Chunk::Size + 2;
+
+	// Strides in the padded volume per axis (x, y, z)
+	static constexpr int32_t s_Strides[3] = { 1, (int32_t)(s_Padded * s_Padded), (int32_t)s_Padded };
+	// Padded index of local block (0, 0, 0)
+	static constexpr int32_t s_Origin = s_Strides[0] + s_Strides[1] + s_Strides[2];
+
+	void ChunkMesher::LoadBlocks(const Chunk& chunk, const ChunkNeighbours& neighbours)
+	{
+		m_Blocks.assign(s_Padded * s_Padded * s_Padded, AirBlock);
+		m_ChunkBlocks.resize(Chunk::Volume);
+		chunk.GetBlocks().Decode(m_ChunkBlocks.data());
+
+		// Chunk rows are contiguous in x in both layouts
+		for (uint32_t y = 0; y < s_N; y++)
+			for (uint32_t z = 0; z < s_N; z++)
+				std::copy_n(&m_ChunkBlocks[Chunk::GetIndex(0, y, z)], s_N, &m_Blocks[s_Origin + y * s_Strides[1] + z * s_Strides[2]]);
+
+		// One layer from each neighbour: the side facing this chunk
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			const Chunk* neighbour = neighbours.Chunks[face];
+			if (!neighbour)
+				continue;
+
+			uint32_t axis = GetFaceAxis((BlockFace)face);
+			bool positive = IsPositiveFace((BlockFace)face);
+			uint32_t uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+
+			int32_t paddedLayer = positive ? (int32_t)s_N : -1;
+			uint32_t neighbourLayer = positive ? 0 : s_N - 1;
+			for (uint32_t v = 0; v < s_N; v++)
+			{
+				for (uint32_t u = 0; u < s_N; u++)
+				{
+					uint32_t local[3];
+					local[axis] = neighbourLayer;
+					local[uAxis] = u;
+					local[vAxis] = v;
+
+					int32_t index = s_Origin + paddedLayer * s_Strides[axis] + (int32_t)u * s_Strides[uAxis] + (int32_t)v * s_Strides[vAxis];
+					m_Blocks[index] = neighbour->Get(local[0], local[1], local[2]);
+				}
+			}
+		}
+	}
+
+	void ChunkMesher::Mesh(const Chunk& chunk, const ChunkNeighbours& neighbours, std::vector<ChunkQuad>& quads)
+	{
+		quads.clear();
+
+		// Nothing to see in an all-air chunk
+		const PalettedBlockStorage& storage = chunk.GetBlocks();
+		if (storage.GetBitsPerBlock() == 0 && storage.GetPalette()[0] == AirBlock)
+			return;
+
+		LoadBlocks(chunk, neighbours);
+		m_Mask.resize(s_N * s_N);
+
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			uint32_t axis = GetFaceAxis((BlockFace)face);
+			uint32_t uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+			int32_t normalStride = IsPositiveFace((BlockFace)face) ? s_Strides[axis] : -s_Strides[axis];
+			int32_t uStride = s_Strides[uAxis], vStride = s_Strides[vAxis];
+
+			for (uint32_t slice = 0; slice < s_N; slice++)
+			{
+				// Visible faces in this slice: solid block with air in front of it
+				bool anyFace = false;
+				int32_t sliceBase = s_Origin + (int32_t)slice * s_Strides[axis];
+				for (uint32_t v = 0; v < s_N; v++)
+				{
+					int32_t index = sliceBase + (int32_t)v * vStride;
+					for (uint32_t u = 0; u < s_N; u++, index += uStride)
+					{
+						BlockID block = m_Blocks[index];
+						BlockID visible = (block != AirBlock && m_Blocks[index + normalStride] == AirBlock) ? block : AirBlock;
+						m_Mask[v * s_N + u] = visible;
+						anyFace |= visible != AirBlock;
+					}
+				}
+
+				if (!anyFace)
+					continue;
+
+				// Greedy merge: take the widest run, then grow it down rows while the whole run matches
+				for (uint32_t v = 0; v < s_N; v++)
+				{
+					for (uint32_t u = 0; u < s_N;)
+					{
+						BlockID block = m_Mask[v * s_N + u];
+						if (block == AirBlock)
+						{
+							u++;
+							continue;
+						}
+
+						uint32_t width = 1;
+						while (u + width < s_N && m_Mask[v * s_N + u + width] == block)
+							width++;
+
+						uint32_t height = 1;
+						for (; v + height < s_N; height++)
+						{
+							const BlockID* row = &m_Mask[(v + height) * s_N + u];
+							if (std::any_of(row, row + width, [block](BlockID other) { return other != block; }))
+								break;
+						}
+
+						for (uint32_t row = 0; row < height; row++)
+							std::fill_n(&m_Mask[(v + row) * s_N + u], width, AirBlock);
+
+						uint32_t position[3];
+						position[axis] = slice;
+						position[uAxis] = u;
+						position[vAxis] = v;
+						quads.push_back({ (uint8_t)position[0], (uint8_t)position[1], (uint8_t)position[2], (BlockFace)face, (uint8_t)width, (uint8_t)height, block });
+
+						u += width;
+					}
+				}
+			}
+		}
+	}
+
+}
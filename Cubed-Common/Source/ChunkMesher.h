@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "Chunk.h"
+
+namespace Cubed
+{
+	enum class BlockFace : uint8_t
+	{
+		PositiveX = 0, NegativeX, PositiveY, NegativeY, PositiveZ, NegativeZ
+	};
+
+	// Axis a face points along (0 = x, 1 = y, 2 = z); its quads span axes (a + 1) % 3 (U) and (a + 2) % 3 (V)
+	constexpr uint32_t GetFaceAxis(BlockFace face) { return (uint32_t)face / 2; }
+	constexpr bool IsPositiveFace(BlockFace face) { return ((uint32_t)face & 1) == 0; }
+
+	//
+	// ChunkQuad - Width x Height visible block faces of the same block merged into one quad.
+	// X, Y, Z is the chunk-local block owning the quad's minimum corner; Width runs along the
+	// face's U axis and Height along V (see GetFaceAxis). 8 bytes, so meshes are small enough
+	// to draw as instanced quads.
+	//
+	struct ChunkQuad
+	{
+		uint8_t X, Y, Z;
+		BlockFace Face;
+		uint8_t Width, Height;
+		BlockID Block;
+	};
+
+	// Adjacent chunks, indexed by BlockFace; null ones count as air, so border faces are emitted
+	struct ChunkNeighbours
+	{
+		const Chunk* Chunks[6] = {};
+	};
+
+	//
+	// ChunkMesher - greedy mesher: for every face direction and every slice along it, marks
+	// the faces between a solid block and air, then merges runs of the same block into the
+	// largest rectangles it can (widest first, then as tall as the whole row allows).
+	//
+	// Keeps its scratch buffers between calls; use one mesher per thread.
+	//
+	class ChunkMesher
+	{
+	public:
+		// Replaces `quads` with the chunk's mesh
+		void Mesh(const Chunk& chunk, const ChunkNeighbours& neighbours, std::vector<ChunkQuad>& quads);
+	private:
+		void LoadBlocks(const Chunk& chunk, const ChunkNeighbours& neighbours);
+	private:
+		// The chunk plus a one block border from its neighbours, (Size + 2)^3, x fastest then z then y
+		std::vector<BlockID> m_Blocks;
+		std::vector<BlockID> m_ChunkBlocks;
+		std::vector<BlockID> m_Mask; // one slice, Size^2
+	};
+
+}
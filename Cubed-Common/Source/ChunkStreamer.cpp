@@ -0,0 +1,317 @@
+#include "ChunkStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "ServerPacket.h"
+
+namespace Cubed
+{
+	// How much the view direction shortens the distance of chunks ahead (and lengthens those behind)
+	static constexpr float s_ViewDirectionWeight = 0.5f;
+	// Pending chunks considered per client per update, best first
+	static constexpr uint32_t s_CandidatesPerClient = 16;
+	// Updates between sweeps for chunks no client holds, and how long those stay cached
+	static constexpr uint64_t s_EvictionInterval = 64;
+
+	ChunkStreamer::ChunkStreamer(const ChunkStreamingSettings& settings, const TerrainSettings& terrain, uint32_t threadCount)
+		: m_Settings(settings), m_Terrain(terrain), m_OwnedJobPool(std::make_unique<JobPool>(threadCount)), m_JobPool(m_OwnedJobPool.get())
+	{
+	}
+
+	ChunkStreamer::ChunkStreamer(JobPool& jobPool, const ChunkStreamingSettings& settings, const TerrainSettings& terrain)
+		: m_Settings(settings), m_Terrain(terrain), m_JobPool(&jobPool)
+	{
+	}
+
+	void ChunkStreamer::AddClient(uint32_t clientID)
+	{
+		m_Clients[clientID] = ClientState();
+	}
+
+	void ChunkStreamer::RemoveClient(uint32_t clientID)
+	{
+		auto it = m_Clients.find(clientID);
+		if (it == m_Clients.end())
+			return;
+
+		for (const auto& [key, coordinate] : it->second.SentChunks)
+			ReleaseChunk(key);
+
+		m_Clients.erase(it);
+	}
+
+	void ChunkStreamer::UpdateClient(uint32_t clientID, const glm::vec2& position, const glm::vec2& velocity)
+	{
+		auto it = m_Clients.find(clientID);
+		if (it == m_Clients.end())
+			return;
+
+		ClientState& client = it->second;
+		client.Position = position;
+
+		// Standing still keeps facing the way we last moved
+		float speed = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+		if (speed > 0.01f)
+			client.ViewDirection = velocity / speed;
+
+		glm::ivec3 column((int32_t)std::floor(position.x / Chunk::Size), 0, (int32_t)std::floor(position.y / Chunk::Size));
+		if (!client.HasPosition || column != client.CenterColumn)
+		{
+			client.CenterColumn = column;
+			client.HasPosition = true;
+			UpdateVisibleChunks(client);
+		}
+	}
+
+	void ChunkStreamer::Acknowledge(uint32_t clientID, uint32_t sequence)
+	{
+		auto it = m_Clients.find(clientID);
+		if (it == m_Clients.end())
+			return;
+
+		ClientState& client = it->second;
+		while (!client.InFlight.empty() && (int32_t)(sequence - client.InFlight.front().Sequence) >= 0)
+		{
+			client.BytesInFlight -= client.InFlight.front().Bytes;
+			client.InFlight.pop_front();
+		}
+	}
+
+	void ChunkStreamer::UpdateVisibleChunks(ClientState& client)
+	{
+		const glm::ivec3& center = client.CenterColumn;
+
+		const int32_t unloadDistanceSquared = m_Settings.UnloadDistance * m_Settings.UnloadDistance;
+		for (auto it = client.SentChunks.begin(); it != client.SentChunks.end();)
+		{
+			int32_t dx = it->second.x - center.x, dz = it->second.z - center.z;
+			if (dx * dx + dz * dz <= unloadDistanceSquared)
+			{
+				++it;
+				continue;
+			}
+
+			client.UnloadedChunks.push_back(it->second);
+			ReleaseChunk(it->first);
+			it = client.SentChunks.erase(it);
+		}
+
+		// Rebuilt rather than diffed; it only happens when the player crosses into another column
+		client.PendingChunks.clear();
+		const int32_t viewDistance = m_Settings.ViewDistance;
+		for (int32_t dz = -viewDistance; dz <= viewDistance; dz++)
+		{
+			for (int32_t dx = -viewDistance; dx <= viewDistance; dx++)
+			{
+				if (dx * dx + dz * dz > viewDistance * viewDistance)
+					continue;
+
+				for (int32_t y = m_Settings.MinChunkY; y <= m_Settings.MaxChunkY; y++)
+				{
+					glm::ivec3 coordinate(center.x + dx, y, center.z + dz);
+					if (!client.SentChunks.contains(GetChunkKey(coordinate)))
+						client.PendingChunks.push_back(coordinate);
+				}
+			}
+		}
+	}
+
+	void ChunkStreamer::Update()
+	{
+		m_UpdateCount++;
+
+		// Pick each client's best candidates first, so the chunks they need are generated together
+		std::vector<WorldChunk*> chunksToGenerate;
+		for (auto& [clientID, client] : m_Clients)
+		{
+			client.ByteBudget = std::min(client.ByteBudget + (float)m_Settings.BytesPerTick, 2.0f * (float)m_Settings.BytesPerTick);
+
+			client.Candidates.clear();
+			if (client.PendingChunks.empty() || client.BytesInFlight >= m_Settings.MaxBytesInFlight)
+				continue;
+
+			SelectCandidates(client);
+			for (Candidate& candidate : client.Candidates)
+			{
+				WorldChunk& chunk = GetOrCreateChunk(client.PendingChunks[candidate.PendingIndex]);
+				chunk.LastUsedUpdate = m_UpdateCount;
+				candidate.Chunk = &chunk;
+
+				if (chunk.Encoded.empty() && !chunk.Queued && chunksToGenerate.size() < m_Settings.MaxGeneratedChunksPerUpdate)
+				{
+					chunk.Queued = true;
+					chunksToGenerate.push_back(&chunk);
+				}
+			}
+		}
+
+		GenerateChunks(chunksToGenerate);
+
+		for (auto& [clientID, client] : m_Clients)
+		{
+			SendUnloads(clientID, client);
+			SendChunks(clientID, client);
+		}
+
+		if (m_UpdateCount % s_EvictionInterval == 0)
+			EvictUnusedChunks();
+	}
+
+	void ChunkStreamer::SelectCandidates(ClientState& client) const
+	{
+		const glm::vec3 viewPosition(client.Position.x, m_Settings.ViewHeight, client.Position.y);
+		const float halfChunk = Chunk::Size * 0.5f;
+
+		for (uint32_t i = 0; i < (uint32_t)client.PendingChunks.size(); i++)
+		{
+			const glm::ivec3& coordinate = client.PendingChunks[i];
+			glm::vec3 offset((float)coordinate.x * Chunk::Size + halfChunk - viewPosition.x,
+				(float)coordinate.y * Chunk::Size + halfChunk - viewPosition.y,
+				(float)coordinate.z * Chunk::Size + halfChunk - viewPosition.z);
+
+			float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+			float horizontalDistance = std::sqrt(offset.x * offset.x + offset.z * offset.z);
+			float facing = horizontalDistance > 0.0f ? (offset.x * client.ViewDirection.x + offset.z * client.ViewDirection.y) / horizontalDistance : 0.0f;
+
+			client.Candidates.push_back({ distance * (1.0f - s_ViewDirectionWeight * facing), i, nullptr });
+		}
+
+		uint32_t count = std::min((uint32_t)client.Candidates.size(), s_CandidatesPerClient);
+		std::partial_sort(client.Candidates.begin(), client.Candidates.begin() + count, client.Candidates.end(),
+			[](const Candidate& a, const Candidate& b) { return a.Score < b.Score; });
+		client.Candidates.resize(count);
+	}
+
+	void ChunkStreamer::GenerateChunks(const std::vector<WorldChunk*>& chunks)
+	{
+		m_JobPool->ParallelFor((uint32_t)chunks.size(), 1, [&](uint32_t i)
+		{
+			WorldChunk& chunk = *chunks[i];
+			GenerateTerrainChunk(chunk.Blocks, m_Terrain);
+
+			PacketStreamWriter& stream = GetThreadPacketWriter();
+			BitWriter writer(stream);
+			WriteChunkCoordinate(writer, chunk.Blocks.GetCoordinate());
+			WriteChunkBlocks(writer, chunk.Blocks.GetBlocks());
+			writer.Flush();
+
+			Walnut::Buffer buffer = stream.GetBuffer();
+			chunk.Encoded.assign(buffer.As<uint8_t>(), buffer.As<uint8_t>() + buffer.Size);
+			chunk.Queued = false;
+		});
+	}
+
+	void ChunkStreamer::SendChunks(uint32_t clientID, ClientState& client)
+	{
+		if (client.Candidates.empty())
+			return;
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		std::vector<uint32_t> sentIndices;
+		for (const Candidate& candidate : client.Candidates)
+		{
+			if (client.ByteBudget <= 0.0f || client.BytesInFlight >= m_Settings.MaxBytesInFlight)
+				break;
+
+			// Not generated yet (over this update's generation limit); a later candidate may be
+			WorldChunk& chunk = *candidate.Chunk;
+			if (chunk.Encoded.empty())
+				continue;
+
+			uint32_t sequence = client.NextSequence++;
+			stream.Reset();
+			WritePacket<ChunkDataPacket>(stream, sequence, Walnut::Buffer(chunk.Encoded.data(), chunk.Encoded.size()));
+
+			Walnut::Buffer buffer = stream.GetBuffer();
+			if (m_SendCallback)
+				m_SendCallback(clientID, buffer);
+
+			uint32_t bytes = (uint32_t)buffer.Size;
+			client.ByteBudget -= (float)bytes;
+			client.BytesInFlight += bytes;
+			client.InFlight.push_back({ sequence, bytes });
+			client.ChunksSent++;
+			client.BytesSent += bytes;
+
+			const glm::ivec3& coordinate = chunk.Blocks.GetCoordinate();
+			client.SentChunks.emplace(GetChunkKey(coordinate), coordinate);
+			chunk.HolderCount++;
+
+			sentIndices.push_back(candidate.PendingIndex);
+		}
+
+		// Pending order doesn't matter, so swap-remove from the back to keep the other indices valid
+		std::sort(sentIndices.begin(), sentIndices.end(), std::greater<uint32_t>());
+		for (uint32_t index : sentIndices)
+		{
+			client.PendingChunks[index] = client.PendingChunks.back();
+			client.PendingChunks.pop_back();
+		}
+	}
+
+	void ChunkStreamer::SendUnloads(uint32_t clientID, ClientState& client)
+	{
+		if (client.UnloadedChunks.empty())
+			return;
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ChunkUnloadPacket>(stream);
+		BitWriter writer(stream);
+		writer.WriteVarUInt((uint32_t)client.UnloadedChunks.size());
+		for (const glm::ivec3& coordinate : client.UnloadedChunks)
+			WriteChunkCoordinate(writer, coordinate);
+		writer.Flush();
+
+		Walnut::Buffer buffer = stream.GetBuffer();
+		if (m_SendCallback)
+			m_SendCallback(clientID, buffer);
+
+		client.ByteBudget -= (float)buffer.Size;
+		client.BytesSent += buffer.Size;
+		client.UnloadedChunks.clear();
+	}
+
+	ChunkStreamer::WorldChunk& ChunkStreamer::GetOrCreateChunk(const glm::ivec3& coordinate)
+	{
+		std::unique_ptr<WorldChunk>& chunk = m_Chunks[GetChunkKey(coordinate)];
+		if (!chunk)
+			chunk = std::make_unique<WorldChunk>(coordinate);
+		return *chunk;
+	}
+
+	void ChunkStreamer::ReleaseChunk(uint64_t key)
+	{
+		auto it = m_Chunks.find(key);
+		if (it != m_Chunks.end() && it->second->HolderCount > 0)
+			it->second->HolderCount--;
+	}
+
+	void ChunkStreamer::EvictUnusedChunks()
+	{
+		std::erase_if(m_Chunks, [this](const auto& entry)
+		{
+			const WorldChunk& chunk = *entry.second;
+			return chunk.HolderCount == 0 && chunk.LastUsedUpdate + s_EvictionInterval < m_UpdateCount;
+		});
+	}
+
+	ChunkStreamStats ChunkStreamer::GetClientStats(uint32_t clientID) const
+	{
+		auto it = m_Clients.find(clientID);
+		if (it == m_Clients.end())
+			return {};
+
+		const ClientState& client = it->second;
+		ChunkStreamStats stats;
+		stats.HeldChunks = (uint32_t)client.SentChunks.size();
+		stats.PendingChunks = (uint32_t)client.PendingChunks.size();
+		stats.BytesInFlight = client.BytesInFlight;
+		stats.ChunksSent = client.ChunksSent;
+		stats.BytesSent = client.BytesSent;
+		return stats;
+	}
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Walnut/Core/Buffer.h"
+
+#include "Chunk.h"
+#include "JobPool.h"
+#include "WorldGenerator.h"
+
+namespace Cubed
+{
+	struct ChunkStreamingSettings
+	{
+		// Chunk columns within ViewDistance chunks are streamed, and unloaded again beyond
+		// UnloadDistance, so a player walking along a chunk border doesn't reload the same column
+		int32_t ViewDistance = 8;
+		int32_t UnloadDistance = 10;
+		// Chunk layers streamed in every column
+		int32_t MinChunkY = 0;
+		int32_t MaxChunkY = 1;
+		// Players move on the XZ plane at this height (in blocks), for chunk distances
+		float ViewHeight = 40.0f;
+
+		// Bytes of chunk traffic per client per tick (unused budget carries over up to one extra tick),
+		// and how much may be unacknowledged before streaming to that client pauses
+		uint32_t BytesPerTick = 16 * 1024;
+		uint32_t MaxBytesInFlight = 256 * 1024;
+
+		// Chunks generated per Update across all clients, bounding the time streaming adds to a tick
+		// (terrain takes about 1ms per chunk per core)
+		uint32_t MaxGeneratedChunksPerUpdate = 8;
+	};
+
+	struct ChunkStreamStats
+	{
+		uint32_t HeldChunks = 0; // sent, including those not acknowledged yet
+		uint32_t PendingChunks = 0; // in view but not sent
+		uint32_t BytesInFlight = 0;
+		uint64_t ChunksSent = 0;
+		uint64_t BytesSent = 0;
+	};
+
+	//
+	// ChunkStreamer - owns the server's chunks and streams them to clients (ChunkData and
+	// ChunkUnload packets, see ServerPacket.h).
+	//
+	// Each client gets the chunks around its player, nearest first and those ahead of the
+	// direction it is moving in before those behind, at most BytesPerTick per tick so chunk
+	// traffic never crowds out snapshots. A chunk is sent to a client once and not again until
+	// it has been unloaded; clients acknowledge the latest chunk sequence they received.
+	// Connections are reliable and ordered, so acknowledgements are cumulative and only used
+	// to limit how much is in flight.
+	//
+	// Chunks are generated on the job pool when first needed and serialized once, then the
+	// same bytes go to every client. Chunks no client holds are dropped again periodically.
+	//
+	class ChunkStreamer
+	{
+	public:
+		using SendCallback = std::function<void(uint32_t clientID, Walnut::Buffer buffer)>;
+	public:
+		ChunkStreamer(const ChunkStreamingSettings& settings = {}, const TerrainSettings& terrain = {}, uint32_t threadCount = 0);
+		// Generates chunks on a pool shared with other work instead of one of its own
+		ChunkStreamer(JobPool& jobPool, const ChunkStreamingSettings& settings = {}, const TerrainSettings& terrain = {});
+
+		void SetSendCallback(const SendCallback& callback) { m_SendCallback = callback; }
+
+		void AddClient(uint32_t clientID);
+		void RemoveClient(uint32_t clientID);
+
+		// Position is in blocks on the XZ plane (world x, z); velocity only picks the view direction
+		void UpdateClient(uint32_t clientID, const glm::vec2& position, const glm::vec2& velocity);
+		// Latest ChunkData sequence the client received
+		void Acknowledge(uint32_t clientID, uint32_t sequence);
+
+		// Generates what clients need next and sends within each client's budget
+		void Update();
+
+		ChunkStreamStats GetClientStats(uint32_t clientID) const;
+		uint32_t GetCachedChunkCount() const { return (uint32_t)m_Chunks.size(); }
+
+		const ChunkStreamingSettings& GetSettings() const { return m_Settings; }
+	private:
+		struct WorldChunk
+		{
+			Chunk Blocks;
+			std::vector<uint8_t> Encoded; // coordinate + blocks, bit-packed
+			uint32_t HolderCount = 0; // clients it was sent to and not unloaded from
+			uint64_t LastUsedUpdate = 0;
+			bool Queued = false; // for generation this update
+
+			WorldChunk(const glm::ivec3& coordinate) : Blocks(coordinate) {}
+		};
+
+		struct InFlightChunk
+		{
+			uint32_t Sequence;
+			uint32_t Bytes;
+		};
+
+		struct Candidate
+		{
+			float Score; // distance, shortened ahead of the view direction; lower goes first
+			uint32_t PendingIndex;
+			WorldChunk* Chunk;
+		};
+
+		struct ClientState
+		{
+			glm::vec2 Position{ 0.0f, 0.0f };
+			glm::vec2 ViewDirection{ 0.0f, 0.0f };
+			glm::ivec3 CenterColumn{ 0, 0, 0 };
+			bool HasPosition = false;
+
+			// Chunks the client has or has been sent, so none is ever sent twice
+			std::unordered_map<uint64_t, glm::ivec3> SentChunks;
+			// In view, not sent yet; reordered every update since the view direction changes
+			std::vector<glm::ivec3> PendingChunks;
+			std::vector<glm::ivec3> UnloadedChunks; // sent in the next update
+			std::vector<Candidate> Candidates; // this update's best pending chunks
+
+			std::deque<InFlightChunk> InFlight;
+			uint32_t BytesInFlight = 0;
+			uint32_t NextSequence = 1;
+			float ByteBudget = 0.0f;
+
+			uint64_t ChunksSent = 0;
+			uint64_t BytesSent = 0;
+		};
+
+		void UpdateVisibleChunks(ClientState& client);
+		void SelectCandidates(ClientState& client) const;
+		void GenerateChunks(const std::vector<WorldChunk*>& chunks);
+		void SendChunks(uint32_t clientID, ClientState& client);
+		void SendUnloads(uint32_t clientID, ClientState& client);
+		void ReleaseChunk(uint64_t key);
+		void EvictUnusedChunks();
+
+		WorldChunk& GetOrCreateChunk(const glm::ivec3& coordinate);
+	private:
+		ChunkStreamingSettings m_Settings;
+		TerrainSettings m_Terrain;
+		SendCallback m_SendCallback;
+
+		std::unordered_map<uint64_t, std::unique_ptr<WorldChunk>> m_Chunks;
+		std::unordered_map<uint32_t, ClientState> m_Clients;
+		uint64_t m_UpdateCount = 0;
+
+		std::unique_ptr<JobPool> m_OwnedJobPool;
+		JobPool* m_JobPool;
+	};
+
+}
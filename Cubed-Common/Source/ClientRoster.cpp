@@ -0,0 +1,196 @@
+#include "ClientRoster.h"
+
+#include <algorithm>
+#include <random>
+
+#include "ServerPacket.h"
+
+namespace Cubed
+{
+	// Usernames are unique ignoring ASCII case, so "Bob" can't join next to "bob"
+	static std::string GetUsernameKey(std::string_view username)
+	{
+		std::string key(username);
+		for (char& c : key)
+		{
+			if (c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+		}
+		return key;
+	}
+
+	bool IsValidUsername(std::string_view username)
+	{
+		if (username.empty() || username.size() > MaxUsernameLength)
+			return false;
+
+		for (char c : username)
+		{
+			if ((uint8_t)c < 0x20 || c == 0x7f)
+				return false;
+		}
+		return true;
+	}
+
+	void WriteRosterEntry(Walnut::StreamWriter& stream, const RosterEntry& entry)
+	{
+		WritePacket<RosterEntryRecord>(stream, entry.ClientID, entry.Color, entry.Username);
+	}
+
+	RosterEntry ReadRosterEntry(const PacketView<RosterEntryRecord>& record)
+	{
+		return { record.Get<RosterEntryRecord::ClientID>(), record.Get<RosterEntryRecord::Color>(), std::string(record.Get<RosterEntryRecord::Username>()) };
+	}
+
+	ClientRoster::ClientRoster(uint32_t epoch)
+		: m_Changes(ChangeLogCapacity), m_Epoch(epoch)
+	{
+		// Clients remember the epoch they synced with; a restarted server must not look like the same roster
+		while (m_Epoch == 0)
+			m_Epoch = std::random_device()();
+	}
+
+	bool ClientRoster::IsUsernameTaken(std::string_view username) const
+	{
+		return m_Usernames.contains(GetUsernameKey(username));
+	}
+
+	void ClientRoster::ReserveUsername(std::string_view username)
+	{
+		m_Usernames.try_emplace(GetUsernameKey(username), UINT32_MAX);
+	}
+
+	SharedPacket ClientRoster::Add(uint32_t clientID, uint32_t color, std::string_view username)
+	{
+		if (!IsValidUsername(username) || m_Entries.contains(clientID))
+			return {};
+
+		if (!m_Usernames.try_emplace(GetUsernameKey(username), clientID).second)
+			return {};
+
+		RosterEntry& entry = m_Entries[clientID];
+		entry = { clientID, color & 0xffffff, std::string(username) };
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ClientConnectPacket>(stream, ++m_Version);
+		WriteRosterEntry(stream, entry);
+
+		SharedPacket& change = GetChange(m_Version);
+		change = PacketPool::Get().Create(stream);
+		return change;
+	}
+
+	SharedPacket ClientRoster::Remove(uint32_t clientID)
+	{
+		auto it = m_Entries.find(clientID);
+		if (it == m_Entries.end())
+			return {};
+
+		m_Usernames.erase(GetUsernameKey(it->second.Username));
+		m_Entries.erase(it);
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ClientDisconnectPacket>(stream, ++m_Version, clientID);
+
+		SharedPacket& change = GetChange(m_Version);
+		change = PacketPool::Get().Create(stream);
+		return change;
+	}
+
+	const RosterEntry* ClientRoster::Find(uint32_t clientID) const
+	{
+		auto it = m_Entries.find(clientID);
+		return it != m_Entries.end() ? &it->second : nullptr;
+	}
+
+	bool ClientRoster::CatchUp(uint32_t epoch, uint32_t version, const SendCallback& send) const
+	{
+		uint32_t missed = m_Version - version;
+		bool canReplay = epoch == m_Epoch && version <= m_Version && missed <= std::min(m_Version, ChangeLogCapacity);
+
+		// A delta carries at most one entry, so past one delta per entry the list is smaller
+		if (canReplay && missed <= m_Entries.size())
+		{
+			for (uint32_t v = version + 1; v <= m_Version; v++)
+				send(GetChange(v).GetBuffer());
+			return false;
+		}
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WriteList(stream);
+		send(stream.GetBuffer());
+		return true;
+	}
+
+	void ClientRoster::WriteList(Walnut::StreamWriter& stream) const
+	{
+		WritePacket<ClientListPacket>(stream, m_Epoch, m_Version, (uint32_t)m_Entries.size());
+		for (const auto& [clientID, entry] : m_Entries)
+			WriteRosterEntry(stream, entry);
+	}
+
+	bool RosterReplica::ApplyList(const PacketView<ClientListPacket>& list)
+	{
+		// Read one at a time rather than trusting the count up front; a bogus count runs out of data quickly
+		std::unordered_map<uint32_t, RosterEntry> entries;
+		RecordReader<RosterEntryRecord> reader(list.Get<ClientListPacket::Entries>());
+		uint32_t count = list.Get<ClientListPacket::Count>();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			PacketView<RosterEntryRecord> record = reader.Next();
+			if (!record)
+				return false;
+			entries[record.Get<RosterEntryRecord::ClientID>()] = ReadRosterEntry(record);
+		}
+
+		if (!reader.IsAtEnd())
+			return false;
+
+		m_Entries = std::move(entries);
+		m_Epoch = list.Get<ClientListPacket::RosterEpoch>();
+		m_Version = list.Get<ClientListPacket::RosterVersion>();
+		return true;
+	}
+
+	bool RosterReplica::ApplyConnect(const PacketView<ClientConnectPacket>& connect)
+	{
+		uint32_t version = connect.Get<ClientConnectPacket::RosterVersion>();
+		if (IsStale(version))
+			return true;
+
+		PacketView<RosterEntryRecord> record(connect.Get<ClientConnectPacket::Body>());
+		if (version != m_Version + 1 || !record)
+			return false;
+
+		m_Entries[record.Get<RosterEntryRecord::ClientID>()] = ReadRosterEntry(record);
+		m_Version = version;
+		return true;
+	}
+
+	bool RosterReplica::ApplyDisconnect(const PacketView<ClientDisconnectPacket>& disconnect)
+	{
+		uint32_t version = disconnect.Get<ClientDisconnectPacket::RosterVersion>();
+		if (IsStale(version))
+			return true;
+		if (version != m_Version + 1)
+			return false;
+
+		m_Entries.erase(disconnect.Get<ClientDisconnectPacket::ClientID>());
+		m_Version = version;
+		return true;
+	}
+
+	void RosterReplica::Clear()
+	{
+		m_Entries.clear();
+		m_Epoch = 0;
+		m_Version = 0;
+	}
+
+	const RosterEntry* RosterReplica::Find(uint32_t clientID) const
+	{
+		auto it = m_Entries.find(clientID);
+		return it != m_Entries.end() ? &it->second : nullptr;
+	}
+
+}
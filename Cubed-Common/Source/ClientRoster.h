@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Walnut/Serialization/BufferStream.h"
+
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+
+namespace Cubed
+{
+	struct RosterEntry
+	{
+		uint32_t ClientID = 0;
+		uint32_t Color = 0; // RGB, most significant 8 bits ignored
+		std::string Username;
+	};
+
+	// Non-empty, at most MaxUsernameLength bytes and no control characters
+	bool IsValidUsername(std::string_view username);
+
+	// A RosterEntryRecord, as in ClientConnect and ClientList packets
+	void WriteRosterEntry(Walnut::StreamWriter& stream, const RosterEntry& entry);
+	RosterEntry ReadRosterEntry(const PacketView<RosterEntryRecord>& record);
+
+	//
+	// ClientRoster - the clients that joined with a username, with a version that goes up by one
+	// per change. Each change is serialized once as a delta (ClientConnect or ClientDisconnect, see
+	// ServerPacket.h) for every other client. The last ChangeLogCapacity deltas are kept, so a client
+	// that is a few versions behind catches up by replaying them; the full ClientList only goes to
+	// clients too far behind, new ones, and those that last synced with an earlier server run (epoch).
+	//
+	// Usernames are indexed by hash, ignoring ASCII case, so checking a name is free is O(1).
+	// Not thread-safe.
+	//
+	class ClientRoster
+	{
+	public:
+		static constexpr uint32_t ChangeLogCapacity = 256;
+
+		using SendCallback = std::function<void(Walnut::Buffer buffer)>;
+	public:
+		ClientRoster(uint32_t epoch = 0); // 0 picks a random epoch
+
+		bool IsUsernameTaken(std::string_view username) const;
+		// Makes a name unavailable to clients without adding an entry, e.g. the server's own chat name
+		void ReserveUsername(std::string_view username);
+
+		// Returns the client's ClientConnect delta, or an empty packet if the client already joined
+		// or the username is invalid or taken
+		SharedPacket Add(uint32_t clientID, uint32_t color, std::string_view username);
+		// Returns the ClientDisconnect delta, or an empty packet if the client never joined
+		SharedPacket Remove(uint32_t clientID);
+
+		const RosterEntry* Find(uint32_t clientID) const;
+
+		// Sends whatever brings a client holding (epoch, version) up to date: nothing, the deltas it
+		// missed, or the full list when replaying would be longer or the deltas are gone.
+		// Returns whether the full list was sent.
+		bool CatchUp(uint32_t epoch, uint32_t version, const SendCallback& send) const;
+
+		// ClientList packet
+		void WriteList(Walnut::StreamWriter& stream) const;
+
+		uint32_t GetEpoch() const { return m_Epoch; }
+		uint32_t GetVersion() const { return m_Version; }
+		uint32_t GetCount() const { return (uint32_t)m_Entries.size(); }
+		const std::unordered_map<uint32_t, RosterEntry>& GetEntries() const { return m_Entries; }
+	private:
+		SharedPacket& GetChange(uint32_t version) { return m_Changes[(version - 1) % ChangeLogCapacity]; }
+		const SharedPacket& GetChange(uint32_t version) const { return m_Changes[(version - 1) % ChangeLogCapacity]; }
+	private:
+		std::unordered_map<uint32_t, RosterEntry> m_Entries; // by client ID
+		std::unordered_map<std::string, uint32_t> m_Usernames; // lowercased username -> client ID
+
+		std::vector<SharedPacket> m_Changes; // delta to version v at (v - 1) % ChangeLogCapacity
+		uint32_t m_Epoch = 0;
+		uint32_t m_Version = 0;
+	};
+
+	//
+	// RosterReplica - a client's copy of the roster, built from ClientList and the deltas after it.
+	// The Apply functions take valid views (ApplyConnect only roster deltas, RosterVersion != 0).
+	// They return false when the packet's contents are malformed or it skips versions; the client
+	// then asks for the roster again (ClientList request) with its Epoch and Version, as it does
+	// for packets that don't even match their layout.
+	//
+	class RosterReplica
+	{
+	public:
+		bool ApplyList(const PacketView<ClientListPacket>& list);
+		bool ApplyConnect(const PacketView<ClientConnectPacket>& connect);
+		bool ApplyDisconnect(const PacketView<ClientDisconnectPacket>& disconnect);
+
+		void Clear();
+
+		const RosterEntry* Find(uint32_t clientID) const;
+
+		uint32_t GetEpoch() const { return m_Epoch; }
+		uint32_t GetVersion() const { return m_Version; }
+		const std::unordered_map<uint32_t, RosterEntry>& GetEntries() const { return m_Entries; }
+	private:
+		// Deltas at or below our version were already applied (by a list that included them)
+		bool IsStale(uint32_t version) const { return (int32_t)(version - m_Version) <= 0; }
+	private:
+		std::unordered_map<uint32_t, RosterEntry> m_Entries;
+		uint32_t m_Epoch = 0;
+		uint32_t m_Version = 0;
+	};
+
+}
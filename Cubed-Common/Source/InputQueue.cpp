@@ -0,0 +1,66 @@
+#include "InputQueue.h"
+
+#include <algorithm>
+
+namespace Cubed
+{
+	bool InputSendWindow::Add(const PlayerInput& input)
+	{
+		if (m_Count == Capacity)
+		{
+			std::move(m_Inputs.begin() + 1, m_Inputs.end(), m_Inputs.begin());
+			m_Count--;
+		}
+
+		m_Inputs[m_Count++] = input;
+		if (++m_UnsentCount < InputsPerPacket)
+			return false;
+
+		m_UnsentCount = 0;
+		return true;
+	}
+
+	void InputSendWindow::Clear()
+	{
+		m_Count = 0;
+		m_UnsentCount = 0;
+	}
+
+	uint32_t InputQueue::Push(const PlayerInput* inputs, uint32_t count)
+	{
+		uint32_t accepted = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const PlayerInput& input = inputs[i];
+			if (m_HasReceivedInput && !IsNewerInputSequence(input.Sequence, m_LastReceivedSequence))
+				continue;
+
+			if (m_Count == Capacity)
+			{
+				m_Begin = (m_Begin + 1) % Capacity;
+				m_Count--;
+				m_DroppedCount++;
+			}
+
+			m_Inputs[(m_Begin + m_Count) % Capacity] = input;
+			m_Count++;
+			m_LastReceivedSequence = input.Sequence;
+			m_HasReceivedInput = true;
+			accepted++;
+		}
+
+		return accepted;
+	}
+
+	bool InputQueue::Pop(PlayerInput& input)
+	{
+		if (m_Count == 0)
+			return false;
+
+		input = m_Inputs[m_Begin];
+		m_Begin = (m_Begin + 1) % Capacity;
+		m_Count--;
+		return true;
+	}
+
+}
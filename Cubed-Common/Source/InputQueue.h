@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+
+#include "Movement.h"
+
+namespace Cubed
+{
+	//
+	// InputSendWindow - client side of the input uplink. Holds the most recent inputs and
+	// says when enough new ones have accumulated to send a packet; every packet carries the
+	// new inputs plus up to RedundantInputs already sent ones.
+	//
+	class InputSendWindow
+	{
+	public:
+		static constexpr uint32_t Capacity = InputsPerPacket + RedundantInputs;
+	public:
+		// Inputs must have consecutive sequences. Returns true when a packet is due.
+		bool Add(const PlayerInput& input);
+		void Clear();
+
+		// Oldest first, ready for WritePlayerInputs()
+		const PlayerInput* GetInputs() const { return m_Inputs.data(); }
+		uint32_t GetCount() const { return m_Count; }
+	private:
+		std::array<PlayerInput, Capacity> m_Inputs;
+		uint32_t m_Count = 0;
+		uint32_t m_UnsentCount = 0;
+	};
+
+	//
+	// InputQueue - server side of the input uplink, one per client. Input packets arrive in
+	// batches with repeats; this drops the repeats and hands back one input per tick in
+	// sequence order, so the server steps through them exactly like the client predicted.
+	// When nothing is queued the previous input stays in effect.
+	//
+	class InputQueue
+	{
+	public:
+		// Inputs beyond this are dropped oldest first, which bounds the added input latency
+		static constexpr uint32_t Capacity = 8;
+	public:
+		// Returns how many of the inputs were new
+		uint32_t Push(const PlayerInput* inputs, uint32_t count);
+		// Next input to apply, oldest first; false if none arrived since the last one
+		bool Pop(PlayerInput& input);
+
+		uint32_t GetCount() const { return m_Count; }
+		uint64_t GetDroppedCount() const { return m_DroppedCount; }
+	private:
+		std::array<PlayerInput, Capacity> m_Inputs;
+		uint32_t m_Begin = 0;
+		uint32_t m_Count = 0;
+
+		bool m_HasReceivedInput = false;
+		uint32_t m_LastReceivedSequence = 0;
+		uint64_t m_DroppedCount = 0;
+	};
+
+}
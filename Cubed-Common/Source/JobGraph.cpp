@@ -0,0 +1,52 @@
+#include "JobGraph.h"
+
+namespace Cubed
+{
+	JobGraph::JobID JobGraph::Add(std::function<void()> job, std::initializer_list<JobID> dependencies)
+	{
+		JobID id = (JobID)m_Jobs.size();
+		Node& node = m_Jobs.emplace_back();
+		node.Func = std::move(job);
+
+		for (JobID dependency : dependencies)
+		{
+			m_Jobs[dependency].Dependents.push_back(id);
+			node.DependencyCount++;
+		}
+
+		return id;
+	}
+
+	void JobGraph::Run(JobPool& pool)
+	{
+		for (Node& node : m_Jobs)
+			node.RemainingDependencies.store(node.DependencyCount, std::memory_order_relaxed);
+
+		// A job submits its dependents before it finishes, so the group can't run dry early
+		JobGroup group;
+		for (JobID id = 0; id < (JobID)m_Jobs.size(); id++)
+		{
+			if (m_Jobs[id].DependencyCount == 0)
+				Submit(pool, group, id);
+		}
+
+		pool.Wait(group);
+	}
+
+	void JobGraph::Submit(JobPool& pool, JobGroup& group, JobID id)
+	{
+		pool.Submit(group, [this, &pool, &group, id]()
+		{
+			Node& node = m_Jobs[id];
+			node.Func();
+
+			// The last dependency to finish releases the job; acq_rel makes every dependency's writes visible to it
+			for (JobID dependent : node.Dependents)
+			{
+				if (m_Jobs[dependent].RemainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					Submit(pool, group, dependent);
+			}
+		});
+	}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include "JobPool.h"
+
+namespace Cubed
+{
+	//
+	// JobGraph - jobs with explicit dependencies, run on a JobPool. A job starts once every job it
+	// depends on has finished; jobs without a path between them may run at the same time. The
+	// graph is the record of which steps may overlap, so each job must only touch state that no job
+	// it can overlap with writes. Built once, then Run() as often as needed (every tick).
+	//
+	class JobGraph
+	{
+	public:
+		using JobID = uint32_t;
+	public:
+		// Dependencies must already be in the graph, which rules out cycles
+		JobID Add(std::function<void()> job, std::initializer_list<JobID> dependencies = {});
+
+		// Runs every job once and returns when all of them have finished. The calling thread helps.
+		void Run(JobPool& pool);
+
+		uint32_t GetJobCount() const { return (uint32_t)m_Jobs.size(); }
+	private:
+		struct Node
+		{
+			std::function<void()> Func;
+			std::vector<JobID> Dependents;
+			uint32_t DependencyCount = 0;
+			std::atomic<uint32_t> RemainingDependencies = 0; // during Run()
+		};
+
+		void Submit(JobPool& pool, JobGroup& group, JobID id);
+	private:
+		std::deque<Node> m_Jobs; // never moves a node, unlike a vector
+	};
+
+}
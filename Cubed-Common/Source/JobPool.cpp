@@ -0,0 +1,178 @@
+#include "JobPool.h"
+
+namespace Cubed
+{
+	// Set on each worker thread, so jobs submitted from a worker go to its own deque
+	static thread_local JobPool* s_CurrentPool = nullptr;
+	static thread_local uint32_t s_WorkerIndex = 0;
+
+	JobPool::JobPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		m_Queues.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Queues.push_back(std::make_unique<WorkerQueue>());
+
+		m_Threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Threads.emplace_back([this, i]() { WorkerThreadFunc(i); });
+	}
+
+	JobPool::~JobPool()
+	{
+		Wait();
+
+		// Every deque is empty now; the extra count just wakes the workers so they see we're stopping
+		m_Stopping.store(true, std::memory_order_release);
+		m_QueuedJobs.fetch_add(1, std::memory_order_release);
+		m_QueuedJobs.notify_all();
+
+		for (std::thread& thread : m_Threads)
+			thread.join();
+	}
+
+	void JobPool::Submit(std::function<void()> job)
+	{
+		Submit(m_DefaultGroup, std::move(job));
+	}
+
+	void JobPool::Submit(JobGroup& group, std::function<void()> job)
+	{
+		group.m_UnfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+
+		uint32_t queueIndex = s_CurrentPool == this ? s_WorkerIndex : m_NextQueue.fetch_add(1, std::memory_order_relaxed) % (uint32_t)m_Queues.size();
+		WorkerQueue& queue = *m_Queues[queueIndex];
+		{
+			std::scoped_lock<std::mutex> lock(queue.Mutex);
+			queue.Jobs.push_back({ std::move(job), &group });
+		}
+
+		// One job needs one helper: wake a single worker, or a single waiter if any is asleep.
+		// Pairs with Wait: either we see its sleeper count or it sees this job (both seq_cst).
+		m_QueuedJobs.fetch_add(1, std::memory_order_seq_cst);
+		m_QueuedJobs.notify_one();
+		if (m_SleepingWaiters.load(std::memory_order_seq_cst) > 0)
+		{
+			m_WaitGeneration.fetch_add(1, std::memory_order_release);
+			m_WaitGeneration.notify_one();
+		}
+	}
+
+	void JobPool::Wait()
+	{
+		Wait(m_DefaultGroup);
+	}
+
+	void JobPool::Wait(JobGroup& group)
+	{
+		for (;;)
+		{
+			// Read before checking, so a job queued or a group finishing in between still changes it
+			uint32_t generation = m_WaitGeneration.load(std::memory_order_acquire);
+			if (group.IsDone())
+				return;
+
+			if (TryRunJob())
+				continue;
+
+			// The rest of the group is running elsewhere; a new job or any group finishing wakes us to look again.
+			// Submit only wakes waiters it can see, so recheck for jobs after announcing ourselves.
+			m_SleepingWaiters.fetch_add(1, std::memory_order_seq_cst);
+			if (m_QueuedJobs.load(std::memory_order_seq_cst) == 0)
+				m_WaitGeneration.wait(generation, std::memory_order_acquire);
+			else
+				std::this_thread::yield(); // a job is being taken right now; look again
+			m_SleepingWaiters.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	bool JobPool::TryRunJob()
+	{
+		if (m_QueuedJobs.load(std::memory_order_acquire) == 0)
+			return false;
+
+		Job job;
+		bool found = false;
+		bool stolen = false;
+
+		bool isWorker = s_CurrentPool == this;
+		uint32_t queueCount = (uint32_t)m_Queues.size();
+		if (isWorker)
+		{
+			WorkerQueue& queue = *m_Queues[s_WorkerIndex];
+			std::scoped_lock<std::mutex> lock(queue.Mutex);
+			if (!queue.Jobs.empty())
+			{
+				job = std::move(queue.Jobs.back());
+				queue.Jobs.pop_back();
+				found = true;
+			}
+		}
+
+		// Steal the oldest job, starting with the next worker's deque so thieves spread out
+		uint32_t firstQueue = isWorker ? s_WorkerIndex + 1 : m_NextQueue.load(std::memory_order_relaxed);
+		for (uint32_t i = 0; i < queueCount && !found; i++)
+		{
+			uint32_t queueIndex = (firstQueue + i) % queueCount;
+			if (isWorker && queueIndex == s_WorkerIndex)
+				continue;
+
+			WorkerQueue& queue = *m_Queues[queueIndex];
+			std::scoped_lock<std::mutex> lock(queue.Mutex);
+			if (!queue.Jobs.empty())
+			{
+				job = std::move(queue.Jobs.front());
+				queue.Jobs.pop_front();
+				found = true;
+				stolen = isWorker;
+			}
+		}
+
+		if (!found)
+			return false;
+
+		m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		if (stolen)
+			m_StolenJobs.fetch_add(1, std::memory_order_relaxed);
+
+		job.Func();
+		FinishJob(*job.Group);
+		return true;
+	}
+
+	void JobPool::FinishJob(JobGroup& group)
+	{
+		// The group may be gone as soon as its count reaches 0, so waiters are woken through the pool
+		if (group.m_UnfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			m_WaitGeneration.fetch_add(1, std::memory_order_release);
+			m_WaitGeneration.notify_all();
+		}
+	}
+
+	void JobPool::WorkerThreadFunc(uint32_t workerIndex)
+	{
+		s_CurrentPool = this;
+		s_WorkerIndex = workerIndex;
+
+		for (;;)
+		{
+			if (TryRunJob())
+				continue;
+
+			if (m_Stopping.load(std::memory_order_acquire))
+				return;
+
+			if (m_QueuedJobs.load(std::memory_order_acquire) == 0)
+				m_QueuedJobs.wait(0, std::memory_order_acquire);
+			else
+				std::this_thread::yield(); // a job is being taken right now; look again
+		}
+	}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Cubed
+{
+	//
+	// JobGroup - counts jobs submitted with it so they can be waited for together, independently
+	// of whatever else the pool is running. Must outlive the jobs submitted with it.
+	//
+	class JobGroup
+	{
+	public:
+		JobGroup() = default;
+		JobGroup(const JobGroup&) = delete;
+		JobGroup& operator=(const JobGroup&) = delete;
+
+		bool IsDone() const { return m_UnfinishedJobs.load(std::memory_order_acquire) == 0; }
+	private:
+		std::atomic<uint32_t> m_UnfinishedJobs = 0; // queued or running
+
+		friend class JobPool;
+	};
+
+	//
+	// JobPool - fixed set of worker threads, each with its own job deque. A worker pushes and pops
+	// jobs it submits at the back of its own deque (newest first, still warm in cache) and, when that
+	// is empty, steals the oldest job from the front of someone else's. Jobs submitted from outside
+	// the pool are spread over the deques. Meant for coarse jobs (a chunk to mesh, a batch of a
+	// parallel loop), where one uncontended lock per job is noise.
+	//
+	// Waiting runs queued jobs on the waiting thread instead of just blocking, so jobs may submit
+	// and wait for jobs of their own (a ParallelFor inside a job). Those may be anyone's jobs, so
+	// per-thread scratch (GetThreadPacketWriter) mustn't be held across a wait.
+	//
+	class JobPool
+	{
+	public:
+		// 0 = one worker per hardware thread, minus one for the thread that submits and waits
+		explicit JobPool(uint32_t threadCount = 0);
+		~JobPool();
+
+		JobPool(const JobPool&) = delete;
+		JobPool& operator=(const JobPool&) = delete;
+
+		void Submit(std::function<void()> job);
+		void Submit(JobGroup& group, std::function<void()> job);
+		// Returns once every job submitted without a group so far has finished
+		void Wait();
+		// Returns once every job submitted with `group` so far has finished
+		void Wait(JobGroup& group);
+
+		// Calls func(i) for every i in [0, count) across the pool and waits for all of them.
+		// Indices are handed out in batches of `batchSize`. Safe to call from inside a job.
+		template<typename Func>
+		void ParallelFor(uint32_t count, uint32_t batchSize, Func&& func)
+		{
+			batchSize = batchSize ? batchSize : 1;
+			if (count <= batchSize)
+			{
+				for (uint32_t i = 0; i < count; i++)
+					func(i);
+				return;
+			}
+
+			JobGroup group;
+			for (uint32_t begin = 0; begin < count; begin += batchSize)
+			{
+				uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+				Submit(group, [&func, begin, end]()
+				{
+					for (uint32_t i = begin; i < end; i++)
+						func(i);
+				});
+			}
+			Wait(group);
+		}
+
+		uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+		// Jobs a worker took from another worker's deque, since the pool was created
+		uint64_t GetStolenJobCount() const { return m_StolenJobs.load(std::memory_order_relaxed); }
+	private:
+		struct Job
+		{
+			std::function<void()> Func;
+			JobGroup* Group = nullptr;
+		};
+
+		struct WorkerQueue
+		{
+			std::mutex Mutex;
+			std::deque<Job> Jobs;
+		};
+
+		void WorkerThreadFunc(uint32_t workerIndex);
+		// Runs one queued job if there is any: the calling worker's own newest job, else the oldest of another deque
+		bool TryRunJob();
+		void FinishJob(JobGroup& group);
+	private:
+		std::vector<std::thread> m_Threads;
+		std::vector<std::unique_ptr<WorkerQueue>> m_Queues; // one per worker
+
+		JobGroup m_DefaultGroup;
+
+		// Jobs sitting in the deques; idle workers sleep on it while it is 0
+		std::atomic<uint32_t> m_QueuedJobs = 0;
+		// Bumped whenever a group finishes, or a job is queued while a waiter sleeps; waiters with nothing
+		// to run sleep on it, so they wake to help with new jobs as well as to return
+		std::atomic<uint32_t> m_WaitGeneration = 0;
+		std::atomic<uint32_t> m_SleepingWaiters = 0;
+		// Where the next job from outside the pool goes
+		std::atomic<uint32_t> m_NextQueue = 0;
+		std::atomic<uint64_t> m_StolenJobs = 0;
+		std::atomic<bool> m_Stopping = false;
+	};
+
+}
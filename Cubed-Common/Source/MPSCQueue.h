@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace Cubed
+{
+	//
+	// MPSCQueue - bounded lock-free multi-producer/single-consumer ring buffer
+	// (Vyukov's sequence-per-cell scheme). Producers claim a cell with a CAS on the
+	// enqueue index; the consumer needs no atomics RMW at all. Push fails instead of
+	// blocking when the queue is full, and the queue itself allocates nothing after
+	// construction (values are moved in and out, so their own storage travels with them).
+	//
+	template<typename T>
+	class MPSCQueue
+	{
+	public:
+		// Capacity is rounded up to a power of two
+		MPSCQueue(uint32_t capacity)
+		{
+			uint32_t roundedCapacity = 1;
+			while (roundedCapacity < capacity)
+				roundedCapacity <<= 1;
+
+			m_Mask = roundedCapacity - 1;
+			m_Cells = std::make_unique<Cell[]>(roundedCapacity);
+			for (uint32_t i = 0; i < roundedCapacity; i++)
+				m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		// Safe to call from any number of threads
+		bool Push(const T& value) { return Emplace(value); }
+		bool Push(T&& value) { return Emplace(std::move(value)); }
+
+		// Consumer thread only
+		bool Pop(T& value)
+		{
+			Cell& cell = m_Cells[m_DequeuePosition & m_Mask];
+			uint64_t sequence = cell.Sequence.load(std::memory_order_acquire);
+			if ((int64_t)sequence - (int64_t)(m_DequeuePosition + 1) < 0)
+				return false; // empty
+
+			value = std::move(cell.Value);
+			cell.Sequence.store(m_DequeuePosition + m_Mask + 1, std::memory_order_release);
+			m_DequeuePosition++;
+			return true;
+		}
+
+		// Consumer thread only; pops what was pushed before the call and returns how many. Values
+		// pushed while draining wait for the next call, so busy producers can't keep the consumer
+		// here: one call handles at most GetCapacity() values.
+		template<typename Func>
+		uint32_t Drain(Func&& func)
+		{
+			uint64_t endPosition = m_EnqueuePosition.load(std::memory_order_relaxed);
+			uint32_t count = 0;
+			T value;
+			while (m_DequeuePosition < endPosition && Pop(value))
+			{
+				func(value);
+				count++;
+			}
+			return count;
+		}
+
+		uint32_t GetCapacity() const { return m_Mask + 1; }
+	private:
+		template<typename U>
+		bool Emplace(U&& value)
+		{
+			Cell* cell;
+			uint64_t position = m_EnqueuePosition.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				cell = &m_Cells[position & m_Mask];
+				uint64_t sequence = cell->Sequence.load(std::memory_order_acquire);
+				int64_t difference = (int64_t)sequence - (int64_t)position;
+				if (difference == 0)
+				{
+					if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (difference < 0)
+				{
+					return false; // full
+				}
+				else
+				{
+					position = m_EnqueuePosition.load(std::memory_order_relaxed);
+				}
+			}
+
+			cell->Value = std::forward<U>(value);
+			cell->Sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+	private:
+		struct Cell
+		{
+			std::atomic<uint64_t> Sequence;
+			T Value;
+		};
+
+		std::unique_ptr<Cell[]> m_Cells;
+		uint64_t m_Mask = 0;
+
+		// Keep producer and consumer indices on separate cache lines
+		alignas(64) std::atomic<uint64_t> m_EnqueuePosition = 0;
+		alignas(64) uint64_t m_DequeuePosition = 0;
+	};
+
+}
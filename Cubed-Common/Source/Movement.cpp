@@ -0,0 +1,183 @@
+#include "Movement.h"
+
+#include "Snapshot.h"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define CUBED_MOVEMENT_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CUBED_MOVEMENT_SSE2
+#endif
+
+namespace Cubed
+{
+	// PlayerPositionQuantization's bounds from Snapshot.h, so snapshots never clamp a position again.
+	// The top is one step under Max, the highest value a position quantizes to.
+	static constexpr float s_MinPosition = PlayerPositionQuantization.Min;
+	static constexpr float s_MaxPosition = PlayerPositionQuantization.Max - PlayerPositionQuantization.GetStep();
+
+	static constexpr float s_InverseSqrt2 = 0.70710678118654752f;
+
+	static constexpr uint32_t s_InputCountBits = 3;
+	static_assert(MaxInputsPerPacket == 1u << s_InputCountBits);
+	static_assert(InputsPerPacket + RedundantInputs <= MaxInputsPerPacket);
+
+	void WritePlayerInputs(BitWriter& writer, const PlayerInput* inputs, uint32_t count)
+	{
+		count = std::clamp(count, 1u, MaxInputsPerPacket);
+		writer.WriteBits(count - 1, s_InputCountBits);
+		writer.WriteBits(inputs[0].Sequence, 32);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			writer.WriteBits((uint32_t)(std::clamp<int>(inputs[i].MoveX, -1, 1) + 1), 2);
+			writer.WriteBits((uint32_t)(std::clamp<int>(inputs[i].MoveY, -1, 1) + 1), 2);
+		}
+	}
+
+	uint32_t ReadPlayerInputs(BitReader& reader, PlayerInput* inputs)
+	{
+		uint32_t count = reader.ReadBits(s_InputCountBits) + 1;
+		uint32_t sequence = reader.ReadBits(32);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			// 3 is never written; treat it like "no movement" rather than trusting it
+			uint32_t moveX = reader.ReadBits(2);
+			uint32_t moveY = reader.ReadBits(2);
+			inputs[i].MoveX = moveX < 3 ? (int8_t)moveX - 1 : 0;
+			inputs[i].MoveY = moveY < 3 ? (int8_t)moveY - 1 : 0;
+			inputs[i].Sequence = sequence + i;
+		}
+
+		return reader.IsValid() ? count : 0;
+	}
+
+	glm::vec2 GetInputDirection(const PlayerInput& input)
+	{
+		glm::vec2 direction((float)input.MoveX, (float)input.MoveY);
+		if (input.MoveX != 0 && input.MoveY != 0)
+			direction *= s_InverseSqrt2;
+		return direction;
+	}
+
+	static float GetDampingFactor(float timestep, const MovementSettings& settings)
+	{
+		float factor = 1.0f - settings.Damping * timestep;
+		return factor > 0.0f ? factor : 0.0f;
+	}
+
+	// Written out to mirror the SIMD kernels operation for operation, including
+	// min/max operand order (which decides the result for equal or signed-zero inputs)
+	static void IntegrateMovementRange(float* positions, float* velocities, const float* directions, uint32_t begin, uint32_t end,
+		float timestep, float speed, float damping)
+	{
+		for (uint32_t i = begin; i < end; i += 2)
+		{
+			bool hasInput = directions[i] != 0.0f || directions[i + 1] != 0.0f;
+			for (uint32_t j = i; j < i + 2; j++)
+			{
+				float velocity = hasInput ? directions[j] * speed : velocities[j];
+				velocity = velocity * damping;
+
+				float position = positions[j] + velocity * timestep;
+				position = position > s_MinPosition ? position : s_MinPosition;
+				position = position < s_MaxPosition ? position : s_MaxPosition;
+
+				velocities[j] = velocity;
+				positions[j] = position;
+			}
+		}
+	}
+
+	void IntegrateMovementScalar(glm::vec2* positions, glm::vec2* velocities, const glm::vec2* directions, uint32_t count, float timestep, const MovementSettings& settings)
+	{
+		IntegrateMovementRange((float*)positions, (float*)velocities, (const float*)directions, 0, count * 2,
+			timestep, settings.Speed, GetDampingFactor(timestep, settings));
+	}
+
+	void IntegrateMovementSIMD(glm::vec2* positions, glm::vec2* velocities, const glm::vec2* directions, uint32_t count, float timestep, const MovementSettings& settings)
+	{
+		// glm::vec2 arrays are tightly packed x,y pairs, so a register holds 2 (SSE) or 4 (AVX) players
+		float* p = (float*)positions;
+		float* v = (float*)velocities;
+		const float* d = (const float*)directions;
+		float damping = GetDampingFactor(timestep, settings);
+
+		uint32_t floatCount = count * 2;
+		uint32_t i = 0;
+
+#if defined(CUBED_MOVEMENT_AVX)
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 speed = _mm256_set1_ps(settings.Speed);
+		const __m256 dampingFactor = _mm256_set1_ps(damping);
+		const __m256 dt = _mm256_set1_ps(timestep);
+		const __m256 minPosition = _mm256_set1_ps(s_MinPosition);
+		const __m256 maxPosition = _mm256_set1_ps(s_MaxPosition);
+
+		for (; i + 8 <= floatCount; i += 8)
+		{
+			__m256 direction = _mm256_loadu_ps(d + i);
+			__m256 velocity = _mm256_loadu_ps(v + i);
+			__m256 position = _mm256_loadu_ps(p + i);
+
+			// A player has input if either of its components is non-zero; swap x/y within each pair and OR
+			__m256 nonZero = _mm256_cmp_ps(direction, zero, _CMP_NEQ_UQ);
+			__m256 hasInput = _mm256_or_ps(nonZero, _mm256_permute_ps(nonZero, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			velocity = _mm256_blendv_ps(velocity, _mm256_mul_ps(direction, speed), hasInput);
+			velocity = _mm256_mul_ps(velocity, dampingFactor);
+
+			position = _mm256_add_ps(position, _mm256_mul_ps(velocity, dt));
+			position = _mm256_max_ps(position, minPosition);
+			position = _mm256_min_ps(position, maxPosition);
+
+			_mm256_storeu_ps(v + i, velocity);
+			_mm256_storeu_ps(p + i, position);
+		}
+#elif defined(CUBED_MOVEMENT_SSE2)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 speed = _mm_set1_ps(settings.Speed);
+		const __m128 dampingFactor = _mm_set1_ps(damping);
+		const __m128 dt = _mm_set1_ps(timestep);
+		const __m128 minPosition = _mm_set1_ps(s_MinPosition);
+		const __m128 maxPosition = _mm_set1_ps(s_MaxPosition);
+
+		for (; i + 4 <= floatCount; i += 4)
+		{
+			__m128 direction = _mm_loadu_ps(d + i);
+			__m128 velocity = _mm_loadu_ps(v + i);
+			__m128 position = _mm_loadu_ps(p + i);
+
+			__m128 nonZero = _mm_cmpneq_ps(direction, zero);
+			__m128 hasInput = _mm_or_ps(nonZero, _mm_shuffle_ps(nonZero, nonZero, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			// No blendv before SSE4.1
+			velocity = _mm_or_ps(_mm_and_ps(hasInput, _mm_mul_ps(direction, speed)), _mm_andnot_ps(hasInput, velocity));
+			velocity = _mm_mul_ps(velocity, dampingFactor);
+
+			position = _mm_add_ps(position, _mm_mul_ps(velocity, dt));
+			position = _mm_max_ps(position, minPosition);
+			position = _mm_min_ps(position, maxPosition);
+
+			_mm_storeu_ps(v + i, velocity);
+			_mm_storeu_ps(p + i, position);
+		}
+#endif
+
+		IntegrateMovementRange(p, v, d, i, floatCount, timestep, settings.Speed, damping);
+	}
+
+	const char* GetMovementKernelName()
+	{
+#if defined(CUBED_MOVEMENT_AVX)
+		return "AVX";
+#elif defined(CUBED_MOVEMENT_SSE2)
+		return "SSE2";
+#else
+		return "Scalar";
+#endif
+	}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "glm/glm.hpp"
+
+#include "BitStream.h"
+
+namespace Cubed
+{
+	//
+	// PlayerInput - what a client sends instead of its position. Each axis is -1, 0 or 1;
+	// the sequence number increases by one per input so the server can discard stale ones.
+	//
+	struct PlayerInput
+	{
+		int8_t MoveX = 0;
+		int8_t MoveY = 0;
+		uint32_t Sequence = 0;
+	};
+
+	// Clients sample one input per server tick and send them InputsPerPacket at a time, each packet
+	// repeating the RedundantInputs before those, so a lost packet doesn't lose any input
+	static constexpr uint32_t InputsPerPacket = 2;
+	static constexpr uint32_t RedundantInputs = 2;
+	static constexpr uint32_t MaxInputsPerPacket = 8;
+
+	// Consecutive inputs (each sequence one more than the last), oldest first: 3-bit count - 1,
+	// 32-bit sequence of the first input, then 2 bits per axis per input. count is 1 to MaxInputsPerPacket.
+	void WritePlayerInputs(BitWriter& writer, const PlayerInput* inputs, uint32_t count);
+	// Returns the number of inputs read into `inputs` (room for MaxInputsPerPacket); 0 if malformed
+	uint32_t ReadPlayerInputs(BitReader& reader, PlayerInput* inputs);
+
+	// Unit-length (or zero) movement direction for an input
+	glm::vec2 GetInputDirection(const PlayerInput& input);
+
+	// True if `sequence` is newer than `lastSequence`, allowing for wrap-around
+	constexpr bool IsNewerInputSequence(uint32_t sequence, uint32_t lastSequence) { return (int32_t)(sequence - lastSequence) > 0; }
+
+	struct MovementSettings
+	{
+		float Speed = 50.0f;
+		float Damping = 2.0f; // fraction of velocity lost per second
+	};
+
+	static constexpr MovementSettings PlayerMovement;
+
+	//
+	// Batch movement integration over the dense PlayerStore arrays, one fixed timestep:
+	//   velocity = direction * speed (if there is any input), then damped
+	//   position += velocity * timestep, clamped to what position quantization can represent
+	// directions[i] must come from GetInputDirection().
+	//
+	// The SIMD kernel performs exactly the same IEEE operations in the same order as the
+	// scalar one, so both produce bit-identical results (as long as the compiler isn't
+	// allowed to contract multiply-adds, which C++ mode doesn't by default).
+	//
+	void IntegrateMovementScalar(glm::vec2* positions, glm::vec2* velocities, const glm::vec2* directions, uint32_t count, float timestep, const MovementSettings& settings = PlayerMovement);
+	// Falls back to the scalar kernel on targets without SSE2
+	void IntegrateMovementSIMD(glm::vec2* positions, glm::vec2* velocities, const glm::vec2* directions, uint32_t count, float timestep, const MovementSettings& settings = PlayerMovement);
+
+	inline void IntegrateMovement(glm::vec2* positions, glm::vec2* velocities, const glm::vec2* directions, uint32_t count, float timestep, const MovementSettings& settings = PlayerMovement)
+	{
+		IntegrateMovementSIMD(positions, velocities, directions, count, timestep, settings);
+	}
+
+	// "AVX", "SSE2" or "Scalar", depending on what IntegrateMovementSIMD was compiled for
+	const char* GetMovementKernelName();
+
+}
@@ -0,0 +1,109 @@
+#include "MovementPredictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Cubed
+{
+	void MovementPredictor::Reset(const PlayerData& state)
+	{
+		m_Initialized = true;
+		m_State = state;
+		m_CorrectionOffset = { 0.0f, 0.0f };
+		m_PendingBegin = 0;
+		m_PendingCount = 0;
+		m_HasAcknowledgedSequence = false;
+	}
+
+	void MovementPredictor::Predict(const PlayerInput& input, float timestep)
+	{
+		if (m_PendingCount == Capacity)
+		{
+			// Server has gone quiet for seconds; forget the oldest input rather than stall
+			m_PendingBegin = (m_PendingBegin + 1) % Capacity;
+			m_PendingCount--;
+			m_Stats.OverflowedInputs++;
+		}
+
+		PendingInput& pending = GetPending(m_PendingCount++);
+		pending.Sequence = input.Sequence;
+		pending.Direction = GetInputDirection(input);
+		pending.Timestep = timestep;
+
+		Step(m_State, pending.Direction, timestep);
+		pending.PredictedState = m_State;
+
+		m_CorrectionOffset *= std::exp(-timestep / CorrectionSmoothingTime);
+		m_Stats.PredictedSteps++;
+	}
+
+	void MovementPredictor::Reconcile(const PlayerData& state, bool hasInputSequence, uint32_t lastInputSequence)
+	{
+		if (!m_Initialized)
+		{
+			Reset(state);
+			return;
+		}
+
+		// Reordered or duplicate state; we've already rebased onto something newer
+		if (hasInputSequence && m_HasAcknowledgedSequence && !IsNewerInputSequence(lastInputSequence, m_AcknowledgedSequence) && lastInputSequence != m_AcknowledgedSequence)
+			return;
+
+		m_Stats.Reconciliations++;
+		if (hasInputSequence)
+		{
+			m_AcknowledgedSequence = lastInputSequence;
+			m_HasAcknowledgedSequence = true;
+		}
+
+		// Drop everything the server has already applied, keeping what we predicted for the last of it
+		bool foundAcknowledged = false;
+		PlayerData acknowledgedPrediction;
+		while (hasInputSequence && m_PendingCount > 0 && !IsNewerInputSequence(GetPending(0).Sequence, lastInputSequence))
+		{
+			if (GetPending(0).Sequence == lastInputSequence)
+			{
+				acknowledgedPrediction = GetPending(0).PredictedState;
+				foundAcknowledged = true;
+			}
+
+			m_PendingBegin = (m_PendingBegin + 1) % Capacity;
+			m_PendingCount--;
+		}
+
+		glm::vec2 renderPosition = GetRenderPosition();
+
+		m_State = state;
+		for (uint32_t i = 0; i < m_PendingCount; i++)
+		{
+			PendingInput& pending = GetPending(i);
+			Step(m_State, pending.Direction, pending.Timestep);
+			pending.PredictedState = m_State;
+		}
+		m_Stats.ReplayedSteps += m_PendingCount;
+
+		// Whatever changed, the player stays where it was drawn and eases onto the new prediction
+		m_CorrectionOffset = renderPosition - m_State.Position;
+
+		if (foundAcknowledged)
+		{
+			glm::vec2 error = acknowledgedPrediction.Position - state.Position;
+			float distance = std::sqrt(error.x * error.x + error.y * error.y);
+			if (distance > CorrectionThreshold)
+			{
+				m_Stats.Corrections++;
+				m_Stats.LastCorrection = distance;
+				m_Stats.MaxCorrection = std::max(m_Stats.MaxCorrection, distance);
+				m_Stats.TotalCorrection += distance;
+			}
+		}
+	}
+
+	void MovementPredictor::Step(PlayerData& state, glm::vec2 direction, float timestep)
+	{
+		// Same kernel the server runs over all players, so the only divergence comes from
+		// inputs landing on different ticks, never from the math
+		IntegrateMovement(&state.Position, &state.Velocity, &direction, 1, timestep);
+	}
+
+}
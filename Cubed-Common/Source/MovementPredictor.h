@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+
+#include "glm/glm.hpp"
+
+#include "Movement.h"
+#include "Snapshot.h"
+
+namespace Cubed
+{
+	struct PredictionStats
+	{
+		uint64_t PredictedSteps = 0;
+		uint64_t Reconciliations = 0; // authoritative states received
+		uint64_t ReplayedSteps = 0;
+
+		// Reconciliations where our prediction for the acknowledged input was off by more than
+		// the correction threshold
+		uint64_t Corrections = 0;
+		float LastCorrection = 0.0f; // distance in world units
+		float MaxCorrection = 0.0f;
+		double TotalCorrection = 0.0;
+
+		// Inputs that fell out of the pending buffer before the server acknowledged them
+		uint64_t OverflowedInputs = 0;
+	};
+
+	//
+	// MovementPredictor - client-side prediction for the local player. Every input is applied
+	// immediately with the same IntegrateMovement step the server runs, and kept until the
+	// server acknowledges it. When an authoritative state arrives, it replaces our state as of
+	// the acknowledged input and the unacknowledged inputs are replayed on top of it.
+	//
+	// Snapshot state is quantized, so replays from it can differ from the server's full-precision
+	// state by a fraction of a quantization step; only errors above CorrectionThreshold count as
+	// corrections. Corrections are blended out visually over CorrectionSmoothingTime.
+	//
+	class MovementPredictor
+	{
+	public:
+		static constexpr uint32_t Capacity = 128; // unacknowledged inputs, ~4s at 30Hz
+
+		// Two position quantization steps
+		static constexpr float CorrectionThreshold = 2.0f * PlayerPositionQuantization.GetStep();
+		static constexpr float CorrectionSmoothingTime = 0.1f;
+	public:
+		// Starts predicting from a known state (e.g. the first snapshot containing our player)
+		void Reset(const PlayerData& state);
+		bool IsInitialized() const { return m_Initialized; }
+
+		// Applies one input for one server tick. Sequences must increase by one per call.
+		void Predict(const PlayerInput& input, float timestep);
+
+		// `state` is the server's state after it applied every input up to `lastInputSequence`
+		// (hasInputSequence is false until the server has applied any)
+		void Reconcile(const PlayerData& state, bool hasInputSequence, uint32_t lastInputSequence);
+
+		const PlayerData& GetState() const { return m_State; }
+		// Predicted position with any recent correction still being blended out
+		glm::vec2 GetRenderPosition() const { return m_State.Position + m_CorrectionOffset; }
+
+		uint32_t GetPendingInputCount() const { return m_PendingCount; }
+		const PredictionStats& GetStats() const { return m_Stats; }
+	private:
+		struct PendingInput
+		{
+			uint32_t Sequence = 0;
+			glm::vec2 Direction{ 0.0f, 0.0f };
+			float Timestep = 0.0f;
+			PlayerData PredictedState; // after applying this input
+		};
+
+		static void Step(PlayerData& state, glm::vec2 direction, float timestep);
+		PendingInput& GetPending(uint32_t index) { return m_PendingInputs[(m_PendingBegin + index) % Capacity]; }
+	private:
+		bool m_Initialized = false;
+		PlayerData m_State;
+		glm::vec2 m_CorrectionOffset{ 0.0f, 0.0f };
+
+		std::array<PendingInput, Capacity> m_PendingInputs;
+		uint32_t m_PendingBegin = 0;
+		uint32_t m_PendingCount = 0;
+
+		bool m_HasAcknowledgedSequence = false;
+		uint32_t m_AcknowledgedSequence = 0;
+
+		PredictionStats m_Stats;
+	};
+
+}
@@ -0,0 +1,183 @@
+#include "PacketBuffer.h"
+
+#include <algorithm>
+
+namespace Cubed
+{
+	PacketStreamWriter::PacketStreamWriter(uint64_t initialCapacity, uint64_t maxCapacity)
+		: m_MaxCapacity(maxCapacity)
+	{
+		Reserve(std::min(initialCapacity, maxCapacity));
+	}
+
+	void PacketStreamWriter::SetStreamPosition(uint64_t position)
+	{
+		if (position > m_Capacity && !Reserve(position))
+		{
+			m_Overflowed = true;
+			return;
+		}
+
+		m_Position = position;
+	}
+
+	bool PacketStreamWriter::WriteData(const char* data, size_t size)
+	{
+		if (m_Overflowed)
+			return false;
+
+		uint64_t end = m_Position + size;
+		if (end > m_Capacity && !Reserve(end))
+		{
+			m_Overflowed = true;
+			return false;
+		}
+
+		memcpy(m_Storage.get() + m_Position, data, size);
+		m_Position = end;
+		return true;
+	}
+
+	void PacketStreamWriter::Reset()
+	{
+		m_Position = 0;
+		m_Overflowed = false;
+	}
+
+	bool PacketStreamWriter::Reserve(uint64_t capacity)
+	{
+		if (capacity <= m_Capacity)
+			return true;
+		if (capacity > m_MaxCapacity)
+			return false;
+
+		uint64_t newCapacity = std::max<uint64_t>(m_Capacity, 64);
+		while (newCapacity < capacity)
+			newCapacity *= 2;
+		newCapacity = std::min(newCapacity, m_MaxCapacity);
+
+		std::unique_ptr<uint8_t[]> storage = std::make_unique_for_overwrite<uint8_t[]>(newCapacity);
+		if (m_Position)
+			memcpy(storage.get(), m_Storage.get(), m_Position);
+
+		m_Storage = std::move(storage);
+		m_Capacity = newCapacity;
+		return true;
+	}
+
+	PacketStreamWriter& GetThreadPacketWriter()
+	{
+		thread_local PacketStreamWriter s_Writer;
+		s_Writer.Reset();
+		return s_Writer;
+	}
+
+	SharedPacket::SharedPacket(Block* block)
+		: m_Block(block)
+	{
+		m_Block->RefCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	SharedPacket::SharedPacket(const SharedPacket& other)
+		: m_Block(other.m_Block)
+	{
+		if (m_Block)
+			m_Block->RefCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	SharedPacket::SharedPacket(SharedPacket&& other) noexcept
+		: m_Block(other.m_Block)
+	{
+		other.m_Block = nullptr;
+	}
+
+	SharedPacket& SharedPacket::operator=(SharedPacket other) noexcept
+	{
+		std::swap(m_Block, other.m_Block);
+		return *this;
+	}
+
+	SharedPacket::~SharedPacket()
+	{
+		// acq_rel so the thread recycling the block sees every other owner's reads as finished
+		if (m_Block && m_Block->RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			PacketPool::Get().Release(m_Block);
+	}
+
+	Walnut::Buffer SharedPacket::GetBuffer() const
+	{
+		if (!m_Block)
+			return Walnut::Buffer();
+
+		return Walnut::Buffer(m_Block->Data.get(), m_Block->Size);
+	}
+
+	static uint32_t GetSizeClass(uint64_t size)
+	{
+		uint32_t sizeClassBits = PacketPool::MinSizeClassBits;
+		while (sizeClassBits <= PacketPool::MaxSizeClassBits && (1ull << sizeClassBits) < size)
+			sizeClassBits++;
+
+		return sizeClassBits - PacketPool::MinSizeClassBits;
+	}
+
+	PacketPool& PacketPool::Get()
+	{
+		static PacketPool s_Pool;
+		return s_Pool;
+	}
+
+	PacketPool::~PacketPool()
+	{
+		for (auto& freeBlocks : m_FreeBlocks)
+		{
+			for (SharedPacket::Block* block : freeBlocks)
+				delete block;
+		}
+	}
+
+	SharedPacket PacketPool::Create(Walnut::Buffer data)
+	{
+		uint32_t sizeClass = GetSizeClass(data.Size);
+
+		SharedPacket::Block* block = nullptr;
+		if (sizeClass != OversizedClass)
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			std::vector<SharedPacket::Block*>& freeBlocks = m_FreeBlocks[sizeClass];
+			if (!freeBlocks.empty())
+			{
+				block = freeBlocks.back();
+				freeBlocks.pop_back();
+			}
+		}
+
+		if (!block)
+		{
+			block = new SharedPacket::Block();
+			block->SizeClass = sizeClass;
+			block->Capacity = sizeClass == OversizedClass ? data.Size : 1ull << (sizeClass + MinSizeClassBits);
+			block->Data = std::make_unique_for_overwrite<uint8_t[]>(block->Capacity);
+			m_AllocatedBlockCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		block->Size = data.Size;
+		if (data.Size)
+			memcpy(block->Data.get(), data.Data, data.Size);
+
+		return SharedPacket(block);
+	}
+
+	void PacketPool::Release(SharedPacket::Block* block)
+	{
+		if (block->SizeClass == OversizedClass)
+		{
+			delete block;
+			return;
+		}
+
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		m_FreeBlocks[block->SizeClass].push_back(block);
+	}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Walnut/Core/Buffer.h"
+#include "Walnut/Serialization/BufferStream.h"
+
+namespace Cubed
+{
+	//
+	// PacketStreamWriter - Walnut stream over a growable byte arena.
+	// Storage doubles on demand up to MaxCapacity and is kept across Reset(), so once a
+	// writer has seen its largest packet it never allocates again. A write that would go
+	// past MaxCapacity is dropped and the stream turns bad; check it before sending.
+	//
+	class PacketStreamWriter : public Walnut::StreamWriter
+	{
+	public:
+		static constexpr uint64_t DefaultInitialCapacity = 4 * 1024;
+		static constexpr uint64_t DefaultMaxCapacity = 16 * 1024 * 1024;
+	public:
+		PacketStreamWriter(uint64_t initialCapacity = DefaultInitialCapacity, uint64_t maxCapacity = DefaultMaxCapacity);
+
+		PacketStreamWriter(const PacketStreamWriter&) = delete;
+		PacketStreamWriter& operator=(const PacketStreamWriter&) = delete;
+
+		bool IsStreamGood() const final { return !m_Overflowed; }
+		uint64_t GetStreamPosition() override { return m_Position; }
+		void SetStreamPosition(uint64_t position) override;
+		bool WriteData(const char* data, size_t size) final;
+
+		// Empties the stream (and clears overflow) without releasing storage
+		void Reset();
+
+		// View of everything written so far; invalidated by further writes
+		Walnut::Buffer GetBuffer() const { return Walnut::Buffer(m_Storage.get(), m_Position); }
+		uint64_t GetCapacity() const { return m_Capacity; }
+	private:
+		bool Reserve(uint64_t capacity);
+	private:
+		std::unique_ptr<uint8_t[]> m_Storage;
+		uint64_t m_Capacity = 0;
+		uint64_t m_MaxCapacity = 0;
+		uint64_t m_Position = 0;
+		bool m_Overflowed = false;
+	};
+
+	// Reset per-thread writer for building a packet. Each thread gets its own arena, so the
+	// network thread and the tick never share serialization memory. The returned writer is
+	// reused by the next call on the same thread; don't hold on to it across calls.
+	PacketStreamWriter& GetThreadPacketWriter();
+
+	class PacketPool;
+
+	//
+	// SharedPacket - reference-counted, immutable serialized packet.
+	// Serialize once, then hand the same bytes to as many clients as needed; copying the
+	// handle only bumps a counter. Storage comes from PacketPool and goes back to it when
+	// the last handle is released, from whichever thread that happens on.
+	//
+	class SharedPacket
+	{
+	public:
+		SharedPacket() = default;
+		SharedPacket(const SharedPacket& other);
+		SharedPacket(SharedPacket&& other) noexcept;
+		SharedPacket& operator=(SharedPacket other) noexcept;
+		~SharedPacket();
+
+		Walnut::Buffer GetBuffer() const;
+		operator bool() const { return m_Block != nullptr; }
+	private:
+		struct Block
+		{
+			std::atomic<uint32_t> RefCount = 0;
+			uint32_t SizeClass = 0;
+			uint64_t Size = 0;
+			uint64_t Capacity = 0;
+			std::unique_ptr<uint8_t[]> Data;
+		};
+
+		SharedPacket(Block* block);
+	private:
+		Block* m_Block = nullptr;
+
+		friend class PacketPool;
+	};
+
+	//
+	// PacketPool - recycles SharedPacket storage in power-of-two size classes.
+	// Packets larger than the biggest class are allocated and freed directly.
+	//
+	class PacketPool
+	{
+	public:
+		static constexpr uint32_t MinSizeClassBits = 8;  // 256 bytes
+		static constexpr uint32_t MaxSizeClassBits = 20; // 1 MB
+		static constexpr uint32_t SizeClassCount = MaxSizeClassBits - MinSizeClassBits + 1;
+		static constexpr uint32_t OversizedClass = SizeClassCount;
+	public:
+		static PacketPool& Get();
+
+		// Copies the serialized bytes into pooled storage
+		SharedPacket Create(Walnut::Buffer data);
+		SharedPacket Create(const PacketStreamWriter& stream) { return Create(stream.GetBuffer()); }
+
+		// Number of blocks ever allocated from the heap, for checking steady-state behaviour
+		uint64_t GetAllocatedBlockCount() const { return m_AllocatedBlockCount.load(std::memory_order_relaxed); }
+	private:
+		PacketPool() = default;
+		~PacketPool();
+
+		void Release(SharedPacket::Block* block);
+	private:
+		std::mutex m_Mutex;
+		std::array<std::vector<SharedPacket::Block*>, SizeClassCount> m_FreeBlocks;
+		std::atomic<uint64_t> m_AllocatedBlockCount = 0;
+
+		friend class SharedPacket;
+	};
+
+}
@@ -0,0 +1,55 @@
+#include "PacketFrame.h"
+
+namespace Cubed
+{
+	void FrameBuilder::Add(Walnut::Buffer message)
+	{
+		// Anything goes into an empty frame; past MaxFrameSize it just won't take another message.
+		// Nor once a shared packet was added after it, which has to go out in between.
+		Frame* frame = m_FrameCount ? m_Frames[m_FrameCount - 1].get() : nullptr;
+		bool afterShared = !m_SharedPackets.empty() && m_SharedPackets.back().FramePosition == m_FrameCount;
+		if (!frame || afterShared || frame->Stream.GetStreamPosition() + GetPacketSize<FrameMessageRecord>(message) > MaxFrameSize)
+			frame = &StartFrame();
+
+		WritePacket<FrameMessageRecord>(frame->Stream, message);
+		frame->MessageCount++;
+		m_MessageCount++;
+	}
+
+	void FrameBuilder::Add(SharedPacket message)
+	{
+		m_SharedPackets.push_back({ m_FrameCount, std::move(message) });
+		m_MessageCount++;
+	}
+
+	FrameBuilder::Frame& FrameBuilder::StartFrame()
+	{
+		if (m_FrameCount == m_Frames.size())
+			m_Frames.push_back(std::make_unique<Frame>());
+
+		Frame& frame = *m_Frames[m_FrameCount++];
+		frame.Stream.Reset();
+		frame.MessageCount = 0;
+
+		// The count isn't known until the frame is sent
+		WritePacket<FramePacket>(frame.Stream, 0u);
+		return frame;
+	}
+
+	void FrameBuilder::FinishFrame(Frame& frame)
+	{
+		uint64_t end = frame.Stream.GetStreamPosition();
+		frame.Stream.SetStreamPosition(0);
+		WritePacket<FramePacket>(frame.Stream, frame.MessageCount);
+		frame.Stream.SetStreamPosition(end);
+	}
+
+	Walnut::Buffer FrameBuilder::GetOnlyMessage(const Frame& frame) const
+	{
+		// Not read through a view: a message alone in its frame may be bigger than a frame may carry
+		constexpr size_t offset = FramePacket::MinSize + FrameMessageRecord::MinSize;
+		Walnut::Buffer buffer = frame.Stream.GetBuffer();
+		return Walnut::Buffer(buffer.As<uint8_t>() + offset, buffer.Size - offset);
+	}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Walnut/Core/Buffer.h"
+
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "ServerPacket.h"
+
+namespace Cubed
+{
+	//
+	// FrameBuilder - collects the messages for one connection over a tick, then hands them out
+	// as Frame packets (see PacketType::Frame), usually just one. Each transport send costs a
+	// syscall and per-message overhead however small the message, so a tick's snapshot, chunks,
+	// chat and roster changes share one. A message alone in its frame goes out as is.
+	// Not thread-safe; the server guards each client's builder with a lock.
+	//
+	class FrameBuilder
+	{
+	public:
+		// Copies the message, so the caller's buffer can be reused right away
+		void Add(Walnut::Buffer message);
+		// Keeps a reference instead of copying: the packet goes out on its own, straight from the
+		// shared buffer, between the frames holding what was added before and after it. For
+		// broadcasts, where a copy per recipient would undo serializing once.
+		void Add(SharedPacket message);
+
+		// Calls send(packet, messageCount) for every packet, in order, then starts over.
+		// Storage is kept, so a builder that has seen a busy tick doesn't allocate again.
+		template<typename Func>
+		void Flush(Func&& send)
+		{
+			uint32_t shared = 0;
+			for (uint32_t i = 0; i < m_FrameCount; i++)
+			{
+				for (; shared < m_SharedPackets.size() && m_SharedPackets[shared].FramePosition == i; shared++)
+					send(m_SharedPackets[shared].Packet.GetBuffer(), 1u);
+
+				Frame& frame = *m_Frames[i];
+				if (frame.MessageCount == 1)
+				{
+					send(GetOnlyMessage(frame), 1u);
+					continue;
+				}
+
+				FinishFrame(frame);
+				send(frame.Stream.GetBuffer(), frame.MessageCount);
+			}
+			for (; shared < m_SharedPackets.size(); shared++)
+				send(m_SharedPackets[shared].Packet.GetBuffer(), 1u);
+
+			// Back to the pool once every recipient has sent them
+			m_SharedPackets.clear();
+			m_FrameCount = 0;
+			m_MessageCount = 0;
+		}
+
+		uint32_t GetMessageCount() const { return m_MessageCount; }
+		bool IsEmpty() const { return m_MessageCount == 0; }
+	private:
+		struct Frame
+		{
+			PacketStreamWriter Stream;
+			uint32_t MessageCount = 0;
+		};
+
+		// Goes out just before the frame at FramePosition (or after the last one)
+		struct SharedMessage
+		{
+			uint32_t FramePosition;
+			SharedPacket Packet;
+		};
+
+		Frame& StartFrame();
+		// Writes the final message count into the frame's header
+		void FinishFrame(Frame& frame);
+		Walnut::Buffer GetOnlyMessage(const Frame& frame) const;
+	private:
+		std::vector<std::unique_ptr<Frame>> m_Frames;
+		uint32_t m_FrameCount = 0; // in use this tick
+		std::vector<SharedMessage> m_SharedPackets;
+		uint32_t m_MessageCount = 0;
+	};
+
+	// Calls func(message) for every message of a Frame, in order, reading them in place; any other
+	// packet is passed through as the only message. Returns false, without calling func at all, if
+	// the frame is malformed.
+	template<typename Func>
+	bool ForEachFrameMessage(Walnut::Buffer packet, Func&& func)
+	{
+		PacketType type = PacketType::None;
+		if (packet.Size >= sizeof(PacketType))
+			std::memcpy(&type, packet.Data, sizeof(type));
+
+		if (type != PacketType::Frame)
+		{
+			func(packet);
+			return true;
+		}
+
+		PacketView<FramePacket> frame(packet);
+		if (!frame)
+			return false;
+
+		// Checked whole first, so a malformed frame is dropped rather than half applied
+		uint32_t count = frame.Get<FramePacket::Count>();
+		RecordReader<FrameMessageRecord> validator(frame.Get<FramePacket::Messages>());
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (!validator.Next())
+				return false;
+		}
+		if (!validator.IsAtEnd())
+			return false;
+
+		RecordReader<FrameMessageRecord> reader(frame.Get<FramePacket::Messages>());
+		for (uint32_t i = 0; i < count; i++)
+			func(reader.Next().Get<FrameMessageRecord::Message>());
+		return true;
+	}
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "PacketSchema.h"
+#include "PlayerStore.h"
+#include "ServerPacket.h"
+
+namespace Cubed
+{
+	//
+	// Byte layouts of every packet the server and clients exchange, built with PacketSchema.h.
+	// What the fields mean is documented with each PacketType in ServerPacket.h. Bit-packed
+	// bodies (ClientUpdate, ChunkData, ChunkUnload) are a PayloadField here, read with BitReader.
+	//
+
+	// Strings over these limits make a packet malformed
+	static constexpr uint32_t MaxUsernameLength = 32;
+	// Longer messages are cut (at a UTF-8 character boundary) before they are stored or sent
+	static constexpr uint32_t MaxChatMessageLength = 256;
+	// What a client may send; anything longer than a chat message gets cut anyway, much longer isn't a chat client
+	static constexpr uint32_t MaxChatRequestLength = MaxChatMessageLength * 4;
+	// Messages are packed into a frame until it reaches this size; a bigger message goes out on its own
+	static constexpr uint32_t MaxFrameSize = 64 * 1024;
+
+	// -- Records, inside other packets' payloads --
+
+	// One message of a Message packet or a MessageHistory page
+	struct ChatMessageRecord : RecordLayout<uint64_t, StringField<MaxUsernameLength>, StringField<MaxChatMessageLength>>
+	{
+		enum : size_t { ID, Username, Text };
+	};
+
+	// One roster entry of a ClientList or a ClientConnect roster delta
+	struct RosterEntryRecord : RecordLayout<uint32_t, uint32_t, StringField<MaxUsernameLength>>
+	{
+		enum : size_t { ClientID, Color, Username };
+	};
+
+	// One message of a Frame
+	struct FrameMessageRecord : RecordLayout<BlobField<MaxFrameSize>>
+	{
+		enum : size_t { Message };
+	};
+
+	// The body of the ClientConnect sent to the connecting client itself
+	struct OwnPlayerRecord : RecordLayout<PlayerID>
+	{
+		enum : size_t { Player };
+	};
+
+	// -- Message --
+
+	struct ChatMessagePacket : PacketLayout<PacketType::Message, ChatMessageRecord> {};
+
+	struct ChatMessageRequest : PacketLayout<PacketType::Message, RecordLayout<StringField<MaxChatRequestLength>>>
+	{
+		enum : size_t { Text };
+	};
+
+	// -- ClientConnectionRequest --
+
+	struct ConnectionRequest : PacketLayout<PacketType::ClientConnectionRequest, RecordLayout<uint32_t, StringField<MaxUsernameLength>, uint32_t, uint32_t>>
+	{
+		enum : size_t { Color, Username, RosterEpoch, RosterVersion };
+	};
+
+	struct ConnectionResponse : PacketLayout<PacketType::ClientConnectionRequest, RecordLayout<bool, uint32_t>>
+	{
+		enum : size_t { Accepted, ClientID };
+	};
+
+	// -- ClientList --
+
+	// Entries: Count RosterEntryRecords
+	struct ClientListPacket : PacketLayout<PacketType::ClientList, RecordLayout<uint32_t, uint32_t, uint32_t, PayloadField>>
+	{
+		enum : size_t { RosterEpoch, RosterVersion, Count, Entries };
+	};
+
+	struct ClientListRequest : PacketLayout<PacketType::ClientList, RecordLayout<uint32_t, uint32_t>>
+	{
+		enum : size_t { RosterEpoch, RosterVersion };
+	};
+
+	// -- ClientConnect --
+
+	// Body: an OwnPlayerRecord when RosterVersion is 0, otherwise a RosterEntryRecord
+	struct ClientConnectPacket : PacketLayout<PacketType::ClientConnect, RecordLayout<uint32_t, PayloadField>>
+	{
+		enum : size_t { RosterVersion, Body };
+	};
+
+	// -- ClientUpdate --
+
+	// Bit-packed in both directions
+	struct ClientUpdatePacket : PacketLayout<PacketType::ClientUpdate, RecordLayout<PayloadField>>
+	{
+		enum : size_t { Body };
+	};
+
+	// -- ClientDisconnect --
+
+	struct ClientDisconnectPacket : PacketLayout<PacketType::ClientDisconnect, RecordLayout<uint32_t, uint32_t>>
+	{
+		enum : size_t { RosterVersion, ClientID };
+	};
+
+	// -- MessageHistory --
+
+	struct MessageHistoryRequest : PacketLayout<PacketType::MessageHistory, RecordLayout<uint64_t>>
+	{
+		enum : size_t { AfterID };
+	};
+
+	// Messages: Count ChatMessageRecords
+	struct MessageHistoryPacket : PacketLayout<PacketType::MessageHistory, RecordLayout<uint64_t, uint64_t, uint32_t, PayloadField>>
+	{
+		enum : size_t { OldestID, NewestID, Count, Messages };
+	};
+
+	// -- ChunkData / ChunkUnload --
+
+	// Body: bit-packed chunk coordinate and blocks
+	struct ChunkDataPacket : PacketLayout<PacketType::ChunkData, RecordLayout<uint32_t, PayloadField>>
+	{
+		enum : size_t { Sequence, Body };
+	};
+
+	struct ChunkUnloadPacket : PacketLayout<PacketType::ChunkUnload, RecordLayout<PayloadField>>
+	{
+		enum : size_t { Body };
+	};
+
+	// -- Frame --
+
+	// Messages: Count FrameMessageRecords
+	struct FramePacket : PacketLayout<PacketType::Frame, RecordLayout<uint32_t, PayloadField>>
+	{
+		enum : size_t { Count, Messages };
+	};
+
+}
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Walnut/Core/Buffer.h"
+#include "Walnut/Serialization/BufferStream.h"
+
+#include "ServerPacket.h"
+
+namespace Cubed
+{
+	//
+	// Packet layouts are declared once, as a list of field types (see PacketLayouts.h); the
+	// writer, the size calculation and the reader (PacketView) are all generated from that list.
+	//
+	// Field types:
+	// - any trivially copyable value, laid out as WriteRaw writes it
+	// - StringField<MaxLength>: a Walnut string (size_t length, then the bytes); longer is malformed
+	// - BlobField<MaxSize>: 32-bit byte count, then the bytes, e.g. a whole message inside a Frame
+	// - PayloadField: everything up to the end of the packet, e.g. a bit-packed body or a list of records
+	//
+
+	template<uint32_t MaxLength>
+	struct StringField {};
+
+	template<uint32_t MaxSize>
+	struct BlobField {};
+
+	struct PayloadField {};
+
+	// Returned by FieldTraits::Measure when a field doesn't fit in what's left of the buffer
+	static constexpr size_t InvalidFieldSize = SIZE_MAX;
+
+	template<typename T>
+	struct FieldTraits
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "fields are trivially copyable values, StringField or PayloadField");
+
+		using ValueType = T;
+		static constexpr bool IsFixedSize = true;
+		static constexpr size_t MinSize = sizeof(T);
+
+		static size_t Measure(const uint8_t*, size_t available) { return available >= sizeof(T) ? sizeof(T) : InvalidFieldSize; }
+		static size_t GetSize(const T&) { return sizeof(T); }
+		static void Write(Walnut::StreamWriter& stream, const T& value) { stream.WriteRaw<T>(value); }
+
+		static T Read(const uint8_t* data, size_t)
+		{
+			// Fields sit at arbitrary offsets, so never dereference them as T in place
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		}
+	};
+
+	// Any nonzero byte is true; copying a byte that isn't 0 or 1 into a bool is undefined
+	template<>
+	struct FieldTraits<bool>
+	{
+		using ValueType = bool;
+		static constexpr bool IsFixedSize = true;
+		static constexpr size_t MinSize = 1;
+
+		static size_t Measure(const uint8_t*, size_t available) { return available >= 1 ? 1 : InvalidFieldSize; }
+		static size_t GetSize(bool) { return 1; }
+		static void Write(Walnut::StreamWriter& stream, bool value) { stream.WriteRaw<uint8_t>(value ? 1 : 0); }
+		static bool Read(const uint8_t* data, size_t) { return *data != 0; }
+	};
+
+	template<uint32_t MaxLength>
+	struct FieldTraits<StringField<MaxLength>>
+	{
+		using ValueType = std::string_view;
+		static constexpr bool IsFixedSize = false;
+		static constexpr size_t MinSize = sizeof(size_t);
+
+		static size_t Measure(const uint8_t* data, size_t available)
+		{
+			if (available < sizeof(size_t))
+				return InvalidFieldSize;
+
+			size_t length;
+			std::memcpy(&length, data, sizeof(length));
+			if (length > MaxLength || length > available - sizeof(size_t))
+				return InvalidFieldSize;
+			return sizeof(size_t) + length;
+		}
+
+		static size_t GetSize(std::string_view value) { return sizeof(size_t) + value.size(); }
+
+		// Same bytes as WriteString, without needing a std::string
+		static void Write(Walnut::StreamWriter& stream, std::string_view value)
+		{
+			stream.WriteRaw<size_t>(value.size());
+			stream.WriteData(value.data(), value.size());
+		}
+
+		static std::string_view Read(const uint8_t* data, size_t size) { return std::string_view((const char*)data + sizeof(size_t), size - sizeof(size_t)); }
+	};
+
+	template<uint32_t MaxSize>
+	struct FieldTraits<BlobField<MaxSize>>
+	{
+		using ValueType = Walnut::Buffer;
+		static constexpr bool IsFixedSize = false;
+		static constexpr size_t MinSize = sizeof(uint32_t);
+
+		static size_t Measure(const uint8_t* data, size_t available)
+		{
+			if (available < sizeof(uint32_t))
+				return InvalidFieldSize;
+
+			uint32_t size;
+			std::memcpy(&size, data, sizeof(size));
+			if (size > MaxSize || size > available - sizeof(uint32_t))
+				return InvalidFieldSize;
+			return sizeof(uint32_t) + size;
+		}
+
+		static size_t GetSize(const Walnut::Buffer& value) { return sizeof(uint32_t) + value.Size; }
+
+		static void Write(Walnut::StreamWriter& stream, const Walnut::Buffer& value)
+		{
+			stream.WriteRaw<uint32_t>((uint32_t)value.Size);
+			stream.WriteData((const char*)value.Data, value.Size);
+		}
+
+		static Walnut::Buffer Read(const uint8_t* data, size_t size) { return Walnut::Buffer(data + sizeof(uint32_t), size - sizeof(uint32_t)); }
+	};
+
+	template<>
+	struct FieldTraits<PayloadField>
+	{
+		using ValueType = Walnut::Buffer;
+		static constexpr bool IsFixedSize = false;
+		static constexpr size_t MinSize = 0;
+
+		static size_t Measure(const uint8_t*, size_t available) { return available; }
+		static size_t GetSize(const Walnut::Buffer& value) { return value.Size; }
+		static void Write(Walnut::StreamWriter& stream, const Walnut::Buffer& value) { stream.WriteData((const char*)value.Data, value.Size); }
+		static Walnut::Buffer Read(const uint8_t* data, size_t size) { return Walnut::Buffer(data, size); }
+	};
+
+	template<typename... Fields>
+	constexpr bool IsPayloadLast()
+	{
+		constexpr bool isPayload[] = { false, std::is_same_v<Fields, PayloadField>... };
+		for (size_t i = 1; i < sizeof...(Fields); i++)
+		{
+			if (isPayload[i])
+				return false;
+		}
+		return true;
+	}
+
+	//
+	// RecordLayout - fields in order, with nothing in front. Used for records inside another
+	// packet's payload (e.g. one roster entry of a ClientList) and as the body of a PacketLayout.
+	// Derived layouts name their fields with an enum, in the same order.
+	//
+	template<typename... Fields>
+	struct RecordLayout
+	{
+		static_assert(IsPayloadLast<Fields...>(), "a PayloadField can only be the last field");
+
+		using FieldTypes = std::tuple<Fields...>;
+		static constexpr size_t FieldCount = sizeof...(Fields);
+		static constexpr bool HasPacketType = false;
+		static constexpr bool HasPayload = (std::is_same_v<Fields, PayloadField> || ... || false);
+		static constexpr bool IsFixedSize = (FieldTraits<Fields>::IsFixedSize && ... && true);
+
+		static constexpr size_t HeaderSize = 0;
+		static constexpr std::array<size_t, sizeof...(Fields)> FieldMinSizes = { FieldTraits<Fields>::MinSize... };
+		// Smallest valid encoding; the only one for fixed-size layouts
+		static constexpr size_t MinSize = (FieldTraits<Fields>::MinSize + ... + 0);
+	};
+
+	//
+	// PacketLayout - a record with the PacketType in front; the layout of a whole packet
+	//
+	template<PacketType TypeValue, typename Record = RecordLayout<>>
+	struct PacketLayout : Record
+	{
+		static constexpr PacketType Type = TypeValue;
+		static constexpr bool HasPacketType = true;
+
+		static constexpr size_t HeaderSize = sizeof(PacketType);
+		static constexpr size_t MinSize = HeaderSize + Record::MinSize;
+	};
+
+	template<typename Layout, size_t Index>
+	using LayoutField = std::tuple_element_t<Index, typename Layout::FieldTypes>;
+
+	// Where each field of a fixed-size layout starts, and (last) where the layout ends
+	template<typename Layout>
+	constexpr std::array<size_t, Layout::FieldCount + 1> ComputeFixedFieldOffsets()
+	{
+		std::array<size_t, Layout::FieldCount + 1> offsets{};
+		offsets[0] = Layout::HeaderSize;
+		for (size_t i = 0; i < Layout::FieldCount; i++)
+			offsets[i + 1] = offsets[i] + Layout::FieldMinSizes[i];
+		return offsets;
+	}
+
+	template<typename Layout>
+	inline constexpr std::array<size_t, Layout::FieldCount + 1> FixedFieldOffsets = ComputeFixedFieldOffsets<Layout>();
+
+	//
+	// PacketView - the fields of a received packet (or a record inside one), read in place from
+	// its buffer. The constructor validates the whole layout once: the packet type, every field
+	// in bounds, every string within its limit, and nothing left over unless the layout ends in a
+	// payload. After that Get() is a copy from a known offset with no checks of its own. For
+	// fixed-size layouts the offsets are compile-time constants and validation is a size compare.
+	//
+	// The view doesn't own the bytes; the buffer must outlive it. Only call Get() on a valid view.
+	//
+	template<typename Layout>
+	class PacketView
+	{
+	public:
+		static constexpr size_t FieldCount = Layout::FieldCount;
+	public:
+		PacketView() = default;
+
+		// The whole buffer has to be exactly one packet (or record) of this layout
+		explicit PacketView(Walnut::Buffer buffer)
+		{
+			Validate((const uint8_t*)buffer.Data, buffer.Size, true);
+		}
+
+		// A record at the start of the buffer; GetSize() says where the next one begins
+		static PacketView AtStart(Walnut::Buffer buffer)
+		{
+			PacketView view;
+			view.Validate((const uint8_t*)buffer.Data, buffer.Size, false);
+			return view;
+		}
+
+		bool IsValid() const { return m_Data != nullptr; }
+		explicit operator bool() const { return IsValid(); }
+
+		template<size_t Index>
+		typename FieldTraits<LayoutField<Layout, Index>>::ValueType Get() const
+		{
+			size_t offset = GetOffset<Index>();
+			return FieldTraits<LayoutField<Layout, Index>>::Read(m_Data + offset, GetOffset<Index + 1>() - offset);
+		}
+
+		// Bytes the view covers, PacketType included
+		size_t GetSize() const { return GetOffset<FieldCount>(); }
+	private:
+		template<size_t Index>
+		size_t GetOffset() const
+		{
+			if constexpr (Layout::IsFixedSize)
+				return FixedFieldOffsets<Layout>[Index];
+			else
+				return m_Offsets[Index];
+		}
+
+		void Validate(const uint8_t* data, size_t size, bool wholeBuffer)
+		{
+			if (!data || size < Layout::MinSize)
+				return;
+
+			if constexpr (Layout::HasPacketType)
+			{
+				PacketType type;
+				std::memcpy(&type, data, sizeof(type));
+				if (type != Layout::Type)
+					return;
+			}
+
+			if constexpr (Layout::IsFixedSize)
+			{
+				if (wholeBuffer && size != Layout::MinSize)
+					return;
+			}
+			else
+			{
+				size_t offset = Layout::HeaderSize;
+				if (!MeasureFields(data, size, offset, std::make_index_sequence<FieldCount>{}))
+					return;
+
+				m_Offsets[FieldCount] = offset;
+				if (wholeBuffer && offset != size)
+					return;
+			}
+
+			m_Data = data;
+		}
+
+		template<size_t... Indices>
+		bool MeasureFields(const uint8_t* data, size_t size, size_t& offset, std::index_sequence<Indices...>)
+		{
+			// Stops at the first field that doesn't fit
+			return (MeasureField<Indices>(data, size, offset) && ...);
+		}
+
+		template<size_t Index>
+		bool MeasureField(const uint8_t* data, size_t size, size_t& offset)
+		{
+			m_Offsets[Index] = offset;
+			size_t fieldSize = FieldTraits<LayoutField<Layout, Index>>::Measure(data + offset, size - offset);
+			if (fieldSize == InvalidFieldSize)
+				return false;
+
+			offset += fieldSize;
+			return true;
+		}
+	private:
+		struct NoOffsets {};
+		using Offsets = std::conditional_t<Layout::IsFixedSize, NoOffsets, std::array<size_t, FieldCount + 1>>;
+
+		const uint8_t* m_Data = nullptr;
+		[[no_unique_address]] Offsets m_Offsets{};
+	};
+
+	//
+	// RecordReader - walks back-to-back records of one layout, e.g. the entries of a list
+	// payload, validating each as it goes
+	//
+	template<typename Layout>
+	class RecordReader
+	{
+	public:
+		explicit RecordReader(Walnut::Buffer buffer)
+			: m_Data((const uint8_t*)buffer.Data), m_Remaining(buffer.Size)
+		{
+		}
+
+		// The next record, or an invalid view (from then on) if what's left isn't one
+		PacketView<Layout> Next()
+		{
+			PacketView<Layout> record = PacketView<Layout>::AtStart(Walnut::Buffer(m_Data, m_Remaining));
+			size_t size = record ? record.GetSize() : m_Remaining;
+			m_Data += size;
+			m_Remaining -= size;
+			return record;
+		}
+
+		bool IsAtEnd() const { return m_Remaining == 0; }
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Remaining = 0;
+	};
+
+	template<typename Layout, size_t... Indices, typename... Values>
+	void WriteFields(Walnut::StreamWriter& stream, std::index_sequence<Indices...>, const Values&... values)
+	{
+		(FieldTraits<LayoutField<Layout, Indices>>::Write(stream, values), ...);
+	}
+
+	template<typename Layout, size_t... Indices, typename... Values>
+	size_t GetFieldsSize(std::index_sequence<Indices...>, const Values&... values)
+	{
+		return (FieldTraits<LayoutField<Layout, Indices>>::GetSize(values) + ... + 0);
+	}
+
+	// Writes a packet (PacketType first) or a record of this layout. A layout ending in a
+	// payload can leave it out, for the caller to write right after (e.g. a list of records).
+	template<typename Layout, typename... Values>
+	void WritePacket(Walnut::StreamWriter& stream, const Values&... values)
+	{
+		static_assert(sizeof...(Values) == Layout::FieldCount || (Layout::HasPayload && sizeof...(Values) == Layout::FieldCount - 1),
+			"one value per field, optionally without the payload");
+
+		if constexpr (Layout::HasPacketType)
+			stream.WriteRaw<PacketType>(Layout::Type);
+		WriteFields<Layout>(stream, std::index_sequence_for<Values...>{}, values...);
+	}
+
+	// Bytes WritePacket writes for the same values; Layout::MinSize for fixed-size layouts
+	template<typename Layout, typename... Values>
+	size_t GetPacketSize(const Values&... values)
+	{
+		return Layout::HeaderSize + GetFieldsSize<Layout>(std::index_sequence_for<Values...>{}, values...);
+	}
+
+}
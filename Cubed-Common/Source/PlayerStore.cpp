@@ -0,0 +1,155 @@
+#include "PlayerStore.h"
+
+namespace Cubed
+{
+	static uint32_t NextGeneration(uint32_t generation)
+	{
+		// Skip 0 on wrap-around so InvalidPlayerID is never handed out
+		generation = (generation + 1) & PlayerGenerationMask;
+		return generation ? generation : 1;
+	}
+
+	PlayerID PlayerStore::Create()
+	{
+		uint32_t slotIndex;
+		if (!m_FreeSlots.empty())
+		{
+			slotIndex = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			if (m_Slots.size() >= MaxPlayerSlots)
+				return InvalidPlayerID;
+
+			slotIndex = (uint32_t)m_Slots.size();
+			m_Slots.emplace_back();
+		}
+
+		Slot& slot = m_Slots[slotIndex];
+		slot.Generation = NextGeneration(slot.Generation);
+
+		PlayerID id = MakePlayerID(slotIndex, slot.Generation);
+		Occupy(slotIndex, id);
+		return id;
+	}
+
+	bool PlayerStore::Insert(PlayerID id)
+	{
+		if (id == InvalidPlayerID)
+			return false;
+
+		// Slots are dictated by the IDs we're given, so there's no free list to maintain
+		m_MirrorsExternalIDs = true;
+
+		uint32_t slotIndex = GetPlayerIndex(id);
+		if (slotIndex >= m_Slots.size())
+			m_Slots.resize(slotIndex + 1);
+
+		Slot& slot = m_Slots[slotIndex];
+		if (slot.DenseIndex != InvalidIndex)
+		{
+			if (slot.Generation == GetPlayerGeneration(id))
+				return true;
+
+			Remove(MakePlayerID(slotIndex, slot.Generation));
+		}
+
+		slot.Generation = GetPlayerGeneration(id);
+		Occupy(slotIndex, id);
+		return true;
+	}
+
+	bool PlayerStore::Remove(PlayerID id)
+	{
+		uint32_t denseIndex = GetDenseIndex(id);
+		if (denseIndex == InvalidIndex)
+			return false;
+
+		uint32_t lastIndex = (uint32_t)m_IDs.size() - 1;
+		if (denseIndex != lastIndex)
+		{
+			m_IDs[denseIndex] = m_IDs[lastIndex];
+			m_Positions[denseIndex] = m_Positions[lastIndex];
+			m_Velocities[denseIndex] = m_Velocities[lastIndex];
+			m_InputDirections[denseIndex] = m_InputDirections[lastIndex];
+			m_Slots[GetPlayerIndex(m_IDs[denseIndex])].DenseIndex = denseIndex;
+		}
+
+		m_IDs.pop_back();
+		m_Positions.pop_back();
+		m_Velocities.pop_back();
+		m_InputDirections.pop_back();
+
+		ReleaseSlot(GetPlayerIndex(id));
+		return true;
+	}
+
+	void PlayerStore::Clear()
+	{
+		for (PlayerID id : m_IDs)
+			ReleaseSlot(GetPlayerIndex(id));
+
+		m_IDs.clear();
+		m_Positions.clear();
+		m_Velocities.clear();
+		m_InputDirections.clear();
+	}
+
+	uint32_t PlayerStore::GetDenseIndex(PlayerID id) const
+	{
+		uint32_t slotIndex = GetPlayerIndex(id);
+		if (id == InvalidPlayerID || slotIndex >= m_Slots.size())
+			return InvalidIndex;
+
+		const Slot& slot = m_Slots[slotIndex];
+		if (slot.Generation != GetPlayerGeneration(id))
+			return InvalidIndex;
+
+		return slot.DenseIndex;
+	}
+
+	PlayerData PlayerStore::Get(PlayerID id) const
+	{
+		uint32_t denseIndex = GetDenseIndex(id);
+		if (denseIndex == InvalidIndex)
+			return PlayerData();
+
+		return { m_Positions[denseIndex], m_Velocities[denseIndex] };
+	}
+
+	void PlayerStore::Set(PlayerID id, const PlayerData& playerData)
+	{
+		uint32_t denseIndex = GetDenseIndex(id);
+		if (denseIndex == InvalidIndex)
+			return;
+
+		m_Positions[denseIndex] = playerData.Position;
+		m_Velocities[denseIndex] = playerData.Velocity;
+	}
+
+	void PlayerStore::Reserve(uint32_t capacity)
+	{
+		m_IDs.reserve(capacity);
+		m_Positions.reserve(capacity);
+		m_Velocities.reserve(capacity);
+		m_InputDirections.reserve(capacity);
+	}
+
+	void PlayerStore::Occupy(uint32_t slotIndex, PlayerID id)
+	{
+		m_Slots[slotIndex].DenseIndex = (uint32_t)m_IDs.size();
+		m_IDs.push_back(id);
+		m_Positions.emplace_back(0.0f, 0.0f);
+		m_Velocities.emplace_back(0.0f, 0.0f);
+		m_InputDirections.emplace_back(0.0f, 0.0f);
+	}
+
+	void PlayerStore::ReleaseSlot(uint32_t slotIndex)
+	{
+		m_Slots[slotIndex].DenseIndex = InvalidIndex;
+		if (!m_MirrorsExternalIDs)
+			m_FreeSlots.push_back(slotIndex);
+	}
+
+}
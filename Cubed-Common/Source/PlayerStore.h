@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Snapshot.h"
+
+namespace Cubed
+{
+	//
+	// PlayerID - generational handle: slot index in the high 20 bits, generation in the low 12.
+	// Generations start at 1, so 0 is never a valid ID. Sorting IDs sorts by slot index.
+	//
+	using PlayerID = uint32_t;
+
+	static constexpr PlayerID InvalidPlayerID = 0;
+	static constexpr uint32_t PlayerGenerationBits = 12;
+	static constexpr uint32_t PlayerGenerationMask = (1u << PlayerGenerationBits) - 1;
+	static constexpr uint32_t MaxPlayerSlots = 1u << (32 - PlayerGenerationBits);
+
+	constexpr PlayerID MakePlayerID(uint32_t index, uint32_t generation) { return (index << PlayerGenerationBits) | (generation & PlayerGenerationMask); }
+	constexpr uint32_t GetPlayerIndex(PlayerID id) { return id >> PlayerGenerationBits; }
+	constexpr uint32_t GetPlayerGeneration(PlayerID id) { return id & PlayerGenerationMask; }
+
+	//
+	// PlayerStore - generational slot map over densely packed player state.
+	// Positions, velocities and inputs live in separate contiguous arrays (structure of arrays);
+	// removal swaps the last element into the hole, so the dense range never has gaps.
+	// Dense order is arbitrary and changes on removal.
+	//
+	class PlayerStore
+	{
+	public:
+		static constexpr uint32_t InvalidIndex = 0xffffffff;
+	public:
+		// Allocates a new ID (server side)
+		PlayerID Create();
+		// Mirrors an ID allocated elsewhere (client side); replaces a stale generation in the same slot.
+		// Don't mix with Create() on the same store.
+		bool Insert(PlayerID id);
+		bool Remove(PlayerID id);
+		void Clear();
+
+		bool Contains(PlayerID id) const { return GetDenseIndex(id) != InvalidIndex; }
+		uint32_t GetDenseIndex(PlayerID id) const;
+
+		PlayerData Get(PlayerID id) const;
+		void Set(PlayerID id, const PlayerData& playerData);
+
+		void Reserve(uint32_t capacity);
+		uint32_t GetCount() const { return (uint32_t)m_IDs.size(); }
+
+		// Dense arrays, all GetCount() long and indexed alike
+		const std::vector<PlayerID>& GetIDs() const { return m_IDs; }
+		std::vector<glm::vec2>& GetPositions() { return m_Positions; }
+		const std::vector<glm::vec2>& GetPositions() const { return m_Positions; }
+		std::vector<glm::vec2>& GetVelocities() { return m_Velocities; }
+		const std::vector<glm::vec2>& GetVelocities() const { return m_Velocities; }
+		// Latest movement input direction (see Movement.h); only meaningful on the server
+		std::vector<glm::vec2>& GetInputDirections() { return m_InputDirections; }
+		const std::vector<glm::vec2>& GetInputDirections() const { return m_InputDirections; }
+	private:
+		void Occupy(uint32_t slotIndex, PlayerID id);
+		void ReleaseSlot(uint32_t slotIndex);
+	private:
+		struct Slot
+		{
+			uint32_t DenseIndex = InvalidIndex;
+			uint32_t Generation = 0;
+		};
+
+		std::vector<Slot> m_Slots;
+		std::vector<uint32_t> m_FreeSlots;
+		bool m_MirrorsExternalIDs = false;
+
+		std::vector<PlayerID> m_IDs;
+		std::vector<glm::vec2> m_Positions;
+		std::vector<glm::vec2> m_Velocities;
+		std::vector<glm::vec2> m_InputDirections;
+	};
+
+}
@@ -16,6 +16,9 @@ std::string_view PacketTypeToString(PacketType type)
 		case PacketType::MessageHistory:           return "PacketType::MessageHistory";
 		case PacketType::ServerShutdown:           return "PacketType::ServerShutdown";
 		case PacketType::ClientKick:               return "PacketType::ClientKick";
+		case PacketType::ChunkData:                return "PacketType::ChunkData";
+		case PacketType::ChunkUnload:              return "PacketType::ChunkUnload";
+		case PacketType::Frame:                    return "PacketType::Frame";
 
 		default: return "PacketType::<Invalid>";
 	}
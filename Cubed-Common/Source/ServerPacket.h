@@ -7,6 +7,10 @@
 // Common "protocol" for server<->client communication for this example chat application //
 ///////////////////////////////////////////////////////////////////////////////////////////
 
+// The byte layouts below are declared for the compiler in PacketLayouts.h; every packet is
+// read through a PacketView that checks its size and string lengths once, before any field is read.
+// A packet that doesn't match its layout exactly is dropped.
+
 enum class PacketType : uint16_t
 {
 	//
@@ -18,20 +22,26 @@ enum class PacketType : uint16_t
 	// -- Message --
 	// 
 	// [Server->Client]
-	// 1. Username - UTF-8 serialized as per Hazel
-	// 2. Message - UTF-8 string serialized as per Hazel
+	// A new chat message, serialized once and sent to every client (see ChatHistory.h)
+	// 1. 64-bit message ID, one more than the previous message's
+	// 2. Username - UTF-8 serialized as per Hazel
+	// 3. Message - UTF-8 string serialized as per Hazel
 	// [Client->Server]
-	// 1. Message - buffer of UTF-8 chars
+	// 1. Message - UTF-8 string serialized as per Hazel, at most MaxChatRequestLength bytes; cut to MaxChatMessageLength by the server
 	Message = 1,
 
 	// 
 	// -- ClientConnectionRequest --
 	// 
+	// Joins the roster (see ClientRoster.h); sent once the client has received its own ClientConnect
 	// [Client->Server]
 	// 1. 32-bit int with requested user color (RGB, most significant 8 bits ignored)
-	// 2. Hazel serialized UTF-8 string with requested username
+	// 2. Hazel serialized UTF-8 string with requested username (unique ignoring ASCII case, at most MaxUsernameLength bytes)
+	// 3. 32-bit roster epoch and 32-bit roster version the client holds from an earlier session (0, 0 = none)
 	// [Server->Client]
-	// boolean response indicating acceptance of requested username
+	// 1. boolean response indicating acceptance of requested username
+	// 2. 32-bit client ID of this client's roster entry (0 if not accepted)
+	// Followed, if accepted, by what brings the client's roster up to date: the deltas it missed or a ClientList
 	ClientConnectionRequest = 2,
 	
 	// 
@@ -44,38 +54,63 @@ enum class PacketType : uint16_t
 	// 
 	// -- ClientList --
 	// 
+	// Only sent to clients whose roster is stale: on joining, unless the deltas it missed are fewer
+	// and still kept, and when asked for. Everyone else stays current through ClientConnect/ClientDisconnect.
 	// [Server->Client]
-	// Contains serialized std::vector (as per Hazel serialization) of ClientInfo structs (color + username)
-	// This is received by client on connection, and at a set interval (10s default)
+	// 1. 32-bit roster epoch (changes when the server restarts)
+	// 2. 32-bit roster version
+	// 3. 32-bit count, then that many roster entries: 32-bit client ID, 32-bit color, username
+	// [Client->Server]
+	// Sent when a delta skipped a version; answered like the roster part of ClientConnectionRequest
+	// 1. 32-bit roster epoch and 32-bit roster version the client holds
 	ClientList = 4,
 
 	// 
 	// -- ClientConnect --
 	// 
+	// 1. 32-bit roster version, 0 for the packet sent to the connecting client itself
 	// [Server->Client]
-	// Indicates connection of new other client
-	// 1. Requested user color (32-bit int RGB, most significant 8 bits ignored)
-	// 2. Requested username (Hazel serialized UTF-8 string)
+	// Sent to the connecting client itself
+	// 2. 32-bit PlayerID assigned to this client (see PlayerStore.h)
+	// [Server->Client]
+	// Roster delta: another client joined; applies to roster version - 1
+	// 2. 32-bit client ID
+	// 3. Requested user color (32-bit int RGB, most significant 8 bits ignored)
+	// 4. Requested username (Hazel serialized UTF-8 string)
 	ClientConnect = 5,
 
 	// 
 	// -- ClientUpdate --
 	// 
+	// Everything after the PacketType is bit-packed (see BitStream.h); player state uses
+	// PlayerPositionQuantization/PlayerVelocityQuantization from Snapshot.h
 	// [Server->Client]
-	// 1. Existing username (Hazel serialized UTF-8 string)
-	// 2. New color for user (32-bit int, RGB)
-	// 3. New username (Hazel serialized UTF-8 string)
+	// Snapshot of the players within the client's interest radius, delta-compressed
+	// against the last snapshot the client acknowledged
+	// Snapshots go out every SnapshotInterval ticks, not necessarily every tick
+	// 1. 32-bit snapshot tick
+	// 2. VarUInt server tick rate (Hz), VarUInt ticks between snapshots
+	// 3. 1-bit has-input flag, followed by the 32-bit sequence of the latest input from this client
+	//    applied by this tick if set (lets the client reconcile its prediction)
+	// 4. 1-bit has-baseline flag, followed by the 32-bit baseline tick if set (unset = full snapshot)
+	// IDs are PlayerIDs in ascending order, each written as VarUInt slot index delta + VarUInt generation
+	// 5. Spawns: VarUInt count, IDs, then per ID the player state
+	// 6. Updates: same layout as spawns, for players whose state changed
+	// 7. Despawns: VarUInt count, IDs of players that left the area or disconnected
 	// [Client->Server]
-	// 1. Requested new color (32-bit int, RGB)
-	// 2. Requested new username (Hazel serialized UTF-8 string)
+	// 1. Movement input (see Movement.h): 2-bit X and Y axis (0 = -1, 1 = none, 2 = +1), 32-bit input sequence
+	//    The server simulates movement itself; clients never send positions
+	// 2. 32-bit tick of the latest snapshot received (0xffffffff = none)
+	// 3. 32-bit sequence of the latest ChunkData received (0 = none)
 	ClientUpdate = 6,
 
 	// 
 	// -- ClientDisconnect --
 	// 
 	// [Server->Client]
-	// Indicates disconnection of existing other client
-	// 1. Hazel serialized UTF-8 string with username
+	// Roster delta: a client that joined the roster disconnected
+	// 1. 32-bit roster version; applies to version - 1
+	// 2. 32-bit client ID
 	// [Client->Server]
 	// Disconnection request from client
 	// 1. [No data]
@@ -92,9 +127,13 @@ enum class PacketType : uint16_t
 	// 
 	// -- MessageHistory --
 	// 
+	// Chat history is synced a page at a time; the server only keeps the latest ChatHistory::DefaultCapacity messages
+	// [Client->Server]
+	// 1. 64-bit ID of the newest message the client has without gaps (0 = none, asks for the latest page)
 	// [Server->Client]
-	// Server chat history - big boi
-	// 1. A vector of ChatMessage in order of send time
+	// 1. 64-bit ID of the oldest message the server still has (0 = none); anything older is gone
+	// 2. 64-bit ID of the newest message; the client asks for the next page until it has caught up
+	// 3. 32-bit count, then that many messages in ID order, each laid out like Message
 	MessageHistory = 9,
 
 	// 
@@ -112,6 +151,37 @@ enum class PacketType : uint16_t
 	// User has been kicked from server
 	// 1. String reason, could be empty string
 	ClientKick = 11,
+
+	// 
+	// -- ChunkData --
+	// 
+	// [Server->Client]
+	// One chunk near the player (see ChunkStreamer.h). Sent once per chunk until it is unloaded again;
+	// clients acknowledge the sequence in ClientUpdate
+	// 1. 32-bit chunk sequence, one more than the previous ChunkData to this client
+	// Everything after is bit-packed (see Chunk.h)
+	// 2. Chunk coordinate
+	// 3. Chunk blocks: palette, then run-length encoded palette indices
+	ChunkData = 12,
+
+	// 
+	// -- ChunkUnload --
+	// 
+	// [Server->Client]
+	// Chunks that went out of view; the server sends them again if they come back into view
+	// Bit-packed (see Chunk.h)
+	// 1. VarUInt count, then that many chunk coordinates
+	ChunkUnload = 13,
+
+	// 
+	// -- Frame --
+	// 
+	// [Server->Client]
+	// Everything the server had for this client at the end of a tick, in the order it was sent (see PacketFrame.h).
+	// Frames stop growing at MaxFrameSize; a message that is alone in its frame goes out as is.
+	// 1. 32-bit message count
+	// 2. That many messages, each a 32-bit byte count followed by the message (PacketType first, never a Frame)
+	Frame = 14,
 };
 
 std::string_view PacketTypeToString(PacketType type);
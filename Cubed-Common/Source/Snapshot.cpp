@@ -0,0 +1,197 @@
+#include "Snapshot.h"
+#include "PlayerStore.h"
+
+#include <vector>
+
+namespace Cubed
+{
+	// Round-trip error of a quantization range must stay within half a step
+	// over its whole representable span (checked at compile time)
+	static constexpr bool VerifyQuantizationBounds(const QuantizationRange& range)
+	{
+		constexpr uint32_t samples = 4096;
+		float span = range.Max - range.GetStep() - range.Min;
+		for (uint32_t i = 0; i <= samples; i++)
+		{
+			float value = range.Min + span * ((float)i / (float)samples);
+			float error = range.RoundTrip(value) - value;
+			if (error < 0.0f)
+				error = -error;
+			if (error > range.GetMaxError())
+				return false;
+		}
+
+		// Rest must stay at rest
+		if (range.Min < 0.0f && range.Max > 0.0f && range.RoundTrip(0.0f) != 0.0f)
+			return false;
+
+		return true;
+	}
+
+	static_assert(VerifyQuantizationBounds(PlayerPositionQuantization));
+	static_assert(VerifyQuantizationBounds(PlayerVelocityQuantization));
+
+	PlayerData QuantizePlayerData(const PlayerData& playerData)
+	{
+		PlayerData result;
+		result.Position = { PlayerPositionQuantization.RoundTrip(playerData.Position.x), PlayerPositionQuantization.RoundTrip(playerData.Position.y) };
+		result.Velocity = { PlayerVelocityQuantization.RoundTrip(playerData.Velocity.x), PlayerVelocityQuantization.RoundTrip(playerData.Velocity.y) };
+		return result;
+	}
+
+	void WritePlayerData(BitWriter& writer, const PlayerData& playerData)
+	{
+		writer.WriteQuantized(playerData.Position, PlayerPositionQuantization);
+
+		// Most players are standing still, so a resting velocity costs a single bit
+		bool moving = PlayerVelocityQuantization.RoundTrip(playerData.Velocity.x) != 0.0f || PlayerVelocityQuantization.RoundTrip(playerData.Velocity.y) != 0.0f;
+		writer.WriteBool(moving);
+		if (moving)
+			writer.WriteQuantized(playerData.Velocity, PlayerVelocityQuantization);
+	}
+
+	PlayerData ReadPlayerData(BitReader& reader)
+	{
+		PlayerData playerData;
+		playerData.Position = reader.ReadQuantizedVec2(PlayerPositionQuantization);
+		if (reader.ReadBool())
+			playerData.Velocity = reader.ReadQuantizedVec2(PlayerVelocityQuantization);
+		return playerData;
+	}
+
+	void SnapshotHistory::Push(std::shared_ptr<const WorldSnapshot> snapshot)
+	{
+		m_Snapshots[snapshot->Tick % Capacity] = std::move(snapshot);
+	}
+
+	const WorldSnapshot* SnapshotHistory::Find(uint32_t tick) const
+	{
+		if (tick == InvalidSnapshotTick)
+			return nullptr;
+
+		const auto& snapshot = m_Snapshots[tick % Capacity];
+		if (!snapshot || snapshot->Tick != tick)
+			return nullptr;
+
+		return snapshot.get();
+	}
+
+	void SnapshotHistory::Clear()
+	{
+		for (auto& snapshot : m_Snapshots)
+			snapshot.reset();
+	}
+
+	// IDs come sorted by slot index, so the index is written as a delta from the previous one
+	// and the generation (usually small) on its own, which keeps both short
+	static void WriteIDs(BitWriter& writer, const std::vector<PlayerID>& ids)
+	{
+		writer.WriteVarUInt((uint32_t)ids.size());
+		uint32_t previousIndex = 0;
+		for (PlayerID id : ids)
+		{
+			writer.WriteVarUInt(GetPlayerIndex(id) - previousIndex);
+			writer.WriteVarUInt(GetPlayerGeneration(id));
+			previousIndex = GetPlayerIndex(id);
+		}
+	}
+
+	void WriteSnapshotDelta(BitWriter& writer, const WorldSnapshot* baseline, const WorldSnapshot& snapshot)
+	{
+		writer.WriteBits(snapshot.Tick, 32);
+		writer.WriteVarUInt(snapshot.TickRate);
+		writer.WriteVarUInt(snapshot.SnapshotInterval);
+		writer.WriteBool(snapshot.HasLastInputSequence);
+		if (snapshot.HasLastInputSequence)
+			writer.WriteBits(snapshot.LastInputSequence, 32);
+		writer.WriteBool(baseline != nullptr);
+		if (baseline)
+			writer.WriteBits(baseline->Tick, 32);
+
+		static thread_local std::vector<PlayerID> s_SpawnedIDs, s_UpdatedIDs, s_DespawnedIDs;
+		s_SpawnedIDs.clear();
+		s_UpdatedIDs.clear();
+		s_DespawnedIDs.clear();
+
+		for (const auto& [id, playerData] : snapshot.Players)
+		{
+			if (!baseline)
+			{
+				s_SpawnedIDs.push_back(id);
+				continue;
+			}
+
+			auto it = baseline->Players.find(id);
+			if (it == baseline->Players.end())
+				s_SpawnedIDs.push_back(id);
+			else if (it->second != playerData)
+				s_UpdatedIDs.push_back(id);
+		}
+
+		if (baseline)
+		{
+			for (const auto& [id, playerData] : baseline->Players)
+			{
+				if (!snapshot.Players.contains(id))
+					s_DespawnedIDs.push_back(id);
+			}
+		}
+
+		WriteIDs(writer, s_SpawnedIDs);
+		for (PlayerID id : s_SpawnedIDs)
+			WritePlayerData(writer, snapshot.Players.at(id));
+
+		WriteIDs(writer, s_UpdatedIDs);
+		for (PlayerID id : s_UpdatedIDs)
+			WritePlayerData(writer, snapshot.Players.at(id));
+
+		WriteIDs(writer, s_DespawnedIDs);
+	}
+
+	SnapshotDeltaHeader ReadSnapshotDeltaHeader(BitReader& reader)
+	{
+		SnapshotDeltaHeader header;
+		header.Tick = reader.ReadBits(32);
+		header.TickRate = reader.ReadVarUInt();
+		header.SnapshotInterval = reader.ReadVarUInt();
+		header.HasLastInputSequence = reader.ReadBool();
+		if (header.HasLastInputSequence)
+			header.LastInputSequence = reader.ReadBits(32);
+		if (reader.ReadBool())
+			header.BaselineTick = reader.ReadBits(32);
+		return header;
+	}
+
+	void ApplySnapshotDelta(BitReader& reader, WorldSnapshot& snapshot)
+	{
+		static thread_local std::vector<PlayerID> s_IDs;
+
+		auto readIDs = [&reader]()
+		{
+			uint32_t count = reader.ReadVarUInt();
+			s_IDs.resize(reader.IsValid() && count <= MaxSnapshotPlayers ? count : 0);
+			uint32_t index = 0;
+			for (PlayerID& id : s_IDs)
+			{
+				index += reader.ReadVarUInt();
+				id = MakePlayerID(index, reader.ReadVarUInt());
+			}
+		};
+
+		// Spawned
+		readIDs();
+		for (PlayerID id : s_IDs)
+			snapshot.Players[id] = ReadPlayerData(reader);
+
+		// Updated
+		readIDs();
+		for (PlayerID id : s_IDs)
+			snapshot.Players[id] = ReadPlayerData(reader);
+
+		// Despawned
+		readIDs();
+		for (PlayerID id : s_IDs)
+			snapshot.Players.erase(id);
+	}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <map>
+#include <memory>
+
+#include "glm/glm.hpp"
+
+#include "BitStream.h"
+
+namespace Cubed
+{
+	struct PlayerData
+	{
+		glm::vec2 Position{ 0.0f, 0.0f };
+		glm::vec2 Velocity{ 0.0f, 0.0f };
+
+		bool operator==(const PlayerData& other) const { return Position == other.Position && Velocity == other.Velocity; }
+		bool operator!=(const PlayerData& other) const { return !(*this == other); }
+	};
+
+	// Positions are clamped to the world bounds; 0.125 unit resolution
+	static constexpr QuantizationRange PlayerPositionQuantization = { -4096.0f, 4096.0f, 16 };
+	// Covers the movement speed (50) with headroom; 0.125 unit/s resolution
+	static constexpr QuantizationRange PlayerVelocityQuantization = { -64.0f, 64.0f, 10 };
+
+	// Rounds player state to what survives the wire, so server-side baselines match the client exactly
+	PlayerData QuantizePlayerData(const PlayerData& playerData);
+	void WritePlayerData(BitWriter& writer, const PlayerData& playerData);
+	PlayerData ReadPlayerData(BitReader& reader);
+
+	static constexpr uint32_t InvalidSnapshotTick = 0xffffffff;
+	// Upper bound on entries in a single delta; anything larger is treated as a corrupt packet
+	static constexpr uint32_t MaxSnapshotPlayers = 1 << 16;
+
+	struct WorldSnapshot
+	{
+		uint32_t Tick = InvalidSnapshotTick;
+		// Server ticks per second and ticks between consecutive snapshots when this was taken,
+		// so the receiver can place Tick on a timeline
+		uint32_t TickRate = 0;
+		uint32_t SnapshotInterval = 1;
+		// Latest input from the receiving client that the server had applied by this tick,
+		// for client-side prediction (snapshots are per client)
+		bool HasLastInputSequence = false;
+		uint32_t LastInputSequence = 0;
+		std::map<uint32_t, PlayerData> Players;
+	};
+
+	//
+	// SnapshotHistory - fixed-size ring of recent snapshots indexed by tick,
+	// used as delta baselines on both ends of the connection
+	//
+	class SnapshotHistory
+	{
+	public:
+		static constexpr uint32_t Capacity = 64;
+	public:
+		void Push(std::shared_ptr<const WorldSnapshot> snapshot);
+		const WorldSnapshot* Find(uint32_t tick) const;
+		void Clear();
+	private:
+		std::array<std::shared_ptr<const WorldSnapshot>, Capacity> m_Snapshots;
+	};
+
+	struct SnapshotDeltaHeader
+	{
+		uint32_t Tick = InvalidSnapshotTick;
+		uint32_t TickRate = 0;
+		uint32_t SnapshotInterval = 1;
+		bool HasLastInputSequence = false;
+		uint32_t LastInputSequence = 0;
+		uint32_t BaselineTick = InvalidSnapshotTick; // InvalidSnapshotTick = full snapshot
+	};
+
+	// Writes header + spawned players (not in baseline) + updated players + despawned player IDs.
+	// Passing a null baseline writes a full snapshot. Snapshots are expected to hold quantized state.
+	void WriteSnapshotDelta(BitWriter& writer, const WorldSnapshot* baseline, const WorldSnapshot& snapshot);
+
+	SnapshotDeltaHeader ReadSnapshotDeltaHeader(BitReader& reader);
+	// Applies the delta body (following the header) onto snapshot, which must hold the baseline state
+	void ApplySnapshotDelta(BitReader& reader, WorldSnapshot& snapshot);
+
+}
@@ -0,0 +1,174 @@
+#include "SnapshotInterpolator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Cubed
+{
+	// How fast (seconds per second) the clock offset may move up towards later-arriving snapshots.
+	// Moving down is immediate, since a snapshot can be delayed but never early.
+	static constexpr double s_ClockOffsetRelaxRate = 0.02;
+
+	// Playback follows the clock offset by speeding up or slowing down by at most this fraction,
+	// so offset corrections never show up as players jumping. Bigger gaps than s_PlaybackSnapThreshold
+	// (seconds) are caught up in one step.
+	static constexpr double s_PlaybackSlewRate = 0.05;
+	static constexpr double s_PlaybackSnapThreshold = 0.25;
+
+	static double ToSeconds(SnapshotInterpolator::Clock::time_point time)
+	{
+		return std::chrono::duration<double>(time.time_since_epoch()).count();
+	}
+
+	static void AddPlayer(PlayerStore& players, PlayerID id, const PlayerData& playerData)
+	{
+		players.Insert(id);
+		players.Set(id, playerData);
+	}
+
+	SnapshotInterpolator::SnapshotInterpolator(const SnapshotInterpolatorSpecification& specification)
+		: m_Specification(specification)
+	{
+	}
+
+	void SnapshotInterpolator::Push(std::shared_ptr<const WorldSnapshot> snapshot, Clock::time_point receiveTime)
+	{
+		if (!snapshot || snapshot->TickRate == 0)
+			return;
+
+		// Ticks before and after a tick rate change don't share a timeline, so start over
+		if (snapshot->TickRate != m_TickRate)
+		{
+			Clear();
+			m_TickRate = snapshot->TickRate;
+		}
+
+		if (m_Count > 0 && (int32_t)(snapshot->Tick - GetEntry(0).Tick) <= 0)
+		{
+			m_Stats.LateSnapshots++;
+			return;
+		}
+
+		double offset = ToSeconds(receiveTime) - GetServerTime(*snapshot);
+		if (!m_HasClockOffset || offset < m_ClockOffset)
+		{
+			m_ClockOffset = offset;
+			m_HasClockOffset = true;
+		}
+		else
+		{
+			double elapsed = std::chrono::duration<double>(receiveTime - m_LastPushTime).count();
+			m_ClockOffset += std::min(offset - m_ClockOffset, elapsed * s_ClockOffsetRelaxRate);
+		}
+		m_LastPushTime = receiveTime;
+
+		m_Newest = m_Count > 0 ? (m_Newest + 1) % Capacity : 0;
+		m_Snapshots[m_Newest] = std::move(snapshot);
+		m_Count = std::min(m_Count + 1, Capacity);
+	}
+
+	void SnapshotInterpolator::Sample(Clock::time_point now, PlayerStore& players)
+	{
+		players.Clear();
+		if (m_Count == 0)
+			return;
+
+		m_Stats.SampleCount++;
+
+		if (!m_HasPlaybackOffset || std::abs(m_ClockOffset - m_PlaybackOffset) > s_PlaybackSnapThreshold)
+		{
+			m_PlaybackOffset = m_ClockOffset;
+			m_HasPlaybackOffset = true;
+		}
+		else
+		{
+			double maxSlew = std::chrono::duration<double>(now - m_LastSampleTime).count() * s_PlaybackSlewRate;
+			m_PlaybackOffset += std::clamp(m_ClockOffset - m_PlaybackOffset, -maxSlew, maxSlew);
+		}
+		m_LastSampleTime = now;
+
+		double renderTime = ToSeconds(now) - m_PlaybackOffset - m_Specification.InterpolationDelay;
+
+		const WorldSnapshot& newest = GetEntry(0);
+		double newestTime = GetServerTime(newest);
+		m_BufferedTime = (float)(newestTime - renderTime);
+
+		if (renderTime >= newestTime)
+		{
+			// Snapshots are late or lost; carry everyone along their last velocity for a little while
+			float extrapolation = (float)(renderTime - newestTime);
+			m_Stats.ExtrapolatedSamples++;
+			if (extrapolation > m_Specification.MaxExtrapolation)
+			{
+				m_Stats.StarvedSamples++;
+				extrapolation = m_Specification.MaxExtrapolation;
+			}
+
+			for (const auto& [id, playerData] : newest.Players)
+				AddPlayer(players, id, { playerData.Position + playerData.Velocity * extrapolation, playerData.Velocity });
+
+			return;
+		}
+
+		// Newest first, so find the first snapshot at or before the render time
+		uint32_t toAge = 0;
+		while (toAge + 1 < m_Count && GetServerTime(GetEntry(toAge + 1)) > renderTime)
+			toAge++;
+
+		if (toAge + 1 == m_Count)
+		{
+			// Render time is before anything we still have (just connected or delay was raised)
+			for (const auto& [id, playerData] : GetEntry(toAge).Players)
+				AddPlayer(players, id, playerData);
+
+			return;
+		}
+
+		const WorldSnapshot& from = GetEntry(toAge + 1);
+		const WorldSnapshot& to = GetEntry(toAge);
+		double fromTime = GetServerTime(from);
+		float t = (float)((renderTime - fromTime) / (GetServerTime(to) - fromTime));
+
+		// Both maps are sorted by ID, so walk them together. Players that only exist in `to`
+		// haven't spawned yet at render time; players missing from `to` stay until it's reached.
+		auto toIt = to.Players.begin();
+		for (const auto& [id, fromData] : from.Players)
+		{
+			while (toIt != to.Players.end() && toIt->first < id)
+				++toIt;
+
+			if (toIt == to.Players.end() || toIt->first != id)
+			{
+				AddPlayer(players, id, fromData);
+				continue;
+			}
+
+			const PlayerData& toData = toIt->second;
+			AddPlayer(players, id, { glm::mix(fromData.Position, toData.Position, t), glm::mix(fromData.Velocity, toData.Velocity, t) });
+		}
+	}
+
+	void SnapshotInterpolator::Clear()
+	{
+		for (auto& snapshot : m_Snapshots)
+			snapshot.reset();
+
+		m_Newest = 0;
+		m_Count = 0;
+		m_TickRate = 0;
+		m_HasClockOffset = false;
+		m_HasPlaybackOffset = false;
+		m_BufferedTime = 0.0f;
+	}
+
+	double SnapshotInterpolator::GetServerTime(const WorldSnapshot& snapshot) const
+	{
+		return (double)snapshot.Tick / (double)snapshot.TickRate;
+	}
+
+	const WorldSnapshot& SnapshotInterpolator::GetEntry(uint32_t age) const
+	{
+		return *m_Snapshots[(m_Newest + Capacity - age) % Capacity];
+	}
+
+}
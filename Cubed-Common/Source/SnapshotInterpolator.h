@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <chrono>
+#include <memory>
+
+#include "Snapshot.h"
+#include "PlayerStore.h"
+
+namespace Cubed
+{
+	struct SnapshotInterpolatorSpecification
+	{
+		// How far behind the estimated server time we render, in seconds. Needs to cover
+		// a couple of snapshot intervals plus jitter so there's usually a snapshot on each side.
+		float InterpolationDelay = 0.1f;
+
+		// Once we run past the newest snapshot, players keep moving along their last
+		// velocity for at most this long (seconds) before they stop
+		float MaxExtrapolation = 0.25f;
+	};
+
+	struct SnapshotInterpolatorStats
+	{
+		uint64_t SampleCount = 0;
+		uint64_t ExtrapolatedSamples = 0; // ran past the newest snapshot
+		uint64_t StarvedSamples = 0; // ran past MaxExtrapolation, players froze
+		uint64_t LateSnapshots = 0; // arrived older than the newest buffered one, dropped
+	};
+
+	//
+	// SnapshotInterpolator - client-side ring of received snapshots stamped with server time.
+	// Rendering samples the world at (estimated server time - InterpolationDelay), blending the
+	// two snapshots around that point, so motion stays smooth with snapshots arriving at
+	// 10-20Hz and irregular spacing.
+	//
+	// Server time is tick / TickRate. The offset to the local clock is the lowest one seen
+	// (the least delayed snapshot), relaxed slowly upwards to follow clock drift and route changes.
+	// Playback eases towards that offset rather than jumping to it.
+	//
+	class SnapshotInterpolator
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr uint32_t Capacity = 32;
+	public:
+		SnapshotInterpolator(const SnapshotInterpolatorSpecification& specification = SnapshotInterpolatorSpecification());
+
+		// Snapshots must carry TickRate; ones older than the newest buffered snapshot are dropped
+		void Push(std::shared_ptr<const WorldSnapshot> snapshot, Clock::time_point receiveTime);
+
+		// Fills players with the interpolated world at the given local time (cleared first)
+		void Sample(Clock::time_point now, PlayerStore& players);
+
+		void Clear();
+
+		void SetInterpolationDelay(float delay) { m_Specification.InterpolationDelay = delay; }
+		float GetInterpolationDelay() const { return m_Specification.InterpolationDelay; }
+		void SetMaxExtrapolation(float maxExtrapolation) { m_Specification.MaxExtrapolation = maxExtrapolation; }
+		float GetMaxExtrapolation() const { return m_Specification.MaxExtrapolation; }
+
+		uint32_t GetBufferedCount() const { return m_Count; }
+		// Seconds of buffered snapshots ahead of the render time at the last Sample (negative when extrapolating)
+		float GetBufferedTime() const { return m_BufferedTime; }
+
+		const SnapshotInterpolatorStats& GetStats() const { return m_Stats; }
+	private:
+		double GetServerTime(const WorldSnapshot& snapshot) const;
+		const WorldSnapshot& GetEntry(uint32_t age) const; // 0 = newest
+	private:
+		SnapshotInterpolatorSpecification m_Specification;
+
+		std::array<std::shared_ptr<const WorldSnapshot>, Capacity> m_Snapshots;
+		uint32_t m_Newest = 0;
+		uint32_t m_Count = 0;
+
+		uint32_t m_TickRate = 0;
+		bool m_HasClockOffset = false;
+		double m_ClockOffset = 0.0; // local seconds - server seconds
+		Clock::time_point m_LastPushTime;
+
+		// Offset actually used for rendering; slews towards m_ClockOffset
+		bool m_HasPlaybackOffset = false;
+		double m_PlaybackOffset = 0.0;
+		Clock::time_point m_LastSampleTime;
+
+		float m_BufferedTime = 0.0f;
+		SnapshotInterpolatorStats m_Stats;
+	};
+
+}
@@ -0,0 +1,69 @@
+#include "SpatialHashGrid.h"
+
+namespace Cubed
+{
+	SpatialHashGrid::SpatialHashGrid(float cellSize)
+		: m_CellSize(cellSize), m_InverseCellSize(1.0f / cellSize)
+	{
+	}
+
+	void SpatialHashGrid::Update(uint32_t entityID, const glm::vec2& position)
+	{
+		CellKey cellKey = GetCellKey(ToCellCoordinate(position.x), ToCellCoordinate(position.y));
+
+		auto it = m_Entities.find(entityID);
+		if (it != m_Entities.end())
+		{
+			EntityLocation& location = it->second;
+			if (location.Cell == cellKey)
+			{
+				m_Cells[cellKey][location.IndexInCell].Position = position;
+				return;
+			}
+
+			RemoveFromCell(location.Cell, location.IndexInCell);
+		}
+
+		std::vector<CellEntry>& cell = m_Cells[cellKey];
+		m_Entities[entityID] = { cellKey, (uint32_t)cell.size() };
+		cell.push_back({ entityID, position });
+	}
+
+	void SpatialHashGrid::Remove(uint32_t entityID)
+	{
+		auto it = m_Entities.find(entityID);
+		if (it == m_Entities.end())
+			return;
+
+		RemoveFromCell(it->second.Cell, it->second.IndexInCell);
+		m_Entities.erase(it);
+	}
+
+	void SpatialHashGrid::Clear()
+	{
+		m_Cells.clear();
+		m_Entities.clear();
+	}
+
+	const glm::vec2* SpatialHashGrid::GetPosition(uint32_t entityID) const
+	{
+		auto it = m_Entities.find(entityID);
+		if (it == m_Entities.end())
+			return nullptr;
+
+		return &m_Cells.at(it->second.Cell)[it->second.IndexInCell].Position;
+	}
+
+	void SpatialHashGrid::RemoveFromCell(CellKey cellKey, uint32_t indexInCell)
+	{
+		std::vector<CellEntry>& cell = m_Cells[cellKey];
+		if (indexInCell != cell.size() - 1)
+		{
+			cell[indexInCell] = cell.back();
+			m_Entities[cell[indexInCell].EntityID].IndexInCell = indexInCell;
+		}
+
+		cell.pop_back();
+	}
+
+}
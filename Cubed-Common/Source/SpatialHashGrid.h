@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace Cubed
+{
+	//
+	// SpatialHashGrid - uniform grid of fixed-size cells keyed by cell coordinate.
+	// Entities keep their slot inside the cell, so moving within a cell is O(1)
+	// and crossing a cell boundary is a swap-remove plus an append.
+	//
+	class SpatialHashGrid
+	{
+	public:
+		SpatialHashGrid(float cellSize = 512.0f);
+
+		// Inserts the entity if it isn't in the grid yet
+		void Update(uint32_t entityID, const glm::vec2& position);
+		void Remove(uint32_t entityID);
+		void Clear();
+
+		bool Contains(uint32_t entityID) const { return m_Entities.contains(entityID); }
+		const glm::vec2* GetPosition(uint32_t entityID) const;
+
+		// Calls func(entityID, position) for every entity within radius of center
+		template<typename Func>
+		void QueryRadius(const glm::vec2& center, float radius, Func&& func) const
+		{
+			int32_t minX = ToCellCoordinate(center.x - radius), maxX = ToCellCoordinate(center.x + radius);
+			int32_t minY = ToCellCoordinate(center.y - radius), maxY = ToCellCoordinate(center.y + radius);
+			float radiusSquared = radius * radius;
+
+			for (int32_t y = minY; y <= maxY; y++)
+			{
+				for (int32_t x = minX; x <= maxX; x++)
+				{
+					auto it = m_Cells.find(GetCellKey(x, y));
+					if (it == m_Cells.end())
+						continue;
+
+					for (const CellEntry& entry : it->second)
+					{
+						glm::vec2 offset = entry.Position - center;
+						if (offset.x * offset.x + offset.y * offset.y <= radiusSquared)
+							func(entry.EntityID, entry.Position);
+					}
+				}
+			}
+		}
+
+		float GetCellSize() const { return m_CellSize; }
+		size_t GetEntityCount() const { return m_Entities.size(); }
+		size_t GetCellCount() const { return m_Cells.size(); }
+	private:
+		using CellKey = uint64_t;
+
+		int32_t ToCellCoordinate(float value) const { return (int32_t)std::floor(value * m_InverseCellSize); }
+		static CellKey GetCellKey(int32_t x, int32_t y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+		void RemoveFromCell(CellKey cellKey, uint32_t indexInCell);
+	private:
+		struct CellEntry
+		{
+			uint32_t EntityID;
+			glm::vec2 Position;
+		};
+
+		struct EntityLocation
+		{
+			CellKey Cell;
+			uint32_t IndexInCell;
+		};
+
+		float m_CellSize;
+		float m_InverseCellSize;
+
+		// Empty cells are kept around; the world is bounded so their count is too
+		std::unordered_map<CellKey, std::vector<CellEntry>> m_Cells;
+		std::unordered_map<uint32_t, EntityLocation> m_Entities;
+	};
+
+}
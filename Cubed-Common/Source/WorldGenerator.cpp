@@ -0,0 +1,142 @@
+#include "WorldGenerator.h"
+
+#include <cmath>
+
+namespace Cubed
+{
+	static uint32_t Hash(uint32_t seed, int32_t x, int32_t y, int32_t z)
+	{
+		uint32_t h = seed ^ ((uint32_t)x * 0x8da6b343u) ^ ((uint32_t)y * 0xd8163841u) ^ ((uint32_t)z * 0xcb1ab31fu);
+		h ^= h >> 16;
+		h *= 0x7feb352du;
+		h ^= h >> 15;
+		h *= 0x846ca68bu;
+		h ^= h >> 16;
+		return h;
+	}
+
+	// Random value in [0, 1] at an integer lattice point
+	static float Lattice(uint32_t seed, int32_t x, int32_t y, int32_t z)
+	{
+		return (float)(Hash(seed, x, y, z) & 0xffffff) / (float)0xffffff;
+	}
+
+	static float Smooth(float t) { return t * t * (3.0f - 2.0f * t); }
+	static float Lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+	static float ValueNoise2D(uint32_t seed, float x, float z)
+	{
+		float fx = std::floor(x), fz = std::floor(z);
+		int32_t ix = (int32_t)fx, iz = (int32_t)fz;
+		float tx = Smooth(x - fx), tz = Smooth(z - fz);
+
+		float a = Lerp(Lattice(seed, ix, 0, iz), Lattice(seed, ix + 1, 0, iz), tx);
+		float b = Lerp(Lattice(seed, ix, 0, iz + 1), Lattice(seed, ix + 1, 0, iz + 1), tx);
+		return Lerp(a, b, tz);
+	}
+
+	static float ValueNoise3D(uint32_t seed, float x, float y, float z)
+	{
+		float fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+		int32_t ix = (int32_t)fx, iy = (int32_t)fy, iz = (int32_t)fz;
+		float tx = Smooth(x - fx), ty = Smooth(y - fy), tz = Smooth(z - fz);
+
+		float layers[2];
+		for (int32_t dy = 0; dy < 2; dy++)
+		{
+			float a = Lerp(Lattice(seed, ix, iy + dy, iz), Lattice(seed, ix + 1, iy + dy, iz), tx);
+			float b = Lerp(Lattice(seed, ix, iy + dy, iz + 1), Lattice(seed, ix + 1, iy + dy, iz + 1), tx);
+			layers[dy] = Lerp(a, b, tz);
+		}
+		return Lerp(layers[0], layers[1], ty);
+	}
+
+	// Four octaves of 2D value noise, in [-1, 1]
+	static float FractalNoise2D(uint32_t seed, float x, float z)
+	{
+		float sum = 0.0f, amplitude = 1.0f, total = 0.0f;
+		for (uint32_t octave = 0; octave < 4; octave++)
+		{
+			sum += ValueNoise2D(seed + octave, x, z) * amplitude;
+			total += amplitude;
+			x *= 2.0f;
+			z *= 2.0f;
+			amplitude *= 0.5f;
+		}
+		return sum / total * 2.0f - 1.0f;
+	}
+
+	static BlockID GetColumnBlock(int32_t worldY, int32_t groundHeight)
+	{
+		if (worldY >= groundHeight)
+			return AirBlock;
+		if (worldY == groundHeight - 1)
+			return GrassBlock;
+		if (worldY >= groundHeight - 4)
+			return DirtBlock;
+		return StoneBlock;
+	}
+
+	void GenerateFlatChunk(Chunk& chunk, int32_t groundHeight)
+	{
+		static thread_local std::vector<BlockID> blocks(Chunk::Volume);
+
+		int32_t baseY = chunk.GetCoordinate().y * (int32_t)Chunk::Size;
+		for (uint32_t y = 0; y < Chunk::Size; y++)
+		{
+			BlockID block = GetColumnBlock(baseY + (int32_t)y, groundHeight);
+			std::fill_n(&blocks[Chunk::GetIndex(0, y, 0)], Chunk::Size * Chunk::Size, block);
+		}
+
+		chunk.GetBlocks().Encode(blocks.data());
+	}
+
+	void GenerateTerrainChunk(Chunk& chunk, const TerrainSettings& settings)
+	{
+		static thread_local std::vector<BlockID> blocks(Chunk::Volume);
+
+		const glm::ivec3 origin = chunk.GetCoordinate() * (int32_t)Chunk::Size;
+		const float frequency = 1.0f / settings.HorizontalScale;
+		const uint32_t caveSeed = settings.Seed * 0x9e3779b9u + 0x632be5abu;
+
+		int32_t heights[Chunk::Size][Chunk::Size];
+		for (uint32_t z = 0; z < Chunk::Size; z++)
+		{
+			for (uint32_t x = 0; x < Chunk::Size; x++)
+			{
+				float noise = FractalNoise2D(settings.Seed, (float)(origin.x + (int32_t)x) * frequency, (float)(origin.z + (int32_t)z) * frequency);
+				heights[z][x] = settings.BaseHeight + (int32_t)std::lround(noise * settings.Amplitude);
+			}
+		}
+
+		for (uint32_t y = 0; y < Chunk::Size; y++)
+		{
+			int32_t worldY = origin.y + (int32_t)y;
+			for (uint32_t z = 0; z < Chunk::Size; z++)
+			{
+				for (uint32_t x = 0; x < Chunk::Size; x++)
+				{
+					int32_t height = heights[z][x];
+					BlockID block = GetColumnBlock(worldY, height);
+
+					// Low ground is beach
+					if (block != AirBlock && block != StoneBlock && height <= settings.BaseHeight - 2)
+						block = SandBlock;
+
+					// Caves stay a few blocks under the surface so they don't riddle the ground with holes
+					if (settings.Caves && block != AirBlock && worldY < height - 6)
+					{
+						float cave = ValueNoise3D(caveSeed, (float)(origin.x + (int32_t)x) / 24.0f, (float)worldY / 16.0f, (float)(origin.z + (int32_t)z) / 24.0f);
+						if (cave > 0.72f)
+							block = AirBlock;
+					}
+
+					blocks[Chunk::GetIndex(x, y, z)] = block;
+				}
+			}
+		}
+
+		chunk.GetBlocks().Encode(blocks.data());
+	}
+
+}
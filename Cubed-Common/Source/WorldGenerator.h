@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Chunk.h"
+
+namespace Cubed
+{
+	struct TerrainSettings
+	{
+		uint32_t Seed = 1;
+		int32_t BaseHeight = 32; // world blocks
+		float Amplitude = 24.0f; // height variation either side of BaseHeight
+		float HorizontalScale = 96.0f; // blocks per base noise period
+		bool Caves = true;
+	};
+
+	//
+	// Deterministic terrain, so every side can generate any chunk on its own and get the same
+	// blocks. Both fill the chunk at its own coordinate.
+	//
+
+	// Grass at groundHeight - 1, dirt below it, stone from 4 blocks down
+	void GenerateFlatChunk(Chunk& chunk, int32_t groundHeight);
+	// Fractal value noise heightmap with sand near the base height and 3D noise caves
+	void GenerateTerrainChunk(Chunk& chunk, const TerrainSettings& settings = {});
+
+}
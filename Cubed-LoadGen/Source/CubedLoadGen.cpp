@@ -0,0 +1,29 @@
+#include "LoadGenerator.h"
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+
+static uint32_t ParseUInt(std::string_view text, uint32_t fallback)
+{
+	uint32_t value = 0;
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return error == std::errc() && value > 0 ? value : fallback;
+}
+
+// Usage: Cubed-LoadGen [address=127.0.0.1:8192] [maxBots=1000] [rampStep=100] [stageSeconds=10]
+int main(int argc, char** argv)
+{
+	Cubed::LoadGeneratorSpecification spec;
+	if (argc > 1)
+		spec.ServerAddress = argv[1];
+	if (argc > 2)
+		spec.MaxBots = ParseUInt(argv[2], spec.MaxBots);
+	if (argc > 3)
+		spec.RampStep = ParseUInt(argv[3], spec.RampStep);
+	if (argc > 4)
+		spec.StageDuration = std::chrono::seconds(ParseUInt(argv[4], (uint32_t)spec.StageDuration.count()));
+
+	Cubed::LoadGenerator loadGenerator(spec);
+	return loadGenerator.Run() ? 0 : 1;
+}
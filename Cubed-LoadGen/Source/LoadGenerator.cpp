@@ -0,0 +1,468 @@
+#include "LoadGenerator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "steam/isteamnetworkingutils.h"
+
+#include "spdlog/spdlog.h"
+
+#include "ServerPacket.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+#include "PacketFrame.h"
+
+namespace Cubed
+{
+	static LoadGenerator* s_Instance = nullptr;
+
+	// Consecutive script steps are 135 degrees apart, so every change flips the sign of at least
+	// one axis that is non-zero in the new direction; that makes the server's response unambiguous
+	static constexpr int8_t s_ScriptDirections[8][2] = {
+		{ 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }
+	};
+	static constexpr uint32_t s_ScriptStride = 3;
+
+	static float ToMilliseconds(LoadGenerator::Clock::duration duration)
+	{
+		return std::chrono::duration<float, std::milli>(duration).count();
+	}
+
+	static float Percentile(std::vector<float>& samples, float percentile)
+	{
+		if (samples.empty())
+			return 0.0f;
+
+		size_t index = std::min(samples.size() - 1, (size_t)(percentile * (float)samples.size()));
+		std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+		return samples[index];
+	}
+
+	static int Sign(float value)
+	{
+		return (value > 0.0f) - (value < 0.0f);
+	}
+
+	LoadGenerator::LoadGenerator(const LoadGeneratorSpecification& specification)
+		: m_Specification(specification)
+	{
+		s_Instance = this;
+	}
+
+	LoadGenerator::~LoadGenerator()
+	{
+		if (m_Interface)
+		{
+			for (Bot& bot : m_Bots)
+			{
+				if (bot.Connection != k_HSteamNetConnection_Invalid)
+					m_Interface->CloseConnection(bot.Connection, 0, "Load test finished", false);
+			}
+
+			m_Interface->DestroyPollGroup(m_PollGroup);
+			GameNetworkingSockets_Kill();
+		}
+
+		s_Instance = nullptr;
+	}
+
+	bool LoadGenerator::Run()
+	{
+		SteamDatagramErrMsg errorMessage;
+		if (!GameNetworkingSockets_Init(nullptr, errorMessage))
+		{
+			std::cout << fmt::format("Failed to initialize GameNetworkingSockets: {}\n", errorMessage);
+			return false;
+		}
+
+		m_Interface = SteamNetworkingSockets();
+		m_PollGroup = m_Interface->CreatePollGroup();
+		m_Bots.reserve(m_Specification.MaxBots);
+
+		std::cout << fmt::format("Ramping to {} bots against {} in steps of {} ({}s per stage)\n",
+			m_Specification.MaxBots, m_Specification.ServerAddress, m_Specification.RampStep, m_Specification.StageDuration.count());
+		std::cout << fmt::format("{:>6} {:>9} {:>9} {:>9} {:>9} {:>12} {:>13} {:>14} {:>10} {:>10} {:>8} {:>8} {:>8}\n",
+			"bots", "connect%", "lat p50", "lat p95", "lat p99", "snap B/s/bot", "chunk B/s/bot", "roster B/s/bot", "intvl p50", "intvl p99", "msgs/pkt", "missed", "errors");
+
+		while (m_Bots.size() < m_Specification.MaxBots)
+		{
+			m_Stage = StageStats();
+			uint32_t count = std::min<uint32_t>(m_Specification.RampStep, m_Specification.MaxBots - (uint32_t)m_Bots.size());
+			AddBots(count);
+			m_Stage.BotCount = (uint32_t)m_Bots.size();
+
+			Clock::time_point stageStart = Clock::now();
+			Clock::time_point stageEnd = stageStart + m_Specification.StageDuration;
+			while (Clock::now() < stageEnd)
+			{
+				m_Interface->RunCallbacks();
+				ReceiveMessages();
+				UpdateBots();
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			ReportStage(m_Stage, Clock::now() - stageStart);
+		}
+
+		return true;
+	}
+
+	void LoadGenerator::AddBots(uint32_t count)
+	{
+		SteamNetworkingIPAddr address;
+		if (!address.ParseString(m_Specification.ServerAddress.c_str()))
+		{
+			std::cout << fmt::format("Invalid server address '{}'\n", m_Specification.ServerAddress);
+			m_Stage.ConnectionAttempts += count;
+			m_Stage.ConnectionFailures += count;
+			m_Bots.resize(m_Bots.size() + count);
+			for (uint32_t i = (uint32_t)m_Bots.size() - count; i < m_Bots.size(); i++)
+				m_Bots[i].ConnectionState = Bot::State::Failed;
+			return;
+		}
+
+		SteamNetworkingConfigValue_t options[2];
+		options[0].SetPtr(k_ESteamNetworkingConfig_Callback_ConnectionStatusChanged, (void*)OnConnectionStatusChanged);
+
+		Clock::time_point now = Clock::now();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t botIndex = (uint32_t)m_Bots.size();
+			Bot& bot = m_Bots.emplace_back();
+			bot.ConnectStartTime = now;
+			bot.ScriptStep = botIndex; // spread bots across the pattern
+
+			m_Stage.ConnectionAttempts++;
+
+			// Set at creation so even the earliest status callbacks carry the bot index
+			options[1].SetInt64(k_ESteamNetworkingConfig_ConnectionUserData, botIndex);
+			bot.Connection = m_Interface->ConnectByIPAddress(address, 2, options);
+			if (bot.Connection == k_HSteamNetConnection_Invalid)
+			{
+				bot.ConnectionState = Bot::State::Failed;
+				m_Stage.ConnectionFailures++;
+				continue;
+			}
+
+			m_Interface->SetConnectionPollGroup(bot.Connection, m_PollGroup);
+		}
+	}
+
+	void LoadGenerator::OnConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* info)
+	{
+		s_Instance->HandleConnectionStatusChanged(info);
+	}
+
+	void LoadGenerator::HandleConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* info)
+	{
+		int64 botIndex = info->m_info.m_nUserData;
+		if (botIndex < 0 || botIndex >= (int64)m_Bots.size())
+			return;
+
+		Bot& bot = m_Bots[botIndex];
+		switch (info->m_info.m_eState)
+		{
+		case k_ESteamNetworkingConnectionState_Connected:
+		{
+			Clock::time_point now = Clock::now();
+			bot.ConnectionState = Bot::State::Connected;
+			// Stagger so inputs and direction changes from all bots don't line up
+			bot.NextInputTime = now + std::chrono::milliseconds(botIndex % (1000 / m_Specification.InputRate));
+			bot.NextDirectionChangeTime = now + m_Specification.DirectionChangeInterval;
+			m_Stage.ConnectionSuccesses++;
+			break;
+		}
+		case k_ESteamNetworkingConnectionState_ClosedByPeer:
+		case k_ESteamNetworkingConnectionState_ProblemDetectedLocally:
+		{
+			if (bot.ConnectionState == Bot::State::Connecting)
+			{
+				bot.ConnectionState = Bot::State::Failed;
+				m_Stage.ConnectionFailures++;
+			}
+			else
+			{
+				bot.ConnectionState = Bot::State::Closed;
+			}
+
+			m_Interface->CloseConnection(info->m_hConn, 0, nullptr, false);
+			bot.Connection = k_HSteamNetConnection_Invalid;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void LoadGenerator::ReceiveMessages()
+	{
+		SteamNetworkingMessage_t* messages[256];
+		for (;;)
+		{
+			int messageCount = m_Interface->ReceiveMessagesOnPollGroup(m_PollGroup, messages, (int)std::size(messages));
+			if (messageCount <= 0)
+				break;
+
+			for (int i = 0; i < messageCount; i++)
+			{
+				SteamNetworkingMessage_t* message = messages[i];
+				int64 botIndex = message->m_nConnUserData;
+				if (botIndex >= 0 && botIndex < (int64)m_Bots.size())
+					OnPacket(m_Bots[botIndex], (const uint8_t*)message->m_pData, (uint32_t)message->m_cbSize);
+
+				message->Release();
+			}
+		}
+	}
+
+	void LoadGenerator::OnPacket(Bot& bot, const uint8_t* data, uint32_t size)
+	{
+		m_Stage.PacketsReceived++;
+
+		// The server sends a tick's messages as one Frame; they are read in place
+		bool valid = ForEachFrameMessage(Walnut::Buffer(data, size), [&](Walnut::Buffer message)
+		{
+			m_Stage.MessagesReceived++;
+			OnMessage(bot, message);
+		});
+
+		if (!valid)
+			m_Stage.DecodeErrors++;
+	}
+
+	void LoadGenerator::OnMessage(Bot& bot, Walnut::Buffer buffer)
+	{
+		uint32_t size = (uint32_t)buffer.Size;
+		PacketType type = PacketType::None;
+		if (size >= sizeof(PacketType))
+			std::memcpy(&type, buffer.Data, sizeof(type));
+
+		switch (type)
+		{
+		case PacketType::ClientConnect:
+		{
+			PacketView<ClientConnectPacket> packet(buffer);
+			if (!packet)
+			{
+				m_Stage.DecodeErrors++;
+				break;
+			}
+
+			// Version 0 is our own player; anything else is another client joining the roster
+			if (packet.Get<ClientConnectPacket::RosterVersion>() != 0)
+			{
+				m_Stage.RosterBytes += size;
+				break;
+			}
+
+			PacketView<OwnPlayerRecord> ownPlayer(packet.Get<ClientConnectPacket::Body>());
+			if (!ownPlayer)
+			{
+				m_Stage.DecodeErrors++;
+				break;
+			}
+
+			bot.Player = ownPlayer.Get<OwnPlayerRecord::Player>();
+			SendJoinRequest(bot);
+			break;
+		}
+		case PacketType::ClientList:
+		case PacketType::ClientDisconnect:
+			m_Stage.RosterBytes += size;
+			break;
+		case PacketType::ClientUpdate:
+		{
+			PacketView<ClientUpdatePacket> update(buffer);
+			if (!update)
+			{
+				m_Stage.DecodeErrors++;
+				break;
+			}
+
+			BitReader reader(update.Get<ClientUpdatePacket::Body>());
+			OnSnapshot(bot, reader, size);
+			break;
+		}
+		case PacketType::ChunkData:
+		{
+			PacketView<ChunkDataPacket> packet(buffer);
+			if (!packet)
+			{
+				m_Stage.DecodeErrors++;
+				break;
+			}
+
+			// Acknowledged like the real client does, so the server keeps streaming to us
+			bot.LastChunkSequence = packet.Get<ChunkDataPacket::Sequence>();
+			m_Stage.ChunkBytes += size;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void LoadGenerator::OnSnapshot(Bot& bot, BitReader& reader, uint32_t size)
+	{
+		Clock::time_point now = Clock::now();
+		SnapshotDeltaHeader header = ReadSnapshotDeltaHeader(reader);
+
+		auto snapshot = std::make_shared<WorldSnapshot>();
+		snapshot->Tick = header.Tick;
+		snapshot->TickRate = header.TickRate;
+		snapshot->SnapshotInterval = header.SnapshotInterval;
+		if (header.BaselineTick != InvalidSnapshotTick)
+		{
+			const WorldSnapshot* baseline = bot.Snapshots.Find(header.BaselineTick);
+			if (!baseline)
+			{
+				// Same recovery as the real client: ask for a full snapshot
+				bot.LastSnapshotTick = InvalidSnapshotTick;
+				m_Stage.DecodeErrors++;
+				return;
+			}
+
+			snapshot->Players = baseline->Players;
+		}
+
+		ApplySnapshotDelta(reader, *snapshot);
+		if (!reader.IsValid())
+		{
+			m_Stage.DecodeErrors++;
+			return;
+		}
+
+		m_Stage.SnapshotBytes += size;
+		m_Stage.SnapshotCount++;
+
+		if (bot.LastSnapshotTick != InvalidSnapshotTick)
+		{
+			// Snapshots only go out every SnapshotInterval ticks, so count the ones that should have arrived in between
+			uint32_t tickDelta = header.Tick - bot.LastSnapshotTick;
+			uint32_t snapshotInterval = std::max(header.SnapshotInterval, 1u);
+			if (tickDelta > snapshotInterval && tickDelta < SnapshotHistory::Capacity)
+				m_Stage.MissedSnapshots += tickDelta / snapshotInterval - 1;
+
+			m_Stage.SnapshotIntervals.push_back(ToMilliseconds(now - bot.LastSnapshotTime));
+		}
+
+		bot.LastSnapshotTick = header.Tick;
+		bot.LastSnapshotTime = now;
+
+		if (bot.AwaitingResponse)
+		{
+			auto it = snapshot->Players.find(bot.Player);
+			if (it != snapshot->Players.end())
+			{
+				const glm::vec2& velocity = it->second.Velocity;
+				bool applied = (bot.Input.MoveX == 0 || Sign(velocity.x) == bot.Input.MoveX)
+					&& (bot.Input.MoveY == 0 || Sign(velocity.y) == bot.Input.MoveY);
+				if (applied)
+				{
+					m_Stage.UpdateLatencies.push_back(ToMilliseconds(now - bot.DirectionChangeTime));
+					bot.AwaitingResponse = false;
+				}
+			}
+		}
+
+		bot.Snapshots.Push(std::move(snapshot));
+	}
+
+	void LoadGenerator::SendJoinRequest(const Bot& bot)
+	{
+		// Bots don't keep a roster, so every join gets the full list like a new client's
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ConnectionRequest>(stream, 0x808080u, fmt::format("Bot{}", &bot - m_Bots.data()), 0u, 0u);
+
+		Walnut::Buffer buffer = stream.GetBuffer();
+		m_Interface->SendMessageToConnection(bot.Connection, buffer.Data, (uint32)buffer.Size, k_nSteamNetworkingSend_Reliable, nullptr);
+	}
+
+	void LoadGenerator::UpdateBots()
+	{
+		Clock::time_point now = Clock::now();
+		Clock::duration inputInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_Specification.InputRate));
+
+		for (Bot& bot : m_Bots)
+		{
+			if (bot.ConnectionState == Bot::State::Connecting && now - bot.ConnectStartTime > m_Specification.ConnectTimeout)
+			{
+				bot.ConnectionState = Bot::State::Failed;
+				m_Stage.ConnectionFailures++;
+				m_Interface->CloseConnection(bot.Connection, 0, "Connect timeout", false);
+				bot.Connection = k_HSteamNetConnection_Invalid;
+				continue;
+			}
+
+			// Wait for our PlayerID so responses can be matched to our own player
+			if (bot.ConnectionState != Bot::State::Connected || bot.Player == InvalidPlayerID)
+				continue;
+
+			if (now >= bot.NextDirectionChangeTime)
+			{
+				bot.ScriptStep += s_ScriptStride;
+				bot.NextDirectionChangeTime += m_Specification.DirectionChangeInterval;
+
+				const int8_t* direction = s_ScriptDirections[bot.ScriptStep % 8];
+				bot.Input.MoveX = direction[0];
+				bot.Input.MoveY = direction[1];
+
+				// Picked up at the next input sample like a real client's key press, so latency
+				// includes sampling and batching delay
+				bot.AwaitingResponse = true;
+				bot.DirectionChangeTime = now;
+			}
+
+			if (now >= bot.NextInputTime)
+			{
+				SampleInput(bot);
+				bot.NextInputTime = std::max(bot.NextInputTime + inputInterval, now);
+			}
+		}
+	}
+
+	void LoadGenerator::SampleInput(Bot& bot)
+	{
+		bot.Input.Sequence++;
+		if (!bot.InputWindow.Add(bot.Input))
+			return;
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ClientUpdatePacket>(stream);
+		BitWriter writer(stream);
+		WritePlayerInputs(writer, bot.InputWindow.GetInputs(), bot.InputWindow.GetCount());
+		writer.WriteBits(bot.LastSnapshotTick, 32);
+		writer.WriteBits(bot.LastChunkSequence, 32);
+		writer.Flush();
+
+		Walnut::Buffer buffer = stream.GetBuffer();
+		m_Interface->SendMessageToConnection(bot.Connection, buffer.Data, (uint32)buffer.Size, k_nSteamNetworkingSend_Reliable, nullptr);
+	}
+
+	void LoadGenerator::ReportStage(const StageStats& stats, std::chrono::duration<float> duration) const
+	{
+		StageStats sorted = stats;
+
+		float connectRate = stats.ConnectionAttempts ? 100.0f * (float)stats.ConnectionSuccesses / (float)stats.ConnectionAttempts : 100.0f;
+		uint32_t connectedBots = 0;
+		for (const Bot& bot : m_Bots)
+			connectedBots += bot.ConnectionState == Bot::State::Connected;
+
+		float bytesPerBotPerSecond = connectedBots ? (float)stats.SnapshotBytes / (float)connectedBots / duration.count() : 0.0f;
+		float chunkBytesPerBotPerSecond = connectedBots ? (float)stats.ChunkBytes / (float)connectedBots / duration.count() : 0.0f;
+		float rosterBytesPerBotPerSecond = connectedBots ? (float)stats.RosterBytes / (float)connectedBots / duration.count() : 0.0f;
+
+		float messagesPerPacket = stats.PacketsReceived ? (float)stats.MessagesReceived / (float)stats.PacketsReceived : 0.0f;
+
+		std::cout << fmt::format("{:>6} {:>8.1f}% {:>7.1f}ms {:>7.1f}ms {:>7.1f}ms {:>12.0f} {:>13.0f} {:>14.0f} {:>8.1f}ms {:>8.1f}ms {:>8.2f} {:>8} {:>8}\n",
+			stats.BotCount, connectRate,
+			Percentile(sorted.UpdateLatencies, 0.5f), Percentile(sorted.UpdateLatencies, 0.95f), Percentile(sorted.UpdateLatencies, 0.99f),
+			bytesPerBotPerSecond, chunkBytesPerBotPerSecond, rosterBytesPerBotPerSecond,
+			Percentile(sorted.SnapshotIntervals, 0.5f), Percentile(sorted.SnapshotIntervals, 0.99f),
+			messagesPerPacket, stats.MissedSnapshots, stats.DecodeErrors);
+	}
+
+}
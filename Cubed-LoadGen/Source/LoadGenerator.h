@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "steam/steamnetworkingsockets.h"
+
+#include "Walnut/Core/Buffer.h"
+
+#include "Snapshot.h"
+#include "PlayerStore.h"
+#include "Movement.h"
+#include "InputQueue.h"
+
+namespace Cubed
+{
+	struct LoadGeneratorSpecification
+	{
+		std::string ServerAddress = "127.0.0.1:8192";
+
+		// Bots are added in steps of RampStep until MaxBots, each step held for StageDuration
+		uint32_t MaxBots = 1000;
+		uint32_t RampStep = 100;
+		std::chrono::seconds StageDuration{ 10 };
+
+		// Bots that aren't connected after this long count as failed
+		std::chrono::seconds ConnectTimeout{ 10 };
+
+		// Input samples per second per bot; like the real client, packets go out every InputsPerPacket samples
+		uint32_t InputRate = 30;
+		std::chrono::milliseconds DirectionChangeInterval{ 1000 };
+	};
+
+	//
+	// LoadGenerator - opens many connections to a Cubed server from one process.
+	// Bots speak the real protocol: they receive ClientConnect, join the roster, decode and
+	// acknowledge delta snapshots, and send movement inputs on a scripted pattern. Everything runs
+	// on one thread over a single GameNetworkingSockets poll group.
+	//
+	// Walnut::Client owns GameNetworkingSockets globally and handles one connection, so
+	// this talks to GameNetworkingSockets directly.
+	//
+	class LoadGenerator
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+	public:
+		LoadGenerator(const LoadGeneratorSpecification& specification);
+		~LoadGenerator();
+
+		// Runs every ramp stage and prints per-stage results; returns false if networking failed to start
+		bool Run();
+	private:
+		struct Bot
+		{
+			enum class State { Connecting, Connected, Failed, Closed };
+
+			HSteamNetConnection Connection = k_HSteamNetConnection_Invalid;
+			State ConnectionState = State::Connecting;
+			Clock::time_point ConnectStartTime;
+
+			PlayerID Player = InvalidPlayerID;
+			SnapshotHistory Snapshots;
+			uint32_t LastSnapshotTick = InvalidSnapshotTick;
+			Clock::time_point LastSnapshotTime;
+			uint32_t LastChunkSequence = 0; // chunks are only acknowledged, not decoded
+
+			PlayerInput Input;
+			InputSendWindow InputWindow;
+			uint32_t ScriptStep = 0;
+			Clock::time_point NextInputTime;
+			Clock::time_point NextDirectionChangeTime;
+
+			// Set when the direction changes; cleared once a snapshot shows the server applied it
+			bool AwaitingResponse = false;
+			Clock::time_point DirectionChangeTime;
+		};
+
+		struct StageStats
+		{
+			uint32_t BotCount = 0;
+			uint32_t ConnectionAttempts = 0;
+			uint32_t ConnectionSuccesses = 0;
+			uint32_t ConnectionFailures = 0;
+
+			std::vector<float> UpdateLatencies; // ms, input direction change to snapshot reflecting it
+			std::vector<float> SnapshotIntervals; // ms between consecutive snapshots per bot
+			uint64_t SnapshotBytes = 0;
+			uint64_t SnapshotCount = 0;
+			uint64_t ChunkBytes = 0;
+			uint64_t RosterBytes = 0; // ClientList and roster deltas, only counted
+			uint64_t PacketsReceived = 0;
+			uint64_t MessagesReceived = 0; // more than packets when the server coalesces them into frames
+			uint64_t MissedSnapshots = 0; // gaps in snapshot tick numbers beyond the snapshot interval
+			uint64_t DecodeErrors = 0;
+		};
+	private:
+		static void OnConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* info);
+		void HandleConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* info);
+
+		void AddBots(uint32_t count);
+		void ReceiveMessages();
+		void OnPacket(Bot& bot, const uint8_t* data, uint32_t size);
+		// One message of a packet; the server sends several per tick as a Frame
+		void OnMessage(Bot& bot, Walnut::Buffer buffer);
+		void OnSnapshot(Bot& bot, BitReader& reader, uint32_t size);
+		void SendJoinRequest(const Bot& bot);
+		void UpdateBots();
+		void SampleInput(Bot& bot);
+
+		void ReportStage(const StageStats& stats, std::chrono::duration<float> duration) const;
+	private:
+		LoadGeneratorSpecification m_Specification;
+
+		ISteamNetworkingSockets* m_Interface = nullptr;
+		HSteamNetPollGroup m_PollGroup = k_HSteamNetPollGroup_Invalid;
+
+		std::vector<Bot> m_Bots;
+		StageStats m_Stage;
+	};
+
+}
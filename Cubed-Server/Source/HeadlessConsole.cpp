@@ -1,7 +1,7 @@
 #include "HeadlessConsole.h"
 
-HeadlessConsole::HeadlessConsole(std::string_view title)
-	: m_Title(title)
+HeadlessConsole::HeadlessConsole(std::string_view title, uint32_t historyRetention)
+	: m_Title(title), m_Log(Cubed::AsyncLog::DefaultQueueCapacity, historyRetention)
 {
 	// NOTE(Yan): to run in background on Linux server you'll need to comment out
 	//            the following line, since we can't std::getline with no terminal
@@ -17,7 +17,7 @@ HeadlessConsole::~HeadlessConsole()
 
 void HeadlessConsole::ClearLog()
 {
-	m_MessageHistory.clear();
+	m_Log.ClearHistory();
 }
 
 void HeadlessConsole::SetMessageSendCallback(const MessageSendCallback& callback)
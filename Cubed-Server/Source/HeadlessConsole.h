@@ -8,6 +8,8 @@
 
 #include "spdlog/spdlog.h"
 
+#include "AsyncLog.h"
+
 //
 // HeadlessConsole - similar to Walnut::UI::Console but for non-GUI builds
 //
@@ -16,7 +18,7 @@ class HeadlessConsole
 public:
 	using MessageSendCallback = std::function<void(std::string_view)>;
 public:
-	HeadlessConsole(std::string_view title = "Walnut Console");
+	HeadlessConsole(std::string_view title = "Walnut Console", uint32_t historyRetention = Cubed::AsyncLog::DefaultHistoryRetention);
 	~HeadlessConsole();
 
 	void ClearLog();
@@ -24,77 +26,56 @@ public:
 	template<typename... Args>
 	void AddMessage(std::string_view format, Args&&... args)
 	{
-		std::string messageString = fmt::vformat(format, fmt::make_format_args(args...));
-		std::cout << messageString << std::endl;
-		m_MessageHistory.push_back(messageString);
+		m_Log.Push({ {}, fmt::vformat(format, fmt::make_format_args(args...)) });
 	}
 
 	template<typename... Args>
 	void AddItalicMessage(std::string_view format, Args&&... args)
 	{
-		std::string messageString = fmt::vformat(format, fmt::make_format_args(args...));
-		MessageInfo info = messageString;
-		info.Italic = true;
-		m_MessageHistory.push_back(info);
-		std::cout << messageString << std::endl;
+		m_Log.Push({ {}, fmt::vformat(format, fmt::make_format_args(args...)), true });
 	}
 
 	template<typename... Args>
 	void AddTaggedMessage(std::string_view tag, std::string_view format, Args&&... args)
 	{
-		std::string messageString = fmt::vformat(format, fmt::make_format_args(args...));
-		m_MessageHistory.push_back(MessageInfo(std::string(tag), messageString));
-		std::cout << '[' << tag << "] " << messageString << std::endl;
+		m_Log.Push({ std::string(tag), fmt::vformat(format, fmt::make_format_args(args...)) });
 	}
 
 	template<typename... Args>
 	void AddMessageWithColor(uint32_t color, std::string_view format, Args&&... args)
 	{
-		std::string messageString = fmt::vformat(format, fmt::make_format_args(args...));
-		m_MessageHistory.push_back(MessageInfo(messageString, color));
-		std::cout << messageString << std::endl;
+		m_Log.Push({ {}, fmt::vformat(format, fmt::make_format_args(args...)), false, color });
 	}
 
 	template<typename... Args>
 	void AddItalicMessageWithColor(uint32_t color, std::string_view format, Args&&... args)
 	{
-		std::string messageString = fmt::vformat(format, fmt::make_format_args(args...));
-		MessageInfo info(messageString, color);
-		info.Italic = true;
-		m_MessageHistory.push_back(info);
-		std::cout << messageString << std::endl;
+		m_Log.Push({ {}, fmt::vformat(format, fmt::make_format_args(args...)), true, color });
 	}
 
 	template<typename... Args>
 	void AddTaggedMessageWithColor(uint32_t color, std::string_view tag, std::string_view format, Args&&... args)
 	{
-		std::string messageString = fmt::vformat(format, fmt::make_format_args(args...));
-		m_MessageHistory.push_back(MessageInfo(std::string(tag), messageString, color));
-		std::cout << '[' << tag << "] " << messageString << std::endl;
+		m_Log.Push({ std::string(tag), fmt::vformat(format, fmt::make_format_args(args...)), false, color });
 	}
 
+	// Messages kept in the history; the oldest are discarded beyond this
+	void SetHistoryRetention(uint32_t retention) { m_Log.SetHistoryRetention(retention); }
+	uint32_t GetHistoryRetention() const { return m_Log.GetHistoryRetention(); }
+	std::vector<Cubed::LogRecord> GetMessageHistory() const { return m_Log.GetHistory(); }
+	// Messages lost because they were logged faster than the terminal took them
+	uint64_t GetDroppedMessageCount() const { return m_Log.GetDroppedCount(); }
+
 	void OnUIRender() {}
 
 	void SetMessageSendCallback(const MessageSendCallback& callback);
 private:
 	void InputThreadFunc();
 private:
-	struct MessageInfo
-	{
-		std::string Tag;
-		std::string Message;
-		bool Italic = false;
-		uint32_t Color = 0xffffffff;
-
-		MessageInfo(const std::string& message, uint32_t color = 0xffffffff)
-			: Message(message), Color(color) {}
-
-		MessageInfo(const std::string& tag, const std::string& message, uint32_t color = 0xffffffff)
-			: Tag(tag), Message(message), Color(color) {}
-	};
-
 	std::string m_Title;
-	std::vector<MessageInfo> m_MessageHistory;
+	// Messages are formatted on the calling thread, then queued and written out by the log's own
+	// thread, so logging never blocks on the terminal
+	Cubed::AsyncLog m_Log;
 
 	std::thread m_InputThread;
 	bool m_InputThreadRunning = false;
@@ -0,0 +1,65 @@
+#include "InterestManager.h"
+
+namespace Cubed
+{
+	InterestManager::InterestManager(float radius, float cellSize)
+		: m_Grid(cellSize), m_Radius(radius)
+	{
+	}
+
+	void InterestManager::AddObserver(uint32_t observerID)
+	{
+		m_Observers[observerID];
+	}
+
+	void InterestManager::RemoveObserver(uint32_t observerID)
+	{
+		m_Observers.erase(observerID);
+	}
+
+	std::pair<uint32_t, uint32_t> InterestManager::UpdateObserver(uint32_t observerID, const glm::vec2& position)
+	{
+		uint32_t enteredCount = 0, leftCount = 0;
+
+		auto it = m_Observers.find(observerID);
+		if (it == m_Observers.end())
+			return { enteredCount, leftCount };
+
+		std::unordered_set<uint32_t>& relevantEntities = it->second;
+
+		// Drop entities that despawned or moved past the leave radius
+		float leaveRadius = m_Radius * LeaveRadiusFactor;
+		float leaveRadiusSquared = leaveRadius * leaveRadius;
+		for (auto entityIt = relevantEntities.begin(); entityIt != relevantEntities.end();)
+		{
+			const glm::vec2* entityPosition = m_Grid.GetPosition(*entityIt);
+			glm::vec2 offset = entityPosition ? *entityPosition - position : glm::vec2(0.0f);
+			if (!entityPosition || offset.x * offset.x + offset.y * offset.y > leaveRadiusSquared)
+			{
+				leftCount++;
+				entityIt = relevantEntities.erase(entityIt);
+			}
+			else
+			{
+				++entityIt;
+			}
+		}
+
+		m_Grid.QueryRadius(position, m_Radius, [&](uint32_t entityID, const glm::vec2&)
+		{
+			if (relevantEntities.insert(entityID).second)
+				enteredCount++;
+		});
+
+		return { enteredCount, leftCount };
+	}
+
+	const std::unordered_set<uint32_t>& InterestManager::GetRelevantEntities(uint32_t observerID) const
+	{
+		static const std::unordered_set<uint32_t> s_Empty;
+
+		auto it = m_Observers.find(observerID);
+		return it != m_Observers.end() ? it->second : s_Empty;
+	}
+
+}
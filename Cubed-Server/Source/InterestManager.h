@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "SpatialHashGrid.h"
+
+namespace Cubed
+{
+	//
+	// InterestManager - tracks, per observer (client), which entities are close
+	// enough to be replicated. Entities enter at Radius and only leave beyond
+	// Radius * LeaveRadiusFactor so players on the edge don't flicker in and out.
+	//
+	class InterestManager
+	{
+	public:
+		static constexpr float LeaveRadiusFactor = 1.1f;
+	public:
+		InterestManager(float radius = 1024.0f, float cellSize = 512.0f);
+
+		void SetRadius(float radius) { m_Radius = radius; }
+		float GetRadius() const { return m_Radius; }
+
+		void UpdateEntity(uint32_t entityID, const glm::vec2& position) { m_Grid.Update(entityID, position); }
+		void RemoveEntity(uint32_t entityID) { m_Grid.Remove(entityID); }
+
+		void AddObserver(uint32_t observerID);
+		void RemoveObserver(uint32_t observerID);
+
+		// Diffs the observer's relevant set against what is around position now,
+		// rather than rebuilding it. Returns how many entities entered/left. Different observers
+		// may be updated at the same time, as long as nothing changes the grid or adds/removes observers.
+		std::pair<uint32_t, uint32_t> UpdateObserver(uint32_t observerID, const glm::vec2& position);
+		const std::unordered_set<uint32_t>& GetRelevantEntities(uint32_t observerID) const;
+
+		const SpatialHashGrid& GetGrid() const { return m_Grid; }
+	private:
+		SpatialHashGrid m_Grid;
+		float m_Radius;
+
+		std::unordered_map<uint32_t, std::unordered_set<uint32_t>> m_Observers;
+	};
+
+}
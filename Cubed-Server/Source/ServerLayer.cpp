@@ -2,21 +2,60 @@
 #include "Walnut/Core/Log.h"
 #include "Walnut/Serialization/BufferStream.h"
 #include "ServerPacket.h"
+#include "PacketBuffer.h"
+#include "PacketLayouts.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
 
 namespace Cubed
 {
-	static Walnut::Buffer s_ScratchBuffer;
+	// Seconds between periodic tick stat reports
+	static constexpr uint32_t s_TickStatsReportInterval = 10;
 
-	void ServerLayer::OnAttach()
+	// Seconds between metrics file exports, and where they go
+	static constexpr uint32_t s_MetricsExportInterval = 15;
+	static constexpr const char* s_MetricsExportPath = "CubedServerMetrics.prom";
+
+	// Weight of each new RTT sample in the smoothed value
+	static constexpr float s_RoundTripTimeSmoothing = 0.1f;
+
+	static const glm::vec2 s_SpawnPosition = { 50.0f, 50.0f };
+
+	// Packets per second each client may send, and how many it may send back-to-back. Clients send
+	// inputs at (tick rate / InputsPerPacket), 15/s at the default 30Hz, so this leaves room for the rest.
+	static constexpr float s_MaxClientPacketRate = 60.0f;
+	static constexpr float s_ClientPacketBurst = 20.0f;
+
+	// Work per job when the tick splits players or clients across the job pool
+	static constexpr uint32_t s_PlayersPerJob = 4096;
+	static constexpr uint32_t s_ClientsPerJob = 4;
+
+	// Whether a multiple of period lies in (from, to]. Skipped ticks leave gaps in the tick
+	// numbers, so periodic work can't just test the current tick against the period.
+	static bool PassedMultiple(uint64_t from, uint64_t to, uint64_t period)
 	{
-		s_ScratchBuffer.Allocate(10 * 1024 * 1024);
+		return from / period != to / period;
+	}
 
+	void ServerLayer::OnAttach()
+	{
 		m_Console.SetMessageSendCallback([this](std::string_view message) {OnConsoleMessage(message); });
 
 		m_Server.SetClientConnectedCallback([this](const Walnut::ClientInfo& clientInfo) {OnClientConnected(clientInfo); });
 		m_Server.SetClientDisconnectedCallback([this](const Walnut::ClientInfo& clientInfo) {OnClientDisconnected(clientInfo); });
 		m_Server.SetDataReceivedCallback([this](const Walnut::ClientInfo& clientInfo, const Walnut::Buffer buffer) {OnDataReceived(clientInfo, buffer); });
 
+		m_ChunkStreamer.SetSendCallback([this](uint32_t clientID, Walnut::Buffer buffer) {SendBufferToClient(clientID, buffer); });
+
+		// Console chat goes out as "Server"
+		m_Roster.ReserveUsername("Server");
+
+		UpdateSnapshotInterval();
+		BuildTickGraph();
+
 		m_Server.Start();
 	}
 
@@ -27,18 +66,445 @@ namespace Cubed
 
 	void ServerLayer::OnUpdate(float ts)
 	{
-		m_PlayerDataMutex.lock();
+		uint32_t requestedTickRate = m_RequestedTickRate.exchange(0);
+		if (requestedTickRate)
+		{
+			m_TickScheduler.SetTickRate(requestedTickRate);
+			UpdateSnapshotInterval();
+			WL_INFO_TAG("Server", "Tick rate set to {}Hz", m_TickScheduler.GetTickRate());
+		}
+
+		uint32_t requestedSnapshotRate = m_RequestedSnapshotRate.exchange(0);
+		if (requestedSnapshotRate)
+		{
+			m_SnapshotRate = requestedSnapshotRate;
+			UpdateSnapshotInterval();
+			WL_INFO_TAG("Server", "Snapshot rate set to {}Hz (every {} ticks)", m_SnapshotRate, m_SnapshotInterval);
+		}
+
+		float requestedInterestRadius = m_RequestedInterestRadius.exchange(0.0f);
+		if (requestedInterestRadius > 0.0f)
+		{
+			m_InterestManager.SetRadius(requestedInterestRadius);
+			WL_INFO_TAG("Server", "Interest radius set to {}", requestedInterestRadius);
+		}
+
+		uint64_t startedTick = m_TickScheduler.BeginTick();
+		uint32_t tick = (uint32_t)startedTick;
+
+		ProcessInboundEvents(tick);
+
+		m_CurrentTick = tick;
+		m_TickClients.clear();
+		for (auto& [id, session] : m_ClientSessions)
+			m_TickClients.emplace_back(id, &session);
+
+		m_TickGraph.Run(m_JobPool);
+		RecordClientMetrics();
+		FlushFrames();
+
+		m_TickScheduler.EndTick();
+		m_Metrics.GetTickDurationHistogram().Record(m_TickScheduler.GetStats().LastTickDuration);
+
+		if (m_PrintStatsRequested.exchange(false))
+			m_Console.AddTaggedMessage("Server", "{}", m_Metrics.FormatSummary());
+
+		uint64_t nextTick = m_TickScheduler.GetCurrentTick();
+		if (PassedMultiple(startedTick, nextTick, m_TickScheduler.GetTickRate() * s_MetricsExportInterval))
+		{
+			// Formatted here, where the metrics are owned; the file is written on the exporter's thread
+			m_MetricsExporter.Export(s_MetricsExportPath, m_Metrics.FormatExposition());
+
+			uint64_t failedCount = m_MetricsExporter.GetFailedCount();
+			if (failedCount != m_LastReportedExportFailures)
+			{
+				WL_WARN_TAG("Server", "Failed to export metrics to {} ({} times since the last report)", s_MetricsExportPath, failedCount - m_LastReportedExportFailures);
+				m_LastReportedExportFailures = failedCount;
+			}
+		}
+
+		if (m_PrintTickStatsRequested.exchange(false) || PassedMultiple(startedTick, nextTick, m_TickScheduler.GetTickRate() * s_TickStatsReportInterval))
+			ReportTickStats();
+	}
+
+	void ServerLayer::ProcessInboundEvents(uint32_t tick)
+	{
+		for (auto& [id, session] : m_ClientSessions)
+			session.Metrics.InputsLastTick = 0;
+
+		TickScheduler::Clock::time_point now = TickScheduler::Clock::now();
+
+		uint32_t eventCount = m_InboundEvents.Drain([&](const InboundEvent& event)
+		{
+			switch (event.Type)
+			{
+			case InboundEvent::EventType::ClientConnected:
+			{
+				PlayerID playerID = m_Players.Create();
+				if (playerID == InvalidPlayerID)
+				{
+					// Every player slot is taken. Turn the client away before anything refers to it.
+					WL_ERROR_TAG("Server", "No player slot left for client {}, disconnecting it", event.ClientID);
+					ForgetClient(event.ClientID);
+					m_Server.KickClient(event.ClientID);
+					break;
+				}
+
+				// No acknowledged baseline yet, so the first snapshot this client gets is a full one
+				m_Players.Set(playerID, { s_SpawnPosition, { 0.0f, 0.0f } });
+				m_ClientSessions[event.ClientID].Player = playerID;
+				m_InterestManager.AddObserver(event.ClientID);
+				m_ChunkStreamer.AddClient(event.ClientID);
+
+				WL_INFO_TAG("Server", "Client connected! ID={} PlayerID={}", event.ClientID, playerID);
+
+				PacketStreamWriter& stream = GetThreadPacketWriter();
+				WritePacket<ClientConnectPacket>(stream, 0u); // not a roster change
+				WritePacket<OwnPlayerRecord>(stream, playerID);
+				SendBufferToClient(event.ClientID, stream.GetBuffer());
+				break;
+			}
+			case InboundEvent::EventType::ClientDisconnected:
+			{
+				auto sessionIt = m_ClientSessions.find(event.ClientID);
+				if (sessionIt == m_ClientSessions.end())
+					break;
+
+				m_Players.Remove(sessionIt->second.Player);
+				m_InterestManager.RemoveEntity(sessionIt->second.Player);
+				m_InterestManager.RemoveObserver(event.ClientID);
+				m_ChunkStreamer.RemoveClient(event.ClientID);
+				m_Metrics.RemoveClient(event.ClientID);
+				m_ClientSessions.erase(sessionIt);
+				break;
+			}
+			case InboundEvent::EventType::ClientUpdate:
+			{
+				auto sessionIt = m_ClientSessions.find(event.ClientID);
+				if (sessionIt == m_ClientSessions.end())
+					break;
+
+				ClientSession& session = sessionIt->second;
+				session.Metrics.InputsLastTick++;
+
+				// Only the first ack of a snapshot is a fresh sample. It includes up to one client
+				// frame and one tick of queueing on top of the network round trip.
+				uint32_t ack = event.AckedSnapshotTick;
+				bool isNewAck = ack != InvalidSnapshotTick && (session.AckedSnapshotTick == InvalidSnapshotTick || (int32_t)(ack - session.AckedSnapshotTick) > 0);
+				if (isNewAck && tick - ack <= SnapshotHistory::Capacity)
+				{
+					float roundTripTime = std::chrono::duration<float, std::milli>(now - session.SnapshotSendTimes[ack % SnapshotHistory::Capacity]).count();
+					if (session.Metrics.RoundTripTime == 0.0f)
+						session.Metrics.RoundTripTime = roundTripTime;
+					else
+						session.Metrics.RoundTripTime += (roundTripTime - session.Metrics.RoundTripTime) * s_RoundTripTimeSmoothing;
+				}
+
+				session.AckedSnapshotTick = ack;
+				session.Inputs.Push(event.Inputs.data(), event.InputCount);
+				m_ChunkStreamer.Acknowledge(event.ClientID, event.AckedChunkSequence);
+				break;
+			}
+			}
+		});
+
+		// One input per client per tick, in order, just like the client stepped through them when
+		// predicting. If none arrived in time the previous one stays in effect.
+		for (auto& [id, session] : m_ClientSessions)
+		{
+			PlayerInput input;
+			if (session.Inputs.Pop(input))
+			{
+				uint32_t playerIndex = m_Players.GetDenseIndex(session.Player);
+				if (playerIndex != PlayerStore::InvalidIndex)
+					m_Players.GetInputDirections()[playerIndex] = GetInputDirection(input);
+
+				session.LastInputSequence = input.Sequence;
+				session.HasReceivedInput = true;
+			}
+
+			session.Metrics.BufferedInputs = session.Inputs.GetCount();
+		}
+
+		m_Metrics.GetInboundEventsHistogram().Record(eventCount);
+	}
+
+	void ServerLayer::BuildTickGraph()
+	{
+		// Movement only reads each player's own input direction, so it splits over player ranges
+		JobGraph::JobID integrate = m_TickGraph.Add([this]() { IntegratePlayers(); });
+		// Writes m_TickPlayers, which everything after reads
+		JobGraph::JobID quantize = m_TickGraph.Add([this]() { QuantizePlayers(); }, { integrate });
+		// Writes the interest grid. Chunk streaming doesn't use it, so the two overlap.
+		JobGraph::JobID interest = m_TickGraph.Add([this]() { UpdateInterestGrid(); }, { quantize });
+		// Writes m_ChunkStreamer only; generating chunks runs as more jobs on the same pool
+		m_TickGraph.Add([this]() { StreamChunks(); }, { quantize });
+		// Writes each client's session and relevant set, one client per job
+		m_TickGraph.Add([this]() { SendSnapshots(); }, { interest });
+	}
+
+	void ServerLayer::IntegratePlayers()
+	{
+		// The kernel handles any range alike, so splitting it doesn't change a bit of the result
+		uint32_t count = m_Players.GetCount();
+		uint32_t jobCount = (count + s_PlayersPerJob - 1) / s_PlayersPerJob;
+		m_JobPool.ParallelFor(jobCount, 1, [&](uint32_t job)
+		{
+			uint32_t begin = job * s_PlayersPerJob;
+			uint32_t end = std::min(begin + s_PlayersPerJob, count);
+			IntegrateMovement(m_Players.GetPositions().data() + begin, m_Players.GetVelocities().data() + begin, m_Players.GetInputDirections().data() + begin,
+				end - begin, m_TickScheduler.GetTimestep());
+		});
+	}
+
+	void ServerLayer::QuantizePlayers()
+	{
+		// Dense arrays, so this is a handful of memcpys rather than a tree walk
+		m_TickPlayers = m_Players;
+
+		std::vector<glm::vec2>& positions = m_TickPlayers.GetPositions();
+		std::vector<glm::vec2>& velocities = m_TickPlayers.GetVelocities();
+		m_JobPool.ParallelFor(m_TickPlayers.GetCount(), s_PlayersPerJob, [&](uint32_t i)
+		{
+			PlayerData quantized = QuantizePlayerData({ positions[i], velocities[i] });
+			positions[i] = quantized.Position;
+			velocities[i] = quantized.Velocity;
+		});
+	}
+
+	void ServerLayer::UpdateInterestGrid()
+	{
+		const std::vector<PlayerID>& playerIDs = m_TickPlayers.GetIDs();
+		const std::vector<glm::vec2>& positions = m_TickPlayers.GetPositions();
+		for (uint32_t i = 0; i < m_TickPlayers.GetCount(); i++)
+			m_InterestManager.UpdateEntity(playerIDs[i], positions[i]);
+	}
+
+	void ServerLayer::SendSnapshots()
+	{
+		// Simulation runs every tick, but snapshots only go out every m_SnapshotInterval ticks
+		uint32_t tick = m_CurrentTick;
+		if (m_LastSnapshotTick != InvalidSnapshotTick && !PassedMultiple(m_LastSnapshotTick, tick, m_SnapshotInterval))
+			return;
+
+		m_LastSnapshotTick = tick;
+
+		// Each snapshot depends only on its own client's session and this tick's (read-only) world, so
+		// which thread builds it, or when, doesn't change a byte. Sending is safe from any thread.
+		const std::vector<glm::vec2>& positions = m_TickPlayers.GetPositions();
+		m_JobPool.ParallelFor((uint32_t)m_TickClients.size(), s_ClientsPerJob, [&](uint32_t i)
+		{
+			auto [id, sessionPointer] = m_TickClients[i];
+			ClientSession& client = *sessionPointer;
+
+			uint32_t playerIndex = m_TickPlayers.GetDenseIndex(client.Player);
+			if (playerIndex == PlayerStore::InvalidIndex)
+				return;
+
+			m_InterestManager.UpdateObserver(id, positions[playerIndex]);
+
+			TickScheduler::Clock::time_point serializationStart = TickScheduler::Clock::now();
+
+			auto snapshot = std::make_shared<WorldSnapshot>();
+			snapshot->Tick = tick;
+			snapshot->TickRate = m_TickScheduler.GetTickRate();
+			snapshot->SnapshotInterval = m_SnapshotInterval;
+			snapshot->HasLastInputSequence = client.HasReceivedInput;
+			snapshot->LastInputSequence = client.LastInputSequence;
+			for (PlayerID entityID : m_InterestManager.GetRelevantEntities(id))
+				snapshot->Players.emplace(entityID, m_TickPlayers.Get(entityID));
+
+			// Spawn/despawn records fall out of diffing against what this client last acknowledged
+			const WorldSnapshot* baseline = client.SentSnapshots.Find(client.AckedSnapshotTick);
+
+			PacketStreamWriter& stream = GetThreadPacketWriter();
+			stream.Reset();
+			WritePacket<ClientUpdatePacket>(stream);
+			BitWriter writer(stream);
+			WriteSnapshotDelta(writer, baseline, *snapshot);
+			writer.Flush();
+
+			if (!stream)
+			{
+				// Not recorded as sent either, so the next delta still uses the old baseline
+				WL_WARN_TAG("Server", "Snapshot for client {} exceeds the maximum packet size, dropping it", id);
+				return;
+			}
+
+			TickScheduler::Clock::time_point sendTime = TickScheduler::Clock::now();
+			client.SerializationTime = std::chrono::duration<double, std::milli>(sendTime - serializationStart).count();
+
+			SendBufferToClient(id, stream.GetBuffer());
+			client.SentSnapshots.Push(std::move(snapshot));
+			client.SnapshotSendTimes[tick % SnapshotHistory::Capacity] = sendTime;
+			client.SnapshotsSent++;
+
+			if (client.AckedSnapshotTick != InvalidSnapshotTick)
+				client.Metrics.PendingSnapshots = (tick - client.AckedSnapshotTick) / m_SnapshotInterval;
+			else
+				client.Metrics.PendingSnapshots = std::min(client.SnapshotsSent, SnapshotHistory::Capacity);
+		});
+	}
+
+	void ServerLayer::StreamChunks()
+	{
+		const std::vector<glm::vec2>& positions = m_TickPlayers.GetPositions();
+		const std::vector<glm::vec2>& velocities = m_TickPlayers.GetVelocities();
+		for (auto [id, client] : m_TickClients)
+		{
+			uint32_t playerIndex = m_TickPlayers.GetDenseIndex(client->Player);
+			if (playerIndex != PlayerStore::InvalidIndex)
+				m_ChunkStreamer.UpdateClient(id, positions[playerIndex], velocities[playerIndex]);
+		}
+
+		m_ChunkStreamer.Update();
+	}
+
+	void ServerLayer::RecordClientMetrics()
+	{
+		for (auto [id, client] : m_TickClients)
+		{
+			ChunkStreamStats stats = m_ChunkStreamer.GetClientStats(id);
+			client->Metrics.HeldChunks = stats.HeldChunks;
+			client->Metrics.PendingChunks = stats.PendingChunks;
+			client->Metrics.ChunkBytesInFlight = stats.BytesInFlight;
+
+			if (client->SerializationTime >= 0.0)
+			{
+				m_Metrics.GetSerializationTimeHistogram().Record(client->SerializationTime);
+				client->SerializationTime = -1.0;
+			}
 
-		Walnut::BufferStreamWriter stream(s_ScratchBuffer);
-		stream.WriteRaw(PacketType::ClientUpdate);
-		stream.WriteMap(m_PlayerData);
+			m_Metrics.SetClientMetrics(id, client->Metrics);
+		}
+	}
+
+	void ServerLayer::UpdateSnapshotInterval()
+	{
+		uint32_t tickRate = m_TickScheduler.GetTickRate();
+		m_SnapshotInterval = std::max((tickRate + m_SnapshotRate / 2) / m_SnapshotRate, 1u);
+	}
 
-		m_PlayerDataMutex.unlock();
+	void ServerLayer::SendBufferToClient(uint32_t clientID, Walnut::Buffer buffer)
+	{
+		std::shared_lock<std::shared_mutex> lock(m_FramesMutex);
+		auto it = m_ClientFrames.find(clientID);
+		if (it == m_ClientFrames.end())
+			return; // disconnected; the tick hasn't caught up yet
+
+		if (buffer.Size >= sizeof(PacketType))
+			m_Metrics.RecordSent(buffer.Read<PacketType>(), buffer.Size);
+
+		ClientFrame& frame = *it->second;
+		std::scoped_lock<std::mutex> frameLock(frame.Mutex);
+		frame.Builder.Add(buffer);
+	}
+
+	void ServerLayer::SendBufferToClient(uint32_t clientID, const SharedPacket& packet)
+	{
+		std::shared_lock<std::shared_mutex> lock(m_FramesMutex);
+		auto it = m_ClientFrames.find(clientID);
+		if (it == m_ClientFrames.end())
+			return;
 
-		m_Server.SendBufferToAllClients(stream.GetBuffer());
+		Walnut::Buffer buffer = packet.GetBuffer();
+		if (buffer.Size >= sizeof(PacketType))
+			m_Metrics.RecordSent(buffer.Read<PacketType>(), buffer.Size);
 
-		using namespace std::chrono_literals;
-		std::this_thread::sleep_for(5ms);
+		ClientFrame& frame = *it->second;
+		std::scoped_lock<std::mutex> frameLock(frame.Mutex);
+		frame.Builder.Add(packet);
+	}
+
+	void ServerLayer::FlushFrames()
+	{
+		std::shared_lock<std::shared_mutex> lock(m_FramesMutex);
+		for (auto& [clientID, frame] : m_ClientFrames)
+		{
+			std::scoped_lock<std::mutex> frameLock(frame->Mutex);
+			frame->Builder.Flush([&](Walnut::Buffer packet, uint32_t messageCount)
+			{
+				m_Server.SendBufferToClient(clientID, packet);
+				m_Metrics.GetMessagesPerFrameHistogram().Record(messageCount);
+			});
+		}
+	}
+
+	void ServerLayer::BroadcastChatMessage(std::string_view username, std::string_view text)
+	{
+		// Serialized once; every client's frame references the same bytes. Sent under the lock so clients see IDs in order.
+		std::scoped_lock<std::mutex> lock(m_ChatMutex);
+		SharedPacket packet = m_ChatHistory.Add(username, text);
+		for (uint32_t clientID : m_ChatRecipients)
+			SendBufferToClient(clientID, packet);
+
+		WL_INFO_TAG("Chat", "{}: {}", username, TruncateUTF8(text, MaxChatMessageLength));
+	}
+
+	void ServerLayer::JoinRoster(uint32_t clientID, uint32_t color, std::string_view username, uint32_t rosterEpoch, uint32_t rosterVersion)
+	{
+		// The reply, the change going out to everyone else and this client's catch-up all happen under
+		// the lock, so no later change can reach this client before the roster it applies to
+		std::scoped_lock<std::mutex> lock(m_RosterMutex);
+		SharedPacket change = m_Roster.Add(clientID, color, username);
+
+		PacketStreamWriter& stream = GetThreadPacketWriter();
+		WritePacket<ConnectionResponse>(stream, (bool)change, change ? clientID : 0);
+		SendBufferToClient(clientID, stream.GetBuffer());
+
+		if (!change)
+		{
+			WL_INFO_TAG("Server", "Client {} can't join as \"{}\"", clientID, username);
+			return;
+		}
+
+		BroadcastRosterChange(change, clientID);
+		m_Roster.CatchUp(rosterEpoch, rosterVersion, [&](Walnut::Buffer buffer) {SendBufferToClient(clientID, buffer); });
+
+		WL_INFO_TAG("Server", "{} joined (ID={}, {} in roster)", username, clientID, m_Roster.GetCount());
+	}
+
+	void ServerLayer::LeaveRoster(uint32_t clientID)
+	{
+		std::scoped_lock<std::mutex> lock(m_RosterMutex);
+		SharedPacket change = m_Roster.Remove(clientID);
+		if (change)
+			BroadcastRosterChange(change, clientID);
+	}
+
+	void ServerLayer::BroadcastRosterChange(const SharedPacket& change, uint32_t excludedClientID)
+	{
+		for (const auto& [clientID, entry] : m_Roster.GetEntries())
+		{
+			if (clientID != excludedClientID)
+				SendBufferToClient(clientID, change);
+		}
+	}
+
+	void ServerLayer::ReportTickStats()
+	{
+		const TickStats& stats = m_TickScheduler.GetStats();
+		bool overloaded = stats.OverrunCount > m_LastReportedOverrunCount || stats.SkippedTicks > m_LastReportedSkippedTicks;
+
+		std::string message = fmt::format("Tick {} @ {}Hz ({}): duration avg={:.2f}ms max={:.2f}ms, lateness avg={:.2f}ms max={:.2f}ms, overruns={}, skipped={}",
+			m_TickScheduler.GetCurrentTick(), m_TickScheduler.GetTickRate(), TickOverrunPolicyToString(m_TickScheduler.GetOverrunPolicy()),
+			stats.AverageTickDuration, stats.MaxTickDuration, stats.AverageLateness, stats.MaxLateness, stats.OverrunCount, stats.SkippedTicks);
+
+		uint64_t droppedInboundUpdates = m_DroppedInboundUpdates.load(std::memory_order_relaxed);
+		if (droppedInboundUpdates > m_LastReportedDroppedInboundUpdates)
+		{
+			message += fmt::format(", dropped inputs={}", droppedInboundUpdates - m_LastReportedDroppedInboundUpdates);
+			overloaded = true;
+		}
+
+		if (overloaded)
+			WL_WARN_TAG("Server", "{}", message);
+		else
+			m_Console.AddTaggedMessage("Server", "{}", message);
+
+		m_LastReportedOverrunCount = stats.OverrunCount;
+		m_LastReportedSkippedTicks = stats.SkippedTicks;
+		m_LastReportedDroppedInboundUpdates = droppedInboundUpdates;
 	}
 
 	void ServerLayer::OnUIRender()
@@ -48,50 +514,242 @@ namespace Cubed
 
 	void ServerLayer::OnConsoleMessage(std::string_view message)
 	{
-		if (message.starts_with('/'))
+		if (!message.starts_with('/'))
+		{
+			if (!message.empty())
+				BroadcastChatMessage("Server", message);
+			return;
+		}
+
+		std::string_view command = message.substr(1, message.find(' ') - 1);
+		std::string_view argument = message.size() > command.size() + 2 ? message.substr(command.size() + 2) : std::string_view();
+
+		if (command == "tickrate")
 		{
-			std::cout << "You called the " << message << " command!\n";
+			uint32_t tickRate = 0;
+			std::from_chars(argument.data(), argument.data() + argument.size(), tickRate);
+			if (tickRate == 0 || tickRate > 1000)
+			{
+				m_Console.AddTaggedMessage("Server", "Usage: /tickrate <1-1000>");
+				return;
+			}
+
+			// Applied by the tick thread at the start of the next tick
+			m_RequestedTickRate = tickRate;
+		}
+		else if (command == "snapshotrate")
+		{
+			uint32_t snapshotRate = 0;
+			std::from_chars(argument.data(), argument.data() + argument.size(), snapshotRate);
+			if (snapshotRate == 0 || snapshotRate > 1000)
+			{
+				m_Console.AddTaggedMessage("Server", "Usage: /snapshotrate <1-1000>");
+				return;
+			}
+
+			m_RequestedSnapshotRate = snapshotRate;
+		}
+		else if (command == "tickstats")
+		{
+			m_PrintTickStatsRequested = true;
+		}
+		else if (command == "stats")
+		{
+			// Client metrics are owned by the tick, so it prints them
+			m_PrintStatsRequested = true;
+		}
+		else if (command == "interestradius")
+		{
+			uint32_t radius = 0;
+			std::from_chars(argument.data(), argument.data() + argument.size(), radius);
+			if (radius == 0)
+			{
+				m_Console.AddTaggedMessage("Server", "Usage: /interestradius <units>");
+				return;
+			}
+
+			m_RequestedInterestRadius = (float)radius;
+		}
+		else if (command == "logretention")
+		{
+			uint32_t retention = 0;
+			std::from_chars(argument.data(), argument.data() + argument.size(), retention);
+			if (retention == 0)
+			{
+				m_Console.AddTaggedMessage("Server", "Usage: /logretention <messages>");
+				return;
+			}
+
+			m_Console.SetHistoryRetention(retention);
+			m_Console.AddTaggedMessage("Server", "Keeping the last {} console messages ({} dropped so far)", retention, m_Console.GetDroppedMessageCount());
+		}
+		else
+		{
+			m_Console.AddTaggedMessage("Server", "You called the {} command!", message);
 		}
 	}
 
 	void ServerLayer::OnClientConnected(const Walnut::ClientInfo& clientInfo)
 	{
-		WL_INFO_TAG("Server", "Client connected! ID={}", clientInfo.ID);
-
-		Walnut::BufferStreamWriter stream(s_ScratchBuffer);
+		m_PacketRateLimits[clientInfo.ID] = { s_ClientPacketBurst, TickScheduler::Clock::now() };
 
-		stream.WriteRaw(PacketType::ClientConnect);
-		stream.WriteRaw(clientInfo.ID);
+		{
+			std::scoped_lock<std::shared_mutex> lock(m_FramesMutex);
+			m_ClientFrames[clientInfo.ID] = std::make_unique<ClientFrame>();
+		}
 
+		{
+			std::scoped_lock<std::mutex> lock(m_ChatMutex);
+			m_ChatRecipients.push_back(clientInfo.ID);
+		}
 
-		m_Server.SendBufferToClient(clientInfo.ID, stream.GetBuffer() );
+		PushLifecycleEvent({ InboundEvent::EventType::ClientConnected, clientInfo.ID });
 	}
 
 	void ServerLayer::OnClientDisconnected(const Walnut::ClientInfo& clientInfo)
 	{
 		WL_INFO_TAG("Server", "Client disconnected! ID={}", clientInfo.ID);
 
+		m_PacketRateLimits.erase(clientInfo.ID);
+		ForgetClient(clientInfo.ID);
+
+		PushLifecycleEvent({ InboundEvent::EventType::ClientDisconnected, clientInfo.ID });
+	}
+
+	void ServerLayer::ForgetClient(uint32_t clientID)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_ChatMutex);
+			std::erase(m_ChatRecipients, clientID);
+		}
+
+		LeaveRoster(clientID);
+
+		{
+			// Whatever was still queued for the client goes with it
+			std::scoped_lock<std::shared_mutex> lock(m_FramesMutex);
+			m_ClientFrames.erase(clientID);
+		}
+	}
+
+	void ServerLayer::PushLifecycleEvent(const InboundEvent& event)
+	{
+		// Losing a connect or disconnect would leak or orphan a player, so wait for the tick to make room
+		while (!m_InboundEvents.Push(event))
+			std::this_thread::yield();
 	}
 
 	void ServerLayer::OnDataReceived(const Walnut::ClientInfo& clientInfo, const Walnut::Buffer buffer)
 	{
-		Walnut::BufferStreamReader stream(buffer);
-		PacketType type;
-		stream.ReadRaw(type);
+		// Each case reads through a PacketView, which drops the packet unless it matches its layout exactly
+		PacketType type = PacketType::None;
+		if (buffer.Size >= sizeof(PacketType))
+			std::memcpy(&type, buffer.Data, sizeof(type));
+
+		m_Metrics.RecordReceived(type, buffer.Size);
+
+		if (!ConsumePacketToken(clientInfo.ID))
+		{
+			m_Metrics.RecordRateLimited(type);
+			return;
+		}
+
 		switch (type)
 		{
+		case PacketType::Message:
+		{
+			PacketView<ChatMessageRequest> request(buffer);
+			if (!request || request.Get<ChatMessageRequest::Text>().empty())
+				break;
+
+			// Only clients that joined the roster have a name to chat under
+			std::string username;
+			{
+				std::scoped_lock<std::mutex> lock(m_RosterMutex);
+				if (const RosterEntry* entry = m_Roster.Find(clientInfo.ID))
+					username = entry->Username;
+			}
+
+			if (!username.empty())
+				BroadcastChatMessage(username, request.Get<ChatMessageRequest::Text>());
+			break;
+		}
+		case PacketType::ClientConnectionRequest:
+		{
+			PacketView<ConnectionRequest> request(buffer);
+			if (!request)
+				break;
+
+			JoinRoster(clientInfo.ID, request.Get<ConnectionRequest::Color>(), request.Get<ConnectionRequest::Username>(),
+				request.Get<ConnectionRequest::RosterEpoch>(), request.Get<ConnectionRequest::RosterVersion>());
+			break;
+		}
+		case PacketType::ClientList:
+		{
+			PacketView<ClientListRequest> request(buffer);
+			if (!request)
+				break;
+
+			std::scoped_lock<std::mutex> lock(m_RosterMutex);
+			if (m_Roster.Find(clientInfo.ID))
+				m_Roster.CatchUp(request.Get<ClientListRequest::RosterEpoch>(), request.Get<ClientListRequest::RosterVersion>(), [&](Walnut::Buffer buffer) {SendBufferToClient(clientInfo.ID, buffer); });
+			break;
+		}
+		case PacketType::MessageHistory:
+		{
+			PacketView<MessageHistoryRequest> request(buffer);
+			if (!request)
+				break;
+
+			PacketStreamWriter& writer = GetThreadPacketWriter();
+			{
+				std::scoped_lock<std::mutex> lock(m_ChatMutex);
+				m_ChatHistory.WritePage(writer, request.Get<MessageHistoryRequest::AfterID>());
+			}
+			SendBufferToClient(clientInfo.ID, writer.GetBuffer());
+			break;
+		}
 		case PacketType::ClientUpdate:
+		{
+			PacketView<ClientUpdatePacket> update(buffer);
+			if (!update)
+				break;
 
-			m_PlayerDataMutex.lock();
+			InboundEvent event{ InboundEvent::EventType::ClientUpdate, clientInfo.ID };
 
-			PlayerData& playerData = m_PlayerData[clientInfo.ID];
-			stream.ReadRaw<glm::vec2>(playerData.Position);
-			stream.ReadRaw<glm::vec2>(playerData.Velocity);
+			BitReader reader(update.Get<ClientUpdatePacket::Body>());
+			event.InputCount = ReadPlayerInputs(reader, event.Inputs.data());
+			event.AckedSnapshotTick = reader.ReadBits(32);
+			event.AckedChunkSequence = reader.ReadBits(32);
+			if (!reader.IsValid() || event.InputCount == 0)
+				break;
 
-			m_PlayerDataMutex.unlock();
+			// Later packets repeat recent inputs anyway, so drop rather than stall the network thread
+			if (!m_InboundEvents.Push(event))
+				m_DroppedInboundUpdates.fetch_add(1, std::memory_order_relaxed);
 
 			break;
 		}
+		}
+	}
+
+	bool ServerLayer::ConsumePacketToken(uint32_t clientID)
+	{
+		auto it = m_PacketRateLimits.find(clientID);
+		if (it == m_PacketRateLimits.end())
+			return false;
+
+		PacketRateLimit& limit = it->second;
+		TickScheduler::Clock::time_point now = TickScheduler::Clock::now();
+		float elapsed = std::chrono::duration<float>(now - limit.LastRefillTime).count();
+		limit.Tokens = std::min(limit.Tokens + elapsed * s_MaxClientPacketRate, s_ClientPacketBurst);
+		limit.LastRefillTime = now;
+
+		if (limit.Tokens < 1.0f)
+			return false;
+
+		limit.Tokens -= 1.0f;
+		return true;
 	}
 
 }
\ No newline at end of file
@@ -1,10 +1,26 @@
 #pragma once
 #include "Walnut/Layer.h"
 #include "HeadlessConsole.h"
+#include "TickScheduler.h"
+#include "Snapshot.h"
+#include "PlayerStore.h"
+#include "InterestManager.h"
+#include "Movement.h"
+#include "MPSCQueue.h"
+#include "InputQueue.h"
+#include "ServerMetrics.h"
+#include "ChunkStreamer.h"
+#include "ChatHistory.h"
+#include "ClientRoster.h"
+#include "JobPool.h"
+#include "JobGraph.h"
+#include "PacketFrame.h"
 #include "Walnut/Networking/Server.h"
 
 #include "glm/glm.hpp"
 
+#include <shared_mutex>
+
 namespace Cubed {
 	class ServerLayer : public Walnut::Layer
 	{
@@ -21,18 +37,153 @@ namespace Cubed {
 		void OnClientConnected(const Walnut::ClientInfo& clientInfo);
 		void OnClientDisconnected(const Walnut::ClientInfo& clientInfo);
 		void OnDataReceived(const Walnut::ClientInfo& clientInfo, const Walnut::Buffer buffer);
+		// Drops the client from chat, the roster and the frames; idempotent, any thread
+		void ForgetClient(uint32_t clientID);
+
+		void ProcessInboundEvents(uint32_t tick);
+
+		// The tick's work after the inbound events, as jobs on m_JobPool (see BuildTickGraph)
+		void BuildTickGraph();
+		void IntegratePlayers();
+		void QuantizePlayers();
+		void UpdateInterestGrid();
+		void StreamChunks();
+		void SendSnapshots();
+		// Once the tick graph is done, back on the tick thread
+		void RecordClientMetrics();
+		void UpdateSnapshotInterval();
+		void ReportTickStats();
+
+		// All server->client traffic goes through here so it shows up in the metrics. Any thread;
+		// the tick's jobs send snapshots and chunks from the job pool's workers. Messages are
+		// queued in the client's frame and go out together at the end of the tick.
+		void SendBufferToClient(uint32_t clientID, Walnut::Buffer buffer);
+		// For broadcasts: the client's frame keeps a reference rather than a copy (see FrameBuilder)
+		void SendBufferToClient(uint32_t clientID, const SharedPacket& packet);
+		// Tick thread, once the tick's work is done
+		void FlushFrames();
+
+		void BroadcastChatMessage(std::string_view username, std::string_view text);
+
+		void JoinRoster(uint32_t clientID, uint32_t color, std::string_view username, uint32_t rosterEpoch, uint32_t rosterVersion);
+		void LeaveRoster(uint32_t clientID);
+		// Sends a roster change to every joined client except the one it is about
+		void BroadcastRosterChange(const SharedPacket& change, uint32_t excludedClientID);
 	private:
 		HeadlessConsole m_Console;
 		Walnut::Server m_Server{ 8192};
 
-		struct PlayerData
+		TickScheduler m_TickScheduler;
+		std::atomic<uint32_t> m_RequestedTickRate = 0;
+		// Snapshots go out at this rate (rounded to a whole number of ticks); clients interpolate in between
+		uint32_t m_SnapshotRate = 15;
+		uint32_t m_SnapshotInterval = 2; // ticks between snapshots
+		std::atomic<uint32_t> m_RequestedSnapshotRate = 0;
+		std::atomic<bool> m_PrintTickStatsRequested = false;
+		uint64_t m_LastReportedOverrunCount = 0;
+		uint64_t m_LastReportedSkippedTicks = 0;
+
+		ServerMetrics m_Metrics;
+		std::atomic<bool> m_PrintStatsRequested = false;
+		MetricsExporter m_MetricsExporter;
+		uint64_t m_LastReportedExportFailures = 0;
+
+		// Network callbacks only decode packets and push them here; the tick drains
+		// the queue at its start, so simulation state is never shared with the network thread
+		struct InboundEvent
+		{
+			enum class EventType : uint8_t
+			{
+				ClientConnected = 0, ClientDisconnected, ClientUpdate
+			};
+
+			EventType Type = EventType::ClientUpdate;
+			uint32_t ClientID = 0;
+			uint32_t AckedSnapshotTick = InvalidSnapshotTick;
+			uint32_t AckedChunkSequence = 0;
+			uint32_t InputCount = 0;
+			std::array<PlayerInput, MaxInputsPerPacket> Inputs{};
+		};
+
+		void PushLifecycleEvent(const InboundEvent& event);
+
+		MPSCQueue<InboundEvent> m_InboundEvents{ 16384 };
+		std::atomic<uint64_t> m_DroppedInboundUpdates = 0;
+		uint64_t m_LastReportedDroppedInboundUpdates = 0;
+
+		// Token bucket per client, so a misbehaving client can't flood the inbound queue.
+		// Only touched by the network thread (connect, disconnect and receive callbacks).
+		struct PacketRateLimit
 		{
-			glm::vec2 Position;
-			glm::vec2 Velocity;
+			float Tokens = 0.0f;
+			TickScheduler::Clock::time_point LastRefillTime;
 		};
 
-		std::mutex m_PlayerDataMutex;
-		std::map<uint32_t, PlayerData> m_PlayerData;
+		bool ConsumePacketToken(uint32_t clientID);
+
+		std::unordered_map<uint32_t, PacketRateLimit> m_PacketRateLimits;
+
+		// Chat doesn't touch simulation state, so it is handled right on the network thread (and the
+		// console thread for server messages) instead of going through the tick. Guarded by m_ChatMutex.
+		std::mutex m_ChatMutex;
+		ChatHistory m_ChatHistory;
+		std::vector<uint32_t> m_ChatRecipients; // connected clients
+
+		// Clients that joined with a username; only changes are broadcast, never the whole list.
+		// Like chat, handled on the network thread. Guarded by m_RosterMutex.
+		std::mutex m_RosterMutex;
+		ClientRoster m_Roster;
+
+		// What each connected client gets at the end of the tick. The network thread adds and removes
+		// builders (under m_FramesMutex); any thread fills one, under that builder's own lock.
+		struct ClientFrame
+		{
+			std::mutex Mutex;
+			FrameBuilder Builder;
+		};
+
+		std::shared_mutex m_FramesMutex;
+		std::unordered_map<uint32_t, std::unique_ptr<ClientFrame>> m_ClientFrames;
+
+		// Everything below is only touched by the tick, which runs its work as a graph of jobs.
+		// Each job's comment in BuildTickGraph says which of this state it may touch.
+		JobPool m_JobPool;
+		JobGraph m_TickGraph;
+		uint32_t m_CurrentTick = 0;
+		uint32_t m_LastSnapshotTick = InvalidSnapshotTick;
+
+		// Per-client view of the world; snapshots only contain what's relevant to that client
+		struct ClientSession
+		{
+			PlayerID Player = InvalidPlayerID;
+			// Latest snapshot the client has confirmed, used as its delta baseline
+			uint32_t AckedSnapshotTick = InvalidSnapshotTick;
+			SnapshotHistory SentSnapshots;
+			// Inputs arrive in redundant batches and are applied one per tick
+			InputQueue Inputs;
+			// Latest input applied, reported back in snapshots for client-side prediction
+			uint32_t LastInputSequence = 0;
+			bool HasReceivedInput = false;
+
+			// Send time of each snapshot still in SentSnapshots, indexed by tick % capacity; acks give us RTT
+			std::array<TickScheduler::Clock::time_point, SnapshotHistory::Capacity> SnapshotSendTimes;
+			uint32_t SnapshotsSent = 0;
+			ClientMetrics Metrics;
+			// ms spent building this tick's snapshot, recorded into the metrics after the tick's jobs (-1 if none was sent)
+			double SerializationTime = -1.0;
+		};
+
+		PlayerStore m_Players; // authoritative, integrated by the tick from client inputs
+		PlayerStore m_TickPlayers; // quantized copy of m_Players for this tick
+		std::unordered_map<uint32_t, ClientSession> m_ClientSessions;
+		// m_ClientSessions as a list, so per-client work can be split by index. Rebuilt every tick.
+		std::vector<std::pair<uint32_t, ClientSession*>> m_TickClients;
+		InterestManager m_InterestManager;
+		std::atomic<float> m_RequestedInterestRadius = 0.0f;
+
+		// World chunks around each player, streamed every tick within a per-client byte budget.
+		// Player positions are in blocks on the world's XZ plane.
+		ChunkStreamer m_ChunkStreamer{ m_JobPool };
 
 	};
 }
\ No newline at end of file
@@ -0,0 +1,359 @@
+#include "ServerMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#include "spdlog/spdlog.h"
+
+namespace Cubed
+{
+	static std::atomic<uint64_t> s_NextMetricsInstanceID = 1;
+
+	// Relaxed read-modify-write without a locked instruction; only valid for single-writer counters
+	static void Increment(std::atomic<uint64_t>& counter, uint64_t amount)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+	static uint32_t ToPacketTypeIndex(PacketType type)
+	{
+		uint32_t index = (uint32_t)type;
+		return index < ServerMetrics::MaxPacketTypes ? index : 0;
+	}
+
+	MetricsHistogram::MetricsHistogram(std::initializer_list<double> upperBounds)
+	{
+		for (double bound : upperBounds)
+		{
+			if (m_BucketCount == MaxBuckets)
+				break;
+			m_UpperBounds[m_BucketCount++] = bound;
+		}
+	}
+
+	void MetricsHistogram::Record(double value)
+	{
+		uint32_t bucket = 0;
+		while (bucket < m_BucketCount && value > m_UpperBounds[bucket])
+			bucket++;
+
+		Increment(m_Buckets[bucket], 1);
+		Increment(m_Count, 1);
+		m_Sum.store(m_Sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	double MetricsHistogram::GetQuantile(double q) const
+	{
+		uint64_t count = GetCount();
+		if (count == 0)
+			return 0.0;
+
+		uint64_t target = (uint64_t)std::ceil(q * (double)count);
+		uint64_t cumulative = 0;
+		for (uint32_t i = 0; i < m_BucketCount; i++)
+		{
+			cumulative += m_Buckets[i].load(std::memory_order_relaxed);
+			if (cumulative >= target)
+				return m_UpperBounds[i];
+		}
+
+		return std::numeric_limits<double>::infinity();
+	}
+
+	void MetricsHistogram::AppendExposition(std::string& out, std::string_view name, std::string_view help) const
+	{
+		out += fmt::format("# HELP {} {}\n# TYPE {} histogram\n", name, help, name);
+
+		uint64_t cumulative = 0;
+		for (uint32_t i = 0; i < m_BucketCount; i++)
+		{
+			cumulative += m_Buckets[i].load(std::memory_order_relaxed);
+			out += fmt::format("{}_bucket{{le=\"{}\"}} {}\n", name, m_UpperBounds[i], cumulative);
+		}
+		cumulative += m_Buckets[m_BucketCount].load(std::memory_order_relaxed);
+
+		out += fmt::format("{}_bucket{{le=\"+Inf\"}} {}\n", name, cumulative);
+		out += fmt::format("{}_sum {}\n", name, GetSum());
+		out += fmt::format("{}_count {}\n", name, cumulative);
+	}
+
+	ServerMetrics::ServerMetrics()
+		: m_InstanceID(s_NextMetricsInstanceID.fetch_add(1)),
+		m_TickDuration({ 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 33.0, 50.0, 100.0, 250.0 }),
+		m_SerializationTime({ 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0 }),
+		m_InboundEvents({ 0, 1, 4, 16, 64, 256, 1024, 4096, 16384 }),
+		m_MessagesPerFrame({ 1, 2, 4, 8, 16, 32, 64, 128 })
+	{
+	}
+
+	ServerMetrics::ThreadCounters& ServerMetrics::GetThreadCounters()
+	{
+		// Instance IDs rather than pointers, so a new ServerMetrics at a recycled address
+		// can't pick up a block belonging to a destroyed one
+		struct ThreadCache
+		{
+			uint64_t InstanceID = 0;
+			ThreadCounters* Counters = nullptr;
+		};
+		thread_local ThreadCache s_Cache;
+
+		if (s_Cache.InstanceID != m_InstanceID)
+		{
+			std::scoped_lock<std::mutex> lock(m_ThreadCountersMutex);
+			s_Cache.Counters = m_ThreadCounters.emplace_back(std::make_unique<ThreadCounters>()).get();
+			s_Cache.InstanceID = m_InstanceID;
+		}
+
+		return *s_Cache.Counters;
+	}
+
+	void ServerMetrics::RecordReceived(PacketType type, uint64_t bytes)
+	{
+		ThreadCounters& counters = GetThreadCounters();
+		uint32_t index = ToPacketTypeIndex(type);
+		Increment(counters.MessagesIn[index], 1);
+		Increment(counters.BytesIn[index], bytes);
+	}
+
+	void ServerMetrics::RecordSent(PacketType type, uint64_t bytes)
+	{
+		ThreadCounters& counters = GetThreadCounters();
+		uint32_t index = ToPacketTypeIndex(type);
+		Increment(counters.MessagesOut[index], 1);
+		Increment(counters.BytesOut[index], bytes);
+	}
+
+	void ServerMetrics::RecordRateLimited(PacketType type)
+	{
+		Increment(GetThreadCounters().RateLimited[ToPacketTypeIndex(type)], 1);
+	}
+
+	ServerMetrics::PacketCounters ServerMetrics::GetPacketCounters(PacketType type) const
+	{
+		uint32_t index = ToPacketTypeIndex(type);
+
+		PacketCounters result;
+		std::scoped_lock<std::mutex> lock(m_ThreadCountersMutex);
+		for (const auto& counters : m_ThreadCounters)
+		{
+			result.MessagesIn += counters->MessagesIn[index].load(std::memory_order_relaxed);
+			result.BytesIn += counters->BytesIn[index].load(std::memory_order_relaxed);
+			result.MessagesOut += counters->MessagesOut[index].load(std::memory_order_relaxed);
+			result.BytesOut += counters->BytesOut[index].load(std::memory_order_relaxed);
+			result.RateLimited += counters->RateLimited[index].load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	ServerMetrics::PacketCounters ServerMetrics::GetTotalPacketCounters() const
+	{
+		PacketCounters total;
+		for (uint32_t i = 0; i < MaxPacketTypes; i++)
+		{
+			PacketCounters counters = GetPacketCounters((PacketType)i);
+			total.MessagesIn += counters.MessagesIn;
+			total.BytesIn += counters.BytesIn;
+			total.MessagesOut += counters.MessagesOut;
+			total.BytesOut += counters.BytesOut;
+			total.RateLimited += counters.RateLimited;
+		}
+		return total;
+	}
+
+	std::string ServerMetrics::FormatSummary() const
+	{
+		PacketCounters total = GetTotalPacketCounters();
+		std::string summary = fmt::format("Traffic: in {} msgs / {} bytes, out {} msgs / {} bytes, rate limited {} msgs\n",
+			total.MessagesIn, total.BytesIn, total.MessagesOut, total.BytesOut, total.RateLimited);
+
+		for (uint32_t i = 0; i < MaxPacketTypes; i++)
+		{
+			PacketCounters counters = GetPacketCounters((PacketType)i);
+			if (counters.MessagesIn == 0 && counters.MessagesOut == 0)
+				continue;
+
+			summary += fmt::format("  {:<40} in {:>10} msgs {:>12} bytes, out {:>10} msgs {:>12} bytes\n",
+				PacketTypeToString((PacketType)i), counters.MessagesIn, counters.BytesIn, counters.MessagesOut, counters.BytesOut);
+		}
+
+		summary += fmt::format("Tick duration: p50 <= {}ms, p99 <= {}ms ({} ticks)\n",
+			m_TickDuration.GetQuantile(0.5), m_TickDuration.GetQuantile(0.99), m_TickDuration.GetCount());
+		summary += fmt::format("Snapshot serialization: p50 <= {}ms, p99 <= {}ms ({} snapshots)\n",
+			m_SerializationTime.GetQuantile(0.5), m_SerializationTime.GetQuantile(0.99), m_SerializationTime.GetCount());
+		summary += fmt::format("Inbound events per tick: p50 <= {}, p99 <= {}\n",
+			m_InboundEvents.GetQuantile(0.5), m_InboundEvents.GetQuantile(0.99));
+
+		// Every packet records its message count, so the sum is messages and the count is sends
+		uint64_t framedMessages = (uint64_t)m_MessagesPerFrame.GetSum();
+		summary += fmt::format("Frames: {} messages in {} sends ({} sends saved), messages per send p50 <= {}, p99 <= {}\n",
+			framedMessages, m_MessagesPerFrame.GetCount(), framedMessages - m_MessagesPerFrame.GetCount(),
+			m_MessagesPerFrame.GetQuantile(0.5), m_MessagesPerFrame.GetQuantile(0.99));
+
+		summary += fmt::format("Clients: {}", m_Clients.size());
+		for (const auto& [clientID, client] : m_Clients)
+		{
+			summary += fmt::format("\n  Client {}: rtt={:.1f}ms pending snapshots={} inputs last tick={} buffered inputs={} chunks={} (pending {}, {} bytes in flight)",
+				clientID, client.RoundTripTime, client.PendingSnapshots, client.InputsLastTick, client.BufferedInputs,
+				client.HeldChunks, client.PendingChunks, client.ChunkBytesInFlight);
+		}
+
+		return summary;
+	}
+
+	std::string ServerMetrics::FormatExposition() const
+	{
+		std::string out;
+
+		static constexpr const char* s_PacketCounterNames[5][2] = {
+			{ "cubed_packets_received_total", "Messages received by packet type" },
+			{ "cubed_bytes_received_total", "Bytes received by packet type" },
+			{ "cubed_packets_sent_total", "Messages sent by packet type" },
+			{ "cubed_bytes_sent_total", "Bytes sent by packet type" },
+			{ "cubed_packets_rate_limited_total", "Messages dropped because the client exceeded its packet rate, by packet type" },
+		};
+
+		std::array<PacketCounters, MaxPacketTypes> counters;
+		for (uint32_t i = 0; i < MaxPacketTypes; i++)
+			counters[i] = GetPacketCounters((PacketType)i);
+
+		for (uint32_t metric = 0; metric < 5; metric++)
+		{
+			const char* name = s_PacketCounterNames[metric][0];
+			out += fmt::format("# HELP {} {}\n# TYPE {} counter\n", name, s_PacketCounterNames[metric][1], name);
+			for (uint32_t i = 0; i < MaxPacketTypes; i++)
+			{
+				const PacketCounters& c = counters[i];
+				if (c.MessagesIn == 0 && c.MessagesOut == 0)
+					continue;
+
+				uint64_t values[5] = { c.MessagesIn, c.BytesIn, c.MessagesOut, c.BytesOut, c.RateLimited };
+				out += fmt::format("{}{{type=\"{}\"}} {}\n", name, PacketTypeToString((PacketType)i), values[metric]);
+			}
+		}
+
+		m_TickDuration.AppendExposition(out, "cubed_tick_duration_ms", "Time spent simulating and sending one tick");
+		m_SerializationTime.AppendExposition(out, "cubed_snapshot_serialization_ms", "Time spent building and writing one client snapshot");
+		m_InboundEvents.AppendExposition(out, "cubed_inbound_events_per_tick", "Inbound events drained at the start of a tick");
+		m_MessagesPerFrame.AppendExposition(out, "cubed_messages_per_frame", "Messages coalesced into one send at the end of a tick");
+
+		out += "# HELP cubed_sends_saved_total Transport sends avoided by coalescing messages into frames\n# TYPE cubed_sends_saved_total counter\n";
+		out += fmt::format("cubed_sends_saved_total {}\n", (uint64_t)m_MessagesPerFrame.GetSum() - m_MessagesPerFrame.GetCount());
+
+		out += "# HELP cubed_clients Connected clients\n# TYPE cubed_clients gauge\n";
+		out += fmt::format("cubed_clients {}\n", m_Clients.size());
+
+		out += "# HELP cubed_client_rtt_ms Smoothed round trip time\n# TYPE cubed_client_rtt_ms gauge\n";
+		for (const auto& [clientID, client] : m_Clients)
+			out += fmt::format("cubed_client_rtt_ms{{client=\"{}\"}} {}\n", clientID, client.RoundTripTime);
+
+		out += "# HELP cubed_client_pending_snapshots Snapshots sent but not yet acknowledged\n# TYPE cubed_client_pending_snapshots gauge\n";
+		for (const auto& [clientID, client] : m_Clients)
+			out += fmt::format("cubed_client_pending_snapshots{{client=\"{}\"}} {}\n", clientID, client.PendingSnapshots);
+
+		out += "# HELP cubed_client_inputs_last_tick Inbound events drained for the client in the last tick\n# TYPE cubed_client_inputs_last_tick gauge\n";
+		for (const auto& [clientID, client] : m_Clients)
+			out += fmt::format("cubed_client_inputs_last_tick{{client=\"{}\"}} {}\n", clientID, client.InputsLastTick);
+
+		out += "# HELP cubed_client_buffered_inputs Received inputs waiting for a tick to apply them\n# TYPE cubed_client_buffered_inputs gauge\n";
+		for (const auto& [clientID, client] : m_Clients)
+			out += fmt::format("cubed_client_buffered_inputs{{client=\"{}\"}} {}\n", clientID, client.BufferedInputs);
+
+		out += "# HELP cubed_client_chunks Chunks streamed to the client and not unloaded\n# TYPE cubed_client_chunks gauge\n";
+		for (const auto& [clientID, client] : m_Clients)
+			out += fmt::format("cubed_client_chunks{{client=\"{}\"}} {}\n", clientID, client.HeldChunks);
+
+		out += "# HELP cubed_client_pending_chunks Chunks in view waiting for the client's streaming budget\n# TYPE cubed_client_pending_chunks gauge\n";
+		for (const auto& [clientID, client] : m_Clients)
+			out += fmt::format("cubed_client_pending_chunks{{client=\"{}\"}} {}\n", clientID, client.PendingChunks);
+
+		out += "# HELP cubed_client_chunk_bytes_in_flight Chunk bytes sent but not yet acknowledged\n# TYPE cubed_client_chunk_bytes_in_flight gauge\n";
+		for (const auto& [clientID, client] : m_Clients)
+			out += fmt::format("cubed_client_chunk_bytes_in_flight{{client=\"{}\"}} {}\n", clientID, client.ChunkBytesInFlight);
+
+		return out;
+	}
+
+	MetricsExporter::MetricsExporter()
+	{
+		m_WriterThread = std::thread([this]() { WriterThreadFunc(); });
+	}
+
+	MetricsExporter::~MetricsExporter()
+	{
+		// The extra request wakes the writer; it writes what is waiting and then sees we're stopping
+		m_Running.store(false, std::memory_order_release);
+		m_RequestCount.fetch_add(1, std::memory_order_release);
+		m_RequestCount.notify_one();
+
+		if (m_WriterThread.joinable())
+			m_WriterThread.join();
+	}
+
+	void MetricsExporter::Export(const std::filesystem::path& path, std::string exposition)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_PendingMutex);
+			m_PendingPath = path;
+			m_Pending = std::move(exposition);
+			m_HasPending = true;
+		}
+
+		m_RequestCount.fetch_add(1, std::memory_order_release);
+		m_RequestCount.notify_one();
+	}
+
+	void MetricsExporter::WriterThreadFunc()
+	{
+		uint64_t handledCount = 0;
+		std::filesystem::path path;
+		std::string text;
+
+		for (;;)
+		{
+			m_RequestCount.wait(handledCount, std::memory_order_acquire);
+			handledCount = m_RequestCount.load(std::memory_order_acquire);
+
+			bool hasText = false;
+			{
+				std::scoped_lock<std::mutex> lock(m_PendingMutex);
+				std::swap(hasText, m_HasPending);
+				path.swap(m_PendingPath);
+				text.swap(m_Pending);
+			}
+
+			if (hasText)
+			{
+				if (WriteFile(path, text))
+					m_WrittenCount.fetch_add(1, std::memory_order_relaxed);
+				else
+					m_FailedCount.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			if (!m_Running.load(std::memory_order_acquire))
+				break;
+		}
+	}
+
+	bool MetricsExporter::WriteFile(const std::filesystem::path& path, const std::string& text)
+	{
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+				return false;
+
+			stream.write(text.data(), text.size());
+			if (!stream)
+				return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		return !error;
+	}
+
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ServerPacket.h"
+
+namespace Cubed
+{
+	//
+	// MetricsHistogram - fixed upper-bound buckets (cumulative on export, Prometheus style).
+	// Record() must only be called from one thread at a time; reading is safe from any thread.
+	//
+	class MetricsHistogram
+	{
+	public:
+		static constexpr uint32_t MaxBuckets = 16;
+	public:
+		MetricsHistogram(std::initializer_list<double> upperBounds);
+
+		void Record(double value);
+
+		uint64_t GetCount() const { return m_Count.load(std::memory_order_relaxed); }
+		double GetSum() const { return m_Sum.load(std::memory_order_relaxed); }
+		// Upper bound of the bucket containing the q-th quantile (+inf past the last bucket)
+		double GetQuantile(double q) const;
+
+		void AppendExposition(std::string& out, std::string_view name, std::string_view help) const;
+	private:
+		std::array<double, MaxBuckets> m_UpperBounds{};
+		uint32_t m_BucketCount = 0;
+		// One extra for values above the last bound
+		std::array<std::atomic<uint64_t>, MaxBuckets + 1> m_Buckets{};
+		std::atomic<uint64_t> m_Count = 0;
+		std::atomic<double> m_Sum = 0.0;
+	};
+
+	struct ClientMetrics
+	{
+		float RoundTripTime = 0.0f; // ms, smoothed; measured from snapshot send to its acknowledgement
+		uint32_t PendingSnapshots = 0; // sent but not yet acknowledged
+		uint32_t InputsLastTick = 0; // inbound events drained for this client at the start of the last tick
+		uint32_t BufferedInputs = 0; // received inputs waiting for a tick to apply them
+		uint32_t HeldChunks = 0; // chunks streamed to the client and not unloaded
+		uint32_t PendingChunks = 0; // chunks in view still waiting for budget
+		uint32_t ChunkBytesInFlight = 0; // chunk bytes sent but not yet acknowledged
+	};
+
+	//
+	// ServerMetrics - counters, histograms and per-client stats for the server.
+	// Packet counters are per thread: each thread that records gets its own block and is
+	// the only writer to it, so the hot path is a couple of uncontended relaxed stores.
+	// Readers sum all blocks. Histograms and client metrics belong to the tick thread.
+	//
+	class ServerMetrics
+	{
+	public:
+		// PacketType values at or above this are counted as PacketType::None
+		static constexpr uint32_t MaxPacketTypes = 32;
+	public:
+		ServerMetrics();
+
+		// Any thread
+		void RecordReceived(PacketType type, uint64_t bytes);
+		void RecordSent(PacketType type, uint64_t bytes);
+		// Received, but dropped because the client exceeded its packet rate
+		void RecordRateLimited(PacketType type);
+
+		struct PacketCounters
+		{
+			uint64_t MessagesIn = 0, BytesIn = 0;
+			uint64_t MessagesOut = 0, BytesOut = 0;
+			uint64_t RateLimited = 0;
+		};
+		PacketCounters GetPacketCounters(PacketType type) const;
+		PacketCounters GetTotalPacketCounters() const;
+
+		// Tick thread
+		MetricsHistogram& GetTickDurationHistogram() { return m_TickDuration; }
+		MetricsHistogram& GetSerializationTimeHistogram() { return m_SerializationTime; }
+		MetricsHistogram& GetInboundEventsHistogram() { return m_InboundEvents; }
+		MetricsHistogram& GetMessagesPerFrameHistogram() { return m_MessagesPerFrame; }
+
+		void SetClientMetrics(uint32_t clientID, const ClientMetrics& metrics) { m_Clients[clientID] = metrics; }
+		void RemoveClient(uint32_t clientID) { m_Clients.erase(clientID); }
+
+		// Human-readable summary for the console (tick thread)
+		std::string FormatSummary() const;
+		// Prometheus text exposition format (tick thread)
+		std::string FormatExposition() const;
+	private:
+		struct ThreadCounters
+		{
+			std::array<std::atomic<uint64_t>, MaxPacketTypes> MessagesIn{}, BytesIn{};
+			std::array<std::atomic<uint64_t>, MaxPacketTypes> MessagesOut{}, BytesOut{};
+			std::array<std::atomic<uint64_t>, MaxPacketTypes> RateLimited{};
+		};
+
+		ThreadCounters& GetThreadCounters();
+	private:
+		uint64_t m_InstanceID = 0;
+
+		mutable std::mutex m_ThreadCountersMutex;
+		std::vector<std::unique_ptr<ThreadCounters>> m_ThreadCounters;
+
+		MetricsHistogram m_TickDuration; // ms
+		MetricsHistogram m_SerializationTime; // ms, per snapshot packet
+		MetricsHistogram m_InboundEvents; // events drained per tick
+		MetricsHistogram m_MessagesPerFrame; // per packet handed to the transport; 1 = a message sent on its own
+
+		std::unordered_map<uint32_t, ClientMetrics> m_Clients;
+	};
+
+	//
+	// MetricsExporter - writes exposition text to a file on its own thread, so the tick only pays
+	// for formatting it. Only the newest text matters: text handed over while an earlier one is
+	// still being written replaces whatever was waiting. Each write goes to a temporary file that
+	// is renamed over the target, so scrapers never see a partial file.
+	//
+	class MetricsExporter
+	{
+	public:
+		MetricsExporter();
+		// Writes out whatever is still waiting
+		~MetricsExporter();
+
+		MetricsExporter(const MetricsExporter&) = delete;
+		MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+		// Never waits on the file system
+		void Export(const std::filesystem::path& path, std::string exposition);
+
+		uint64_t GetWrittenCount() const { return m_WrittenCount.load(std::memory_order_relaxed); }
+		uint64_t GetFailedCount() const { return m_FailedCount.load(std::memory_order_relaxed); }
+	private:
+		void WriterThreadFunc();
+		static bool WriteFile(const std::filesystem::path& path, const std::string& text);
+	private:
+		std::mutex m_PendingMutex;
+		std::filesystem::path m_PendingPath;
+		std::string m_Pending;
+		bool m_HasPending = false;
+
+		// Bumped by every Export; the writer sleeps on it
+		std::atomic<uint64_t> m_RequestCount = 0;
+		std::atomic<uint64_t> m_WrittenCount = 0;
+		std::atomic<uint64_t> m_FailedCount = 0;
+		std::atomic<bool> m_Running = true;
+
+		std::thread m_WriterThread;
+	};
+
+}
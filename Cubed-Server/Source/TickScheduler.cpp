@@ -0,0 +1,118 @@
+#include "TickScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace Cubed
+{
+	static constexpr float s_StatsSmoothing = 0.05f;
+
+	static float ToMilliseconds(TickScheduler::Clock::duration duration)
+	{
+		return std::chrono::duration<float, std::milli>(duration).count();
+	}
+
+	TickScheduler::TickScheduler(const TickSchedulerSpecification& specification)
+		: m_Specification(specification)
+	{
+		SetTickRate(m_Specification.TickRate);
+	}
+
+	void TickScheduler::SetTickRate(uint32_t tickRate)
+	{
+		m_Specification.TickRate = std::max(tickRate, 1u);
+		m_TickInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_Specification.TickRate));
+
+		// Realign deadlines to the new interval starting from now
+		m_Started = false;
+	}
+
+	uint64_t TickScheduler::BeginTick()
+	{
+		Clock::time_point now = Clock::now();
+		if (!m_Started)
+		{
+			m_NextTickTime = now;
+			m_Started = true;
+		}
+
+		if (now < m_NextTickTime)
+		{
+			WaitUntil(m_NextTickTime);
+			now = Clock::now();
+		}
+
+		float lateness = ToMilliseconds(now - m_NextTickTime);
+		m_Stats.LastLateness = lateness;
+		m_Stats.AverageLateness += (lateness - m_Stats.AverageLateness) * s_StatsSmoothing;
+		m_Stats.MaxLateness = std::max(m_Stats.MaxLateness, lateness);
+
+		m_TickStartTime = now;
+		m_NextTickTime += m_TickInterval;
+
+		// Already behind for the next deadline(s) as well
+		if (now >= m_NextTickTime)
+		{
+			uint64_t ticksBehind = (uint64_t)((now - m_NextTickTime) / m_TickInterval) + 1;
+			uint64_t ticksToSkip = 0;
+			if (m_Specification.OverrunPolicy == TickOverrunPolicy::Skip)
+				ticksToSkip = ticksBehind;
+			else if (ticksBehind > m_Specification.MaxCatchUpTicks)
+				ticksToSkip = ticksBehind - m_Specification.MaxCatchUpTicks;
+
+			m_NextTickTime += m_TickInterval * ticksToSkip;
+			m_Stats.SkippedTicks += ticksToSkip;
+			m_PendingSkippedTicks = ticksToSkip;
+		}
+
+		return m_CurrentTick;
+	}
+
+	void TickScheduler::EndTick()
+	{
+		Clock::duration duration = Clock::now() - m_TickStartTime;
+		float durationMs = ToMilliseconds(duration);
+
+		m_Stats.LastTickDuration = durationMs;
+		m_Stats.AverageTickDuration += (durationMs - m_Stats.AverageTickDuration) * s_StatsSmoothing;
+		m_Stats.MaxTickDuration = std::max(m_Stats.MaxTickDuration, durationMs);
+		if (duration > m_TickInterval)
+			m_Stats.OverrunCount++;
+
+		// Dropped ticks still use up their numbers, so tick numbers keep following wall time
+		m_Stats.TickCount++;
+		m_CurrentTick += 1 + m_PendingSkippedTicks;
+		m_PendingSkippedTicks = 0;
+	}
+
+	void TickScheduler::ResetStats()
+	{
+		uint64_t tickCount = m_Stats.TickCount;
+		m_Stats = TickStats();
+		m_Stats.TickCount = tickCount;
+	}
+
+	void TickScheduler::WaitUntil(Clock::time_point deadline)
+	{
+		// Coarse sleep first, leaving SpinThreshold to absorb OS wake-up jitter
+		Clock::time_point sleepUntil = deadline - m_Specification.SpinThreshold;
+		Clock::time_point now = Clock::now();
+		if (now < sleepUntil)
+			std::this_thread::sleep_for(sleepUntil - now);
+
+		while (Clock::now() < deadline)
+			std::this_thread::yield();
+	}
+
+	const char* TickOverrunPolicyToString(TickOverrunPolicy policy)
+	{
+		switch (policy)
+		{
+			case TickOverrunPolicy::CatchUp: return "CatchUp";
+			case TickOverrunPolicy::Skip:    return "Skip";
+		}
+
+		return "<Invalid>";
+	}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+namespace Cubed
+{
+	enum class TickOverrunPolicy
+	{
+		// Run missed ticks back-to-back until we're on schedule again (bounded by MaxCatchUpTicks)
+		CatchUp = 0,
+		// Drop missed ticks and realign to the next deadline
+		Skip
+	};
+
+	struct TickSchedulerSpecification
+	{
+		uint32_t TickRate = 30;
+		TickOverrunPolicy OverrunPolicy = TickOverrunPolicy::CatchUp;
+
+		// When catching up, never run more than this many ticks back-to-back;
+		// anything beyond is skipped so a long stall doesn't turn into a death spiral
+		uint32_t MaxCatchUpTicks = 4;
+
+		// Sleep until this close to the deadline, then spin. OS sleep granularity
+		// (~1ms on Linux, up to ~15ms on Windows) is too coarse for 60Hz on its own
+		std::chrono::microseconds SpinThreshold{ 2000 };
+	};
+
+	struct TickStats
+	{
+		uint64_t TickCount = 0;
+		uint64_t OverrunCount = 0; // ticks whose work took longer than the tick interval
+		uint64_t SkippedTicks = 0; // ticks dropped due to the overrun policy
+
+		// All in milliseconds
+		float LastTickDuration = 0.0f;
+		float AverageTickDuration = 0.0f; // exponential moving average
+		float MaxTickDuration = 0.0f;
+		float LastLateness = 0.0f; // how late the tick started relative to its deadline
+		float AverageLateness = 0.0f;
+		float MaxLateness = 0.0f;
+	};
+
+	//
+	// TickScheduler - drives the server simulation at a fixed rate.
+	// Deadlines are absolute (start + N * interval), so time spent inside a
+	// tick or oversleeping never accumulates into drift.
+	//
+	class TickScheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+	public:
+		TickScheduler(const TickSchedulerSpecification& specification = TickSchedulerSpecification());
+
+		void SetTickRate(uint32_t tickRate);
+		uint32_t GetTickRate() const { return m_Specification.TickRate; }
+
+		void SetOverrunPolicy(TickOverrunPolicy policy) { m_Specification.OverrunPolicy = policy; }
+		TickOverrunPolicy GetOverrunPolicy() const { return m_Specification.OverrunPolicy; }
+
+		// Blocks until the next tick is due. Returns the number of the tick to simulate; numbers of
+		// skipped ticks are not reused, so consecutive ticks can be further apart than one.
+		uint64_t BeginTick();
+		void EndTick();
+
+		// Fixed simulation timestep in seconds
+		float GetTimestep() const { return 1.0f / (float)m_Specification.TickRate; }
+		uint64_t GetCurrentTick() const { return m_CurrentTick; }
+
+		const TickStats& GetStats() const { return m_Stats; }
+		void ResetStats();
+	private:
+		void WaitUntil(Clock::time_point deadline);
+	private:
+		TickSchedulerSpecification m_Specification;
+		Clock::duration m_TickInterval;
+
+		Clock::time_point m_NextTickTime;
+		Clock::time_point m_TickStartTime;
+		bool m_Started = false;
+
+		uint64_t m_CurrentTick = 0;
+		uint64_t m_PendingSkippedTicks = 0; // skipped after the current tick, applied by EndTick
+		TickStats m_Stats;
+	};
+
+	const char* TickOverrunPolicyToString(TickOverrunPolicy policy);
+}